@@ -0,0 +1,219 @@
+#include "arduino_hal.h"
+#include "heap_guard.h"
+
+ArduinoClock::ArduinoClock() {
+    wakeTimer = nullptr;
+    waitingTask = nullptr;
+}
+
+void ArduinoClock::wakeCallback(void* arg) {
+    ArduinoClock* clock = static_cast<ArduinoClock*>(arg);
+    if (clock->waitingTask != nullptr) {
+        xTaskNotifyGive(clock->waitingTask);
+    }
+}
+
+uint32_t ArduinoClock::micros() {
+    return ::micros();
+}
+
+void ArduinoClock::delayMicros(uint32_t us) {
+    if (us < MIN_SLEEP_MICROS) {
+        delayMicroseconds(us);
+        return;
+    }
+    
+    // 初回のみタイマーを生成
+    if (wakeTimer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = wakeCallback;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "clock_wake";
+        if (esp_timer_create(&args, &wakeTimer) != ESP_OK) {
+            wakeTimer = nullptr;
+            delayMicroseconds(us);
+            return;
+        }
+    }
+    
+    // 呼び出し元タスクをタイマー（またはwakeFromIsr()）で起こす
+    // 待機の前に届いた通知は捨てない（受信機のパルスで起こされた分を取りこぼさない）
+    // 残っていた古いタイマーの通知で早く起きることはあるが、呼び出し元は時刻を見て待ち直す
+    waitingTask = xTaskGetCurrentTaskHandle();
+    esp_timer_stop(wakeTimer);
+    if (esp_timer_start_once(wakeTimer, us) != ESP_OK) {
+        // タイマーで起こせなければ、その分はビジーウェイト（制御タスクを止めない）
+        delayMicroseconds(us);
+        return;
+    }
+    // タイマーの通知が届かなくても1ティック余分に待てば戻る（呼び出し元は時刻を見て待ち直す）
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(us / 1000 + 1) + 1);
+    esp_timer_stop(wakeTimer);
+}
+
+void IRAM_ATTR ArduinoClock::wakeFromIsr() {
+    TaskHandle_t task = waitingTask;
+    if (task == nullptr) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void ArduinoPwmInput::attach(int pin, void (*isr)()) {
+    pinMode(pin, INPUT);
+    // 立ち上がりと立ち下がりの両方で検出
+    attachInterrupt(digitalPinToInterrupt(pin), isr, CHANGE);
+}
+
+void ArduinoSerialPort::begin(uint32_t baud, bool evenParityTwoStop, bool inverted) {
+    serial.setRxBufferSize(RX_BUFFER_SIZE);
+    serial.begin(baud, evenParityTwoStop ? SERIAL_8E2 : SERIAL_8N1, rxPin, -1, inverted);
+}
+
+size_t ArduinoSerialPort::readAvailable(uint8_t* buffer, size_t length) {
+    int available = serial.available();
+    if (available <= 0) return 0;
+    if ((size_t)available < length) length = available;
+    return serial.read(buffer, length);
+}
+
+static const char* NVS_NAMESPACE = "imu";
+static const char* NVS_KEY = "calib";
+
+NvsCalibrationStore::NvsCalibrationStore() : pending(), task(nullptr) {
+    pendingLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool NvsCalibrationStore::begin(UBaseType_t priority) {
+    if (task != nullptr) return true;
+    return xTaskCreate(taskEntry, "calib", STACK_SIZE, this, priority, &task) == pdPASS;
+}
+
+bool NvsCalibrationStore::load(ImuCalibration& calibration) {
+    if (!preferences.begin(NVS_NAMESPACE, true)) return false;
+    size_t length = preferences.getBytes(NVS_KEY, &calibration, sizeof(calibration));
+    preferences.end();
+    return length == sizeof(calibration);
+}
+
+void NvsCalibrationStore::save(const ImuCalibration& calibration) {
+    portENTER_CRITICAL(&pendingLock);
+    pending = calibration;
+    portEXIT_CRITICAL(&pendingLock);
+    if (task != nullptr) xTaskNotifyGive(task);
+}
+
+void NvsCalibrationStore::taskEntry(void* arg) {
+    NvsCalibrationStore* store = static_cast<NvsCalibrationStore*>(arg);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ImuCalibration calibration;
+        portENTER_CRITICAL(&store->pendingLock);
+        calibration = store->pending;
+        portEXIT_CRITICAL(&store->pendingLock);
+        
+        if (store->preferences.begin(NVS_NAMESPACE, false)) {
+            store->preferences.putBytes(NVS_KEY, &calibration, sizeof(calibration));
+            store->preferences.end();
+        }
+    }
+}
+
+bool EspPartitionStorage::begin() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    return partition != nullptr;
+}
+
+bool EspPartitionStorage::erase(uint32_t offset, uint32_t length) {
+    // 64KB単位に揃っている範囲はブロック消去になる（4KBずつより速い）
+    return partition != nullptr && esp_partition_erase_range(partition, offset, length) == ESP_OK;
+}
+
+bool EspPartitionStorage::write(uint32_t offset, const void* data, size_t length) {
+    return partition != nullptr && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+bool EspPartitionStorage::read(uint32_t offset, void* data, size_t length) {
+    return partition != nullptr && esp_partition_read(partition, offset, data, length) == ESP_OK;
+}
+
+void ArduinoI2CBus::begin(int sda_pin, int scl_pin, uint32_t clock_hz) {
+    sdaPin = sda_pin;
+    sclPin = scl_pin;
+    clockHz = clock_hz;
+    wire.begin(sdaPin, sclPin);
+    wire.setClock(clockHz);
+    wire.setTimeOut(TIMEOUT_MS);
+}
+
+bool ArduinoI2CBus::recover() {
+    if (sdaPin < 0 || sclPin < 0) return false;
+    // Wireの作り直しはバッファを確保し直すことがある（バスが固まった時だけ通るので許容する）
+    HeapGuard::Exempt exempt;
+    wire.end();
+    
+    // 途中で止まったスレーブがSDAを離すまでSCLを最大9回送る
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sclPin, HIGH);
+    for (int i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++) {
+        digitalWrite(sclPin, LOW);
+        delayMicroseconds(5);
+        digitalWrite(sclPin, HIGH);
+        delayMicroseconds(5);
+    }
+    
+    // STOP条件（SCLがHIGHの間にSDAをLOWからHIGHへ）
+    pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(sdaPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sdaPin, HIGH);
+    delayMicroseconds(5);
+    pinMode(sdaPin, INPUT_PULLUP);
+    bool released = digitalRead(sdaPin) == HIGH;
+    
+    begin(sdaPin, sclPin, clockHz);
+    return released;
+}
+
+bool ArduinoI2CBus::probe(uint8_t address) {
+    wire.beginTransmission(address);
+    return wire.endTransmission() == 0;
+}
+
+bool ArduinoI2CBus::write(uint8_t address, const uint8_t* data, size_t length) {
+    wire.beginTransmission(address);
+    wire.write(data, length);
+    return wire.endTransmission() == 0;
+}
+
+bool ArduinoI2CBus::writeRead(uint8_t address, const uint8_t* tx, size_t txLength,
+                              uint8_t* rx, size_t rxLength) {
+    wire.beginTransmission(address);
+    wire.write(tx, txLength);
+    if (wire.endTransmission(false) != 0) return false;  // リピートスタート
+    
+    if (wire.requestFrom(address, (uint8_t)rxLength) != rxLength) return false;
+    for (size_t i = 0; i < rxLength; i++) {
+        rx[i] = wire.read();
+    }
+    return true;
+}
+
+bool LedcServoDriver::attach(int pin, uint16_t frameRateHz) {
+    // 周波数と分解能の組み合わせが作れなければ0が返る
+    if (frameRateHz == 0 || ledcSetup(channel, frameRateHz, resolutionBits) == 0) return false;
+    ledcAttachPin(pin, channel);
+    maxDuty = (1u << resolutionBits) - 1;
+    dutyPerMicro = (float)(1u << resolutionBits) * frameRateHz / 1000000.0f;
+    ledcWrite(channel, 0);
+    return true;
+}
+
+void LedcServoDriver::writeMicroseconds(float micros) {
+    if (micros < 0) micros = 0;
+    uint32_t duty = (uint32_t)(micros * dutyPerMicro + 0.5f);
+    if (duty > maxDuty) duty = maxDuty;
+    ledcWrite(channel, duty);
+}
@@ -0,0 +1,143 @@
+#ifndef ARDUINO_HAL_H
+#define ARDUINO_HAL_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <Wire.h>
+#include <Preferences.h>
+#include "calibration_store.h"
+#include "clock.h"
+#include "flash_storage.h"
+#include "i2c_bus.h"
+#include "pwm_input.h"
+#include "servo_driver.h"
+#include "serial_port.h"
+
+// Arduino/ESP32用の時刻源
+// 待機はesp_timerのワンショットで起床するため、1ms未満の周期でもCPUを手放せる
+class ArduinoClock : public Clock {
+private:
+    esp_timer_handle_t wakeTimer;
+    TaskHandle_t waitingTask;
+
+    // これより短い待機はビジーウェイトの方が正確
+    static const uint32_t MIN_SLEEP_MICROS = 50;
+
+    static void wakeCallback(void* arg);
+
+public:
+    ArduinoClock();
+    uint32_t micros() override;
+    uint32_t IRAM_ATTR cycleCount() override { return ESP.getCycleCount(); }
+    uint32_t cyclesPerMicro() override { return ESP.getCpuFreqMHz(); }
+    void delayMicros(uint32_t us) override;
+    void IRAM_ATTR wakeFromIsr() override;
+};
+
+// WireによるI2Cバス
+class ArduinoI2CBus : public I2CBus {
+private:
+    TwoWire& wire;
+    int sdaPin;
+    int sclPin;
+    uint32_t clockHz;
+
+    // 1トランザクションの上限（応答しないデバイスで制御ループを止めないため）
+    static const uint16_t TIMEOUT_MS = 5;
+
+public:
+    ArduinoI2CBus(TwoWire& wire) : wire(wire), sdaPin(-1), sclPin(-1), clockHz(400000) {}
+    void begin(int sda_pin, int scl_pin, uint32_t clock_hz);
+    bool recover() override;
+    bool probe(uint8_t address) override;
+    bool write(uint8_t address, const uint8_t* data, size_t length) override;
+    bool writeRead(uint8_t address, const uint8_t* tx, size_t txLength,
+                   uint8_t* rx, size_t rxLength) override;
+};
+
+// NVS（Preferences）への補正値の保存
+// フラッシュ書き込みは数ms止まることがあるため、低優先度タスクで行う
+class NvsCalibrationStore : public CalibrationStore {
+private:
+    Preferences preferences;
+    ImuCalibration pending;
+    portMUX_TYPE pendingLock;
+    TaskHandle_t task;
+
+    static const uint32_t STACK_SIZE = 3072;
+    static void taskEntry(void* arg);
+
+public:
+    NvsCalibrationStore();
+
+    // 書き込みタスクを起動（priorityは制御ループより低くする）
+    bool begin(UBaseType_t priority);
+
+    bool load(ImuCalibration& calibration) override;
+    void save(const ImuCalibration& calibration) override;
+};
+
+// 内蔵フラッシュのデータパーティション（partitions.csvで名前を付けたもの）
+// 消去・書き込み中はキャッシュが止まり、IRAMにない処理は全て待たされる
+class EspPartitionStorage : public FlashStorage {
+private:
+    const char* label;
+    const esp_partition_t* partition;
+
+    static const uint32_t SECTOR_SIZE = 4096;   // 消去の最小単位（SPI_FLASH_SEC_SIZE）
+
+public:
+    EspPartitionStorage(const char* label) : label(label), partition(nullptr) {}
+
+    // パーティションを探す（無ければfalse）
+    bool begin();
+
+    uint32_t size() override { return partition != nullptr ? partition->size : 0; }
+    uint32_t sectorSize() override { return SECTOR_SIZE; }
+    bool erase(uint32_t offset, uint32_t length) override;
+    bool write(uint32_t offset, const void* data, size_t length) override;
+    bool read(uint32_t offset, void* data, size_t length) override;
+};
+
+// GPIO割り込みによるPWM入力
+class ArduinoPwmInput : public PwmInput {
+public:
+    void attach(int pin, void (*isr)()) override;
+    bool IRAM_ATTR read(int pin) override { return digitalRead(pin) == HIGH; }
+};
+
+// UART受信（SBUS/CRSF用、受信ピンのみ使用）
+class ArduinoSerialPort : public SerialPort {
+private:
+    HardwareSerial& serial;
+    int rxPin;
+
+    static const size_t RX_BUFFER_SIZE = 256;
+
+public:
+    ArduinoSerialPort(HardwareSerial& serial, int rx_pin) : serial(serial), rxPin(rx_pin) {}
+    void begin(uint32_t baud, bool evenParityTwoStop, bool inverted) override;
+    size_t readAvailable(uint8_t* buffer, size_t length) override;
+};
+
+// LEDCによるサーボ出力（1インスタンスにつき1チャンネル）
+// ESP32-C3のLEDCは14ビットまで。50Hzで約1.2μs、333Hzで約0.18μs刻み
+// デューティの変更は次の周期の始まりで反映される
+class LedcServoDriver : public ServoDriver {
+private:
+    uint8_t channel;
+    uint8_t resolutionBits;
+    uint32_t maxDuty;
+    float dutyPerMicro;     // 1μsあたりのデューティ（周期と分解能から事前に計算）
+
+public:
+    static const uint8_t DEFAULT_RESOLUTION_BITS = 14;
+
+    LedcServoDriver(uint8_t channel, uint8_t resolution_bits = DEFAULT_RESOLUTION_BITS)
+        : channel(channel), resolutionBits(resolution_bits), maxDuty(0), dutyPerMicro(0) {}
+    bool attach(int pin, uint16_t frameRateHz) override;
+    void writeMicroseconds(float micros) override;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#include "attitude_estimator.h"
+#include "fast_math.h"
+
+void ComplementaryEstimator::update(float accX, float accY, float accZ,
+                                    float gyroX, float gyroY, float gyroZ, float deltaTime) {
+    // 加速度から水平基準角度計算
+    // libmのdouble演算は使わず、近似関数で度を直接求める
+    float accPitch = fastAtan2Deg(-accX, fastSqrt(accY * accY + accZ * accZ));
+    float accRoll = fastAtan2Deg(accY, accZ);
+    
+    float alpha = gyroWeight;
+    if (firstUpdate) {
+        // 初回は加速度ベース
+        pitch = accPitch;
+        roll = accRoll;
+        yaw = 0;
+    } else {
+        // 相補フィルター適用
+        pitch = alpha * (pitch + gyroY * deltaTime) + (1 - alpha) * accPitch;
+        roll = alpha * (roll + gyroX * deltaTime) + (1 - alpha) * accRoll;
+        yaw += gyroZ * deltaTime; // ヨーは積分のみ
+    }
+    firstUpdate = false;
+}
+
+void ComplementaryEstimator::reset() {
+    pitch = roll = yaw = 0;
+    firstUpdate = true;
+}
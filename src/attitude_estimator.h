@@ -0,0 +1,45 @@
+#ifndef ATTITUDE_ESTIMATOR_H
+#define ATTITUDE_ESTIMATOR_H
+
+// 姿勢推定器のインターフェース
+// 加速度[g]とジャイロ[deg/s]から機体の姿勢（度）を推定する
+
+class AttitudeEstimator {
+public:
+    virtual ~AttitudeEstimator() {}
+    
+    // deltaTime: 前回からの経過時間[秒]
+    virtual void update(float accX, float accY, float accZ,
+                        float gyroX, float gyroY, float gyroZ, float deltaTime) = 0;
+    virtual void reset() = 0;
+    
+    virtual float getPitch() const = 0;
+    virtual float getRoll() const = 0;
+    virtual float getYaw() const = 0;
+    virtual const char* getName() const = 0;
+};
+
+// 相補フィルター（ジャイロ積分と加速度の角度を固定比率で混ぜる）
+// ヨーはジャイロの積分のみ。ピッチが±90度に近いとロールが不安定になる
+class ComplementaryEstimator : public AttitudeEstimator {
+private:
+    float pitch, roll, yaw;     // 推定角度[度]
+    float gyroWeight;           // ジャイロの重み
+    bool firstUpdate;           // 初回は加速度から角度を初期化
+
+public:
+    ComplementaryEstimator() : gyroWeight(0.96f) { reset(); }
+    
+    void update(float accX, float accY, float accZ,
+                float gyroX, float gyroY, float gyroZ, float deltaTime) override;
+    void reset() override;
+    
+    void setGyroWeight(float weight) { gyroWeight = weight; }
+    
+    float getPitch() const override { return pitch; }
+    float getRoll() const override { return roll; }
+    float getYaw() const override { return yaw; }
+    const char* getName() const override { return "complementary"; }
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "attitude_filter.h"
+
+static const float SMOOTH_WEIGHT = 0.8;        // 制御入力用ローパスの前回値の重み
+static const float ACCEL_WEIGHT = 0.8;         // 加速度ローパスの前回値の重み
+
+static const q16_t FIXED_ANGLE_GYRO_WEIGHT = q16Const(0.96);  // ComplementaryEstimatorと同じ
+static const q16_t FIXED_SMOOTH_WEIGHT = q16Const(0.8);
+static const q16_t FIXED_ACCEL_WEIGHT = q16Const(0.8);
+
+AngleFilter::AngleFilter() : estimator(&mahony) {
+    reset();
+}
+
+void AngleFilter::update(float accX, float accY, float accZ,
+                         float gyroX, float gyroY, float gyroZ, float deltaTime) {
+    estimator->update(accX, accY, accZ, gyroX, gyroY, gyroZ, deltaTime);
+    
+    // ローパスフィルター（リセット直後は推定値から始める。0から追従させると舵が跳ねる）
+    if (firstUpdate) {
+        smoothPitch = estimator->getPitch();
+        smoothRoll = estimator->getRoll();
+        firstUpdate = false;
+    }
+    smoothPitch = smoothPitch * SMOOTH_WEIGHT + estimator->getPitch() * (1 - SMOOTH_WEIGHT);
+    smoothRoll = smoothRoll * SMOOTH_WEIGHT + estimator->getRoll() * (1 - SMOOTH_WEIGHT);
+}
+
+void AngleFilter::reset() {
+    estimator->reset();
+    smoothPitch = smoothRoll = 0;
+    firstUpdate = true;
+}
+
+void AngleFilter::selectEstimator(EstimatorType type) {
+    if (type == ESTIMATOR_COMPLEMENTARY) {
+        setEstimator(complementary);
+    } else {
+        setEstimator(mahony);
+    }
+}
+
+void AngleFilter::setEstimator(AttitudeEstimator& custom) {
+    estimator = &custom;
+    reset();
+}
+
+// a * weight + b * (1 - weight)
+static q16_t blend(q16_t a, q16_t b, q16_t weight) {
+    return q16Add(q16Mul(a, weight), q16Mul(b, Q16_ONE - weight));
+}
+
+void FixedAngleFilter::update(q16_t accX, q16_t accY, q16_t accZ,
+                              q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step) {
+    if (type == ESTIMATOR_MAHONY) {
+        mahony.update(accX, accY, accZ, gyroX, gyroY, gyroZ, step);
+        pitch = mahony.getPitch();
+        roll = mahony.getRoll();
+        yaw = mahony.getYaw();
+    } else {
+        updateComplementary(accX, accY, accZ, gyroX, gyroY, gyroZ, step);
+    }
+    
+    // ローパスはリセット直後は推定値から始める（float版と同じ）
+    if (firstUpdate) {
+        smoothPitch = pitch;
+        smoothRoll = roll;
+        firstUpdate = false;
+    }
+    smoothPitch = blend(smoothPitch, pitch, FIXED_SMOOTH_WEIGHT);
+    smoothRoll = blend(smoothRoll, roll, FIXED_SMOOTH_WEIGHT);
+}
+
+// ComplementaryEstimatorと同じ計算
+void FixedAngleFilter::updateComplementary(q16_t accX, q16_t accY, q16_t accZ,
+                                           q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step) {
+    q16_t horizontal = q16Sqrt(q16Add(q16Mul(accY, accY), q16Mul(accZ, accZ)));
+    q16_t accPitch = q16Atan2Deg(-accX, horizontal);
+    q16_t accRoll = q16Atan2Deg(accY, accZ);
+    
+    if (firstUpdate) {
+        pitch = accPitch;
+        roll = accRoll;
+        yaw = 0;
+    } else {
+        pitch = blend(q16Add(pitch, q16MulTime(gyroY, step)), accPitch, FIXED_ANGLE_GYRO_WEIGHT);
+        roll = blend(q16Add(roll, q16MulTime(gyroX, step)), accRoll, FIXED_ANGLE_GYRO_WEIGHT);
+        yaw = q16Add(yaw, q16MulTime(gyroZ, step));
+    }
+}
+
+void FixedAngleFilter::reset() {
+    mahony.reset();
+    pitch = roll = yaw = 0;
+    smoothPitch = smoothRoll = 0;
+    firstUpdate = true;
+}
+
+void FixedAngleFilter::selectEstimator(EstimatorType newType) {
+    type = newType;
+    reset();
+}
+
+void AccelFilter::update(float accX, float accY, float accZ) {
+    float alpha = ACCEL_WEIGHT;
+    accel[0] = alpha * accel[0] + (1 - alpha) * accX;
+    accel[1] = alpha * accel[1] + (1 - alpha) * accY;
+    accel[2] = alpha * accel[2] + (1 - alpha) * accZ;
+}
+
+void AccelFilter::reset() {
+    accel[0] = 0;
+    accel[1] = 0;
+    accel[2] = -1.0;  // 重力分
+}
+
+void FixedAccelFilter::update(q16_t accX, q16_t accY, q16_t accZ) {
+    accel[0] = blend(accel[0], accX, FIXED_ACCEL_WEIGHT);
+    accel[1] = blend(accel[1], accY, FIXED_ACCEL_WEIGHT);
+    accel[2] = blend(accel[2], accZ, FIXED_ACCEL_WEIGHT);
+}
+
+void FixedAccelFilter::reset() {
+    accel[0] = 0;
+    accel[1] = 0;
+    accel[2] = q16Const(-1.0);
+}
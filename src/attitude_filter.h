@@ -0,0 +1,113 @@
+#ifndef ATTITUDE_FILTER_H
+#define ATTITUDE_FILTER_H
+
+// AutoControlの姿勢・加速度フィルター
+// float版と固定小数点版（USE_FIXED_POINT）がある
+
+#include "fixed_point.h"
+#include "attitude_estimator.h"
+#include "mahony_estimator.h"
+#include "fixed_mahony_estimator.h"
+
+enum EstimatorType {
+    ESTIMATOR_COMPLEMENTARY,
+    ESTIMATOR_MAHONY,
+};
+
+// 角度制御用：姿勢推定器と制御入力用ローパスフィルター
+// 推定器は既定でMahony。実行中に切り替えたり、外から別の推定器を差し込める
+class AngleFilter {
+private:
+    ComplementaryEstimator complementary;
+    MahonyEstimator mahony;
+    AttitudeEstimator* estimator;   // 使用中の推定器
+    float smoothPitch, smoothRoll;  // ローパス後の角度（PID入力）
+    bool firstUpdate;               // リセット後の初回（ローパスを推定値から始める）
+
+public:
+    AngleFilter();
+    AngleFilter(const AngleFilter&) = delete;
+    AngleFilter& operator=(const AngleFilter&) = delete;
+    
+    // acc: [g]、gyro: [deg/s]、deltaTime: [秒]
+    void update(float accX, float accY, float accZ,
+                float gyroX, float gyroY, float gyroZ, float deltaTime);
+    void reset();
+    
+    // 推定器の切り替え（切り替え後は初回の値から推定し直す）
+    void selectEstimator(EstimatorType type);
+    void setEstimator(AttitudeEstimator& custom);
+    const AttitudeEstimator& getEstimator() const { return *estimator; }
+    MahonyEstimator& getMahony() { return mahony; }
+    ComplementaryEstimator& getComplementary() { return complementary; }
+    
+    float getPitch() const { return estimator->getPitch(); }
+    float getRoll() const { return estimator->getRoll(); }
+    float getYaw() const { return estimator->getYaw(); }
+    float getSmoothPitch() const { return smoothPitch; }
+    float getSmoothRoll() const { return smoothRoll; }
+};
+
+// 固定小数点版。推定器はfloat版と同じく既定でMahony（FixedMahonyEstimator）、相補フィルターも選べる
+class FixedAngleFilter {
+private:
+    FixedMahonyEstimator mahony;
+    EstimatorType type;
+    q16_t pitch, roll, yaw;         // 使用中の推定器の値
+    q16_t smoothPitch, smoothRoll;
+    bool firstUpdate;
+
+    void updateComplementary(q16_t accX, q16_t accY, q16_t accZ,
+                             q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step);
+
+public:
+    FixedAngleFilter() : type(ESTIMATOR_MAHONY) { reset(); }
+    
+    void update(q16_t accX, q16_t accY, q16_t accZ,
+                q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step);
+    void reset();
+    
+    // 推定器の切り替え（切り替え後は初回の値から推定し直す）
+    void selectEstimator(EstimatorType newType);
+    EstimatorType getEstimatorType() const { return type; }
+    FixedMahonyEstimator& getMahony() { return mahony; }
+    
+    q16_t getPitch() const { return pitch; }
+    q16_t getRoll() const { return roll; }
+    q16_t getYaw() const { return yaw; }
+    q16_t getSmoothPitch() const { return smoothPitch; }
+    q16_t getSmoothRoll() const { return smoothRoll; }
+};
+
+// 加速度制御用：加速度のローパスフィルター
+class AccelFilter {
+private:
+    float accel[3];
+
+public:
+    AccelFilter() { reset(); }
+    
+    void update(float accX, float accY, float accZ);
+    void reset();
+    
+    float getX() const { return accel[0]; }
+    float getY() const { return accel[1]; }
+    float getZ() const { return accel[2]; }
+};
+
+class FixedAccelFilter {
+private:
+    q16_t accel[3];
+
+public:
+    FixedAccelFilter() { reset(); }
+    
+    void update(q16_t accX, q16_t accY, q16_t accZ);
+    void reset();
+    
+    q16_t getX() const { return accel[0]; }
+    q16_t getY() const { return accel[1]; }
+    q16_t getZ() const { return accel[2]; }
+};
+
+#endif
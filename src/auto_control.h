@@ -1,110 +1,166 @@
 #ifndef AUTO_CONTROL_H
 #define AUTO_CONTROL_H
 
-// 制御モード選択（どちらか一つをコメントアウト）
-#define USE_ANGLE_CONTROL     // 角度制御モード
-// #define USE_ACCEL_CONTROL     // 加速度制御モード
+// 演算方式選択（有効にするとフィルターとPIDを固定小数点で計算する）
+// #define USE_FIXED_POINT
 
-#include "pid_controller.h"
-#include <MPU6050_tockn.h>
+#include <stdint.h>
+#include "control_mode.h"
+#include "loop_profiler.h"
 
+// 自動制御（モードは実行時に切り替え、既定は角度制御）
+// 全モードの推定（姿勢、加速度）は選ばれていない間も続け、切り替えた直後から今の測定値で制御できるようにする
+// （加速度制御の間、姿勢推定は外側ループの周期に間引く。setBackgroundEstimation(false)で止められる）
+// PIDはstep()の中で1周期1回だけ計算し、出力の取得は結果を読むだけ（何度呼んでも積分は進まない）
 class AutoControl {
+public:
+    static const uint16_t ANGLE_LOOP_RATE_HZ = AngleModeControl::ANGLE_LOOP_RATE_HZ;
+
 private:
-    PIDController pitchPID;     // ピッチ制御用PID
-    PIDController rollPID;      // ロール制御用PID
-    PIDController yawPID;       // ヨー制御用PID
-    
-    // 目標値
-    float targetPitch;
-    float targetRoll;
-    float targetYaw;
-    
-#ifdef USE_ANGLE_CONTROL
-    // 現在の角度（積分により計算）
-    float currentPitch;
-    float currentRoll;
-    float currentYaw;
-#endif
+    ControlMode mode;
+    AngleModeControl angleMode;
+    AccelModeControl accelMode;
+    bool transferPending;       // 次のstep()で前のモードの出力を引き継ぐ
+    bool backgroundEstimation;  // 加速度制御の間も姿勢推定を続ける
+
+    ControlStep lastStep;       // 直近の周期（PID計算に使用）
+    ControlOutputs outputs;     // 直近のstep()の結果
 
-#ifdef USE_ACCEL_CONTROL
-    // 目標加速度
-    float targetAccelX;
-    float targetAccelY;
-    float targetAccelZ;
-    
-    // 現在の加速度
-    float currentAccelX;
-    float currentAccelY;
-    float currentAccelZ;
-#endif
-    
-    // 角度積分用
-    unsigned long lastUpdateTime;
-    
     // 制御有効フラグ
     bool enablePitchControl;
     bool enableRollControl;
     bool enableYawControl;
-    
-    // フィルター用
-    float pitchFilter;
-    float rollFilter;
-    
+
+#ifdef LOOP_PROFILER_ENABLED
+    LoopProfiler* profiler;     // step()の中の推定とPIDの区切りを記録する（nullptrなら記録しない）
+#endif
+
+    void profileStage(LoopStage stage) {
+#ifdef LOOP_PROFILER_ENABLED
+        if (profiler) profiler->endStage(stage);
+#else
+        (void)stage;
+#endif
+    }
+
+    static void setAxis(ControlAxisOutput& axis, ControlValue value, const ControlPID& pid) {
+        axis.value = fromControlValue(value);
+        axis.p = pid.getLastP();
+        axis.i = pid.getLastI();
+        axis.d = pid.getLastD();
+    }
+
+    // 選ばれているモードで目標を決めて舵を計算する（モードの型ごとに展開される）
+    template <typename Mode>
+    void runMode(Mode& control, const ControlInputs& inputs) {
+        if (inputs.hold || transferPending) control.holdCurrent();
+        control.setTargetOffsets(inputs.targetOffset);
+        control.setTargetRates(inputs.targetRate);
+        if (transferPending) {
+            control.transfer(outputs);
+            transferPending = false;
+        }
+        if (enablePitchControl) setAxis(outputs.elevator, control.computeElevator(lastStep), control.getPitchPID());
+        if (enableRollControl) setAxis(outputs.aileron, control.computeAileron(lastStep), control.getRollPID());
+        if (enableYawControl) setAxis(outputs.rudder, control.computeRudder(lastStep), control.getYawPID());
+    }
+
 public:
     AutoControl();
-    
-    // 初期化
-    void begin();
-    
-    // 目標値設定
-#ifdef USE_ANGLE_CONTROL
-    void setTargets(float pitch, float roll, float yaw);
-    void setTargetPitch(float pitch) { targetPitch = pitch; }
-    void setTargetRoll(float roll) { targetRoll = roll; }
-    void setTargetYaw(float yaw) { targetYaw = yaw; }
-#endif
 
-#ifdef USE_ACCEL_CONTROL
-    void setAccelTargets(float accelX, float accelY, float accelZ);
-    void setTargetAccelX(float accelX) { targetAccelX = accelX; }
-    void setTargetAccelY(float accelY) { targetAccelY = accelY; }
-    void setTargetAccelZ(float accelZ) { targetAccelZ = accelZ; }
+    // 初期化（controlRateHz: step()を呼ぶ周期）
+    void begin(uint16_t controlRateHz);
+
+    // 周期の計測（step()の推定をfilter、PIDをpidのステージとして記録する。リリースビルドでは何もしない）
+    void setProfiler(LoopProfiler* loopProfiler) {
+#ifdef LOOP_PROFILER_ENABLED
+        profiler = loopProfiler;
+#else
+        (void)loopProfiler;
 #endif
-    
-    // 制御実行
-    void update(MPU6050& mpu);
-    
-    // 制御出力取得
-    float getElevatorOutput();  // ピッチ制御出力
-    float getRudderOutput();    // ヨー制御出力
-    float getAileronOutput();   // ロール制御出力（将来用）
-    
-    // PIDパラメータ設定
-    void setPitchPID(float kp, float ki, float kd);
-    void setRollPID(float kp, float ki, float kd);
-    void setYawPID(float kp, float ki, float kd);
-    
+    }
+
+    // モード切り替え（次のstep()で、舵が連続するようにPIDの状態を引き継ぐ）
+    void setMode(ControlMode newMode);
+    ControlMode getMode() const { return mode; }
+
+    // 加速度制御の間の姿勢推定（既定で有効）
+    // 止めると加速度制御の周期毎のコストは加速度制御だけの時と同じになるが、その間の姿勢は更新されず、
+    // 角度制御に戻した周期の姿勢は加速度の1サンプルから取り直す（学習したジャイロのバイアスも失う）
+    void setBackgroundEstimation(bool enabled);
+    bool isBackgroundEstimationEnabled() const { return backgroundEstimation; }
+    static const char* getModeName(ControlMode mode);
+
+    // 1周期分の制御（deltaMicros: スケジューラが計測した周期[μs]）
+    // 推定の更新 → 目標値 → 全PIDを1回ずつ計算し、結果を返す
+    const ControlOutputs& step(uint32_t deltaMicros, const ControlInputs& inputs) {
+        if (deltaMicros == 0) return outputs;
+        lastStep = toControlStep(deltaMicros);
+        accelMode.update(inputs);
+        if (mode == CONTROL_MODE_ACCEL) {
+            if (backgroundEstimation) angleMode.updateBackground(inputs, deltaMicros);
+            profileStage(STAGE_FILTER);
+            runMode(accelMode, inputs);
+        } else {
+            angleMode.update(inputs, deltaMicros, lastStep);
+            profileStage(STAGE_FILTER);
+            runMode(angleMode, inputs);
+        }
+        profileStage(STAGE_PID);
+        return outputs;
+    }
+
+    // 制御していない周期（パススルー中）: 推定だけを続ける（姿勢推定は外側ループの周期に間引く）
+    // 地上で静止している間にジャイロのバイアスを学習し、制御を始めた周期の姿勢を1サンプルの加速度で決めないようにする
+    void observe(uint32_t deltaMicros, const ControlInputs& inputs) {
+        if (deltaMicros == 0) return;
+        accelMode.update(inputs);
+        angleMode.updateBackground(inputs, deltaMicros);
+        profileStage(STAGE_FILTER);
+        // 制御していない間のモード切り替えは、次に制御を始めた時の目標の取り直しで足りる
+        transferPending = false;
+    }
+
+    // 直近のstep()の結果（読むだけ）
+    const ControlOutputs& getOutputs() const { return outputs; }
+    float getElevatorOutput() const { return outputs.elevator.value; }  // ピッチ制御出力
+    float getRudderOutput() const { return outputs.rudder.value; }      // ヨー制御出力
+    float getAileronOutput() const { return outputs.aileron.value; }    // ロール制御出力（将来用）
+
+    // 目標値（角度制御[度]）
+    float getTargetPitch() const { return angleMode.getTargetPitch(); }
+    float getTargetRoll() const { return angleMode.getTargetRoll(); }
+    float getTargetYaw() const { return angleMode.getTargetYaw(); }
+
+    // 目標値（加速度制御[g]）
+    float getTargetAccelX() const { return accelMode.getTargetAccelX(); }
+    float getTargetAccelY() const { return accelMode.getTargetAccelY(); }
+    float getTargetAccelZ() const { return accelMode.getTargetAccelZ(); }
+
+    // モード毎のゲイン設定など
+    AngleModeControl& getAngleMode() { return angleMode; }
+    AccelModeControl& getAccelMode() { return accelMode; }
+
     // 制御有効/無効
     void enableControl(bool pitch, bool roll, bool yaw);
-    
-#ifdef USE_ANGLE_CONTROL
+
     // 現在の角度取得
-    float getCurrentPitch() const { return currentPitch; }
-    float getCurrentRoll() const { return currentRoll; }
-    float getCurrentYaw() const { return currentYaw; }
-#endif
+    float getCurrentPitch() const { return angleMode.getCurrentPitch(); }
+    float getCurrentRoll() const { return angleMode.getCurrentRoll(); }
+    float getCurrentYaw() const { return angleMode.getCurrentYaw(); }
 
-#ifdef USE_ACCEL_CONTROL
     // 現在の加速度取得
-    float getCurrentAccelX() const { return currentAccelX; }
-    float getCurrentAccelY() const { return currentAccelY; }
-    float getCurrentAccelZ() const { return currentAccelZ; }
-#endif
-    
-    // デバッグ情報
-    void printDebugInfo();
-    
-    // リセット
+    float getCurrentAccelX() const { return accelMode.getCurrentAccelX(); }
+    float getCurrentAccelY() const { return accelMode.getCurrentAccelY(); }
+    float getCurrentAccelZ() const { return accelMode.getCurrentAccelZ(); }
+
+    // 動作モード名（起動ログ用）
+    const char* getModeName() const { return getModeName(mode); }
+
+    // 制御をやめた時: PIDと目標値、出力だけをリセットする（推定は続ける）
+    void resetControl();
+
+    // 推定を含めた全体のリセット（IMUの値が途切れた時など）
     void reset();
 };
 
@@ -0,0 +1,284 @@
+#include "blackbox.h"
+#include <string.h>
+#include "telemetry.h"
+
+static const float TERM_SCALE = 100.0f;
+static const float PULSE_SCALE = 10.0f;
+
+// 値を倍率付きでint16に変換（範囲外は飽和）
+static int16_t toFixed16(float value, float scale) {
+    float scaled = value * scale;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static uint16_t toUnsigned16(float value) {
+    if (value > 65535.0f) return 0xFFFF;
+    if (value < 0) return 0;
+    return (uint16_t)(value + 0.5f);
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t value) {
+    p = putU16(p, value & 0xFFFF);
+    return putU16(p, value >> 16);
+}
+
+static uint8_t* putFloat(uint8_t* p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return putU32(p, bits);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+static float getFloat(const uint8_t* p) {
+    uint32_t bits = getU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 角度は0.01度、加速度は0.001g単位（テレメトリと同じ）
+static float attitudeScale(uint8_t flags) {
+    return (flags & TELEMETRY_FLAG_ACCEL_MODE) ? 1000.0f : 100.0f;
+}
+
+void encodeBlackboxRecord(const BlackboxSample& sample, uint8_t* out) {
+    float scale = attitudeScale(sample.flags);
+    uint8_t* p = out;
+    *p++ = BLACKBOX_RECORD_CONTROL;
+    *p++ = (sample.flags & 0x3F) | (sample.rcFrames << 6);
+    p = putU32(p, sample.timeMicros);
+    for (int i = 0; i < 3; i++) p = putFloat(p, sample.acc[i]);
+    for (int i = 0; i < 3; i++) p = putFloat(p, sample.gyro[i]);
+    for (int i = 0; i < 3; i++) p = putU16(p, sample.rcPulse[i]);
+    for (int i = 0; i < 2; i++) p = putU16(p, sample.rcAge[i]);
+    for (int i = 0; i < 2; i++) p = putU16(p, sample.rcPeriod[i]);
+    for (int i = 0; i < 3; i++) p = putU16(p, toFixed16(sample.attitude[i], scale));
+    for (int i = 0; i < 3; i++) p = putU16(p, toFixed16(sample.target[i], scale));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.pTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.iTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.dTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toUnsigned16(sample.servoPulse[i] * PULSE_SCALE));
+    p = putU16(p, toUnsigned16((float)sample.dtMicros));
+    p = putU16(p, toUnsigned16((float)sample.execMicros));
+    p = putU16(p, toUnsigned16((float)sample.jitterMicros));
+    putU16(p, telemetryCrc16(out, BLACKBOX_RECORD_SIZE - 2));
+}
+
+bool decodeBlackboxRecord(const uint8_t* data, BlackboxSample& sample) {
+    if (data[0] != BLACKBOX_RECORD_CONTROL) return false;
+    if (telemetryCrc16(data, BLACKBOX_RECORD_SIZE - 2) != getU16(data + BLACKBOX_RECORD_SIZE - 2)) return false;
+
+    const uint8_t* p = data + 1;
+    sample.flags = *p & 0x3F;
+    sample.rcFrames = *p++ >> 6;
+    sample.timeMicros = getU32(p); p += 4;
+    float scale = attitudeScale(sample.flags);
+    for (int i = 0; i < 3; i++, p += 4) sample.acc[i] = getFloat(p);
+    for (int i = 0; i < 3; i++, p += 4) sample.gyro[i] = getFloat(p);
+    for (int i = 0; i < 3; i++, p += 2) sample.rcPulse[i] = getU16(p);
+    for (int i = 0; i < 2; i++, p += 2) sample.rcAge[i] = getU16(p);
+    for (int i = 0; i < 2; i++, p += 2) sample.rcPeriod[i] = getU16(p);
+    for (int i = 0; i < 3; i++, p += 2) sample.attitude[i] = (int16_t)getU16(p) / scale;
+    for (int i = 0; i < 3; i++, p += 2) sample.target[i] = (int16_t)getU16(p) / scale;
+    for (int i = 0; i < 2; i++, p += 2) sample.pTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.iTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.dTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.servoPulse[i] = getU16(p) / PULSE_SCALE;
+    sample.dtMicros = getU16(p); p += 2;
+    sample.execMicros = getU16(p); p += 2;
+    sample.jitterMicros = getU16(p);
+    return true;
+}
+
+void encodeBlackboxHeader(const BlackboxSectorHeader& header, uint8_t* out) {
+    uint8_t* p = putU32(out, BLACKBOX_MAGIC);
+    p = putU32(p, header.sequence);
+    p = putU16(p, header.session);
+    *p++ = BLACKBOX_FORMAT;
+    *p++ = BLACKBOX_RECORD_SIZE;
+    p = putU16(p, 0);
+    putU16(p, telemetryCrc16(out, BLACKBOX_HEADER_SIZE - 2));
+}
+
+bool decodeBlackboxHeader(const uint8_t* data, BlackboxSectorHeader& header) {
+    if (getU32(data) != BLACKBOX_MAGIC || data[10] != BLACKBOX_FORMAT || data[11] != BLACKBOX_RECORD_SIZE) {
+        return false;
+    }
+    if (telemetryCrc16(data, BLACKBOX_HEADER_SIZE - 2) != getU16(data + BLACKBOX_HEADER_SIZE - 2)) return false;
+    header.sequence = getU32(data + 4);
+    header.session = getU16(data + 8);
+    return true;
+}
+
+BlackboxLog::BlackboxLog(FlashStorage& flash)
+    : flash(flash), sectorSize(0), sectorCount(0), ready(false), prepared(false),
+      sequence(0), session(0), newestSector(0), sector(0), sectorUsed(0), regionStart(0), regionSize(0), erasedAhead(0),
+      batchLength(0), failed(false), recordCount(0), sectorsUsed(0), fullDrops(0), errorCount(0) {
+}
+
+bool BlackboxLog::readHeader(uint32_t index, BlackboxSectorHeader& header) {
+    uint8_t raw[BLACKBOX_HEADER_SIZE];
+    return flash.read(index * sectorSize, raw, sizeof(raw)) && decodeBlackboxHeader(raw, header);
+}
+
+bool BlackboxLog::begin() {
+    sectorSize = flash.sectorSize();
+    sectorCount = sectorSize > 0 ? flash.size() / sectorSize : 0;
+    if (sectorCount < 2 || sectorSize < BLACKBOX_HEADER_SIZE + BLACKBOX_RECORD_SIZE) return false;
+
+    // 通し番号が最大のセクターが最後に書いたところ
+    bool found = false;
+    uint32_t newestSequence = 0;
+    uint16_t newestSession = 0;
+    newestSector = sectorCount;
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        BlackboxSectorHeader header;
+        if (!readHeader(i, header)) continue;
+        if (!found || header.sequence > newestSequence) {
+            found = true;
+            newestSequence = header.sequence;
+            newestSession = header.session;
+            newestSector = i;
+        }
+    }
+    sequence = found ? newestSequence + 1 : 0;
+    session = found ? newestSession + 1 : 0;
+    ready = true;
+    return true;
+}
+
+bool BlackboxLog::prepare() {
+    if (!ready || prepared || failed) return prepared;
+
+    // 前回のセッションのセクター数（最後に書いたセクターから通し番号を遡る、最大で半分）
+    uint32_t kept = 0;
+    uint32_t start = 0;
+    if (newestSector < sectorCount) {
+        start = (newestSector + 1) % sectorCount;
+        uint32_t index = newestSector;
+        uint32_t expected = sequence - 1;
+        BlackboxSectorHeader header;
+        while (kept < sectorCount / 2 && readHeader(index, header) &&
+               header.session == (uint16_t)(session - 1) && header.sequence == expected) {
+            kept++;
+            expected--;
+            index = (index + sectorCount - 1) % sectorCount;
+        }
+    }
+
+    // 残りを今回の領域にする（消去はeraseAhead()で地上にいる間に少しずつ）
+    regionStart = start;
+    regionSize = sectorCount - kept;
+    sectorUsed = 0;
+    erasedAhead = 0;
+    prepared = true;
+    return true;
+}
+
+bool BlackboxLog::eraseAhead() {
+    if (!prepared || failed || erasedAhead >= eraseLimit()) return false;
+    // 消去済みの領域のすぐ後ろから（パーティションの終わりと今回の領域の終わりで区切る）
+    uint32_t offset = sectorsUsed + erasedAhead;
+    uint32_t first = regionSector(offset);
+    uint32_t count = eraseLimit() - erasedAhead;
+    if (count > ERASE_STEP_SECTORS) count = ERASE_STEP_SECTORS;
+    if (count > sectorCount - first) count = sectorCount - first;
+    if (count > regionSize - offset % regionSize) count = regionSize - offset % regionSize;
+    if (!flash.erase(first * sectorSize, count * sectorSize)) {
+        errorCount++;
+        failed = true;
+        return false;
+    }
+    erasedAhead += count;
+    return true;
+}
+
+bool BlackboxLog::openNextSector() {
+    sector = regionSector(sectorsUsed);
+    sectorUsed = 0;
+    erasedAhead--;
+    uint8_t raw[BLACKBOX_HEADER_SIZE];
+    BlackboxSectorHeader header = { sequence, session };
+    encodeBlackboxHeader(header, raw);
+    if (!flash.write(sector * sectorSize, raw, sizeof(raw))) return false;
+    sequence++;
+    sectorUsed = BLACKBOX_HEADER_SIZE;
+    sectorsUsed++;
+    return true;
+}
+
+// 1回の書き込みはページの境目まで（ページプログラム1回分）。残りはbatchの先頭に詰めて次に書く
+bool BlackboxLog::flushBatch() {
+    if (batchLength == 0) return true;
+    uint32_t address = sector * sectorSize + sectorUsed;
+    uint32_t length = FLASH_PAGE_SIZE - address % FLASH_PAGE_SIZE;
+    if (length > batchLength) length = batchLength;
+    bool ok = flash.write(address, batch, length);
+    sectorUsed += length;
+    batchLength -= length;
+    memmove(batch, batch + length, batchLength);
+    if (!ok) {
+        errorCount++;
+        failed = true;
+        batchLength = 0;
+    }
+    return ok;
+}
+
+// ページ毎に分けて書くので、書き込みの間に優先度の高い制御タスクが割り込める
+bool BlackboxLog::flushAll() {
+    while (batchLength > 0) {
+        if (!flushBatch()) return false;
+    }
+    return true;
+}
+
+void BlackboxLog::drain(BlackboxQueue& queue) {
+    if (!prepared) return;
+    BlackboxSample sample;
+    while (queue.pop(sample)) {
+        // 書き込みに失敗したら以降は捨てる（失敗する度に次のセクターを消去して回らないように）
+        if (failed) continue;
+        // セクターに入りきらなければ次のセクターへ（レコードはセクターをまたがない）
+        if (sectorUsed == 0 || sectorUsed + batchLength + BLACKBOX_RECORD_SIZE > sectorSize) {
+            if (!flushAll()) continue;
+            // 消去済みの領域を使い切ったら捨てる（飛行中は消去しない。地上に戻って消去が進めば続きから書く）
+            if (erasedAhead == 0) {
+                fullDrops++;
+                continue;
+            }
+            if (!openNextSector()) {
+                errorCount++;
+                failed = true;
+                continue;
+            }
+        }
+        encodeBlackboxRecord(sample, batch + batchLength);
+        batchLength += BLACKBOX_RECORD_SIZE;
+        recordCount++;
+        if (batchLength == sizeof(batch)) flushAll();
+    }
+    // 溜まった分は毎回書く（電源が切れても直前まで残るように）
+    flushAll();
+}
+
+void BlackboxLog::service(BlackboxQueue& queue) {
+    if (queue.isEnabled() && !prepared && !failed) prepare();
+    if (queue.isEraseAllowed()) eraseAhead();
+    drain(queue);
+}
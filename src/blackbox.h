@@ -0,0 +1,159 @@
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "spsc_ring.h"
+#include "flash_storage.h"
+
+// フライトレコーダー（ブラックボックス）
+// 制御周期毎の状態をRAMのリングバッファに積み、低優先度タスクがフラッシュの専用パーティションにまとめて書く
+//
+// フラッシュ上の形式（数値はすべてリトルエンディアン）
+//   セクター: [ヘッダー16バイト][レコード80バイト × n]（4KBセクターなら51レコードで隙間なし）
+//   ヘッダー: magic "BBX1"(u32), 通し番号(u32), セッション番号(u16), 形式(u8), レコード長(u8), 予約(u16), CRC16(u16)
+//   レコード: [種類(u8)][flags(u8、上位2ビットはrcFrames)][本体][CRC16]。種類が0xFF（消去したまま）の位置でそのセクターは終わり
+// セクターは通し番号の順に環状に使い、毎回前回の続きから書くので、消去回数は全セクターで揃う
+// CRCはテレメトリと同じCRC-16/CCITT-FALSE
+
+static const uint32_t BLACKBOX_MAGIC = 0x31584242;     // "BBX1"
+static const uint8_t BLACKBOX_FORMAT = 3;             // 2: IMUをfloatのまま記録、3: 受信機のフレームの時刻
+static const uint8_t BLACKBOX_RECORD_CONTROL = 0x01;
+static const uint8_t BLACKBOX_HEADER_SIZE = 16;
+static const uint8_t BLACKBOX_RECORD_SIZE = 80;
+
+// 1周期分の記録（制御タスク側では変換せずにそのまま詰める）
+struct BlackboxSample {
+    uint32_t timeMicros;
+    uint8_t flags;          // TELEMETRY_FLAG_*と同じ
+    float acc[3];           // AutoControlに渡したIMUの値（補正後）[g]
+    float gyro[3];          // [deg/s]
+    uint16_t rcPulse[3];    // 受信機のパルス幅（エレベーター/ラダー/LED）[μs]
+    uint8_t rcFrames;       // この周期に新しいフレームが届いた軸（ビット0: エレベーター、1: ラダー）
+    uint16_t rcAge[2];      // エレベーター/ラダーのフレームが届いてからの時間[μs]（RcConditionerの補間の再生用）
+    uint16_t rcPeriod[2];   // フレーム周期[μs]
+    float attitude[3];      // ピッチ/ロール/ヨー[deg]（加速度モードではX/Y/Z[g]）
+    float target[3];
+    float pTerm[2];         // エレベーター/ラダーのPID各項
+    float iTerm[2];
+    float dTerm[2];
+    float servoPulse[2];    // エレベーター/ラダーのサーボに出したパルス幅[μs]
+    uint32_t dtMicros;      // 実測周期
+    uint32_t execMicros;    // 周期内の処理時間
+    uint32_t jitterMicros;  // 予定時刻からの遅れ
+};
+
+struct BlackboxSectorHeader {
+    uint32_t sequence;      // 書いた順の通し番号（電源を切っても続きから）
+    uint16_t session;       // 記録を始める毎に1増える
+};
+
+// IMUはfloatのまま（replayで制御コードに同じ値を入れ直すため）、角度は0.01度、PID項は0.01、パルス幅は0.1μs単位
+void encodeBlackboxRecord(const BlackboxSample& sample, uint8_t* out);
+bool decodeBlackboxRecord(const uint8_t* data, BlackboxSample& sample);
+void encodeBlackboxHeader(const BlackboxSectorHeader& header, uint8_t* out);
+bool decodeBlackboxHeader(const uint8_t* data, BlackboxSectorHeader& header);
+
+// 制御タスクから書き込みタスクへ渡すキュー
+// 満杯なら捨てて数える（制御タスクは決して待たない）
+class BlackboxQueue {
+private:
+    static const uint32_t CAPACITY = 128;   // 500Hzで256ms分（地上でセクターを消去する間に溜まる分）
+    SpscRing<BlackboxSample, CAPACITY> ring;
+    volatile bool enabled;
+    volatile bool eraseAllowed;
+
+public:
+    BlackboxQueue() : enabled(false), eraseAllowed(false) {}
+
+    // 記録の開始/停止（既定は停止。開始するまでは積んでも捨てる）
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // フラッシュの消去を許すか（制御タスクが毎周期設定する。地上のパススルー中だけtrue）
+    // 消去の間はキャッシュが止まり制御ループも止まるので、制御中や飛行中は消去しない
+    void setEraseAllowed(bool allowed) { eraseAllowed = allowed; }
+    bool isEraseAllowed() const { return eraseAllowed; }
+
+    // 制御タスク側
+    void push(const BlackboxSample& sample) {
+        if (enabled) ring.push(sample);
+    }
+
+    // 書き込みタスク側
+    bool pop(BlackboxSample& sample) { return ring.pop(sample); }
+
+    uint32_t size() const { return ring.size(); }
+    uint32_t getDropCount() const { return ring.getDropCount(); }
+    static uint32_t capacity() { return CAPACITY; }
+};
+
+// フラッシュへの書き込み（書き込みタスクから呼ぶ。フラッシュの消去・書き込みの間は待つ）
+// 消去・書き込みの間はCPUのキャッシュが止まり、制御ループも止まる
+//   begin():      各セクターのヘッダーを読み、最後に書いた位置とセッションを探す
+//   prepare():    前回のセッション（最大で領域の半分）を残し、残りを今回のセッションの領域にする（ここでは消去しない）
+//   eraseAhead(): 書いている位置の先をERASE_STEP_SECTORSずつ消去する。地上（キューのisEraseAllowed()）の間だけ呼ぶ
+//                 今回の領域の中で環状に進み、地上で待つ間の古いレコードは消して、離陸までに書いている所以外を消去済みにする
+//   drain():      キューのレコードを書く。1回のフラッシュへの書き込みは1ページまで（制御ループが止まるのは1ページ分）
+//                 消去済みの領域を使い切ったら、飛行中に消去はせずにレコードを捨てて数える
+//   service():    書き込みタスクの1回分（上の3つを順に）
+class BlackboxLog {
+public:
+    static const uint32_t BATCH_RECORDS = 16;   // まとめて変換するレコード数
+    static const uint32_t ERASE_STEP_SECTORS = 4;   // 1回の消去のセクター数（約180ms、キューが溢れない量）
+
+private:
+    FlashStorage& flash;
+    uint32_t sectorSize;
+    uint32_t sectorCount;
+    bool ready;
+    bool prepared;
+
+    uint32_t sequence;          // 次に開くセクターの通し番号
+    uint16_t session;           // 今回のセッション番号
+    uint32_t newestSector;      // begin()の時点で最後に書かれていたセクター（なければsectorCount）
+    uint32_t sector;            // 書き込み中のセクター
+    uint32_t sectorUsed;        // 書き込み中のセクターの使用バイト数（0なら未使用）
+    uint32_t regionStart;       // 今回のセッションの領域（前回のセッションの後ろから環状に）
+    uint32_t regionSize;
+    uint32_t erasedAhead;       // 次のセクターから消去済みの数
+
+    uint8_t batch[BATCH_RECORDS * BLACKBOX_RECORD_SIZE];
+    uint32_t batchLength;
+    bool failed;                // 書き込みに失敗した（以降は記録しない）
+
+    uint32_t recordCount;
+    uint32_t sectorsUsed;       // 今回のセッションで開いたセクター数
+    uint32_t fullDrops;         // 消去済みの領域を使い切って捨てたレコード数
+    uint32_t errorCount;
+
+    uint32_t regionSector(uint32_t offset) const { return (regionStart + offset % regionSize) % sectorCount; }
+    uint32_t eraseLimit() const { return regionSize - (sectorsUsed > 0 ? 1 : 0); }
+    bool openNextSector();
+    bool flushBatch();
+    bool flushAll();
+    bool readHeader(uint32_t index, BlackboxSectorHeader& header);
+
+public:
+    explicit BlackboxLog(FlashStorage& flash);
+
+    bool begin();
+    bool prepare();
+    bool eraseAhead();
+    void drain(BlackboxQueue& queue);
+    void service(BlackboxQueue& queue);
+
+    bool isReady() const { return ready; }
+    bool isPrepared() const { return prepared; }
+    bool isFailed() const { return failed; }
+    uint16_t getSession() const { return session; }
+    uint32_t getSectorCount() const { return sectorCount; }
+    uint32_t getRecordsPerSector() const { return (sectorSize - BLACKBOX_HEADER_SIZE) / BLACKBOX_RECORD_SIZE; }
+    uint32_t getRecordCount() const { return recordCount; }
+    uint32_t getSectorsUsed() const { return sectorsUsed; }
+    uint32_t getErasePending() const { return prepared ? eraseLimit() - erasedAhead : 0; }
+    uint32_t getFullDrops() const { return fullDrops; }
+    uint32_t getErrorCount() const { return errorCount; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#include "blackbox_writer.h"
+
+BlackboxWriter::BlackboxWriter(BlackboxQueue& queue, BlackboxLog& log)
+    : queue(queue), log(log), task(nullptr) {
+}
+
+bool BlackboxWriter::begin(UBaseType_t priority) {
+    if (task != nullptr) return true;
+    return xTaskCreate(taskEntry, "blackbox", STACK_SIZE, this, priority, &task) == pdPASS;
+}
+
+void BlackboxWriter::taskEntry(void* arg) {
+    BlackboxWriter* writer = static_cast<BlackboxWriter*>(arg);
+    while (true) {
+        writer->log.service(writer->queue);
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+    }
+}
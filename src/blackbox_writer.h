@@ -0,0 +1,27 @@
+#ifndef BLACKBOX_WRITER_H
+#define BLACKBOX_WRITER_H
+
+#include <Arduino.h>
+#include "blackbox.h"
+
+// ブラックボックスのキューを低優先度タスクでフラッシュへ書き出す
+// 記録が有効になったら消去の予定を立て（prepare）、地上にいる間に少しずつ消去しながら、溜まった分を書く
+class BlackboxWriter {
+private:
+    BlackboxQueue& queue;
+    BlackboxLog& log;
+    TaskHandle_t task;
+
+    static const uint32_t DRAIN_INTERVAL_MS = 20;
+    static const uint32_t STACK_SIZE = 3072;
+
+    static void taskEntry(void* arg);
+
+public:
+    BlackboxWriter(BlackboxQueue& queue, BlackboxLog& log);
+
+    // 書き込みタスクを起動（priorityは制御ループより低くする）
+    bool begin(UBaseType_t priority);
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include "boot_sequencer.h"
+
+bool BootSequencer::poll() {
+    if (isDone()) return true;
+    if (stages[current].step()) {
+        trace.mark(stages[current].name);
+        current++;
+    }
+    return isDone();
+}
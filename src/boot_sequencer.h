@@ -0,0 +1,39 @@
+#ifndef BOOT_SEQUENCER_H
+#define BOOT_SEQUENCER_H
+
+// 起動処理の段階的な実行
+// サーボと受信機だけsetup()で立ち上げ、残り（IMU、補正値、ディスプレイ）は
+// 制御ループの各周期で1段階ずつ少しだけ進める。その間もパススルーは動く
+
+#include <stdint.h>
+#include "boot_trace.h"
+
+class BootSequencer {
+public:
+    // 1回の呼び出しで少しだけ処理し、その段階が終わったらtrueを返す
+    typedef bool (*StepFunc)();
+
+    struct Stage {
+        const char* name;
+        StepFunc step;
+    };
+
+private:
+    const Stage* stages;
+    uint8_t stageCount;
+    uint8_t current;
+    BootTrace& trace;
+
+public:
+    BootSequencer(const Stage* stages, uint8_t stageCount, BootTrace& trace)
+        : stages(stages), stageCount(stageCount), current(0), trace(trace) {}
+
+    // 現在の段階を1回進める（終わった段階はトレースに記録）
+    // 全段階が終わったらtrue
+    bool poll();
+
+    bool isDone() const { return current >= stageCount; }
+    const char* getCurrentStageName() const { return isDone() ? "done" : stages[current].name; }
+};
+
+#endif
@@ -0,0 +1,13 @@
+#include "boot_trace.h"
+
+void BootTrace::mark(const char* name) {
+    if (count >= MAX_STEPS) return;
+    steps[count].name = name;
+    steps[count].micros = clock.micros();
+    count++;
+}
+
+uint32_t BootTrace::getDuration(uint8_t index) const {
+    if (index == 0) return steps[0].micros;
+    return steps[index].micros - steps[index - 1].micros;
+}
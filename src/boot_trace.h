@@ -0,0 +1,37 @@
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+// 起動処理の各段階にかかった時間の記録
+// 時刻はリセットからの経過時間（Clock::micros()）
+
+#include <stdint.h>
+#include "clock.h"
+
+class BootTrace {
+public:
+    static const uint8_t MAX_STEPS = 16;
+
+private:
+    struct Step {
+        const char* name;
+        uint32_t micros;
+    };
+
+    Clock& clock;
+    Step steps[MAX_STEPS];
+    uint8_t count;
+
+public:
+    BootTrace(Clock& clock) : clock(clock), count(0) {}
+
+    // 直前の段階の終わりを記録
+    void mark(const char* name);
+
+    uint8_t getCount() const { return count; }
+    const char* getName(uint8_t index) const { return steps[index].name; }
+    uint32_t getMicros(uint8_t index) const { return steps[index].micros; }
+    // その段階だけの時間（最初の段階はリセットから）
+    uint32_t getDuration(uint8_t index) const;
+};
+
+#endif
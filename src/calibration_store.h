@@ -0,0 +1,28 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include <stdint.h>
+
+// IMUの補正値（起動時に読み込み、静止中に更新して保存する）
+struct ImuCalibration {
+    static const uint16_t VERSION = 1;
+
+    uint16_t version;
+    float gyroOffset[3];    // [deg/s]
+    float accelOffset[3];   // [g]
+    float temperature;      // 補正値を求めた時のセンサー温度[℃]
+};
+
+// 補正値の保存先のインターフェース
+class CalibrationStore {
+public:
+    virtual ~CalibrationStore() {}
+
+    // 保存済みの値を読み込む（無い、または形式が違う場合はfalse）
+    virtual bool load(ImuCalibration& calibration) = 0;
+
+    // 保存を依頼する（実装によっては書き込みを後で行う）
+    virtual void save(const ImuCalibration& calibration) = 0;
+};
+
+#endif
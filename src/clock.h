@@ -0,0 +1,26 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+// 時刻源のインターフェース
+// 制御ループのスケジューラやdt計算をホスト上で差し替えられるようにする
+class Clock {
+public:
+    virtual ~Clock() {}
+
+    // 起動からの経過時間（マイクロ秒、32bitで折り返す）
+    virtual uint32_t micros() = 0;
+
+    // CPUサイクルカウンタ（32bitで折り返す）と1マイクロ秒あたりのサイクル数
+    virtual uint32_t cycleCount() = 0;
+    virtual uint32_t cyclesPerMicro() = 0;
+
+    // 指定時間だけ待機（実機ではタイマーで起床、ホストでは時刻を進める）
+    virtual void delayMicros(uint32_t us) = 0;
+
+    // 待機中のdelayMicros()を時間前に終わらせる（割り込みから呼ぶ。待機していなければ次の待機がすぐ終わる）
+    virtual void wakeFromIsr() {}
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "control_mode.h"
+
+// カスケードの既定ゲイン { kp, ki, kd }（ピッチは host の bench cascade で調整、ロール/ヨーは控えめな値）
+// 外側: 角度誤差1度あたりの目標角速度[deg/s]
+static const float PITCH_ANGLE_GAINS[3] = { 8.0f, 0.0f, 0.0f };
+static const float ROLL_ANGLE_GAINS[3] = { 6.0f, 0.0f, 0.0f };
+static const float YAW_ANGLE_GAINS[3] = { 2.0f, 0.0f, 0.0f };
+static const float PITCH_MAX_RATE = 180.0f;    // 目標角速度の上限[deg/s]
+static const float ROLL_MAX_RATE = 180.0f;
+static const float YAW_MAX_RATE = 45.0f;
+
+// 内側: 角速度誤差1deg/sあたりの舵[%]（定常の誤差は内側の積分で消す）
+static const float PITCH_RATE_GAINS[3] = { 3.0f, 6.0f, 0.02f };
+static const float ROLL_RATE_GAINS[3] = { 1.5f, 3.0f, 0.01f };
+static const float YAW_RATE_GAINS[3] = { 0.8f, 1.0f, 0.01f };
+
+// スティックによる目標角度の変化率を目標角速度に足す割合
+// （1.0では補間の1フレームで角度の変化分を全部出し、SITLのstepで行き過ぎを抑え込み過ぎて目標に届かない）
+static const float STICK_FEEDFORWARD = 0.5f;
+
+// 内側の微分項のローパス（ジャイロのノイズと機体の振動を落とす）
+static const DerivativeFilterType RATE_DTERM_FILTER = DERIVATIVE_FILTER_BIQUAD;
+static const float RATE_DTERM_CUTOFF_HZ = 80.0f;
+
+// 加速度制御のゲイン（調整が必要）
+static const float ACCEL_GAINS[3] = { 2.0f, 0.1f, 0.05f };
+
+AngleModeControl::AngleModeControl()
+    : pitchAnglePID(PITCH_ANGLE_GAINS[0], PITCH_ANGLE_GAINS[1], PITCH_ANGLE_GAINS[2]),
+      rollAnglePID(ROLL_ANGLE_GAINS[0], ROLL_ANGLE_GAINS[1], ROLL_ANGLE_GAINS[2]),
+      yawAnglePID(YAW_ANGLE_GAINS[0], YAW_ANGLE_GAINS[1], YAW_ANGLE_GAINS[2]),
+      pitchRateTarget(0), rollRateTarget(0), yawRateTarget(0),
+      stickFeedForward(STICK_FEEDFORWARD), pitchRateFeedForward(0), rollRateFeedForward(0), yawRateFeedForward(0),
+      pitchRatePID(PITCH_RATE_GAINS[0], PITCH_RATE_GAINS[1], PITCH_RATE_GAINS[2]),
+      rollRatePID(ROLL_RATE_GAINS[0], ROLL_RATE_GAINS[1], ROLL_RATE_GAINS[2]),
+      yawRatePID(YAW_RATE_GAINS[0], YAW_RATE_GAINS[1], YAW_RATE_GAINS[2]),
+      pitchRate(0), rollRate(0), yawRate(0),
+      basePitch(0), baseRoll(0), baseYaw(0),
+      targetPitch(0), targetRoll(0), targetYaw(0),
+      angleLoopElapsed(0), angleLoopStep(toControlStep(ANGLE_LOOP_PERIOD_MICROS)),
+      angleLoopPending(AXIS_ALL), backgroundGyro{ 0, 0, 0 }, backgroundMicros(0) {
+}
+
+void AngleModeControl::begin(uint16_t controlRateHz) {
+    // 内側（角速度）ループの出力制限
+    pitchRatePID.setOutputLimits(-90, 90);  // エレベーター出力制限
+    rollRatePID.setOutputLimits(-90, 90);   // エルロン出力制限
+    yawRatePID.setOutputLimits(-90, 90);    // ラダー出力制限
+    pitchRatePID.setDerivativeFilter(RATE_DTERM_FILTER, RATE_DTERM_CUTOFF_HZ, controlRateHz);
+    rollRatePID.setDerivativeFilter(RATE_DTERM_FILTER, RATE_DTERM_CUTOFF_HZ, controlRateHz);
+    yawRatePID.setDerivativeFilter(RATE_DTERM_FILTER, RATE_DTERM_CUTOFF_HZ, controlRateHz);
+
+    // 外側（角度）ループの出力制限 = 目標角速度の上限
+    pitchAnglePID.setOutputLimits(-PITCH_MAX_RATE, PITCH_MAX_RATE);
+    rollAnglePID.setOutputLimits(-ROLL_MAX_RATE, ROLL_MAX_RATE);
+    yawAnglePID.setOutputLimits(-YAW_MAX_RATE, YAW_MAX_RATE);
+}
+
+void AngleModeControl::transfer(const ControlOutputs& previous) {
+    // 外側はここで1回計算して目標角速度を決め、内側はその目標角速度と今の角速度で舵を引き継ぐ
+    // （PIDの入力はローパス後の角度なので、目標との差は0にならない）
+    pitchAnglePID.reset();
+    rollAnglePID.reset();
+    yawAnglePID.reset();
+    pitchRateTarget = pitchAnglePID.calculate(toControlValue(targetPitch), angleFilter.getSmoothPitch(), angleLoopStep);
+    rollRateTarget = rollAnglePID.calculate(toControlValue(targetRoll), angleFilter.getSmoothRoll(), angleLoopStep);
+    yawRateTarget = yawAnglePID.calculate(toControlValue(targetYaw), angleFilter.getYaw(), angleLoopStep);
+    pitchRatePID.preset(toControlValue(previous.elevator.value), pitchRateTarget + pitchRateFeedForward, pitchRate);
+    rollRatePID.preset(toControlValue(previous.aileron.value), rollRateTarget + rollRateFeedForward, rollRate);
+    yawRatePID.preset(toControlValue(previous.rudder.value), yawRateTarget + yawRateFeedForward, yawRate);
+    angleLoopElapsed = 0;
+    angleLoopPending = 0;
+}
+
+void AngleModeControl::resetControl() {
+    pitchAnglePID.reset();
+    rollAnglePID.reset();
+    yawAnglePID.reset();
+    pitchRatePID.reset();
+    rollRatePID.reset();
+    yawRatePID.reset();
+    pitchRateTarget = rollRateTarget = yawRateTarget = 0;
+    pitchRateFeedForward = rollRateFeedForward = yawRateFeedForward = 0;
+    basePitch = baseRoll = baseYaw = 0;
+    targetPitch = targetRoll = targetYaw = 0;
+    angleLoopElapsed = 0;
+    angleLoopPending = AXIS_ALL;
+}
+
+void AngleModeControl::resetEstimate() {
+    angleFilter.reset();
+    backgroundGyro[0] = backgroundGyro[1] = backgroundGyro[2] = 0;
+    backgroundMicros = 0;
+}
+
+void AngleModeControl::reset() {
+    resetEstimate();
+    resetControl();
+}
+
+void AngleModeControl::setPitchAnglePID(float kp, float ki, float kd, float maxRate) {
+    pitchAnglePID.setGains(kp, ki, kd);
+    pitchAnglePID.setOutputLimits(-maxRate, maxRate);
+}
+
+void AngleModeControl::setRollAnglePID(float kp, float ki, float kd, float maxRate) {
+    rollAnglePID.setGains(kp, ki, kd);
+    rollAnglePID.setOutputLimits(-maxRate, maxRate);
+}
+
+void AngleModeControl::setYawAnglePID(float kp, float ki, float kd, float maxRate) {
+    yawAnglePID.setGains(kp, ki, kd);
+    yawAnglePID.setOutputLimits(-maxRate, maxRate);
+}
+
+AccelModeControl::AccelModeControl()
+    : pitchPID(ACCEL_GAINS[0], ACCEL_GAINS[1], ACCEL_GAINS[2]),
+      rollPID(ACCEL_GAINS[0], ACCEL_GAINS[1], ACCEL_GAINS[2]),
+      yawPID(ACCEL_GAINS[0], ACCEL_GAINS[1], ACCEL_GAINS[2]),
+      baseAccelX(0), baseAccelY(0), baseAccelZ(-1.0),  // Z軸は重力分
+      targetAccelX(0), targetAccelY(0), targetAccelZ(-1.0) {
+}
+
+void AccelModeControl::begin() {
+    // 角度制御より小さな出力制限
+    pitchPID.setOutputLimits(-50, 50);  // エレベーター出力制限
+    rollPID.setOutputLimits(-50, 50);   // エルロン出力制限
+    yawPID.setOutputLimits(-30, 30);    // ラダー出力制限
+}
+
+void AccelModeControl::transfer(const ControlOutputs& previous) {
+    // 出力制限を超える分は制限される
+    pitchPID.preset(toControlValue(previous.elevator.value), toControlValue(targetAccelX), accelFilter.getX());
+    rollPID.preset(toControlValue(previous.aileron.value), toControlValue(targetAccelY), accelFilter.getY());
+    yawPID.preset(toControlValue(previous.rudder.value), toControlValue(targetAccelZ), accelFilter.getZ());
+}
+
+void AccelModeControl::resetControl() {
+    pitchPID.reset();
+    rollPID.reset();
+    yawPID.reset();
+    baseAccelX = baseAccelY = 0;
+    baseAccelZ = -1.0;
+    targetAccelX = targetAccelY = 0;
+    targetAccelZ = -1.0;
+}
+
+void AccelModeControl::reset() {
+    accelFilter.reset();
+    resetControl();
+}
@@ -0,0 +1,338 @@
+#ifndef CONTROL_MODE_H
+#define CONTROL_MODE_H
+
+// 自動制御のモード（全てのモードを常にビルドし、AutoControlが実行時に切り替える）
+// 各モードは同じ名前の非仮想メソッドを持ち、AutoControlはモードを判定してから直接呼ぶ（仮想関数は使わない）
+// 制御周期毎に呼ぶメソッドはAutoControlの中に展開されるようヘッダーに書く
+
+#include <stdint.h>
+#include "pid_controller.h"
+#include "fixed_pid_controller.h"
+#include "attitude_filter.h"
+#include "imu_sensor.h"
+
+// 演算方式ごとの型（モードの処理は型の違いだけで共通）
+#ifdef USE_FIXED_POINT
+typedef q16_t ControlValue;
+typedef Q16TimeStep ControlStep;
+typedef FixedPIDController ControlPID;
+typedef FixedAngleFilter ControlAngleFilter;
+typedef FixedAccelFilter ControlAccelFilter;
+inline ControlValue toControlValue(float value) { return q16FromFloat(value); }
+inline float fromControlValue(ControlValue value) { return q16ToFloat(value); }
+inline ControlStep toControlStep(uint32_t micros) { return q16TimeStep(micros); }
+#else
+typedef float ControlValue;
+typedef float ControlStep;
+typedef PIDController ControlPID;
+typedef AngleFilter ControlAngleFilter;
+typedef AccelFilter ControlAccelFilter;
+inline ControlValue toControlValue(float value) { return value; }
+inline float fromControlValue(ControlValue value) { return value; }
+inline ControlStep toControlStep(uint32_t micros) { return micros * 1e-6f; }
+#endif
+
+enum ControlMode : uint8_t {
+    CONTROL_MODE_ANGLE = 0,     // 角度制御（カスケード）
+    CONTROL_MODE_ACCEL,         // 加速度制御
+    CONTROL_MODE_COUNT
+};
+
+// 1周期分の入力（AutoControl::stepに渡す）
+struct ControlInputs {
+    float acc[3];           // 加速度 X/Y/Z[g]
+    float gyro[3];          // 角速度 X/Y/Z[deg/s]
+    float targetOffset[3];  // 基準の目標値からのずれ（角度制御: ピッチ/ロール/ヨー[度]、加速度制御: X/Y/Z[g]）
+    float targetRate[3];    // targetOffsetの変化率[/秒]（スティックを動かしている間のフィードフォワード）
+    bool hold;              // この周期の推定値を基準の目標値にする（制御を始めた周期）
+
+    void setImu(ImuSensor& imu) {
+        acc[0] = imu.getAccX();
+        acc[1] = imu.getAccY();
+        acc[2] = imu.getAccZ();
+        gyro[0] = imu.getGyroX();
+        gyro[1] = imu.getGyroY();
+        gyro[2] = imu.getGyroZ();
+    }
+};
+
+// 1軸分の出力とPIDの各項（テレメトリ用）
+struct ControlAxisOutput {
+    float value;        // 舵[%]
+    float p, i, d;
+};
+
+// 1周期分の出力（step()で1回だけ計算し、モード切り替えでは次のモードへ引き継ぐ）
+struct ControlOutputs {
+    ControlAxisOutput elevator;
+    ControlAxisOutput aileron;
+    ControlAxisOutput rudder;
+};
+
+// 角度制御はカスケード構成
+//   外側: 角度の誤差 → 目標角速度[deg/s]（ANGLE_LOOP_RATE_HZに間引いて計算）
+//   内側: 目標角速度とジャイロの差 → 舵（制御周期ごと、500Hz以上を推奨）
+// 外乱（突風など）はジャイロに先に現れるため、内側のループですぐに打ち消せる
+class AngleModeControl {
+public:
+    static const uint16_t ANGLE_LOOP_RATE_HZ = 100;
+
+private:
+    static const uint32_t ANGLE_LOOP_PERIOD_MICROS = 1000000 / ANGLE_LOOP_RATE_HZ;
+    static const uint8_t AXIS_PITCH = 0x01;
+    static const uint8_t AXIS_ROLL = 0x02;
+    static const uint8_t AXIS_YAW = 0x04;
+    static const uint8_t AXIS_ALL = AXIS_PITCH | AXIS_ROLL | AXIS_YAW;
+
+    // 現在の角度（姿勢推定器で計算）
+    ControlAngleFilter angleFilter;
+
+    // 外側の角度ループ（出力は目標角速度）
+    ControlPID pitchAnglePID;
+    ControlPID rollAnglePID;
+    ControlPID yawAnglePID;
+    ControlValue pitchRateTarget;
+    ControlValue rollRateTarget;
+    ControlValue yawRateTarget;
+
+    // 目標角度の変化率をそのまま目標角速度に足す（外側ループの間引きと誤差の発生を待たない）
+    float stickFeedForward;
+    ControlValue pitchRateFeedForward;
+    ControlValue rollRateFeedForward;
+    ControlValue yawRateFeedForward;
+
+    // 内側の角速度ループ（出力が舵）
+    ControlPID pitchRatePID;
+    ControlPID rollRatePID;
+    ControlPID yawRatePID;
+
+    // 現在の角速度（ジャイロそのまま、フィルターなし）
+    ControlValue pitchRate;
+    ControlValue rollRate;
+    ControlValue yawRate;
+
+    // 目標角度 = 基準（制御開始時の姿勢） + ずれ（RC入力）
+    float basePitch, baseRoll, baseYaw;
+    float targetPitch;
+    float targetRoll;
+    float targetYaw;
+
+    // 外側ループの間引き
+    uint32_t angleLoopElapsed;      // 前回の外側ループからの経過時間[μs]
+    ControlStep angleLoopStep;      // 外側ループの周期
+    uint8_t angleLoopPending;       // 外側ループを計算する軸（軸毎のビット）
+
+    // 他のモードの間の姿勢推定（外側ループの周期に間引く）
+    float backgroundGyro[3];        // 間引いた区間の角速度の積算[deg/s × μs]
+    uint32_t backgroundMicros;      // 間引いた区間の長さ[μs]
+
+    void flushBackground(const ControlInputs& inputs) {
+        float scale = 1.0f / backgroundMicros;
+        rollRate = toControlValue(backgroundGyro[0] * scale);
+        pitchRate = toControlValue(backgroundGyro[1] * scale);
+        yawRate = toControlValue(backgroundGyro[2] * scale);
+        angleFilter.update(toControlValue(inputs.acc[0]), toControlValue(inputs.acc[1]),
+                           toControlValue(inputs.acc[2]), rollRate, pitchRate, yawRate,
+                           toControlStep(backgroundMicros));
+        backgroundGyro[0] = backgroundGyro[1] = backgroundGyro[2] = 0;
+        backgroundMicros = 0;
+    }
+
+    ControlValue runCascade(ControlPID& anglePID, ControlPID& ratePID, ControlValue& rateTarget,
+                            ControlValue rateFeedForward, uint8_t axisBit, float targetAngle,
+                            ControlValue angle, ControlValue rate, const ControlStep& step) {
+        // 外側は間引いた周期の時だけ目標角速度を更新し、それ以外は前回の値を使う
+        if (angleLoopPending & axisBit) {
+            angleLoopPending &= ~axisBit;
+            rateTarget = anglePID.calculate(toControlValue(targetAngle), angle, angleLoopStep);
+        }
+        return ratePID.calculate(rateTarget + rateFeedForward, rate, step);
+    }
+
+public:
+    AngleModeControl();
+    // controlRateHz: computeElevatorなどを呼ぶ周期（内側ループの微分フィルターの設計に使う）
+    void begin(uint16_t controlRateHz);
+
+    // 姿勢推定と外側ループの間引き（このモードが選ばれている間、毎周期呼ぶ）
+    void update(const ControlInputs& inputs, uint32_t deltaMicros, const ControlStep& step) {
+        // 他のモードから切り替わった周期は、間引いていた残りの区間を先に反映する
+        if (backgroundMicros > 0) flushBackground(inputs);
+        rollRate = toControlValue(inputs.gyro[0]);
+        pitchRate = toControlValue(inputs.gyro[1]);
+        yawRate = toControlValue(inputs.gyro[2]);
+        angleFilter.update(toControlValue(inputs.acc[0]), toControlValue(inputs.acc[1]),
+                           toControlValue(inputs.acc[2]), rollRate, pitchRate, yawRate, step);
+
+        // 周期の揺らぎで1回飛ばさないよう3/4周期で判定
+        angleLoopElapsed += deltaMicros;
+        if (angleLoopElapsed >= ANGLE_LOOP_PERIOD_MICROS * 3 / 4) {
+            angleLoopStep = toControlStep(angleLoopElapsed);
+            angleLoopElapsed = 0;
+            angleLoopPending = AXIS_ALL;
+        }
+    }
+
+    // 他のモードが選ばれている間（毎周期呼ぶ）: 切り替えた時にすぐ使えるよう姿勢推定だけを続ける
+    // 推定は外側ループの周期（ANGLE_LOOP_RATE_HZ）に間引き、角速度は区間の平均を使う
+    void updateBackground(const ControlInputs& inputs, uint32_t deltaMicros) {
+        backgroundGyro[0] += inputs.gyro[0] * deltaMicros;
+        backgroundGyro[1] += inputs.gyro[1] * deltaMicros;
+        backgroundGyro[2] += inputs.gyro[2] * deltaMicros;
+        backgroundMicros += deltaMicros;
+        if (backgroundMicros >= ANGLE_LOOP_PERIOD_MICROS * 3 / 4) flushBackground(inputs);
+    }
+
+    // 舵の計算（PIDを1周期進める。モードが選ばれている時に1周期1回だけ呼ぶ）
+    ControlValue computeElevator(const ControlStep& step) {
+        return runCascade(pitchAnglePID, pitchRatePID, pitchRateTarget, pitchRateFeedForward, AXIS_PITCH,
+                          targetPitch, angleFilter.getSmoothPitch(), pitchRate, step);
+    }
+    ControlValue computeAileron(const ControlStep& step) {
+        return runCascade(rollAnglePID, rollRatePID, rollRateTarget, rollRateFeedForward, AXIS_ROLL,
+                          targetRoll, angleFilter.getSmoothRoll(), rollRate, step);
+    }
+    ControlValue computeRudder(const ControlStep& step) {
+        return runCascade(yawAnglePID, yawRatePID, yawRateTarget, yawRateFeedForward, AXIS_YAW,
+                          targetYaw, angleFilter.getYaw(), yawRate, step);
+    }
+
+    // 現在の姿勢を基準の目標値にする
+    void holdCurrent() {
+        basePitch = getCurrentPitch();
+        baseRoll = getCurrentRoll();
+        baseYaw = getCurrentYaw();
+    }
+    void setTargetOffsets(const float offsets[3]) {
+        targetPitch = basePitch + offsets[0];
+        targetRoll = baseRoll + offsets[1];
+        targetYaw = baseYaw + offsets[2];
+    }
+    void setTargetRates(const float rates[3]) {
+        pitchRateFeedForward = toControlValue(rates[0] * stickFeedForward);
+        rollRateFeedForward = toControlValue(rates[1] * stickFeedForward);
+        yawRateFeedForward = toControlValue(rates[2] * stickFeedForward);
+    }
+
+    // 目標角度の変化率を目標角速度に足す割合（0で無効、1で目標の動きにそのまま追従させる）
+    void setStickFeedForward(float gain) { stickFeedForward = gain; }
+    float getStickFeedForward() const { return stickFeedForward; }
+
+    // 他のモードから切り替わった時: 今の目標のまま、舵がpreviousから続くようにPIDを設定する
+    void transfer(const ControlOutputs& previous);
+    // 姿勢推定だけのリセット（次のupdate()で加速度から姿勢を取り直す）
+    void resetEstimate();
+    // PIDと目標値だけをリセットする（姿勢推定は続ける）
+    void resetControl();
+    void reset();
+
+    float getTargetPitch() const { return targetPitch; }
+    float getTargetRoll() const { return targetRoll; }
+    float getTargetYaw() const { return targetYaw; }
+
+    // 外側の角度ループのゲインと目標角速度の上限[deg/s]
+    void setPitchAnglePID(float kp, float ki, float kd, float maxRate);
+    void setRollAnglePID(float kp, float ki, float kd, float maxRate);
+    void setYawAnglePID(float kp, float ki, float kd, float maxRate);
+
+    // 内側の角速度ループのゲイン
+    void setPitchRatePID(float kp, float ki, float kd) { pitchRatePID.setGains(kp, ki, kd); }
+    void setRollRatePID(float kp, float ki, float kd) { rollRatePID.setGains(kp, ki, kd); }
+    void setYawRatePID(float kp, float ki, float kd) { yawRatePID.setGains(kp, ki, kd); }
+
+    // 現在の角度
+    float getCurrentPitch() const { return fromControlValue(angleFilter.getPitch()); }
+    float getCurrentRoll() const { return fromControlValue(angleFilter.getRoll()); }
+    float getCurrentYaw() const { return fromControlValue(angleFilter.getYaw()); }
+
+    // 現在の角速度と外側ループが出した目標角速度[deg/s]
+    float getCurrentPitchRate() const { return fromControlValue(pitchRate); }
+    float getCurrentRollRate() const { return fromControlValue(rollRate); }
+    float getCurrentYawRate() const { return fromControlValue(yawRate); }
+    float getPitchRateTarget() const { return fromControlValue(pitchRateTarget); }
+    float getRollRateTarget() const { return fromControlValue(rollRateTarget); }
+    float getYawRateTarget() const { return fromControlValue(yawRateTarget); }
+
+    // 舵を出すPID（テレメトリ用）
+    const ControlPID& getPitchPID() const { return pitchRatePID; }
+    const ControlPID& getRollPID() const { return rollRatePID; }
+    const ControlPID& getYawPID() const { return yawRatePID; }
+
+    // 姿勢推定器の切り替え・調整用
+    ControlAngleFilter& getAngleFilter() { return angleFilter; }
+};
+
+// 加速度制御（ローパス後の加速度を直接PIDで舵にする）
+class AccelModeControl {
+private:
+    ControlAccelFilter accelFilter;
+    ControlPID pitchPID;    // X軸 → エレベーター
+    ControlPID rollPID;     // Y軸 → エルロン
+    ControlPID yawPID;      // Z軸 → ラダー
+
+    // 目標加速度[g] = 基準（制御開始時の加速度） + ずれ（RC入力）
+    float baseAccelX, baseAccelY, baseAccelZ;
+    float targetAccelX;
+    float targetAccelY;
+    float targetAccelZ;
+
+public:
+    AccelModeControl();
+    void begin();
+
+    // 加速度のローパス（モードに関係なく毎周期呼ぶ）
+    void update(const ControlInputs& inputs) {
+        accelFilter.update(toControlValue(inputs.acc[0]), toControlValue(inputs.acc[1]),
+                           toControlValue(inputs.acc[2]));
+    }
+
+    // 舵の計算（PIDを1周期進める）
+    ControlValue computeElevator(const ControlStep& step) {
+        return pitchPID.calculate(toControlValue(targetAccelX), accelFilter.getX(), step);
+    }
+    ControlValue computeAileron(const ControlStep& step) {
+        return rollPID.calculate(toControlValue(targetAccelY), accelFilter.getY(), step);
+    }
+    ControlValue computeRudder(const ControlStep& step) {
+        return yawPID.calculate(toControlValue(targetAccelZ), accelFilter.getZ(), step);
+    }
+
+    // 現在の加速度を基準の目標値にする
+    void holdCurrent() {
+        baseAccelX = getCurrentAccelX();
+        baseAccelY = getCurrentAccelY();
+        baseAccelZ = getCurrentAccelZ();
+    }
+    void setTargetOffsets(const float offsets[3]) {
+        targetAccelX = baseAccelX + offsets[0];
+        targetAccelY = baseAccelY + offsets[1];
+        targetAccelZ = baseAccelZ + offsets[2];
+    }
+    // 加速度は舵にすぐ現れるので、目標の変化率のフィードフォワードは使わない
+    void setTargetRates(const float rates[3]) { (void)rates; }
+
+    // 他のモードから切り替わった時: 今の目標のまま、舵がpreviousから続くようにPIDを設定する
+    void transfer(const ControlOutputs& previous);
+    // PIDと目標値だけをリセットする（加速度のローパスは続ける）
+    void resetControl();
+    void reset();
+
+    float getTargetAccelX() const { return targetAccelX; }
+    float getTargetAccelY() const { return targetAccelY; }
+    float getTargetAccelZ() const { return targetAccelZ; }
+
+    void setPitchPID(float kp, float ki, float kd) { pitchPID.setGains(kp, ki, kd); }
+    void setRollPID(float kp, float ki, float kd) { rollPID.setGains(kp, ki, kd); }
+    void setYawPID(float kp, float ki, float kd) { yawPID.setGains(kp, ki, kd); }
+
+    // 現在の加速度（ローパス後）
+    float getCurrentAccelX() const { return fromControlValue(accelFilter.getX()); }
+    float getCurrentAccelY() const { return fromControlValue(accelFilter.getY()); }
+    float getCurrentAccelZ() const { return fromControlValue(accelFilter.getZ()); }
+
+    const ControlPID& getPitchPID() const { return pitchPID; }
+    const ControlPID& getRollPID() const { return rollPID; }
+    const ControlPID& getYawPID() const { return yawPID; }
+};
+
+#endif
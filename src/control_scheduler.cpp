@@ -0,0 +1,85 @@
+#include "control_scheduler.h"
+
+ControlScheduler::ControlScheduler(Clock& clock, uint16_t rate_hz)
+    : clock(clock), rateHz(100), periodMicros(10000),
+      started(false), nextTickTime(0), lastTickTime(0), deltaMicros(10000) {
+    setRate(rate_hz);
+    resetStats();
+}
+
+bool ControlScheduler::isSupportedRate(uint16_t rate_hz) {
+    return rate_hz == 100 || rate_hz == 250 || rate_hz == 500 || rate_hz == 1000;
+}
+
+bool ControlScheduler::setRate(uint16_t rate_hz) {
+    if (!isSupportedRate(rate_hz)) return false;
+    
+    rateHz = rate_hz;
+    periodMicros = 1000000UL / rate_hz;
+    
+    // 動作中なら次回予定を新しい周期で取り直す
+    if (started) {
+        nextTickTime = lastTickTime + periodMicros;
+    }
+    return true;
+}
+
+void ControlScheduler::begin() {
+    uint32_t now = clock.micros();
+    nextTickTime = now;
+    lastTickTime = now - periodMicros;  // 初回dtは公称周期
+    deltaMicros = periodMicros;
+    started = true;
+    resetStats();
+}
+
+bool ControlScheduler::poll() {
+    if (!started) begin();
+    
+    uint32_t now = clock.micros();
+    
+    // 折り返しを考慮して符号付きで比較
+    int32_t late = (int32_t)(now - nextTickTime);
+    if (late < 0) return false;
+    
+    deltaMicros = now - lastTickTime;
+    lastTickTime = now;
+    lastJitterMicros = (uint32_t)late;
+    if (lastJitterMicros > maxJitterMicros) maxJitterMicros = lastJitterMicros;
+    tickCount++;
+    
+    nextTickTime += periodMicros;
+    
+    // 1周期以上遅れた場合は取りこぼした分を捨てて再同期（連続実行しない）
+    if ((int32_t)(now - nextTickTime) >= 0) {
+        overrunCount++;
+        nextTickTime = now + periodMicros;
+    }
+    return true;
+}
+
+void ControlScheduler::waitForTick() {
+    while (!poll()) {
+        clock.delayMicros(getTimeUntilNextTick());
+    }
+}
+
+bool ControlScheduler::waitForTickOrWake() {
+    if (poll()) return true;
+    clock.delayMicros(getTimeUntilNextTick());
+    return poll();
+}
+
+uint32_t ControlScheduler::getTimeUntilNextTick() {
+    if (!started) return 0;
+    
+    int32_t remaining = (int32_t)(nextTickTime - clock.micros());
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+void ControlScheduler::resetStats() {
+    lastJitterMicros = 0;
+    maxJitterMicros = 0;
+    overrunCount = 0;
+    tickCount = 0;
+}
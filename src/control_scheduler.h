@@ -0,0 +1,63 @@
+#ifndef CONTROL_SCHEDULER_H
+#define CONTROL_SCHEDULER_H
+
+#include <stdint.h>
+#include "clock.h"
+
+// 固定周期の制御スケジューラ
+// 絶対時刻で次回予定を管理するため、処理時間が変わっても周期がずれない
+class ControlScheduler {
+private:
+    Clock& clock;
+    uint16_t rateHz;
+    uint32_t periodMicros;
+    
+    bool started;
+    uint32_t nextTickTime;      // 次回の予定時刻
+    uint32_t lastTickTime;      // 前回ティックの実時刻
+    uint32_t deltaMicros;       // 前回ティックからの実測間隔
+    
+    // ジッタ統計
+    uint32_t lastJitterMicros;  // 予定時刻からの遅れ
+    uint32_t maxJitterMicros;
+    uint32_t overrunCount;      // 1周期以上遅れた回数
+    uint32_t tickCount;
+
+public:
+    ControlScheduler(Clock& clock, uint16_t rate_hz);
+    
+    // 対応周期（100/250/500/1000Hz）以外はfalse
+    static bool isSupportedRate(uint16_t rate_hz);
+    bool setRate(uint16_t rate_hz);
+    
+    // 計測開始（最初のティックは即時）
+    void begin();
+    
+    // 予定時刻に達していればtrueを返し、dtを更新する
+    bool poll();
+    
+    // 次のティックまで待機してからdtを更新する
+    void waitForTick();
+    
+    // waitForTick()と同じだが、Clock::wakeFromIsr()で起こされたらティック前でもfalseを返す
+    bool waitForTickOrWake();
+    
+    // 次回予定時刻までの残り時間（マイクロ秒、過ぎていれば0）
+    uint32_t getTimeUntilNextTick();
+    
+    // 実測dt
+    uint32_t getDeltaMicros() const { return deltaMicros; }
+    float getDeltaTime() const { return deltaMicros * 1e-6f; }
+    
+    uint16_t getRate() const { return rateHz; }
+    uint32_t getPeriodMicros() const { return periodMicros; }
+    
+    // 統計
+    uint32_t getLastJitter() const { return lastJitterMicros; }
+    uint32_t getMaxJitter() const { return maxJitterMicros; }
+    uint32_t getOverrunCount() const { return overrunCount; }
+    uint32_t getTickCount() const { return tickCount; }
+    void resetStats();
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "control_tick.h"
+
+static float limitOutput(float value) {
+    if (value > CONTROL_OUTPUT_LIMIT) return CONTROL_OUTPUT_LIMIT;
+    if (value < -CONTROL_OUTPUT_LIMIT) return -CONTROL_OUTPUT_LIMIT;
+    return value;
+}
+
+ControlTickOutput runControlTick(AutoControl& control, const RcConditioner& rc, ControlInputs& inputs,
+                                 uint32_t deltaMicros) {
+    float elevatorInput = rc.getElevatorValue();
+    float rudderInput = rc.getRudderValue();
+
+    // RC入力による目標値の微調整（基準の目標値からのずれ）
+    float stickScale = control.getMode() == CONTROL_MODE_ACCEL ? ACCEL_STICK_SCALE : ANGLE_STICK_SCALE;
+    inputs.targetOffset[0] = elevatorInput * stickScale;
+    inputs.targetOffset[1] = 0;
+    inputs.targetOffset[2] = rudderInput * stickScale;
+    inputs.targetRate[0] = rc.getRate(RC_AXIS_ELEVATOR) * stickScale;
+    inputs.targetRate[1] = 0;
+    inputs.targetRate[2] = rc.getRate(RC_AXIS_RUDDER) * stickScale;
+
+    // 推定の更新と全PIDの計算（1周期1回、以降は結果を読むだけ）
+    const ControlOutputs& outputs = control.step(deltaMicros, inputs);
+
+    // RC入力と制御出力を混合して制限
+    ControlTickOutput result;
+    result.elevator = limitOutput(elevatorInput + outputs.elevator.value);
+    result.rudder = limitOutput(rudderInput + outputs.rudder.value);
+    return result;
+}
+
+void runIdleTick(AutoControl& control, const ControlInputs& inputs, uint32_t deltaMicros, bool imuOk,
+                 bool disengaged) {
+    if (disengaged) control.resetControl();
+    if (imuOk) {
+        control.observe(deltaMicros, inputs);
+    } else {
+        control.reset();
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CONTROL_TICK_H
+#define CONTROL_TICK_H
+
+// 制御中の1周期（スティック → 目標値のずれ、AutoControl、RC入力との混合と出力制限）、制御していない周期の推定と機体の設定
+// 実機（src/main.cpp）とホストのSITL/再生/run（src/host/）で同じ処理と設定を使う
+
+#include <stdint.h>
+#include "auto_control.h"
+#include "rc_conditioner.h"
+#include "servo_output.h"
+
+// サーボのパルス周期（アナログサーボは50Hz、デジタルサーボなら200/333Hzで遅れが減る）
+#ifndef SERVO_FRAME_RATE_HZ
+#define SERVO_FRAME_RATE_HZ 50
+#endif
+
+// サーボ毎の設定（中立、サブトリム、振れ幅、エンドポイント、リバース、周期）[μs]
+static const ServoConfig ELEVATOR_SERVO_CONFIG = { 1500, 0, 500, 1000, 2000, false, SERVO_FRAME_RATE_HZ };
+static const ServoConfig RUDDER_SERVO_CONFIG = { 1500, 0, 500, 1000, 2000, false, SERVO_FRAME_RATE_HZ };
+
+// スティックのカーブ（不感帯[%]、エクスポ）
+static const RcCurveConfig ELEVATOR_RC_CURVE = { 1.0f, 0.0f };
+static const RcCurveConfig RUDDER_RC_CURVE = { 1.0f, 0.0f };
+
+// スティック±100%に対する目標値のずれ（角度制御は±5度、加速度制御は±1g）
+static const float ANGLE_STICK_SCALE = 0.05f;
+static const float ACCEL_STICK_SCALE = 0.01f;
+
+// 混合後の舵の制限[%]
+static const float CONTROL_OUTPUT_LIMIT = 100.0f;
+
+// 1周期分の舵[%]（RC入力 + 制御出力、制限後）
+struct ControlTickOutput {
+    float elevator;
+    float rudder;
+};
+
+// 制御中の1周期
+// inputsにはIMU値（acc/gyro）とholdを入れて渡す。目標値のずれと変化率はrcから埋める
+ControlTickOutput runControlTick(AutoControl& control, const RcConditioner& rc, ControlInputs& inputs,
+                                 uint32_t deltaMicros);
+
+// 制御していない1周期（パススルー中、またはIMUの値が途切れている間）
+// 推定だけを続け、制御をやめた周期（disengaged）にPIDと目標値をリセットする
+// imuOkがfalseの間は推定もリセットし、IMUが戻った時に加速度から推定し直す（途切れていた間の回転は分からない）
+void runIdleTick(AutoControl& control, const ControlInputs& inputs, uint32_t deltaMicros, bool imuOk,
+                 bool disengaged);
+
+#endif
@@ -0,0 +1,62 @@
+#include "derivative_filter.h"
+#include <math.h>
+
+DerivativeFilterCoefficients DerivativeFilterCoefficients::design(DerivativeFilterType type, float cutoffHz,
+                                                                  float sampleRateHz) {
+    DerivativeFilterCoefficients c = {};
+    c.type = type;
+    if (type == DERIVATIVE_FILTER_NONE || cutoffHz <= 0 || sampleRateHz <= 0 || cutoffHz >= sampleRateHz / 2) {
+        c.type = DERIVATIVE_FILTER_NONE;
+        return c;
+    }
+
+    if (type == DERIVATIVE_FILTER_FIRST_ORDER) {
+        // RCローパスの離散化: alpha = dt / (RC + dt)
+        float dt = 1.0f / sampleRateHz;
+        float rc = 1.0f / (2.0f * (float)M_PI * cutoffHz);
+        c.alpha = dt / (rc + dt);
+        return c;
+    }
+
+    // バターワース（Q = 1/√2）
+    const float q = 0.70710678f;
+    float k = tanf((float)M_PI * cutoffHz / sampleRateHz);
+    float norm = 1.0f / (1.0f + k / q + k * k);
+    c.b0 = k * k * norm;
+    c.b1 = 2.0f * c.b0;
+    c.b2 = c.b0;
+    c.a1 = 2.0f * (k * k - 1.0f) * norm;
+    c.a2 = (1.0f - k / q + k * k) * norm;
+    return c;
+}
+
+DerivativeFilter::DerivativeFilter() : coeff(), state1(0), state2(0) {
+    coeff.type = DERIVATIVE_FILTER_NONE;
+}
+
+void DerivativeFilter::configure(DerivativeFilterType type, float cutoffHz, float sampleRateHz) {
+    coeff = DerivativeFilterCoefficients::design(type, cutoffHz, sampleRateHz);
+    reset();
+}
+
+// Q2.30への変換（設定時のみ）
+static int32_t toQ30(float value) {
+    return (int32_t)lroundf(value * 1073741824.0f);
+}
+
+FixedDerivativeFilter::FixedDerivativeFilter()
+    : type(DERIVATIVE_FILTER_NONE), alpha(0), b0(0), b1(0), b2(0), a1(0), a2(0),
+      x1(0), x2(0), y1(0), y2(0) {
+}
+
+void FixedDerivativeFilter::configure(DerivativeFilterType newType, float cutoffHz, float sampleRateHz) {
+    DerivativeFilterCoefficients c = DerivativeFilterCoefficients::design(newType, cutoffHz, sampleRateHz);
+    type = c.type;
+    alpha = toQ30(c.alpha);
+    b0 = toQ30(c.b0);
+    b1 = toQ30(c.b1);
+    b2 = toQ30(c.b2);
+    a1 = toQ30(c.a1);
+    a2 = toQ30(c.a2);
+    reset();
+}
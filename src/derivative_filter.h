@@ -0,0 +1,104 @@
+#ifndef DERIVATIVE_FILTER_H
+#define DERIVATIVE_FILTER_H
+
+// PIDの微分項のローパスフィルター
+// 係数は設定時に制御周期（サンプリング周波数）から一度だけ計算し、制御周期毎は積和だけにする
+
+#include <stdint.h>
+#include "fixed_point.h"
+
+enum DerivativeFilterType : uint8_t {
+    DERIVATIVE_FILTER_NONE = 0,     // フィルターなし
+    DERIVATIVE_FILTER_FIRST_ORDER,  // 1次ローパス
+    DERIVATIVE_FILTER_BIQUAD        // 2次ローパス（バターワース、双一次変換）
+};
+
+// 係数の計算（float/固定小数点で共通）
+struct DerivativeFilterCoefficients {
+    DerivativeFilterType type;
+    float alpha;                // 1次: y += alpha * (x - y)
+    float b0, b1, b2, a1, a2;   // 2次: y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2
+
+    // cutoffHzがサンプリング周波数の半分以上、または0以下ならフィルターなし
+    static DerivativeFilterCoefficients design(DerivativeFilterType type, float cutoffHz, float sampleRateHz);
+};
+
+class DerivativeFilter {
+private:
+    DerivativeFilterCoefficients coeff;
+    float state1, state2;       // 1次: state1 = 前回の出力、2次: 転置直接形IIの状態
+
+public:
+    DerivativeFilter();
+
+    void configure(DerivativeFilterType type, float cutoffHz, float sampleRateHz);
+    DerivativeFilterType getType() const { return coeff.type; }
+
+    // 次の入力から始める（前回の状態を捨てる）
+    void reset(float value = 0) {
+        state1 = value;
+        state2 = 0;
+        if (coeff.type == DERIVATIVE_FILTER_BIQUAD) {
+            // 一定の入力valueで落ち着いた状態
+            state1 = value * (1.0f - coeff.b0);
+            state2 = value * (coeff.b2 - coeff.a2);
+        }
+    }
+
+    float apply(float x) {
+        switch (coeff.type) {
+            case DERIVATIVE_FILTER_FIRST_ORDER:
+                state1 += coeff.alpha * (x - state1);
+                return state1;
+            case DERIVATIVE_FILTER_BIQUAD: {
+                float y = coeff.b0 * x + state1;
+                state1 = coeff.b1 * x - coeff.a1 * y + state2;
+                state2 = coeff.b2 * x - coeff.a2 * y;
+                return y;
+            }
+            default:
+                return x;
+        }
+    }
+};
+
+// 固定小数点版（USE_FIXED_POINT）。係数はQ2.30、積和はint64で行う
+class FixedDerivativeFilter {
+private:
+    DerivativeFilterType type;
+    int32_t alpha;                  // Q2.30
+    int32_t b0, b1, b2, a1, a2;     // Q2.30
+    q16_t x1, x2, y1, y2;           // 2次: 直接形I（整数では丸め誤差が状態に溜まりにくい）
+
+public:
+    FixedDerivativeFilter();
+
+    void configure(DerivativeFilterType type, float cutoffHz, float sampleRateHz);
+    DerivativeFilterType getType() const { return type; }
+
+    void reset(q16_t value = 0) {
+        x1 = x2 = y1 = y2 = value;
+    }
+
+    q16_t apply(q16_t x) {
+        switch (type) {
+            case DERIVATIVE_FILTER_FIRST_ORDER:
+                y1 = q16Add(y1, q16Saturate(((int64_t)alpha * q16Sub(x, y1) + (1 << 29)) >> 30));
+                return y1;
+            case DERIVATIVE_FILTER_BIQUAD: {
+                int64_t acc = (int64_t)b0 * x + (int64_t)b1 * x1 + (int64_t)b2 * x2
+                            - (int64_t)a1 * y1 - (int64_t)a2 * y2;
+                q16_t y = q16Saturate((acc + (1 << 29)) >> 30);
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+                return y;
+            }
+            default:
+                return x;
+        }
+    }
+};
+
+#endif
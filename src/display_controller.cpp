@@ -1,25 +1,89 @@
 #include "display_controller.h"
+#include <string.h>
+#include "fixed_string.h"
 
-// グローバルディスプレイオブジェクト（OLED: SDA=5, SCL=6）
-U8G2_SSD1306_72X40_ER_F_SW_I2C u8g2(U8G2_R0, /* clock=*/ 6, /* data=*/ 5, /* reset=*/ U8X8_PIN_NONE);
+// 描画1行分の処理時間の見積もり（文字描画のみ、転送なし）
+static const uint32_t RENDER_MICROS = 200;
 
-DisplayController::DisplayController(int sda_pin, int scl_pin) {
-    sdaPin = sda_pin;
-    sclPin = scl_pin;
-    display = &u8g2;
+// 積んだ転送がこの時間内に始められなければ捨てて、画面全体を送り直す
+static const uint32_t TRANSFER_TIMEOUT_MICROS = 200000;
+
+// u8g2のバイト転送コールバックから使う（ディスプレイは1台のみ）
+static ManagedI2CBus* displayBus = nullptr;
+static bool synchronousTransfers = false;
+static uint8_t transferBuffer[I2CBusManager::MAX_WRITE_SIZE];
+static uint8_t transferLength = 0;
+static bool transferOverflow = false;
+
+// START_TRANSFERからEND_TRANSFERまでを1トランザクションとしてまとめる
+static uint8_t managedByteCallback(u8x8_t* u8x8, uint8_t msg, uint8_t arg_int, void* arg_ptr) {
+    switch (msg) {
+        case U8X8_MSG_BYTE_INIT:
+        case U8X8_MSG_BYTE_SET_DC:
+            // バスはI2CBusManager側で初期化済み
+            return 1;
+        case U8X8_MSG_BYTE_START_TRANSFER:
+            transferLength = 0;
+            transferOverflow = false;
+            return 1;
+        case U8X8_MSG_BYTE_SEND:
+            if (transferLength + arg_int > sizeof(transferBuffer)) {
+                transferOverflow = true;
+                return 0;
+            }
+            memcpy(transferBuffer + transferLength, arg_ptr, arg_int);
+            transferLength += arg_int;
+            return 1;
+        case U8X8_MSG_BYTE_END_TRANSFER: {
+            if (displayBus == nullptr || transferOverflow) return 0;
+            uint8_t address = u8x8_GetI2CAddress(u8x8) >> 1;
+            if (synchronousTransfers) {
+                return displayBus->write(address, transferBuffer, transferLength) ? 1 : 0;
+            }
+            return displayBus->submitWrite(address, transferBuffer, transferLength,
+                                           TRANSFER_TIMEOUT_MICROS) ? 1 : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+ManagedSsd1306::ManagedSsd1306(ManagedI2CBus& bus) : U8G2() {
+    displayBus = &bus;
+    u8g2_Setup_ssd1306_i2c_72x40_er_f(&u8g2, U8G2_R0, managedByteCallback, u8x8_gpio_and_delay_arduino);
+}
+
+void ManagedSsd1306::setSynchronous(bool synchronous) {
+    synchronousTransfers = synchronous;
+}
+
+DisplayController::DisplayController(ManagedI2CBus& bus) : bus(bus), display(bus) {
     initialized = false;
     lastUpdate = 0;
+    step = STEP_IDLE;
+    renderLine = 0;
+    transferPage = 0;
+    status = {};
+    memset(sentBuffer, 0, sizeof(sentBuffer));
+    memset(forcedTiles, 0, sizeof(forcedTiles));
+    lastFailureCount = 0;
 }
 
 void DisplayController::begin() {
-    // ディスプレイ初期化
-    display->begin();
-    display->clearBuffer();
-    display->setFont(u8g2_font_4x6_tr);  // 小さなフォント
+    // 初期化コマンドのみ送る（u8g2のbegin()は画面全体の消去を同期で送るため使わない）
+    display.setSynchronous(true);
+    display.initDisplay();
+    display.setPowerSave(0);
+    display.setSynchronous(false);
+    display.clearBuffer();
+    display.setFont(u8g2_font_4x6_tr);
     
-    showStartupMessage();
-    display->sendBuffer();
+    // 電源投入直後の画面内容は不定なので、最初は全タイルを送る
+    forceFullRefresh();
+    lastFailureCount = bus.getFailureCount();
     
+    // すぐに最初の画面を描き始める
+    lastUpdate = millis() - DISPLAY_UPDATE_INTERVAL;
     initialized = true;
 }
 
@@ -27,73 +91,109 @@ bool DisplayController::isInitialized() {
     return initialized;
 }
 
-void DisplayController::update() {
-    if (!initialized) return;
-    
-    // 定期的に表示更新
-    if (millis() - lastUpdate >= DISPLAY_UPDATE_INTERVAL) {
-        updateDisplay();
-        lastUpdate = millis();
+void DisplayController::forceFullRefresh() {
+    for (uint8_t page = 0; page < TILE_ROWS; page++) {
+        forcedTiles[page] = (1u << TILE_COLUMNS) - 1;
     }
 }
 
-void DisplayController::updateDisplay() {
-    display->clearBuffer();
-    display->setFont(u8g2_font_4x6_tr);
-    
-    // ライン1: システム状態
-    statusLine = "ESP32-C3 Ready";
-    display->drawStr(0, 8, statusLine.c_str());
-    
-    // ライン2: モード表示
-    modeLine = "Mode: MPU6050";
-    display->drawStr(0, 18, modeLine.c_str());
+void DisplayController::poll(uint32_t idleMicros) {
+    if (!initialized) return;
     
-    // ライン3-4: 固定表示
-    display->drawStr(0, 28, "RC System");
-    display->drawStr(0, 38, "Running...");
+    // 積んだ転送が失敗・期限切れになったら、画面の内容が分からないので全体を送り直す
+    uint32_t failures = bus.getFailureCount();
+    if (failures != lastFailureCount) {
+        lastFailureCount = failures;
+        forceFullRefresh();
+        if (step != STEP_RENDER) {
+            transferPage = 0;
+            step = STEP_TRANSFER;
+        }
+    }
     
-    display->sendBuffer();
+    // 1回の呼び出しで行うのは1行の描画か1ページ分の追加のみ
+    switch (step) {
+        case STEP_IDLE:
+            if (millis() - lastUpdate < DISPLAY_UPDATE_INTERVAL) return;
+            lastUpdate = millis();
+            formatLines();
+            renderLine = 0;
+            step = STEP_RENDER;
+            break;
+        
+        case STEP_RENDER:
+            if (idleMicros < RENDER_MICROS) return;
+            renderNextLine();
+            if (renderLine >= LINE_COUNT) {
+                transferPage = 0;
+                step = STEP_TRANSFER;
+            }
+            break;
+        
+        case STEP_TRANSFER:
+            // 前のページの転送が終わるまで待つ（キューを1ページ分以上使わない）
+            if (bus.getPendingCount() > 0) return;
+            if (!queueNextPage()) {
+                step = STEP_IDLE;
+            }
+            break;
+    }
 }
 
-void DisplayController::updateDisplayWithGyroData(float gx, float gy, float gz, float temp) {
-    display->clearBuffer();
-    display->setFont(u8g2_font_4x6_tr);
-    
-    // ライン1: システム状態
-    display->drawStr(0, 8, "ESP32-C3 Ready");
-    
-    // ライン2: モード表示
-    display->drawStr(0, 18, "Mode: MPU6050");
-    
-    // ライン3-4: ジャイロデータ
-    String gyroX = "X:" + String(gx, 1);
-    String gyroY = "Y:" + String(gy, 1);
-    String tempStr = String(temp, 0) + "C";
+void DisplayController::formatLines() {
+    // 固定長バッファに直接組み立てる（Stringやprintfの浮動小数点変換はヒープを使うことがある）
+    for (TextBuffer& line : lines) line.clear();
+    if (status.bootStage != nullptr) {
+        lines[0].add("BOOT ").add(status.bootStage);
+    } else {
+        lines[0].add(status.passthrough ? "PASS " : "AUTO ").add(status.rcValid ? "RC:OK " : "RC:-- ");
+        lines[0].addUnsigned(status.controlRate).add("Hz");
+    }
     
-    display->drawStr(0, 28, gyroX.c_str());
-    display->drawStr(24, 28, gyroY.c_str());
-    display->drawStr(48, 28, tempStr.c_str());
-    display->drawStr(0, 38, ("Z:" + String(gz, 1)).c_str());
+    if (status.imuAvailable) {
+        lines[1].add('P').addFloat(status.pitch, 1, 6, true).add(" R").addFloat(status.roll, 1, 6, true);
+        lines[2].add('Y').addFloat(status.yaw, 1, 6, true).add(' ').addFloat(status.temperature, 1, 5).add('C');
+    } else {
+        lines[1].add("IMU: none");
+    }
     
-    display->sendBuffer();
+    lines[3].add("OVR ").addUnsigned(status.overruns);
 }
 
-void DisplayController::showStartupMessage() {
-    display->clearBuffer();
-    display->setFont(u8g2_font_4x6_tr);
-    display->drawStr(0, 8, "ESP32-C3");
-    display->drawStr(0, 18, "RC System");
-    display->drawStr(0, 28, "I2C:400kHz");
-    display->drawStr(0, 38, "Starting...");
-    display->sendBuffer();
-    delay(800);  // 短縮
+void DisplayController::renderNextLine() {
+    // 行の範囲だけ消してから描く（画面全体のclearBufferはしない）
+    int top = renderLine * LINE_HEIGHT;
+    display.setDrawColor(0);
+    display.drawBox(0, top, TILE_COLUMNS * 8, LINE_HEIGHT);
+    display.setDrawColor(1);
+    display.drawStr(0, top + 8, lines[renderLine].c_str());
+    renderLine++;
 }
 
-void DisplayController::showError(String message) {
-    display->clearBuffer();
-    display->setFont(u8g2_font_4x6_tr);
-    display->drawStr(0, 8, "ERROR:");
-    display->drawStr(0, 18, message.c_str());
-    display->sendBuffer();
+bool DisplayController::queueNextPage() {
+    const uint8_t* buffer = display.getBufferPtr();
+    const uint16_t pageBytes = TILE_COLUMNS * 8;
+    
+    // 変更のあるページを探す（バッファの比較だけなので1回で全ページ見てよい）
+    for (; transferPage < TILE_ROWS; transferPage++) {
+        uint16_t offset = transferPage * pageBytes;
+        int first = -1, last = -1;
+        for (uint8_t tile = 0; tile < TILE_COLUMNS; tile++) {
+            bool forced = (forcedTiles[transferPage] >> tile) & 1;
+            if (forced || memcmp(buffer + offset + tile * 8, sentBuffer + offset + tile * 8, 8) != 0) {
+                if (first < 0) first = tile;
+                last = tile;
+            }
+        }
+        if (first < 0) continue;
+        
+        // 変更のあった範囲（先頭〜末尾のタイル）をまとめて積む
+        uint8_t tiles = last - first + 1;
+        display.updateDisplayArea(first, transferPage, tiles, 1);
+        memcpy(sentBuffer + offset + first * 8, buffer + offset + first * 8, tiles * 8);
+        forcedTiles[transferPage] &= ~(((1u << tiles) - 1) << first);
+        transferPage++;
+        return true;
+    }
+    return false;
 }
@@ -3,34 +3,89 @@
 
 #include <Arduino.h>
 #include <U8g2lib.h>
+#include "i2c_bus_manager.h"
+#include "fixed_string.h"
 
+// 画面に出す状態（制御ループから毎周期渡す）
+struct DisplayStatus {
+    bool passthrough;
+    bool imuAvailable;
+    bool rcValid;
+    float pitch;            // [度]
+    float roll;
+    float yaw;
+    float temperature;      // [℃]
+    uint16_t controlRate;   // [Hz]
+    uint32_t overruns;
+    const char* bootStage;  // 起動中の段階名（起動完了後はnullptr）
+};
+
+// SSD1306 72x40（フルバッファ）
+// u8g2の転送をWireに直接出さず、I2CBusManagerのキューに積む
+class ManagedSsd1306 : public U8G2 {
+public:
+    ManagedSsd1306(ManagedI2CBus& bus);
+    // 初期化コマンドはキューに収まらないため、その間だけ同期で送る
+    void setSynchronous(bool synchronous);
+};
+
+// OLEDの表示
+// MPU6050と同じハードウェアI2Cを使い、制御周期の空き時間に少しずつ描画する
+// 描画は1行ずつ、転送は前回送った内容から変わったタイルだけを1ページ（8ピクセル行）単位でキューに積む
+// 実際の転送はI2CBusManagerが空き時間にトランザクション単位で行う
 class DisplayController {
 private:
-    U8G2_SSD1306_72X40_ER_F_SW_I2C* display;
-    int sdaPin;
-    int sclPin;
+    ManagedI2CBus& bus;
+    ManagedSsd1306 display;
     bool initialized;
     
     // 表示更新間隔
     static constexpr unsigned long DISPLAY_UPDATE_INTERVAL = 500;  // 500ms
     unsigned long lastUpdate;
     
-    // 表示用バッファ
-    String statusLine;
-    String gyroLine;
-    String modeLine;
+    // 画面構成（4x6フォントで18文字 x 4行）
+    static const uint8_t LINE_COUNT = 4;
+    static const uint8_t LINE_HEIGHT = 10;
+    static const uint8_t LINE_LENGTH = 19;
+    static const uint8_t TILE_COLUMNS = 9;    // 72 / 8
+    static const uint8_t TILE_ROWS = 5;       // 40 / 8
+    static const uint16_t BUFFER_SIZE = TILE_COLUMNS * 8 * TILE_ROWS;
+    
+    // 1回の処理単位
+    enum Step {
+        STEP_IDLE,
+        STEP_RENDER,    // 1行描画
+        STEP_TRANSFER,  // 1ページ内の変更タイルをキューに積む
+    };
+    Step step;
+    uint8_t renderLine;
+    uint8_t transferPage;
+    
+    DisplayStatus status;
+    FixedString<LINE_LENGTH> lines[LINE_COUNT];
+    
+    // 最後に転送した画面（変更箇所の検出用）
+    uint8_t sentBuffer[BUFFER_SIZE];
+    uint16_t forcedTiles[TILE_ROWS];    // 内容に関係なく送るタイル（ページ毎のビット）
+    uint32_t lastFailureCount;          // 転送失敗を検出したら全体を送り直す
+    
+    void formatLines();
+    void renderNextLine();
+    void forceFullRefresh();
+    // 1ページ分をキューに積む、送るものがなければfalse
+    bool queueNextPage();
     
 public:
-    DisplayController(int sda_pin, int scl_pin);
+    DisplayController(ManagedI2CBus& bus);
+    // 初期化コマンドだけを送る（画面の転送は空き時間に行う）
     void begin();
-    void update();
     bool isInitialized();
     
-    // 表示内容更新
-    void updateDisplay();
-    void updateDisplayWithGyroData(float gx, float gy, float gz, float temp);
-    void showStartupMessage();
-    void showError(String message);
+    void setStatus(const DisplayStatus& newStatus) { status = newStatus; }
+    
+    // 制御周期の空き時間に呼ぶ（idleMicros: 次の制御周期までの時間）
+    // ここではCPUでの描画とキューへの追加のみ行い、I2Cの転送はI2CBusManager::poll()で行う
+    void poll(uint32_t idleMicros);
 };
 
 #endif
@@ -0,0 +1,99 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+// FPUなしでも軽い近似数学関数（float版）
+// libmのatan2/sqrtはdoubleのソフトウェア演算で非常に遅いため、制御ループではこちらを使う
+// 各関数の最大誤差は下の定数に記載し、単体テスト（test_fast_math.cpp）で全域を走査して確認する
+
+#include <stdint.h>
+#include <string.h>
+
+// fastAtan2Deg の最大絶対誤差[度]
+static const float FAST_ATAN2_MAX_ERROR_DEG = 0.0001f;
+// fastInvSqrt / fastSqrt の最大相対誤差（正規化数の範囲）
+static const float FAST_INVSQRT_MAX_REL_ERROR = 5e-6f;
+static const float FAST_SQRT_MAX_REL_ERROR = 5e-6f;
+
+namespace fast_math_detail {
+
+// コンパイル時のテーブル生成用（doubleで計算し、実行時には使わない）
+constexpr double constSqrt(double x) {
+    double y = x > 1 ? x : 1;
+    for (int i = 0; i < 64; i++) y = 0.5 * (y + x / y);
+    return y;
+}
+
+// atan(z)、0 <= z <= 1
+// 半角公式で引数を小さくしてからテイラー級数を使う
+constexpr double constAtan(double z) {
+    double reduced = z / (1 + constSqrt(1 + z * z));          // atan(z) = 2 atan(reduced)
+    reduced = reduced / (1 + constSqrt(1 + reduced * reduced)); // さらに半分（|reduced| <= 0.2）
+    double term = reduced, sum = 0, square = reduced * reduced;
+    for (int n = 0; n < 30; n++) {
+        sum += (n % 2 == 0 ? term : -term) / (2 * n + 1);
+        term *= square;
+    }
+    return 4 * sum;
+}
+
+// atan(z)[度]の表（z = 0〜1を256分割、線形補間で使う）
+static const int ATAN_TABLE_SIZE = 256;
+
+struct AtanTable {
+    float degrees[ATAN_TABLE_SIZE + 1];
+
+    constexpr AtanTable() : degrees() {
+        for (int i = 0; i <= ATAN_TABLE_SIZE; i++) {
+            degrees[i] = (float)(constAtan((double)i / ATAN_TABLE_SIZE) * 180.0 / 3.14159265358979323846);
+        }
+    }
+};
+
+inline constexpr AtanTable ATAN_TABLE = AtanTable();
+
+}  // namespace fast_math_detail
+
+// 1/sqrt(x)（x <= 0 は0を返す）
+// ビット演算の初期値 + ニュートン法2回（除算なし）
+inline float fastInvSqrt(float x) {
+    if (!(x > 0)) return 0;
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5F375A86u - (bits >> 1);
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    float halfX = 0.5f * x;
+    y = y * (1.5f - halfX * y * y);
+    y = y * (1.5f - halfX * y * y);
+    return y;
+}
+
+// sqrt(x)（x <= 0 は0を返す）
+inline float fastSqrt(float x) {
+    return x * fastInvSqrt(x);
+}
+
+// atan2(y, x)を度で返す（-180〜180、両方0なら0）
+// 比を0〜1に折り返して表を線形補間する。除算は1回
+inline float fastAtan2Deg(float y, float x) {
+    float absX = x < 0 ? -x : x;
+    float absY = y < 0 ? -y : y;
+    bool swapped = absY > absX;
+    float num = swapped ? absX : absY;
+    float den = swapped ? absY : absX;
+    if (den == 0) return 0;
+
+    float position = num / den * fast_math_detail::ATAN_TABLE_SIZE;
+    int index = (int)position;
+    if (index >= fast_math_detail::ATAN_TABLE_SIZE) index = fast_math_detail::ATAN_TABLE_SIZE - 1;
+    float fraction = position - index;
+    const float* table = fast_math_detail::ATAN_TABLE.degrees;
+    float angle = table[index] + (table[index + 1] - table[index]) * fraction;
+
+    if (swapped) angle = 90.0f - angle;
+    if (x < 0) angle = 180.0f - angle;
+    if (y < 0) angle = -angle;
+    return angle;
+}
+
+#endif
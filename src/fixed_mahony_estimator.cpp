@@ -0,0 +1,217 @@
+#include "fixed_mahony_estimator.h"
+
+static const int32_t Q30_ONE = q30Const(1.0);
+static const int64_t DEG_TO_RAD_Q30 = q30Const(0.017453292519943295);
+static const uint32_t REST_CONFIRM_MICROS = 500000;    // これだけ静止が続いたらバイアス追従を始める
+static const int64_t BIAS_LIMIT = (int64_t)(10.0 * 0.017453292519943295 * ((int64_t)1 << 40));  // 10deg/s（Q40）
+static const int32_t REST_GYRO_THRESHOLD = (int32_t)(3.0 * 0.017453292519943295 * (1 << 24));  // 3deg/s（Q24）
+static const int64_t REST_GYRO_THRESHOLD_SQUARED = (int64_t)REST_GYRO_THRESHOLD * REST_GYRO_THRESHOLD;
+
+// Q30の乗算（四捨五入）
+static inline int32_t mulQ30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+// バイアス（Q40）→ Q24
+static inline int32_t biasToQ24(int64_t value) {
+    return (int32_t)((value + (1 << 15)) >> 16);
+}
+
+// [deg/s]（Q16）→ [rad/s]（Q24、±128rad/sで飽和）
+static inline int32_t degToRadQ24(q16_t value) {
+    int64_t rad = ((int64_t)value * DEG_TO_RAD_Q30 + (1 << 21)) >> 22;
+    if (rad > INT32_MAX) return INT32_MAX;
+    if (rad < INT32_MIN) return INT32_MIN;
+    return (int32_t)rad;
+}
+
+FixedMahonyEstimator::FixedMahonyEstimator()
+    : kp(q16Const(0.5)), ki(q16Const(0.1)), accelTolerance(q16Const(0.15)), restBiasRate(q16Const(0.2)) {
+    reset();
+}
+
+void FixedMahonyEstimator::reset() {
+    q[0] = Q30_ONE;
+    q[1] = q[2] = q[3] = 0;
+    bias[0] = bias[1] = bias[2] = 0;
+    restMicros = 0;
+    firstUpdate = true;
+    pitch = roll = yaw = 0;
+    lastWrappedYaw = 0;
+}
+
+void FixedMahonyEstimator::setGains(float newKp, float newKi) {
+    kp = q16FromFloat(newKp);
+    ki = q16FromFloat(newKi);
+}
+
+void FixedMahonyEstimator::setAccelTolerance(float tolerance) {
+    accelTolerance = q16FromFloat(tolerance);
+}
+
+void FixedMahonyEstimator::setRestBiasRate(float rate) {
+    restBiasRate = q16FromFloat(rate);
+}
+
+// 向き (x, y) の単位ベクトル（Q30）。大きさは問わない（2^30〜2^31にそろえてから正規化する）
+static void unitVector(int64_t x, int64_t y, int32_t& cosOut, int32_t& sinOut) {
+    uint64_t largest = (uint64_t)(x < 0 ? -x : x);
+    uint64_t absY = (uint64_t)(y < 0 ? -y : y);
+    if (absY > largest) largest = absY;
+    if (largest == 0) {
+        cosOut = Q30_ONE;
+        sinOut = 0;
+        return;
+    }
+    while (largest >= ((uint64_t)1 << 31)) { x >>= 1; y >>= 1; largest >>= 1; }
+    while (largest < ((uint64_t)1 << 30)) { x <<= 1; y <<= 1; largest <<= 1; }
+    uint32_t length = isqrt64((uint64_t)(x * x) + (uint64_t)(y * y));
+    cosOut = (int32_t)((x << 30) / length);
+    sinOut = (int32_t)((y << 30) / length);
+}
+
+// 単位ベクトル (cosθ, sinθ) から半角の単位ベクトル（三角関数を使わない）
+// 半角の向きは (1 + cosθ, sinθ)。cosθ < 0 では打ち消しを避けて (sinθ, 1 - cosθ) を使う
+static void halfAngle(int32_t cosAngle, int32_t sinAngle, int32_t& cosHalf, int32_t& sinHalf) {
+    if (cosAngle >= 0) {
+        unitVector((int64_t)Q30_ONE + cosAngle, sinAngle, cosHalf, sinHalf);
+    } else if (sinAngle >= 0) {
+        unitVector(sinAngle, (int64_t)Q30_ONE - cosAngle, cosHalf, sinHalf);
+    } else {
+        unitVector(-(int64_t)sinAngle, cosAngle - (int64_t)Q30_ONE, cosHalf, sinHalf);
+    }
+}
+
+// 加速度からロール・ピッチを求め、ヨー0度のクォータニオンにする
+// 垂直に近いピッチでもロールが崩れないよう、途中もQ30で計算する
+void FixedMahonyEstimator::initFromAccel(q16_t accX, q16_t accY, q16_t accZ) {
+    int32_t cosRoll, sinRoll, cosPitch, sinPitch;
+    unitVector(accZ, accY, cosRoll, sinRoll);
+    // √(accY² + accZ²) をロールの向きへの射影で求める（Q16 × Q30 → Q30）
+    int64_t horizontal = ((int64_t)accZ * cosRoll + (int64_t)accY * sinRoll) >> 16;
+    unitVector(horizontal, -((int64_t)accX << 14), cosPitch, sinPitch);
+
+    int32_t cr, sr, cp, sp;
+    halfAngle(cosRoll, sinRoll, cr, sr);
+    halfAngle(cosPitch, sinPitch, cp, sp);
+    q[0] = mulQ30(cr, cp);
+    q[1] = mulQ30(sr, cp);
+    q[2] = mulQ30(cr, sp);
+    q[3] = -mulQ30(sr, sp);
+}
+
+void FixedMahonyEstimator::update(q16_t accX, q16_t accY, q16_t accZ,
+                                  q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step) {
+    if (firstUpdate) {
+        initFromAccel(accX, accY, accZ);
+        firstUpdate = false;
+        updateEuler();
+        return;
+    }
+
+    int32_t g[3] = { degToRadQ24(gyroX), degToRadQ24(gyroY), degToRadQ24(gyroZ) };
+
+    q16_t accNorm = q16Sqrt(q16Add(q16Add(q16Mul(accX, accX), q16Mul(accY, accY)), q16Mul(accZ, accZ)));
+    bool accelValid = accNorm > Q16_ONE - accelTolerance && accNorm < Q16_ONE + accelTolerance;
+
+    // 静止判定（加速度が1g付近で、バイアス除去後の角速度が小さい）
+    int64_t restSquared = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        int64_t r = (int64_t)g[axis] - biasToQ24(bias[axis]);
+        restSquared += r * r;
+    }
+    bool still = accelValid && restSquared < REST_GYRO_THRESHOLD_SQUARED;
+    if (!still) restMicros = 0;
+    else if (restMicros < REST_CONFIRM_MICROS * 2) restMicros += step.micros;
+    if (restMicros > REST_CONFIRM_MICROS) {
+        // 静止中はジャイロの出力そのものがバイアス（係数はQ32、Q24 × Q32 → Q40）
+        int64_t rate = ((int64_t)restBiasRate * step.seconds) >> 16;
+        for (int axis = 0; axis < 3; axis++) {
+            bias[axis] += (((int64_t)g[axis] - biasToQ24(bias[axis])) * rate) >> 16;
+        }
+    }
+
+    for (int axis = 0; axis < 3; axis++) g[axis] -= biasToQ24(bias[axis]);
+
+    if (accelValid) {
+        // 正規化（Q30）
+        int64_t recipNorm = ((int64_t)1 << 46) / accNorm;
+        int32_t ax = (int32_t)((accX * recipNorm) >> 16);
+        int32_t ay = (int32_t)((accY * recipNorm) >> 16);
+        int32_t az = (int32_t)((accZ * recipNorm) >> 16);
+
+        // 現在の姿勢から見た重力方向
+        int32_t vx = 2 * (mulQ30(q[1], q[3]) - mulQ30(q[0], q[2]));
+        int32_t vy = 2 * (mulQ30(q[0], q[1]) + mulQ30(q[2], q[3]));
+        int32_t vz = mulQ30(q[0], q[0]) - mulQ30(q[1], q[1]) - mulQ30(q[2], q[2]) + mulQ30(q[3], q[3]);
+
+        // 測定との誤差（外積、Q30）
+        int32_t e[3] = {
+            mulQ30(ay, vz) - mulQ30(az, vy),
+            mulQ30(az, vx) - mulQ30(ax, vz),
+            mulQ30(ax, vy) - mulQ30(ay, vx),
+        };
+
+        // I項はバイアスとして保持（ki × 周期はQ32、Q30 × Q32 → Q40）
+        if (ki > 0) {
+            int64_t kiStep = ((int64_t)ki * step.seconds) >> 16;
+            for (int axis = 0; axis < 3; axis++) {
+                bias[axis] -= ((int64_t)e[axis] * kiStep) >> 22;
+                if (bias[axis] > BIAS_LIMIT) bias[axis] = BIAS_LIMIT;
+                if (bias[axis] < -BIAS_LIMIT) bias[axis] = -BIAS_LIMIT;
+            }
+        }
+
+        // Q16 × Q30 → Q24
+        for (int axis = 0; axis < 3; axis++) {
+            g[axis] += (int32_t)(((int64_t)kp * e[axis]) >> 22);
+        }
+    }
+
+    // クォータニオンの積分（q' = 0.5 * q * ω）。角速度 × 周期 / 2 をQ30にする（Q24 × Q0.32 → Q56）
+    int32_t hx = (int32_t)(((int64_t)g[0] * step.seconds + (1 << 26)) >> 27);
+    int32_t hy = (int32_t)(((int64_t)g[1] * step.seconds + (1 << 26)) >> 27);
+    int32_t hz = (int32_t)(((int64_t)g[2] * step.seconds + (1 << 26)) >> 27);
+    int32_t a = q[0], b = q[1], c = q[2], d = q[3];
+    q[0] += -mulQ30(b, hx) - mulQ30(c, hy) - mulQ30(d, hz);
+    q[1] += mulQ30(a, hx) + mulQ30(c, hz) - mulQ30(d, hy);
+    q[2] += mulQ30(a, hy) - mulQ30(b, hz) + mulQ30(d, hx);
+    q[3] += mulQ30(a, hz) + mulQ30(b, hy) - mulQ30(c, hx);
+
+    // 正規化（|q|² ≈ 1 なので 1/√x ≈ (3 - x) / 2）
+    int64_t normSquared = (int64_t)mulQ30(q[0], q[0]) + mulQ30(q[1], q[1]) + mulQ30(q[2], q[2]) + mulQ30(q[3], q[3]);
+    int32_t recipNorm = (int32_t)((3 * (int64_t)Q30_ONE - normSquared) >> 1);
+    for (int i = 0; i < 4; i++) q[i] = mulQ30(q[i], recipNorm);
+
+    updateEuler();
+}
+
+// ZYX順のオイラー角（float版と同じ）
+// q16Atan2Deg は比だけを見るので、Q30のまま渡す（Q16に落とすと垂直に近いピッチで分解能が足りない）
+void FixedMahonyEstimator::updateEuler() {
+    int32_t sinPitch = 2 * (mulQ30(q[0], q[2]) - mulQ30(q[3], q[1]));
+    if (sinPitch > Q30_ONE) sinPitch = Q30_ONE;
+    if (sinPitch < -Q30_ONE) sinPitch = -Q30_ONE;
+    // Q30の値をQ16として平方根を取るとQ23になる
+    int32_t cosPitch = q16Sqrt(Q30_ONE - mulQ30(sinPitch, sinPitch)) << 7;
+    roll = q16Atan2Deg(2 * (mulQ30(q[0], q[1]) + mulQ30(q[2], q[3])),
+                       Q30_ONE - 2 * (mulQ30(q[1], q[1]) + mulQ30(q[2], q[2])));
+    pitch = q16Atan2Deg(sinPitch, cosPitch);
+
+    // ヨーは±180度で折り返さず連続にする
+    q16_t wrappedYaw = q16Atan2Deg(2 * (mulQ30(q[0], q[3]) + mulQ30(q[1], q[2])),
+                                   Q30_ONE - 2 * (mulQ30(q[2], q[2]) + mulQ30(q[3], q[3])));
+    q16_t delta = wrappedYaw - lastWrappedYaw;
+    if (delta > q16Const(180)) delta -= q16Const(360);
+    if (delta < q16Const(-180)) delta += q16Const(360);
+    yaw = q16Add(yaw, delta);
+    lastWrappedYaw = wrappedYaw;
+}
+
+float FixedMahonyEstimator::getGyroBias(int axis) const {
+    return (float)biasToQ24(bias[axis]) * (57.29578f / 16777216.0f);
+}
+
+bool FixedMahonyEstimator::isResting() const {
+    return restMicros > REST_CONFIRM_MICROS;
+}
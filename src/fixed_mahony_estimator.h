@@ -0,0 +1,50 @@
+#ifndef FIXED_MAHONY_ESTIMATOR_H
+#define FIXED_MAHONY_ESTIMATOR_H
+
+// MahonyEstimatorの固定小数点版（USE_FIXED_POINT）
+// 1周期の回転はQ16の分解能より小さいので、クォータニオンはQ30、角速度はQ24[rad/s]で持つ
+// 手順（静止中のバイアス追従、重力誤差のPI、積分と正規化、オイラー角）はfloat版と同じ
+// 除算と平方根は加速度の正規化の1回ずつで、クォータニオンの正規化は1次の近似（ほぼ1なので十分）
+
+#include <stdint.h>
+#include "fixed_point.h"
+
+class FixedMahonyEstimator {
+private:
+    int32_t q[4];               // 姿勢クォータニオン（Q30）
+    int64_t bias[3];            // ジャイロバイアス推定値（Q40、rad/s。1周期の更新量がQ24の分解能を下回るため）
+    q16_t kp, ki;               // 重力誤差のフィードバックゲイン
+    q16_t accelTolerance;       // 加速度補正を使う |a| の許容幅[g]
+    q16_t restBiasRate;         // 静止中のバイアス追従の速さ[1/s]
+    uint32_t restMicros;        // 静止が続いている時間[μs]
+    bool firstUpdate;           // 初回は加速度から姿勢を初期化
+
+    q16_t pitch, roll, yaw;     // 直近のオイラー角[度]（ヨーは連続値）
+    q16_t lastWrappedYaw;       // 前回の±180度のヨー
+
+    void initFromAccel(q16_t accX, q16_t accY, q16_t accZ);
+    void updateEuler();
+
+public:
+    FixedMahonyEstimator();
+
+    // acc: [g]、gyro: [deg/s]
+    void update(q16_t accX, q16_t accY, q16_t accZ,
+                q16_t gyroX, q16_t gyroY, q16_t gyroZ, const Q16TimeStep& step);
+    void reset();
+
+    // float版と同じ既定値（設定時のみfloatから変換する）
+    void setGains(float kp, float ki);
+    void setAccelTolerance(float tolerance);
+    void setRestBiasRate(float rate);
+
+    q16_t getPitch() const { return pitch; }
+    q16_t getRoll() const { return roll; }
+    q16_t getYaw() const { return yaw; }
+
+    // 推定したジャイロバイアス[deg/s]
+    float getGyroBias(int axis) const;
+    bool isResting() const;
+};
+
+#endif
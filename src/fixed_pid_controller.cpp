@@ -0,0 +1,132 @@
+#include "fixed_pid_controller.h"
+#include <math.h>
+
+// ki = 0 かつ kp = 0 の時のバックカリキュレーションの係数[1/秒]（float版と同じ）
+static const q16_t DEFAULT_TRACKING_GAIN = q16Const(10.0);
+
+FixedPIDController::FixedPIDController(float kp, float ki, float kd)
+    : kf(0), trackingGain(0), autoTrackingGain(true),
+      previousError(0), previousInput(0), integral(0), firstRun(true), presetPending(false),
+      outputMin(q16Const(-1000)), outputMax(q16Const(1000)), integralLimit(Q16_MAX),
+      lastP(0), lastI(0), lastD(0), lastF(0) {
+    setGains(kp, ki, kd);
+}
+
+void FixedPIDController::updateTrackingGain() {
+    if (!autoTrackingGain) return;
+    // float版と同じ（ゲイン変更時のみなのでfloatで計算する）
+    if (kd > 0 && ki > 0) trackingGain = q16FromFloat(sqrtf(q16ToFloat(ki) / q16ToFloat(kd)));
+    else trackingGain = kp > 0 ? q16Div(ki, kp) : DEFAULT_TRACKING_GAIN;
+}
+
+void FixedPIDController::limitIntegral() {
+    // 積分だけで出力制限を超えないようにする（ki = 0 なら積分しない）
+    if (ki == 0) integral = 0;
+    if (integral > ((int64_t)outputMax << 16)) integral = (int64_t)outputMax << 16;
+    if (integral < ((int64_t)outputMin << 16)) integral = (int64_t)outputMin << 16;
+    if (integral > ((int64_t)integralLimit << 16)) integral = (int64_t)integralLimit << 16;
+    if (integral < -((int64_t)integralLimit << 16)) integral = -((int64_t)integralLimit << 16);
+}
+
+q16_t FixedPIDController::calculate(q16_t setpoint, q16_t input, const Q16TimeStep& step) {
+    // 誤差計算
+    q16_t error = q16Sub(setpoint, input);
+
+    // 積分項（ki × 誤差 × 周期、Q16 × Q0.32 → Q32）。presetの直後は進めない
+    if (!presetPending) integral += ((int64_t)q16Mul(ki, error) * step.seconds) >> 16;
+    presetPending = false;
+    limitIntegral();
+
+    // 微分項（測定値の変化 × 周期の逆数。初回は0）
+    q16_t derivative = 0;
+    if (firstRun) {
+        derivativeFilter.reset();
+    } else {
+        derivative = derivativeFilter.apply(q16Mul(q16Sub(previousInput, input), step.rate));
+    }
+
+    // PID出力計算
+    lastP = q16Mul(kp, error);
+    lastI = q16Saturate(integral >> 16);
+    lastD = q16Mul(kd, derivative);
+    lastF = q16Mul(kf, setpoint);
+    int64_t unlimited = (int64_t)lastP + lastI + lastD + lastF;
+
+    // 出力制限
+    q16_t output = q16Saturate(unlimited);
+    if (output > outputMax) output = outputMax;
+    if (output < outputMin) output = outputMin;
+
+    // 積分ワインドアップ対策（制限で削られた分を積分から戻す、1周期で戻し過ぎない）
+    if (output != unlimited) {
+        q16_t tracking = q16MulTime(trackingGain, step);
+        if (tracking > q16Const(1)) tracking = q16Const(1);
+        integral += (int64_t)tracking * q16Saturate(output - unlimited);  // Q16 × Q16 → Q32
+        limitIntegral();
+    }
+
+    // 次回用に保存
+    previousError = error;
+    previousInput = input;
+    firstRun = false;
+
+    return output;
+}
+
+void FixedPIDController::setGains(float new_kp, float new_ki, float new_kd) {
+    kp = q16FromFloat(new_kp);
+    ki = q16FromFloat(new_ki);
+    kd = q16FromFloat(new_kd);
+    updateTrackingGain();
+    limitIntegral();
+}
+
+void FixedPIDController::setOutputLimits(float min, float max) {
+    outputMin = q16FromFloat(min);
+    outputMax = q16FromFloat(max);
+    limitIntegral();
+}
+
+void FixedPIDController::setFeedForward(float new_kf) {
+    kf = q16FromFloat(new_kf);
+}
+
+void FixedPIDController::setTrackingGain(float gain) {
+    trackingGain = q16FromFloat(gain);
+    autoTrackingGain = false;
+}
+
+void FixedPIDController::setIntegralLimit(float limit) {
+    integralLimit = q16FromFloat(fabsf(limit));
+    limitIntegral();
+}
+
+void FixedPIDController::setDerivativeFilter(DerivativeFilterType type, float cutoffHz, float sampleRateHz) {
+    derivativeFilter.configure(type, cutoffHz, sampleRateHz);
+}
+
+void FixedPIDController::preset(q16_t output, q16_t setpoint, q16_t input) {
+    q16_t error = q16Sub(setpoint, input);
+    // P + I + F = output
+    lastP = q16Mul(kp, error);
+    lastF = q16Mul(kf, setpoint);
+    integral = ((int64_t)output - lastP - lastF) << 16;
+    limitIntegral();
+    previousError = error;
+    previousInput = input;
+    firstRun = false;
+    presetPending = true;
+    derivativeFilter.reset();
+    lastI = q16Saturate(integral >> 16);
+    lastD = 0;
+}
+
+void FixedPIDController::reset() {
+    previousError = 0;
+    previousInput = 0;
+    integral = 0;
+    firstRun = true;
+    presetPending = false;
+    derivativeFilter.reset();
+    lastP = lastI = lastD = lastF = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef FIXED_PID_CONTROLLER_H
+#define FIXED_PID_CONTROLLER_H
+
+// PIDControllerの固定小数点版（USE_FIXED_POINT）
+// 測定値の微分、バックカリキュレーション、フィードフォワード、出力制限はfloat版と同じ順序で行う
+
+#include "fixed_point.h"
+#include "derivative_filter.h"
+
+class FixedPIDController {
+private:
+    q16_t kp, ki, kd, kf;           // PID係数とフィードフォワード係数
+    q16_t trackingGain;             // バックカリキュレーションの係数[1/秒]
+    bool autoTrackingGain;          // trackingGainをゲインから決める
+    q16_t previousError;            // 前回の誤差
+    q16_t previousInput;            // 前回の測定値（微分用）
+    int64_t integral;               // 積分項（出力の単位、Q32。小さい周期でも積算誤差が出ないように）
+    bool firstRun;                  // 初回計算フラグ（前回の測定値がない）
+    bool presetPending;             // preset直後（次の計算で積分を進めない）
+    q16_t outputMin, outputMax;     // 出力制限
+    q16_t integralLimit;            // 積分項の上限（絶対値）
+    q16_t lastP, lastI, lastD, lastF; // 直近の各項（テレメトリ用）
+    FixedDerivativeFilter derivativeFilter;
+
+    void updateTrackingGain();
+    void limitIntegral();
+
+public:
+    FixedPIDController(float kp, float ki, float kd);
+
+    // PID計算
+    q16_t calculate(q16_t setpoint, q16_t input, const Q16TimeStep& step);
+
+    // パラメータ設定（ゲイン変更時のみ除算する）
+    void setGains(float kp, float ki, float kd);
+    void setOutputLimits(float min, float max);
+    void setFeedForward(float kf);
+    void setTrackingGain(float gain);
+    void setIntegralLimit(float limit);
+    void setDerivativeFilter(DerivativeFilterType type, float cutoffHz, float sampleRateHz);
+
+    // リセット
+    void reset();
+
+    // 次の出力がoutputから続くように積分と前回の測定値を設定（モード切り替え時のバンプレス移行）
+    void preset(q16_t output, q16_t setpoint, q16_t input);
+
+    // デバッグ情報取得
+    float getLastError() const { return q16ToFloat(previousError); }
+    float getIntegral() const { return (float)integral * (1.0f / 4294967296.0f); }
+    float getLastP() const { return q16ToFloat(lastP); }
+    float getLastI() const { return q16ToFloat(lastI); }
+    float getLastD() const { return q16ToFloat(lastD); }
+    float getLastF() const { return q16ToFloat(lastF); }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+// Q16.16固定小数点演算（ESP32-C3はFPUがないため、制御演算を整数で行う）
+// 値域は約±32768、分解能は1/65536。演算結果は範囲外になると飽和する
+
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t q16_t;
+
+static const q16_t Q16_ONE = 65536;
+static const q16_t Q16_MAX = INT32_MAX;
+static const q16_t Q16_MIN = INT32_MIN;
+
+// 定数用（コンパイル時に変換される）
+constexpr q16_t q16Const(double value) {
+    return (q16_t)(value * 65536.0 + (value >= 0 ? 0.5 : -0.5));
+}
+
+// Q30（-2〜2）の定数（途中の計算で分解能が要る所に使う）
+constexpr int32_t q30Const(double value) {
+    return (int32_t)(value * 1073741824.0 + (value >= 0 ? 0.5 : -0.5));
+}
+
+inline q16_t q16Saturate(int64_t value) {
+    if (value > Q16_MAX) return Q16_MAX;
+    if (value < Q16_MIN) return Q16_MIN;
+    return (q16_t)value;
+}
+
+inline q16_t q16Add(q16_t a, q16_t b) { return q16Saturate((int64_t)a + b); }
+inline q16_t q16Sub(q16_t a, q16_t b) { return q16Saturate((int64_t)a - b); }
+
+// 乗算（四捨五入）
+inline q16_t q16Mul(q16_t a, q16_t b) {
+    return q16Saturate(((int64_t)a * b + 0x8000) >> 16);
+}
+
+// 除算（0除算は符号に応じて飽和）
+inline q16_t q16Div(q16_t a, q16_t b) {
+    if (b == 0) return a >= 0 ? Q16_MAX : Q16_MIN;
+    return q16Saturate(((int64_t)a << 16) / b);
+}
+
+// floatからの変換
+// ソフトウェア浮動小数点を使わず、ビット列から直接シフトで求める
+inline q16_t q16FromFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits & 0x80000000u) != 0;
+    int exponent = (int)((bits >> 23) & 0xFF);
+    if (exponent == 0) return 0;                        // 0と非正規化数
+    if (exponent == 0xFF && (bits & 0x7FFFFF)) return 0; // NaN
+
+    // 値 = mantissa * 2^(exponent - 150)、Q16では2^(exponent - 134)倍
+    uint32_t mantissa = (bits & 0x7FFFFF) | 0x800000;
+    int shift = exponent - 134;
+    uint32_t magnitude;
+    if (shift >= 8) {
+        return negative ? Q16_MIN : Q16_MAX;
+    } else if (shift >= 0) {
+        magnitude = mantissa << shift;
+    } else if (shift > -25) {
+        magnitude = (mantissa + (1u << (-shift - 1))) >> -shift;
+    } else {
+        return 0;
+    }
+    return negative ? -(q16_t)magnitude : (q16_t)magnitude;
+}
+
+inline float q16ToFloat(q16_t value) {
+    return (float)value * (1.0f / 65536.0f);
+}
+
+// 64ビットの整数平方根（切り捨て）
+inline uint32_t isqrt64(uint64_t x) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+// 平方根（負の入力は0）
+inline q16_t q16Sqrt(q16_t value) {
+    if (value <= 0) return 0;
+    // Q32の整数平方根がQ16の結果になる
+    return (q16_t)isqrt64((uint64_t)value << 16);
+}
+
+// atan2の結果を度で返す（-180〜180）
+// 0〜1の範囲のatanを9次の多項式で近似し、象限で展開する。誤差は約0.002度（1g程度の入力で）
+// 比と多項式はQ30で計算する（Q16では角度が約0.0009度刻みになり、角度の微分が段になる）
+inline q16_t q16Atan2Deg(q16_t y, q16_t x) {
+    if (x == 0 && y == 0) return 0;
+    uint32_t absX = x < 0 ? (uint32_t)0 - (uint32_t)x : (uint32_t)x;
+    uint32_t absY = y < 0 ? (uint32_t)0 - (uint32_t)y : (uint32_t)y;
+    bool swapped = absY > absX;
+    uint32_t num = swapped ? absX : absY;
+    uint32_t den = swapped ? absY : absX;
+
+    // z = num / den（Q30、0〜1）
+    int64_t z = (int64_t)(((uint64_t)num << 30) / den);
+    int64_t z2 = (z * z) >> 30;
+
+    // ラジアンの近似式（Q30）を最後に度へ変換する
+    int64_t poly = q30Const(0.0208351);
+    poly = q30Const(-0.0851330) + ((poly * z2) >> 30);
+    poly = q30Const(0.1801410) + ((poly * z2) >> 30);
+    poly = q30Const(-0.3302995) + ((poly * z2) >> 30);
+    poly = q30Const(0.9998660) + ((poly * z2) >> 30);
+    int64_t radians = (poly * z) >> 30;
+    q16_t angle = (q16_t)((radians * q16Const(57.29577951308232) + (1 << 29)) >> 30);
+
+    if (swapped) angle = q16Const(90.0) - angle;
+    if (x < 0) angle = q16Const(180.0) - angle;
+    if (y < 0) angle = -angle;
+    return angle;
+}
+
+// 制御周期（1周期につき一度だけ除算して、各演算は乗算で済ませる）
+struct Q16TimeStep {
+    uint32_t micros;    // 周期[μs]
+    uint32_t seconds;   // 周期[秒]（Q0.32、1秒未満）
+    q16_t rate;         // 1/周期[Hz]
+};
+
+inline Q16TimeStep q16TimeStep(uint32_t micros) {
+    if (micros == 0) micros = 1;
+    if (micros > 999999) micros = 999999;
+    Q16TimeStep step;
+    step.micros = micros;
+    step.seconds = (uint32_t)(((uint64_t)micros << 32) / 1000000u);
+    step.rate = q16Saturate(((int64_t)1000000 << 16) / micros);
+    return step;
+}
+
+// 値 × 周期（Q16のまま）
+inline q16_t q16MulTime(q16_t value, const Q16TimeStep& step) {
+    return (q16_t)(((int64_t)value * step.seconds + 0x80000000LL) >> 32);
+}
+
+#endif
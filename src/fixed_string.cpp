@@ -0,0 +1,91 @@
+#include "fixed_string.h"
+
+TextBuffer::TextBuffer(char* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), overflow(false) {
+    if (capacity > 0) buffer[0] = '\0';
+}
+
+TextBuffer& TextBuffer::clear() {
+    length = 0;
+    overflow = false;
+    if (capacity > 0) buffer[0] = '\0';
+    return *this;
+}
+
+TextBuffer& TextBuffer::add(char c) {
+    if (length + 1 < capacity) {
+        buffer[length++] = c;
+        buffer[length] = '\0';
+    } else {
+        overflow = true;
+    }
+    return *this;
+}
+
+TextBuffer& TextBuffer::add(const char* text) {
+    if (text == nullptr) return *this;
+    while (*text != '\0') add(*text++);
+    return *this;
+}
+
+TextBuffer& TextBuffer::addPadded(const char* text, uint8_t width) {
+    size_t start = length;
+    add(text);
+    while (length - start < width && !overflow) add(' ');
+    return *this;
+}
+
+TextBuffer& TextBuffer::addDigits(uint32_t value, bool negative, bool plus, uint8_t width, uint8_t decimals) {
+    // 下の桁から作って反転する（uint32_tは最大10桁 + 小数点 + 符号）
+    char digits[16];
+    uint8_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+        if (count == decimals) digits[count++] = '.';
+    } while (value != 0 || count < (decimals > 0 ? decimals + 2 : 1));   // 整数部は最低1桁
+    if (negative) digits[count++] = '-';
+    else if (plus) digits[count++] = '+';
+    
+    for (uint8_t i = count; i < width; i++) add(' ');
+    while (count > 0) add(digits[--count]);
+    return *this;
+}
+
+TextBuffer& TextBuffer::addInt(int32_t value, uint8_t width, bool plus) {
+    uint32_t magnitude = value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    return addDigits(magnitude, value < 0, plus, width, 0);
+}
+
+TextBuffer& TextBuffer::addUnsigned(uint32_t value, uint8_t width) {
+    return addDigits(value, false, false, width, 0);
+}
+
+TextBuffer& TextBuffer::addHex(uint32_t value, uint8_t digits) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    if (digits > 8) digits = 8;
+    add("0x");
+    for (int8_t shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        add(HEX_DIGITS[(value >> shift) & 0xF]);
+    }
+    return *this;
+}
+
+TextBuffer& TextBuffer::addFloat(float value, uint8_t decimals, uint8_t width, bool plus) {
+    if (value != value) {
+        for (uint8_t i = 3; i < width; i++) add(' ');
+        return add("nan");
+    }
+    if (decimals > 6) decimals = 6;
+    
+    bool negative = value < 0;
+    float magnitude = negative ? -value : value;
+    float scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    float scaled = magnitude * scale + 0.5f;
+    // 整数に収まらない値（無限大を含む）は上限で止める
+    uint32_t fixed = scaled < 4294967040.0f ? (uint32_t)scaled : 4294967040u;
+    // 丸めて0になった負の値は符号を付けない（printfは"-0.0"になるが表示上紛らわしい）
+    if (fixed == 0) negative = false;
+    return addDigits(fixed, negative, plus, width, decimals);
+}
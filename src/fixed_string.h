@@ -0,0 +1,53 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+// 固定長バッファへの文字列の組み立て（ヒープを使わない）
+// ArduinoのStringやprintfの代わりに、制御ループと表示で使う
+// 容量を超えた分は切り捨てる（常にヌル終端）
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TextBuffer {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+    TextBuffer& addDigits(uint32_t value, bool negative, bool plus, uint8_t width, uint8_t decimals);
+
+public:
+    TextBuffer(char* buffer, size_t capacity);
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    TextBuffer& clear();
+    TextBuffer& add(const char* text);
+    TextBuffer& add(char c);
+    // 左詰めで幅に満たない分を空白で埋める（%-8s相当）
+    TextBuffer& addPadded(const char* text, uint8_t width);
+    // 右詰めの整数（%7ld / %+d相当）
+    TextBuffer& addInt(int32_t value, uint8_t width = 0, bool plus = false);
+    TextBuffer& addUnsigned(uint32_t value, uint8_t width = 0);
+    // 16進数（0x付き、digits桁まで0で埋める）
+    TextBuffer& addHex(uint32_t value, uint8_t digits = 8);
+    // 小数点以下decimals桁に四捨五入（%+6.1f相当）。floatの整数化のみでdoubleは使わない
+    TextBuffer& addFloat(float value, uint8_t decimals, uint8_t width = 0, bool plus = false);
+
+    const char* c_str() const { return buffer; }
+    size_t size() const { return length; }
+    bool truncated() const { return overflow; }
+};
+
+// 容量Nの文字列（末尾のヌル文字を含む）
+template <size_t N>
+class FixedString : public TextBuffer {
+private:
+    char storage[N];
+
+public:
+    FixedString() : TextBuffer(storage, N) {}
+};
+
+#endif
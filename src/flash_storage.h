@@ -0,0 +1,27 @@
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// フラッシュの1領域（パーティション）を直接読み書きするインターフェース
+// NORフラッシュと同じく、消去すると全ビット1になり、書き込みは1 → 0の変化しかできない
+// オフセットは領域の先頭から
+
+// 1回の書き込み（ページプログラム）の単位。境目をまたぐ書き込みは、チップの中で複数回に分かれる
+static const uint32_t FLASH_PAGE_SIZE = 256;
+
+class FlashStorage {
+public:
+    virtual ~FlashStorage() {}
+
+    virtual uint32_t size() = 0;
+    virtual uint32_t sectorSize() = 0;
+
+    // offset、lengthはsectorSizeの倍数（実装によってはまとめて大きなブロック単位で消去する）
+    virtual bool erase(uint32_t offset, uint32_t length) = 0;
+    virtual bool write(uint32_t offset, const void* data, size_t length) = 0;
+    virtual bool read(uint32_t offset, void* data, size_t length) = 0;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "heap_guard.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <reent.h>
+
+static TaskHandle_t volatile guardedTask = nullptr;
+static TaskHandle_t volatile exemptTask = nullptr;
+static volatile uint32_t violationCount = 0;
+static volatile uint32_t lastCaller = 0;
+
+static inline void checkHeapAccess(void* caller) {
+    TaskHandle_t task = guardedTask;
+    if (task == nullptr || task == exemptTask) return;
+    if (xTaskGetCurrentTaskHandle() != task) return;
+    violationCount++;
+    lastCaller = (uint32_t)(uintptr_t)caller;
+#ifdef HEAP_GUARD_STRICT
+    abort();
+#endif
+}
+
+void HeapGuard::arm() {
+    guardedTask = xTaskGetCurrentTaskHandle();
+}
+
+void HeapGuard::disarm() {
+    guardedTask = nullptr;
+}
+
+bool HeapGuard::isArmed() {
+    return guardedTask != nullptr;
+}
+
+uint32_t HeapGuard::getViolationCount() {
+    return violationCount;
+}
+
+uint32_t HeapGuard::getLastCaller() {
+    return lastCaller;
+}
+
+HeapGuard::Exempt::Exempt() {
+    wasArmed = guardedTask != nullptr;
+    if (wasArmed) exemptTask = guardedTask;
+}
+
+HeapGuard::Exempt::~Exempt() {
+    if (wasArmed) exemptTask = nullptr;
+}
+
+// --wrap=<関数> で差し替えた確保・解放（newlibの再入版も含む）
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+void* __real__malloc_r(struct _reent* r, size_t size);
+void* __real__calloc_r(struct _reent* r, size_t count, size_t size);
+void* __real__realloc_r(struct _reent* r, void* ptr, size_t size);
+void __real__free_r(struct _reent* r, void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr != nullptr) checkHeapAccess(__builtin_return_address(0));
+    __real_free(ptr);
+}
+
+void* __wrap__malloc_r(struct _reent* r, size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real__malloc_r(r, size);
+}
+
+void* __wrap__calloc_r(struct _reent* r, size_t count, size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real__calloc_r(r, count, size);
+}
+
+void* __wrap__realloc_r(struct _reent* r, void* ptr, size_t size) {
+    checkHeapAccess(__builtin_return_address(0));
+    return __real__realloc_r(r, ptr, size);
+}
+
+void __wrap__free_r(struct _reent* r, void* ptr) {
+    if (ptr != nullptr) checkHeapAccess(__builtin_return_address(0));
+    __real__free_r(r, ptr);
+}
+}
@@ -0,0 +1,33 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+// 制御ループでのヒープ使用の検出
+// リンク時にmalloc/free系を --wrap で差し替え（platformio.iniのbuild_flags）、
+// 監視中のタスクから呼ばれたら回数と呼び出し元を記録する
+// 長時間の飛行での断片化と確保の遅延を避けるため、起動完了後の制御ループと表示はヒープを使わない
+// HEAP_GUARD_STRICT を定義すると違反した時点でabortする（地上での確認用）
+
+#include <stdint.h>
+
+class HeapGuard {
+public:
+    // 呼び出したタスクを監視対象にする
+    static void arm();
+    static void disarm();
+    static bool isArmed();
+
+    static uint32_t getViolationCount();
+    // 最後に違反した呼び出し元（mallocなどを呼んだ命令のアドレス）
+    static uint32_t getLastCaller();
+
+    // 範囲内だけ監視を止める（バス回復など、非常時にだけ通る処理）
+    class Exempt {
+    private:
+        bool wasArmed;
+    public:
+        Exempt();
+        ~Exempt();
+    };
+};
+
+#endif
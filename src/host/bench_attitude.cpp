@@ -0,0 +1,156 @@
+// 姿勢推定器（相補フィルター / Mahony）の精度と1回あたりの計算時間
+// 真値の姿勢からIMU値（バイアス・ノイズ付き）を作って推定させ、真値との差を見る
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "attitude_estimator.h"
+#include "mahony_estimator.h"
+
+static const uint32_t IMU_PERIOD_MICROS = 1000;   // IMUのサンプル周期で回す
+static const float WARMUP_SECONDS = 10;           // バイアスが収束するまでは誤差に含めない
+static const float GYRO_BIAS[3] = { 1.0f, -0.8f, 0.6f };  // [deg/s]
+
+struct Euler {
+    double roll, pitch, yaw;    // [度]
+};
+
+struct ImuSample {
+    float acc[3];
+    float gyro[3];
+    Euler truth;
+};
+
+typedef Euler (*TrajectoryFunc)(double t);
+
+// ピッチ・ロールを揺らしながら一定の角速度で旋回
+static Euler wobble(double t) {
+    return { 30 * sin(2 * M_PI * 0.3 * t), 20 * sin(2 * M_PI * 0.5 * t), 10 * t };
+}
+
+// 機首を85度まで上げて保持し、ロールを揺らす（オイラー角の特異点付近）
+static Euler steep(double t) {
+    double pitch = t < 5 ? 17 * t : 85;
+    return { 20 * sin(2 * M_PI * 0.4 * t), pitch, 0 };
+}
+
+// 水平で静止（ヨーのドリフトを見る）
+static Euler rest(double) {
+    return { 0, 0, 0 };
+}
+
+static float noise(float amplitude) {
+    return amplitude * ((rand() % 2001) / 1000.0f - 1.0f);
+}
+
+static double toRad(double degrees) { return degrees * M_PI / 180; }
+
+// ZYX順のオイラー角からジャイロ（機体座標の角速度）と重力方向を求める
+static std::vector<ImuSample> makeSamples(TrajectoryFunc trajectory, double seconds) {
+    std::vector<ImuSample> samples;
+    srand(3);
+    double dt = IMU_PERIOD_MICROS * 1e-6;
+    for (double t = 0; t < seconds; t += dt) {
+        Euler e = trajectory(t);
+        Euler before = trajectory(t - 1e-4), after = trajectory(t + 1e-4);
+        double rollRate = toRad(after.roll - before.roll) / 2e-4;
+        double pitchRate = toRad(after.pitch - before.pitch) / 2e-4;
+        double yawRate = toRad(after.yaw - before.yaw) / 2e-4;
+        double sr = sin(toRad(e.roll)), cr = cos(toRad(e.roll));
+        double sp = sin(toRad(e.pitch)), cp = cos(toRad(e.pitch));
+
+        ImuSample s;
+        s.truth = e;
+        double p = rollRate - yawRate * sp;
+        double q = pitchRate * cr + yawRate * cp * sr;
+        double r = -pitchRate * sr + yawRate * cp * cr;
+        s.gyro[0] = (float)(p * 180 / M_PI) + GYRO_BIAS[0] + noise(0.3f);
+        s.gyro[1] = (float)(q * 180 / M_PI) + GYRO_BIAS[1] + noise(0.3f);
+        s.gyro[2] = (float)(r * 180 / M_PI) + GYRO_BIAS[2] + noise(0.3f);
+        // 機体の振動による加速度ノイズ
+        s.acc[0] = (float)-sp + noise(0.1f);
+        s.acc[1] = (float)(cp * sr) + noise(0.1f);
+        s.acc[2] = (float)(cp * cr) + noise(0.1f);
+        samples.push_back(s);
+    }
+    return samples;
+}
+
+static double angleDiff(double a, double b) {
+    double diff = fmod(a - b, 360.0);
+    if (diff > 180) diff -= 360;
+    if (diff < -180) diff += 360;
+    return fabs(diff);
+}
+
+struct ErrorStats {
+    double sumSquared = 0, max = 0;
+    int count = 0;
+
+    void add(double error) {
+        sumSquared += error * error;
+        if (error > max) max = error;
+        count++;
+    }
+    double rms() const { return count > 0 ? sqrt(sumSquared / count) : 0; }
+};
+
+static void evaluate(AttitudeEstimator& estimator, const std::vector<ImuSample>& samples) {
+    ErrorStats pitch, roll, yaw;
+    float dt = IMU_PERIOD_MICROS * 1e-6f;
+    estimator.reset();
+    for (size_t i = 0; i < samples.size(); i++) {
+        const ImuSample& s = samples[i];
+        estimator.update(s.acc[0], s.acc[1], s.acc[2], s.gyro[0], s.gyro[1], s.gyro[2], dt);
+        if (i * dt < WARMUP_SECONDS) continue;
+        pitch.add(angleDiff(estimator.getPitch(), s.truth.pitch));
+        // ピッチ±90度付近ではロールとヨーが一意に決まらないため、ピッチが正しい時だけ比べる
+        if (fabs(s.truth.pitch) < 89) roll.add(angleDiff(estimator.getRoll(), s.truth.roll));
+        yaw.add(angleDiff(estimator.getYaw(), s.truth.yaw));
+    }
+    printf("    %-14s pitch rms %6.2f max %6.2f | roll rms %6.2f max %6.2f | yaw rms %7.2f max %7.2f [deg]\n",
+           estimator.getName(), pitch.rms(), pitch.max, roll.rms(), roll.max, yaw.rms(), yaw.max);
+}
+
+static void runScenario(const char* name, TrajectoryFunc trajectory, double seconds) {
+    std::vector<ImuSample> samples = makeSamples(trajectory, seconds);
+    printf("  %s (%.0fs @ %luHz, gyro bias %.1f/%.1f/%.1f deg/s)\n", name, seconds,
+           (unsigned long)(1000000 / IMU_PERIOD_MICROS), GYRO_BIAS[0], GYRO_BIAS[1], GYRO_BIAS[2]);
+    ComplementaryEstimator complementary;
+    MahonyEstimator mahony;
+    evaluate(complementary, samples);
+    evaluate(mahony, samples);
+    printf("    %-14s estimated bias %.2f/%.2f/%.2f deg/s\n", "",
+           mahony.getGyroBias(0), mahony.getGyroBias(1), mahony.getGyroBias(2));
+}
+
+static void benchUpdate(AttitudeEstimator& estimator, const std::vector<ImuSample>& samples) {
+    const int REPEAT = 10;
+    float dt = IMU_PERIOD_MICROS * 1e-6f;
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT; r++) {
+        estimator.reset();
+        for (const ImuSample& s : samples) {
+            estimator.update(s.acc[0], s.acc[1], s.acc[2], s.gyro[0], s.gyro[1], s.gyro[2], dt);
+            doNotOptimize(estimator.getPitch());
+        }
+    }
+    char name[48];
+    snprintf(name, sizeof(name), "%s update", estimator.getName());
+    printBenchResult(name, timer.elapsedNanos(), (uint64_t)samples.size() * REPEAT);
+}
+
+void benchAttitude() {
+    runScenario("wobble", wobble, 120);
+    runScenario("steep", steep, 60);
+    runScenario("rest", rest, 300);
+
+    std::vector<ImuSample> samples = makeSamples(wobble, 20);
+    ComplementaryEstimator complementary;
+    MahonyEstimator mahony;
+    benchUpdate(complementary, samples);
+    benchUpdate(mahony, samples);
+}
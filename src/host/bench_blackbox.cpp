@@ -0,0 +1,258 @@
+// ブラックボックスの書き込み経路を模擬フラッシュ（FakeFlashStorage、実機と同じ大きさ）で確かめる
+//   encode:   1レコードの変換と書き込みの時間
+//   flight:   500Hzで積み、20ms毎に書く。地上（消去してよい間）と飛行中に分けて、フラッシュの消去・書き込みで
+//             遅れた制御周期（stalled）と1周期以上遅れた数（missed）、キューの最大使用数と取りこぼし
+//   sessions: 何度も記録した時の消去回数の偏りと、前回のセッションが残るか
+//   powercut: 書き込みの途中で電源が切れた時に、読み出せるレコードの数と時刻の連続性
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "blackbox.h"
+#include "blackbox_image.h"
+#include "fake_hal.h"
+#include "telemetry.h"
+
+static const uint32_t PARTITION_SIZE = 0x260000;   // partitions.csvのblackbox
+static const uint32_t PERIOD_MICROS = 2000;
+static const uint32_t DRAIN_MICROS = 20000;        // BlackboxWriterの間隔
+static const uint32_t STICK_CHECK_MICROS = 1000000; // 離陸前にスティックを動かしてから離陸まで（ここで消去をやめる）
+
+static BlackboxSample makeSample(uint32_t timeMicros) {
+    BlackboxSample s = {};
+    s.timeMicros = timeMicros;
+    s.flags = TELEMETRY_FLAG_IMU_OK;
+    float phase = (timeMicros % 1000000) * 1e-6f;
+    s.acc[0] = -0.1f + phase * 0.2f;
+    s.acc[2] = 0.98f;
+    s.gyro[1] = 20.0f * phase - 10.0f;
+    s.rcPulse[0] = 1500;
+    s.rcPulse[1] = 1500;
+    s.rcPulse[2] = 1000;
+    s.rcFrames = (timeMicros % 20000) < PERIOD_MICROS ? 3 : 0;
+    s.rcAge[0] = s.rcAge[1] = timeMicros % 20000;
+    s.rcPeriod[0] = s.rcPeriod[1] = 20000;
+    s.attitude[0] = 5.0f * phase;
+    s.pTerm[0] = 1.5f;
+    s.servoPulse[0] = 1512.3f;
+    s.servoPulse[1] = 1500.0f;
+    s.dtMicros = PERIOD_MICROS;
+    s.execMicros = 180;
+    return s;
+}
+
+// フラッシュの操作の間に来た制御周期（操作が終わるまで遅れる）
+struct StallStats {
+    uint32_t stalled;
+    uint32_t missed;        // 1周期以上遅れた（次の周期にかかった）
+    uint32_t maxDelay;      // [μs]
+};
+
+struct FlightResult {
+    uint32_t records;
+    uint32_t highWater;
+    uint32_t drops;
+    uint32_t fullDrops;
+    uint32_t errors;
+    StallStats ground;
+    StallStats flight;
+};
+
+// 1回の記録（電源投入から地上でgroundSeconds秒、その後flightSeconds秒飛ぶ）。startMicrosから時刻を振る
+// 書き込みタスクは実機と同じBlackboxLog::service()を20ms毎に呼び、消去・書き込みの間は時計が進む
+// 消去は実機と同じく、離陸前にスティックを動かした時（離陸のSTICK_CHECK_MICROS前）にやめる
+static FlightResult fly(FakeFlashStorage& flash, float groundSeconds, float flightSeconds, uint32_t startMicros) {
+    FakeClock clock(startMicros);
+    flash.clock = &clock;
+    flash.busy.clear();
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    log.begin();
+    queue.setEnabled(true);
+
+    FlightResult r = {};
+    uint32_t takeoff = startMicros + (uint32_t)(groundSeconds * 1e6f);
+    uint32_t end = takeoff + (uint32_t)(flightSeconds * 1e6f);
+    uint32_t sticksMoved = takeoff > startMicros + STICK_CHECK_MICROS ? takeoff - STICK_CHECK_MICROS : startMicros;
+    uint32_t nextDrain = startMicros;
+    size_t busyIndex = 0;
+    for (uint32_t t = startMicros; t < end; t += PERIOD_MICROS) {
+        while (busyIndex < flash.busy.size() && flash.busy[busyIndex].end <= t) busyIndex++;
+        if (busyIndex < flash.busy.size() && flash.busy[busyIndex].start <= t) {
+            StallStats& stats = t < takeoff ? r.ground : r.flight;
+            uint32_t delay = flash.busy[busyIndex].end - t;
+            stats.stalled++;
+            if (delay >= PERIOD_MICROS) stats.missed++;
+            if (delay > stats.maxDelay) stats.maxDelay = delay;
+        }
+        queue.setEraseAllowed(t < sticksMoved);
+        queue.push(makeSample(t));
+        if (queue.size() > r.highWater) r.highWater = queue.size();
+        if (t >= nextDrain) {
+            clock.set(t);
+            log.service(queue);
+            nextDrain = clock.micros() + DRAIN_MICROS;
+        }
+    }
+    log.drain(queue);
+    flash.clock = nullptr;
+    r.records = log.getRecordCount();
+    r.drops = queue.getDropCount();
+    r.fullDrops = log.getFullDrops();
+    r.errors = log.getErrorCount();
+    return r;
+}
+
+// 時刻がPERIOD_MICROS刻みで続いていない箇所の数
+static uint32_t countTimeGaps(const std::vector<BlackboxSample>& samples) {
+    uint32_t gaps = 0;
+    for (size_t i = 1; i < samples.size(); i++) {
+        if (samples[i].timeMicros - samples[i - 1].timeMicros != PERIOD_MICROS) gaps++;
+    }
+    return gaps;
+}
+
+static void benchEncode() {
+    printf("encode:\n");
+    const uint64_t iterations = 1000000;
+    uint8_t record[BLACKBOX_RECORD_SIZE];
+    BenchTimer timer;
+    for (uint64_t i = 0; i < iterations; i++) {
+        encodeBlackboxRecord(makeSample((uint32_t)i * PERIOD_MICROS), record);
+        doNotOptimize(record[BLACKBOX_RECORD_SIZE - 1]);
+    }
+    printBenchResult("encodeBlackboxRecord", timer.elapsedNanos(), iterations);
+
+    FakeFlashStorage flash(PARTITION_SIZE);
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    log.begin();
+    log.prepare();
+    while (log.eraseAhead()) {
+    }
+    queue.setEnabled(true);
+    const uint32_t records = 30000;
+    BenchTimer drainTimer;
+    for (uint32_t i = 0; i < records; i++) {
+        queue.push(makeSample(i * PERIOD_MICROS));
+        if (queue.size() >= 10) log.drain(queue);
+    }
+    log.drain(queue);
+    printBenchResult("drain (encode + fake flash)", drainTimer.elapsedNanos(), records);
+
+    BlackboxSample decoded;
+    encodeBlackboxRecord(makeSample(1234000), record);
+    bool ok = decodeBlackboxRecord(record, decoded);
+    printf("  round trip: %s (servo %.1f us, attitude %.2f deg)\n", ok ? "ok" : "FAILED",
+           decoded.servoPulse[0], decoded.attitude[0]);
+}
+
+static void printStalls(const char* name, const StallStats& stats) {
+    printf("    %-9s stalled ticks=%u missed=%u max delay=%uus\n", name, stats.stalled, stats.missed,
+           stats.maxDelay);
+}
+
+static void benchFlight() {
+    FakeFlashStorage flash(PARTITION_SIZE);
+    printf("\nflight (500Hz, drain every %ums, erase %ums/sector, page write %uus):\n", DRAIN_MICROS / 1000,
+           flash.eraseMicros / 1000, flash.pageMicros);
+    BlackboxLog probe(flash);
+    probe.begin();
+    printf("  partition %u sectors x %u records = %.1f s at 500Hz\n", probe.getSectorCount(),
+           probe.getRecordsPerSector(),
+           probe.getSectorCount() * probe.getRecordsPerSector() * PERIOD_MICROS * 1e-6);
+
+    // 2回目は前回の半分を残すので、消去済みの領域を使い切った後は捨てる（full）
+    // 3回目は消去が終わる前に離陸する
+    struct Scenario {
+        float ground;
+        float flight;
+    };
+    const Scenario scenarios[] = { { 40.0f, 120.0f }, { 40.0f, 120.0f }, { 3.0f, 60.0f } };
+    uint32_t flightMissed = 0;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        FlightResult r = fly(flash, scenarios[i].ground, scenarios[i].flight, 0);
+        printf("  flight %zu (ground %.0fs, flight %.0fs): records=%u queue max=%u/%u drops=%u full=%u errors=%u\n",
+               i + 1, scenarios[i].ground, scenarios[i].flight, r.records, r.highWater, BlackboxQueue::capacity(),
+               r.drops, r.fullDrops, r.errors);
+
+        // 読み出せる記録のうち離陸後の分（地上で待つ間の古いレコードは消去して離陸後の領域に回す）
+        BlackboxImage image;
+        image.load(flash.data);
+        uint32_t takeoff = (uint32_t)(scenarios[i].ground * 1e6f);
+        uint32_t airborne = 0;
+        if (!image.getSessions().empty()) {
+            for (const BlackboxSample& sample : image.read(image.getSessions().back())) {
+                if (sample.timeMicros >= takeoff) airborne++;
+            }
+        }
+        printf("    recorded after takeoff: %.1f s\n", airborne * PERIOD_MICROS * 1e-6);
+        printStalls("ground:", r.ground);
+        printStalls("in flight:", r.flight);
+        flightMissed += r.flight.missed;
+    }
+    printf("  no missed ticks in flight: %s\n", flightMissed == 0 ? "ok" : "FAILED");
+}
+
+static void benchSessions() {
+    // 1回は地上10秒 + 飛行18秒で領域の4割ほど（前回の残りが一部上書きされる長さ）
+    printf("\nsessions (20 x 28s):\n");
+    FakeFlashStorage flash(PARTITION_SIZE);
+    const int sessions = 20;
+    bool keptAll = true;
+    for (int i = 0; i < sessions; i++) {
+        fly(flash, 10.0f, 18.0f, 0);
+        BlackboxImage image;
+        image.load(flash.data);
+        const std::vector<BlackboxSession>& found = image.getSessions();
+        // 最後のセッションと、その前のセッション（の新しい側）が読み出せること
+        if (found.empty() || found.back().session != i) keptAll = false;
+        if (i > 0 && (found.size() < 2 || found[found.size() - 2].session != i - 1)) keptAll = false;
+    }
+    uint32_t minErase = UINT32_MAX, maxErase = 0;
+    for (uint32_t count : flash.eraseCounts) {
+        if (count < minErase) minErase = count;
+        if (count > maxErase) maxErase = count;
+    }
+    printf("  erase count per sector: min=%u max=%u (erase calls %u)\n", minErase, maxErase, flash.eraseCalls);
+    printf("  previous session kept: %s\n", keptAll ? "ok" : "FAILED");
+}
+
+static void benchPowerCut() {
+    printf("\npowercut:\n");
+    // 書き込みの途中で止まるよう、レコード長で割り切れない量で切る
+    const uint32_t budgets[] = { 100000, 654321, 1234567 };
+    for (uint32_t budget : budgets) {
+        FakeFlashStorage flash(PARTITION_SIZE);
+        fly(flash, 5.0f, 15.0f, 0);
+        flash.writeBudget = budget;
+        FlightResult cut = fly(flash, 40.0f, 20.0f, 100000000);
+        flash.writeBudget = UINT32_MAX;
+
+        BlackboxImage image;
+        image.load(flash.data);
+        const BlackboxSession* session = image.findSession(1);
+        uint32_t corrupt = 0;
+        std::vector<BlackboxSample> samples;
+        if (session != nullptr) samples = image.read(*session, &corrupt);
+        printf("  cut after %7u bytes: encoded=%u readable=%zu corrupt=%u time gaps=%u\n", budget, cut.records,
+               samples.size(), corrupt, countTimeGaps(samples));
+
+        // 次の電源投入では続きのセッション番号で記録できること
+        fly(flash, 5.0f, 0.0f, 200000000);
+        image.load(flash.data);
+        const BlackboxSession* next = image.findSession(2);
+        size_t nextRecords = next != nullptr ? image.read(*next).size() : 0;
+        printf("  %27s next session records=%zu (%s)\n", "", nextRecords,
+               nextRecords == 5000000 / PERIOD_MICROS ? "ok" : "FAILED");
+    }
+}
+
+void benchBlackbox() {
+    benchEncode();
+    benchFlight();
+    benchSessions();
+    benchPowerCut();
+}
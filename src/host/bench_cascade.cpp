@@ -0,0 +1,153 @@
+// ピッチ軸の簡易シミュレーションで、角度の単一ループとAutoControlのカスケード（角度→角速度）を比べる
+// 機体: q' = Mδ·δ − Mq·q − Mθ·θ + 突風、θ' = q（δはサーボの舵角[%]）
+// サーボはパルス周期毎に指令を取り込み、1次遅れで動く。IMUはノイズと機体振動付き
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_tools.h"
+#include "fake_hal.h"
+#include "attitude_filter.h"
+#include "legacy_pid.h"
+#include "auto_control.h"
+
+static const uint32_t PHYSICS_STEP_MICROS = 100;
+static const float SIM_SECONDS = 12;
+
+// 機体（ピッチの短周期を1自由度で近似）
+static const float ELEVATOR_MOMENT = 20.0f;     // 舵1%あたりの角加速度[deg/s^2]
+static const float PITCH_DAMPING = 4.0f;        // [1/s]
+static const float PITCH_STIFFNESS = 12.0f;     // 静安定[1/s^2]
+static const float GUST_MOMENT = 400.0f;        // 突風の角加速度の大きさ[deg/s^2]
+
+// サーボ（デジタル、333Hz）
+static const uint32_t SERVO_FRAME_MICROS = 3000;
+static const float SERVO_TIME_CONSTANT = 0.02f;  // [s]
+
+static float noise(float amplitude) {
+    return amplitude * ((rand() % 2001) / 1000.0f - 1.0f);
+}
+
+// 目標ピッチ: 水平 → +15度 → -10度 → 水平
+static float targetAt(float t) {
+    if (t < 1) return 0;
+    if (t < 4) return 15;
+    if (t < 7) return -10;
+    return 0;
+}
+
+// 目標を変えてから追従を待つ時間（外乱への強さはこれ以降で見る）
+static bool isSettled(float t) {
+    const float changes[] = { 1, 4, 7 };
+    for (float change : changes) {
+        if (t >= change && t < change + 1.5f) return false;
+    }
+    return t >= 0.5f;
+}
+
+struct Result {
+    double sumSquared = 0, settledSquared = 0, settledMax = 0, overshoot = 0;
+    int count = 0, settledCount = 0;
+};
+
+typedef float (*ControllerStep)(void* context, FakeImu& imu, float target, uint32_t dtMicros);
+
+// 制御周期controlMicrosで機体・サーボ・IMUを仮想時間で回す
+static Result simulate(ControllerStep controller, void* context, uint32_t controlMicros) {
+    srand(7);
+    FakeImu imu;
+    Result result;
+    float pitch = 0, rate = 0, servo = 0, heldCommand = 0, command = 0;
+    float gust = 0, gustTarget = 0;
+    uint32_t sinceControl = 0, sinceFrame = 0, sinceGust = 0;
+    const float dt = PHYSICS_STEP_MICROS * 1e-6f;
+
+    for (uint32_t now = 0; now < SIM_SECONDS * 1000000; now += PHYSICS_STEP_MICROS) {
+        float t = now * 1e-6f;
+        float target = targetAt(t);
+
+        // 突風: 0.2秒毎に強さを変え、なめらかにつなぐ
+        if ((sinceGust += PHYSICS_STEP_MICROS) >= 200000) {
+            sinceGust = 0;
+            gustTarget = noise(GUST_MOMENT);
+        }
+        gust += (gustTarget - gust) * dt / 0.05f;
+
+        if ((sinceControl += PHYSICS_STEP_MICROS) >= controlMicros) {
+            float p = pitch * (float)M_PI / 180;
+            imu.gyroY = rate + noise(0.3f);
+            imu.accX = -sinf(p) + noise(0.1f);
+            imu.accY = noise(0.1f);
+            imu.accZ = cosf(p) + noise(0.1f);
+            command = controller(context, imu, target, sinceControl);
+            sinceControl = 0;
+        }
+        if ((sinceFrame += PHYSICS_STEP_MICROS) >= SERVO_FRAME_MICROS) {
+            sinceFrame = 0;
+            heldCommand = command;
+        }
+        servo += (heldCommand - servo) * dt / SERVO_TIME_CONSTANT;
+
+        rate += (ELEVATOR_MOMENT * servo - PITCH_DAMPING * rate - PITCH_STIFFNESS * pitch + gust) * dt;
+        pitch += rate * dt;
+
+        double error = pitch - target;
+        result.sumSquared += error * error;
+        result.count++;
+        if (isSettled(t)) {
+            result.settledSquared += error * error;
+            result.settledMax = fmax(result.settledMax, fabs(error));
+            result.settledCount++;
+        }
+        if (target != 0) {
+            double beyond = target > 0 ? pitch - target : target - pitch;
+            result.overshoot = fmax(result.overshoot, beyond);
+        }
+    }
+    return result;
+}
+
+// 以前の角度制御（ローパス後の角度を直接PIDで舵にする）
+struct SingleLoop {
+    AngleFilter filter;
+    LegacyPIDController pid;
+
+    SingleLoop() : pid(0.8, 0.5, 0.5) { pid.setOutputLimits(-90, 90); }
+};
+
+static float singleLoopStep(void* context, FakeImu& imu, float target, uint32_t dtMicros) {
+    SingleLoop& loop = *(SingleLoop*)context;
+    float dt = dtMicros * 1e-6f;
+    loop.filter.update(imu.getAccX(), imu.getAccY(), imu.getAccZ(),
+                       imu.getGyroX(), imu.getGyroY(), imu.getGyroZ(), dt);
+    return loop.pid.calculate(target, loop.filter.getSmoothPitch(), dt);
+}
+
+// 基準の目標値は初期値（水平）のままにして、目標ピッチをずれとして渡す
+static float cascadeStep(void* context, FakeImu& imu, float target, uint32_t dtMicros) {
+    AutoControl& control = *(AutoControl*)context;
+    ControlInputs inputs = {};
+    inputs.setImu(imu);
+    inputs.targetOffset[0] = target;
+    return control.step(dtMicros, inputs).elevator.value;
+}
+
+static void printResult(const char* name, uint32_t rateHz, const Result& r) {
+    printf("  %-8s %4luHz  rms %6.2f | overshoot %6.2f | hold rms %5.2f max %5.2f [deg]\n", name,
+           (unsigned long)rateHz, sqrt(r.sumSquared / r.count), r.overshoot,
+           sqrt(r.settledSquared / r.settledCount), r.settledMax);
+}
+
+void benchCascade() {
+    printf("  pitch steps 0/+15/-10/0 deg, gust up to %.0f deg/s^2, servo %luHz frame\n",
+           GUST_MOMENT, (unsigned long)(1000000 / SERVO_FRAME_MICROS));
+    const uint32_t rates[] = { 100, 250, 500, 1000 };
+    for (uint32_t rateHz : rates) {
+        SingleLoop single;
+        printResult("single", rateHz, simulate(singleLoopStep, &single, 1000000 / rateHz));
+        AutoControl cascade;
+        cascade.begin(rateHz);
+        cascade.enableControl(true, false, false);
+        printResult("cascade", rateHz, simulate(cascadeStep, &cascade, 1000000 / rateHz));
+    }
+}
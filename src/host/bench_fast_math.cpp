@@ -0,0 +1,92 @@
+// fast_math.h の近似関数の誤差確認（定義域の走査）とlibmとの速度比較
+// ホストのlibmはFPUを使うため、実機ほどの差は出ない
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "fast_math.h"
+
+static const int REPEAT = 20;
+
+static void printBound(const char* name, double maxError, float bound) {
+    printf("  %-24s max error %.3g (bound %.3g) %s\n", name, maxError, (double)bound,
+           maxError <= bound ? "ok" : "EXCEEDED");
+}
+
+// 全周の角度を複数の半径で走査
+static void checkAtan2() {
+    double maxError = 0;
+    for (double radius : { 1e-6, 1e-3, 0.5, 1.0, 2.0, 1e3, 1e6 }) {
+        for (int i = 0; i < 360000; i++) {
+            double angle = (i - 180000) * M_PI / 180000.0;
+            float y = (float)(radius * sin(angle));
+            float x = (float)(radius * cos(angle));
+            double exact = atan2((double)y, (double)x) * 180.0 / M_PI;
+            double diff = fabs(exact - fastAtan2Deg(y, x));
+            if (diff > 180) diff = 360 - diff;  // ±180度の境界
+            if (diff > maxError) maxError = diff;
+        }
+    }
+    printBound("fastAtan2Deg [deg]", maxError, FAST_ATAN2_MAX_ERROR_DEG);
+}
+
+// 1e-6〜1e6を対数で走査（相対誤差）
+static void checkSqrt() {
+    double invError = 0, sqrtError = 0;
+    for (double x = 1e-6; x < 1e6; x *= 1.00005) {
+        float value = (float)x;
+        double exactSqrt = sqrt((double)value);
+        double inv = fabs(fastInvSqrt(value) * exactSqrt - 1.0);
+        double root = fabs(fastSqrt(value) / exactSqrt - 1.0);
+        if (inv > invError) invError = inv;
+        if (root > sqrtError) sqrtError = root;
+    }
+    printBound("fastInvSqrt [relative]", invError, FAST_INVSQRT_MAX_REL_ERROR);
+    printBound("fastSqrt [relative]", sqrtError, FAST_SQRT_MAX_REL_ERROR);
+}
+
+// 加速度センサー程度の大きさの入力
+static std::vector<float> makeInputs() {
+    std::vector<float> inputs;
+    for (int i = 0; i < 4096; i++) {
+        inputs.push_back(2.0f * sinf(i * 0.37f) + 0.01f * (i % 7));
+    }
+    return inputs;
+}
+
+template <typename Func>
+static void benchUnary(const char* name, const std::vector<float>& inputs, Func func) {
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT * 10; r++) {
+        for (float x : inputs) doNotOptimize(func(fabsf(x)));
+    }
+    printBenchResult(name, timer.elapsedNanos(), (uint64_t)inputs.size() * REPEAT * 10);
+}
+
+template <typename Func>
+static void benchBinary(const char* name, const std::vector<float>& inputs, Func func) {
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT * 10; r++) {
+        for (size_t i = 1; i < inputs.size(); i++) doNotOptimize(func(inputs[i], inputs[i - 1]));
+    }
+    printBenchResult(name, timer.elapsedNanos(), (uint64_t)(inputs.size() - 1) * REPEAT * 10);
+}
+
+void benchFastMath() {
+    checkAtan2();
+    checkSqrt();
+
+    std::vector<float> inputs = makeInputs();
+    benchBinary("libm atan2 (double)", inputs,
+                [](float y, float x) { return (float)(atan2(y, x) * 180.0 / M_PI); });
+    benchBinary("libm atan2f", inputs,
+                [](float y, float x) { return atan2f(y, x) * (180.0f / (float)M_PI); });
+    benchBinary("fastAtan2Deg", inputs, fastAtan2Deg);
+    benchUnary("libm sqrt (double)", inputs, [](float x) { return (float)sqrt(x); });
+    benchUnary("libm sqrtf", inputs, [](float x) { return sqrtf(x); });
+    benchUnary("fastSqrt", inputs, fastSqrt);
+    benchUnary("libm 1/sqrtf", inputs, [](float x) { return 1.0f / sqrtf(x); });
+    benchUnary("fastInvSqrt", inputs, fastInvSqrt);
+}
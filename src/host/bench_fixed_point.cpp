@@ -0,0 +1,183 @@
+// 固定小数点版のフィルター/PIDがfloat版と同じ結果になるかの確認と計算コストの比較
+// ホストにはFPUがあるため速度差は実機より小さく出る。実機では 'p' コマンドの
+// filter / pid ステージ（サイクル数）を USE_FIXED_POINT の有無で比べる
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "fixed_point.h"
+#include "attitude_filter.h"
+#include "pid_controller.h"
+#include "fixed_pid_controller.h"
+
+static const int REPEAT = 20;
+
+struct ImuInput {
+    float acc[3];
+    float gyro[3];
+    uint32_t dtMicros;
+};
+
+static float noise(float amplitude) {
+    return amplitude * ((rand() % 2001) / 1000.0f - 1.0f);
+}
+
+// ピッチ/ロールを正弦波で振った時のIMU値（ノイズと周期の揺らぎ付き）
+static std::vector<ImuInput> makeTrajectory(uint32_t periodMicros, float seconds) {
+    std::vector<ImuInput> inputs;
+    srand(1);
+    float t = 0;
+    while (t < seconds) {
+        ImuInput in;
+        in.dtMicros = periodMicros + rand() % 41 - 20;
+        t += in.dtMicros * 1e-6f;
+        float pitch = 20.0f * sinf(2 * (float)M_PI * 0.5f * t) * (float)M_PI / 180;
+        float roll = 30.0f * sinf(2 * (float)M_PI * 0.3f * t) * (float)M_PI / 180;
+        in.acc[0] = -sinf(pitch) + noise(0.02f);
+        in.acc[1] = cosf(pitch) * sinf(roll) + noise(0.02f);
+        in.acc[2] = cosf(pitch) * cosf(roll) + noise(0.02f);
+        in.gyro[0] = 30.0f * 2 * (float)M_PI * 0.3f * cosf(2 * (float)M_PI * 0.3f * t) + noise(0.5f);
+        in.gyro[1] = 20.0f * 2 * (float)M_PI * 0.5f * cosf(2 * (float)M_PI * 0.5f * t) + noise(0.5f);
+        in.gyro[2] = 3.0f + noise(0.5f);
+        inputs.push_back(in);
+    }
+    return inputs;
+}
+
+static float maxAbs(float current, float diff) {
+    diff = fabsf(diff);
+    return diff > current ? diff : current;
+}
+
+// 近似関数の誤差
+static void checkMath() {
+    // 半径が小さいと入力の量子化（1/65536）の影響が出るため、加速度の大きさ（約1g）以上で見る
+    double atanError = 0;
+    for (int i = 0; i < 3600; i++) {
+        double angle = (i - 1800) * M_PI / 1800.0;
+        for (double radius : { 0.5, 1.0, 2.0, 1000.0 }) {
+            float y = (float)(radius * sin(angle));
+            float x = (float)(radius * cos(angle));
+            double exact = atan2((double)y, (double)x) * 180.0 / M_PI;
+            double approx = q16ToFloat(q16Atan2Deg(q16FromFloat(y), q16FromFloat(x)));
+            double diff = fabs(exact - approx);
+            if (diff > 180) diff = 360 - diff;  // ±180度の境界
+            if (diff > atanError) atanError = diff;
+        }
+    }
+    double sqrtError = 0;
+    for (float x = 0.001f; x < 30000.0f; x *= 1.01f) {
+        double diff = fabs(sqrt((double)q16ToFloat(q16FromFloat(x))) - q16ToFloat(q16Sqrt(q16FromFloat(x))));
+        if (diff > sqrtError) sqrtError = diff;
+    }
+    printf("  q16Atan2Deg max error %.5f deg, q16Sqrt max error %.6f\n", atanError, sqrtError);
+}
+
+static const char* estimatorName(EstimatorType type) {
+    return type == ESTIMATOR_MAHONY ? "mahony" : "complementary";
+}
+
+// AutoControl（角度制御）と同じ組み合わせで両方を回し、最大差を表示（推定器は両方とも同じ種類）
+static void checkEquivalence(const char* name, const std::vector<ImuInput>& inputs, EstimatorType type) {
+    AngleFilter floatFilter;
+    FixedAngleFilter fixedFilter;
+    floatFilter.selectEstimator(type);
+    fixedFilter.selectEstimator(type);
+    PIDController floatPitch(0.8, 0.5, 0.5), floatYaw(0.8, 0.5, 0.5);
+    FixedPIDController fixedPitch(0.8, 0.5, 0.5), fixedYaw(0.8, 0.5, 0.5);
+    floatPitch.setOutputLimits(-90, 90);
+    floatYaw.setOutputLimits(-90, 90);
+    fixedPitch.setOutputLimits(-90, 90);
+    fixedYaw.setOutputLimits(-90, 90);
+
+    float pitchDiff = 0, rollDiff = 0, yawDiff = 0, elevatorDiff = 0, rudderDiff = 0;
+    int saturated = 0, saturationMismatch = 0;
+    for (const ImuInput& in : inputs) {
+        float dt = in.dtMicros * 1e-6f;
+        Q16TimeStep step = q16TimeStep(in.dtMicros);
+        floatFilter.update(in.acc[0], in.acc[1], in.acc[2], in.gyro[0], in.gyro[1], in.gyro[2], dt);
+        fixedFilter.update(q16FromFloat(in.acc[0]), q16FromFloat(in.acc[1]), q16FromFloat(in.acc[2]),
+                           q16FromFloat(in.gyro[0]), q16FromFloat(in.gyro[1]), q16FromFloat(in.gyro[2]),
+                           step);
+
+        // 目標は水平、ヨーは0度保持（積分が溜まって飽和する）
+        float elevator = floatPitch.calculate(0, floatFilter.getSmoothPitch(), dt);
+        float rudder = floatYaw.calculate(0, floatFilter.getYaw(), dt);
+        float fixedElevator = q16ToFloat(fixedPitch.calculate(0, fixedFilter.getSmoothPitch(), step));
+        float fixedRudder = q16ToFloat(fixedYaw.calculate(0, fixedFilter.getYaw(), step));
+
+        pitchDiff = maxAbs(pitchDiff, floatFilter.getPitch() - q16ToFloat(fixedFilter.getPitch()));
+        rollDiff = maxAbs(rollDiff, floatFilter.getRoll() - q16ToFloat(fixedFilter.getRoll()));
+        yawDiff = maxAbs(yawDiff, floatFilter.getYaw() - q16ToFloat(fixedFilter.getYaw()));
+        elevatorDiff = maxAbs(elevatorDiff, elevator - fixedElevator);
+        rudderDiff = maxAbs(rudderDiff, rudder - fixedRudder);
+
+        bool floatSaturated = fabsf(rudder) >= 90;
+        bool fixedSaturated = fabsf(fixedRudder) >= 90;
+        if (floatSaturated) saturated++;
+        if (floatSaturated != fixedSaturated) saturationMismatch++;
+    }
+    printf("  %s %s: %zu steps, max |float - fixed|: pitch %.4f roll %.4f yaw %.4f deg, "
+           "elevator %.4f rudder %.4f\n",
+           name, estimatorName(type), inputs.size(), pitchDiff, rollDiff, yawDiff, elevatorDiff, rudderDiff);
+    printf("  %s %s: rudder saturated %d steps, %d saturation mismatches\n",
+           name, estimatorName(type), saturated, saturationMismatch);
+}
+
+// 1周期分（フィルター + PID 2軸）の計算時間
+static void benchStep(const std::vector<ImuInput>& inputs, EstimatorType type) {
+    char label[48];
+    {
+        BenchTimer timer;
+        for (int r = 0; r < REPEAT; r++) {
+            AngleFilter filter;
+            filter.selectEstimator(type);
+            PIDController pitch(0.8, 0.5, 0.5), yaw(0.8, 0.5, 0.5);
+            pitch.setOutputLimits(-90, 90);
+            yaw.setOutputLimits(-90, 90);
+            for (const ImuInput& in : inputs) {
+                float dt = in.dtMicros * 1e-6f;
+                filter.update(in.acc[0], in.acc[1], in.acc[2], in.gyro[0], in.gyro[1], in.gyro[2], dt);
+                doNotOptimize(pitch.calculate(0, filter.getSmoothPitch(), dt));
+                doNotOptimize(yaw.calculate(0, filter.getYaw(), dt));
+            }
+        }
+        snprintf(label, sizeof(label), "float %s + 2 PID", estimatorName(type));
+        printBenchResult(label, timer.elapsedNanos(), (uint64_t)inputs.size() * REPEAT);
+    }
+    {
+        BenchTimer timer;
+        for (int r = 0; r < REPEAT; r++) {
+            FixedAngleFilter filter;
+            filter.selectEstimator(type);
+            FixedPIDController pitch(0.8, 0.5, 0.5), yaw(0.8, 0.5, 0.5);
+            pitch.setOutputLimits(-90, 90);
+            yaw.setOutputLimits(-90, 90);
+            for (const ImuInput& in : inputs) {
+                Q16TimeStep step = q16TimeStep(in.dtMicros);
+                filter.update(q16FromFloat(in.acc[0]), q16FromFloat(in.acc[1]), q16FromFloat(in.acc[2]),
+                              q16FromFloat(in.gyro[0]), q16FromFloat(in.gyro[1]), q16FromFloat(in.gyro[2]),
+                              step);
+                doNotOptimize(pitch.calculate(0, filter.getSmoothPitch(), step));
+                doNotOptimize(yaw.calculate(0, filter.getYaw(), step));
+            }
+        }
+        snprintf(label, sizeof(label), "fixed %s + 2 PID", estimatorName(type));
+        printBenchResult(label, timer.elapsedNanos(), (uint64_t)inputs.size() * REPEAT);
+    }
+}
+
+void benchFixedPoint() {
+    checkMath();
+    std::vector<ImuInput> slow = makeTrajectory(10000, 60);
+    std::vector<ImuInput> fast = makeTrajectory(1000, 60);
+    for (EstimatorType type : { ESTIMATOR_COMPLEMENTARY, ESTIMATOR_MAHONY }) {
+        checkEquivalence("100Hz", slow, type);
+        checkEquivalence("1kHz", fast, type);
+    }
+    benchStep(fast, ESTIMATOR_COMPLEMENTARY);
+    benchStep(fast, ESTIMATOR_MAHONY);
+}
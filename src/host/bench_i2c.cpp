@@ -0,0 +1,168 @@
+// I2CバスをIMUとOLEDで共有した時の制御周期への影響
+// 旧来の「画面全体を同期で送る」方式と、I2CBusManagerで空き時間に流す方式を仮想時間で比べる
+// 転送時間はMockI2CBusの見積もり（400kHz）なので、実機の絶対値とは少し異なる
+// 1kHzでは空き時間にOLEDのデータ転送が収まらず、予約の枠がないと表示は期限切れで送り直しが続く。
+// 予約の枠（IMUのトランザクション20回毎に1回）では、枠で流した周期だけ次の周期が遅れる代わりに表示が進む
+
+#include <stdio.h>
+#include "host_tools.h"
+#include "fake_hal.h"
+#include "control_scheduler.h"
+#include "i2c_bus_manager.h"
+#include "mpu6050_driver.h"
+
+static const uint8_t DISPLAY_ADDRESS = 0x3C;
+static const uint32_t CONTROL_WORK_MICROS = 300;    // IMU読み出し以外の制御処理
+static const uint32_t FRAME_INTERVAL_MICROS = 100000;
+static const uint32_t IDLE_MARGIN_MICROS = 100;
+static const uint8_t PAGES = 5;
+
+// u8g2がSSD1306の1ページ（72バイト）を送る時のトランザクション列
+// コマンド3回（列・ページの指定）+ データ24バイトずつ3回
+static const uint8_t PAGE_TRANSACTIONS = 6;
+static size_t pageTransaction(uint8_t index, uint8_t* data) {
+    if (index < 3) {
+        data[0] = 0x00;
+        data[1] = 0xB0 + index;
+        return 2;
+    }
+    data[0] = 0x40;
+    for (int i = 1; i <= 24; i++) data[i] = (uint8_t)i;
+    return 25;
+}
+
+struct Result {
+    uint32_t maxJitter;
+    uint32_t overruns;
+    uint32_t maxImuMicros;
+    uint32_t frames;
+    uint32_t maxFrameMicros;
+};
+
+struct Scenario {
+    const char* name;
+    bool managed;
+    uint16_t rateHz;
+    float seconds;
+    bool injectFaults;
+    uint16_t reserve;       // 表示の最低限の枠（IMUのトランザクション数、0で無効）
+};
+
+static Result runScenario(const Scenario& scenario, bool printStats) {
+    FakeClock clock(1);
+    FakeMpu6050Bus imuDevice;
+    MockI2CBus bus(clock);
+    bus.attach(Mpu6050Driver::ADDRESS_LOW, &imuDevice);
+    bus.attach(DISPLAY_ADDRESS, nullptr);
+    
+    I2CBusManager manager(bus, clock);
+    manager.setLowPriorityReserve(scenario.reserve);
+    ManagedI2CBus imuBus(manager, "imu", I2C_PRIORITY_HIGH, 1);
+    ManagedI2CBus displayBus(manager, "display", I2C_PRIORITY_LOW, 1);
+    Mpu6050Driver imu(imuBus);
+    Mpu6050Config imuConfig = { 3, 0, true, -1 };
+    imu.begin(Mpu6050Driver::ADDRESS_LOW, imuConfig);
+    
+    ControlScheduler scheduler(clock, scenario.rateHz);
+    scheduler.begin();
+    manager.resetStats();
+    
+    const float acc[3] = { 0, 0, 1 };
+    const float gyro[3] = { 0, 0, 0 };
+    uint32_t samplesPerTick = 1000 / scheduler.getRate();
+    uint32_t ticks = (uint32_t)(scenario.seconds * scheduler.getRate());
+    
+    Result result = {};
+    uint32_t nextFrame = clock.micros();
+    uint32_t frameStart = 0;
+    bool frameActive = false;
+    uint8_t nextPage = 0;
+    
+    for (uint32_t i = 0; i < ticks; i++) {
+        scheduler.waitForTick();
+        if (i > 0 && scheduler.getLastJitter() > result.maxJitter) result.maxJitter = scheduler.getLastJitter();
+        
+        // 1秒目に2回失敗（リトライで回復）、2秒目にバス固着（回復処理で復帰）
+        if (scenario.injectFaults && i == scheduler.getRate()) bus.failuresToInject = 2;
+        if (scenario.injectFaults && i == 2u * scheduler.getRate()) bus.stuck = true;
+        
+        for (uint32_t n = 0; n < samplesPerTick; n++) imuDevice.pushSample(acc, gyro, 25.0f);
+        uint32_t imuStart = clock.micros();
+        imu.update();
+        uint32_t imuMicros = clock.micros() - imuStart;
+        if (imuMicros > result.maxImuMicros) result.maxImuMicros = imuMicros;
+        clock.advance(CONTROL_WORK_MICROS);
+        
+        if (!frameActive && (int32_t)(clock.micros() - nextFrame) >= 0) {
+            frameActive = true;
+            frameStart = clock.micros();
+            nextFrame += FRAME_INTERVAL_MICROS;
+            nextPage = 0;
+        }
+        
+        uint8_t data[32];
+        if (frameActive && !scenario.managed) {
+            // 旧方式: 画面全体をその場で送る
+            for (uint8_t page = 0; page < PAGES; page++) {
+                for (uint8_t t = 0; t < PAGE_TRANSACTIONS; t++) {
+                    size_t length = pageTransaction(t, data);
+                    bus.write(DISPLAY_ADDRESS, data, length);
+                }
+            }
+            nextPage = PAGES;
+        } else if (frameActive && displayBus.getPendingCount() == 0 && nextPage < PAGES) {
+            // 1ページ分を積む（DisplayController::queueNextPage()と同じ）
+            for (uint8_t t = 0; t < PAGE_TRANSACTIONS; t++) {
+                size_t length = pageTransaction(t, data);
+                displayBus.submitWrite(DISPLAY_ADDRESS, data, length, 200000);
+            }
+            nextPage++;
+        }
+        
+        if (scenario.managed) {
+            uint32_t idle = scheduler.getTimeUntilNextTick();
+            manager.poll(idle > IDLE_MARGIN_MICROS ? idle - IDLE_MARGIN_MICROS : 0);
+        }
+        
+        if (frameActive && nextPage >= PAGES && displayBus.getPendingCount() == 0) {
+            frameActive = false;
+            result.frames++;
+            uint32_t frameMicros = clock.micros() - frameStart;
+            if (frameMicros > result.maxFrameMicros) result.maxFrameMicros = frameMicros;
+        }
+    }
+    result.overruns = scheduler.getOverrunCount();
+    
+    if (printStats) {
+        printf("    device     count errors retries expired dropped   min  mean   max [us]  bytes/s\n");
+        for (uint8_t d = 0; d < manager.getDeviceCount(); d++) {
+            const I2CDeviceStats& stats = manager.getStats(d);
+            printf("    %-8s %7u %6u %7u %7u %7u %5u %5u %5u %8u\n", manager.getDeviceName(d),
+                   stats.transactions, stats.errors, stats.retries, stats.expired, stats.dropped,
+                   stats.transactions > 0 ? stats.minLatencyMicros : 0, manager.getMeanLatency(d),
+                   stats.maxLatencyMicros, manager.getBytesPerSecond(d));
+        }
+        printf("    bus recoveries %u\n", manager.getRecoveryCount());
+    }
+    return result;
+}
+
+void benchI2C() {
+    static const Scenario scenarios[] = {
+        { "direct", false, 250, 5, false, 0 },
+        { "managed", true, 250, 5, false, 0 },
+        { "direct", false, 500, 5, false, 0 },
+        { "managed", true, 500, 5, false, 0 },
+        { "direct", false, 1000, 5, false, 0 },
+        { "managed", true, 1000, 5, false, 0 },
+        { "managed+reserve", true, 1000, 5, false, 20 },
+        { "managed+faults", true, 250, 5, true, 0 },
+    };
+    for (const Scenario& scenario : scenarios) {
+        printf("  %-15s %4uHz:", scenario.name, scenario.rateHz);
+        Result result = runScenario(scenario, false);
+        printf(" jitter max %5u us, overruns %4u, imu read max %4u us, frames %3u (max %7u us)\n",
+               result.maxJitter, result.overruns, result.maxImuMicros, result.frames, result.maxFrameMicros);
+        if (scenario.injectFaults) runScenario(scenario, true);
+    }
+}
@@ -0,0 +1,171 @@
+// 制御モードの実行時切り替えのコストと、切り替え時の舵の連続性
+// 以前の #ifdef ビルドは1つのモードだけを直接呼んでいたので、モードのクラスを直接回したものと
+// AutoControl（モード判定 + 選ばれていないモードの推定）を同じ入力で比べる
+// 加速度制御は、モード判定だけ（姿勢推定を止めたもの）と加速度制御の間の姿勢推定を分けて測る
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "auto_control.h"
+
+static const uint32_t PERIOD_MICROS = 2000;
+static const uint16_t CONTROL_RATE_HZ = 1000000 / PERIOD_MICROS;
+static const int REPEAT = 50;
+
+static float noise(float amplitude) {
+    return amplitude * ((rand() % 2001) / 1000.0f - 1.0f);
+}
+
+// ピッチ/ロールを揺らした時のIMU値（ノイズ付き、scaleで角度の大きさを変える）
+static std::vector<ControlInputs> makeInputs(float seconds, float scale) {
+    std::vector<ControlInputs> inputs;
+    srand(5);
+    for (float t = 0; t < seconds; t += PERIOD_MICROS * 1e-6f) {
+        float pitch = 20.0f * scale * sinf(2 * (float)M_PI * 0.5f * t) * (float)M_PI / 180;
+        float roll = 30.0f * scale * sinf(2 * (float)M_PI * 0.3f * t) * (float)M_PI / 180;
+        ControlInputs in = {};
+        in.acc[0] = -sinf(pitch) + noise(0.05f);
+        in.acc[1] = cosf(pitch) * sinf(roll) + noise(0.05f);
+        in.acc[2] = cosf(pitch) * cosf(roll) + noise(0.05f);
+        in.gyro[0] = 30.0f * scale * 2 * (float)M_PI * 0.3f * cosf(2 * (float)M_PI * 0.3f * t) + noise(0.5f);
+        in.gyro[1] = 20.0f * scale * 2 * (float)M_PI * 0.5f * cosf(2 * (float)M_PI * 0.5f * t) + noise(0.5f);
+        in.gyro[2] = 3.0f + noise(0.5f);
+        inputs.push_back(in);
+    }
+    return inputs;
+}
+
+// 1周期分（推定 + エレベーター/ラダー）。インライン展開で差が隠れないよう関数を分ける
+__attribute__((noinline)) static float angleOnlyTick(AngleModeControl& control, const ControlInputs& in,
+                                                    const ControlStep& step) {
+    control.update(in, PERIOD_MICROS, step);
+    control.setTargetOffsets(in.targetOffset);
+    return fromControlValue(control.computeElevator(step)) + fromControlValue(control.computeRudder(step));
+}
+
+__attribute__((noinline)) static float accelOnlyTick(AccelModeControl& control, const ControlInputs& in,
+                                                    const ControlStep& step) {
+    control.update(in);
+    control.setTargetOffsets(in.targetOffset);
+    return fromControlValue(control.computeElevator(step)) + fromControlValue(control.computeRudder(step));
+}
+
+__attribute__((noinline)) static float autoControlTick(AutoControl& control, const ControlInputs& in) {
+    const ControlOutputs& outputs = control.step(PERIOD_MICROS, in);
+    return outputs.elevator.value + outputs.rudder.value;
+}
+
+// 加速度制御の間の姿勢推定だけ（AutoControl::stepの中で加速度制御に足される分）
+__attribute__((noinline)) static float backgroundTick(AngleModeControl& control, const ControlInputs& in) {
+    control.updateBackground(in, PERIOD_MICROS);
+    return control.getCurrentPitch();
+}
+
+// 1周期あたりの時間[ns]を表示して返す
+template <typename Tick>
+static double benchTicks(const char* name, const std::vector<ControlInputs>& inputs, Tick tick) {
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT; r++) {
+        for (const ControlInputs& in : inputs) {
+            doNotOptimize(tick(in));
+        }
+    }
+    double nanos = timer.elapsedNanos();
+    uint64_t ticks = (uint64_t)inputs.size() * REPEAT;
+    printBenchResult(name, nanos, ticks);
+    return nanos / ticks;
+}
+
+static void benchDispatch(const std::vector<ControlInputs>& inputs) {
+    ControlStep step = toControlStep(PERIOD_MICROS);
+    AngleModeControl angle, background;
+    AccelModeControl accel;
+    AutoControl autoAngle, autoAccel, autoAccelDispatch;
+    angle.begin(CONTROL_RATE_HZ);
+    background.begin(CONTROL_RATE_HZ);
+    accel.begin();
+    autoAngle.begin(CONTROL_RATE_HZ);
+    autoAccel.begin(CONTROL_RATE_HZ);
+    autoAccel.setMode(CONTROL_MODE_ACCEL);
+    autoAccelDispatch.begin(CONTROL_RATE_HZ);
+    autoAccelDispatch.setMode(CONTROL_MODE_ACCEL);
+    autoAccelDispatch.setBackgroundEstimation(false);
+
+    // 測定の順番による差を見るため2回ずつ
+    for (int round = 0; round < 2; round++) {
+        benchTicks("angle only (#ifdef)", inputs, [&](const ControlInputs& in) { return angleOnlyTick(angle, in, step); });
+        benchTicks("AutoControl angle", inputs, [&](const ControlInputs& in) { return autoControlTick(autoAngle, in); });
+        double accelOnly = benchTicks("accel only (#ifdef)", inputs,
+                                      [&](const ControlInputs& in) { return accelOnlyTick(accel, in, step); });
+        double dispatch = benchTicks("AutoControl accel (no attitude)", inputs,
+                                     [&](const ControlInputs& in) { return autoControlTick(autoAccelDispatch, in); });
+        double estimate = benchTicks("attitude while accel", inputs,
+                                     [&](const ControlInputs& in) { return backgroundTick(background, in); });
+        double total = benchTicks("AutoControl accel", inputs, [&](const ControlInputs& in) { return autoControlTick(autoAccel, in); });
+        printf("  accel: dispatch %+.1f ns, attitude while accel %+.1f ns (total %+.1f ns over accel only)\n",
+               dispatch - accelOnly, estimate, total - accelOnly);
+    }
+}
+
+static void beginMode(AngleModeControl& control) {
+    control.begin(CONTROL_RATE_HZ);
+}
+
+static void beginMode(AccelModeControl& control) {
+    control.begin();
+}
+
+static void updateMode(AngleModeControl& control, const ControlInputs& in, const ControlStep& step) {
+    control.update(in, PERIOD_MICROS, step);
+}
+
+static void updateMode(AccelModeControl& control, const ControlInputs& in, const ControlStep&) {
+    control.update(in);
+}
+
+// 制御中にモードを切り替えた時のエレベーター出力の段差
+// PIDの状態を引き継がない場合（切り替え先のPIDを0から始める）と比べる
+template <typename From, typename To>
+static void checkTransfer(const std::vector<ControlInputs>& inputs, const char* fromName, const char* toName) {
+    const size_t switchIndex = inputs.size() / 2;
+    ControlStep step = toControlStep(PERIOD_MICROS);
+    float steps[2];
+    for (int bumpless = 0; bumpless < 2; bumpless++) {
+        From from;
+        To to;
+        beginMode(from);
+        beginMode(to);
+        float before = 0, after = 0;
+        for (size_t i = 0; i <= switchIndex; i++) {
+            const ControlInputs& in = inputs[i];
+            updateMode(from, in, step);
+            updateMode(to, in, step);
+            if (i == 0) from.holdCurrent();
+            if (i < switchIndex) {
+                from.setTargetOffsets(in.targetOffset);
+                before = fromControlValue(from.computeElevator(step));
+                continue;
+            }
+            to.holdCurrent();
+            to.setTargetOffsets(in.targetOffset);
+            ControlOutputs previous = {};
+            previous.elevator.value = bumpless ? before : 0.0f;
+            to.transfer(previous);
+            after = fromControlValue(to.computeElevator(step));
+        }
+        steps[bumpless] = fabsf(after - before);
+    }
+    printf("  %s -> %s: elevator step at switch %.2f%% (without transfer %.2f%%)\n",
+           fromName, toName, steps[1], steps[0]);
+}
+
+void benchModes() {
+    // 切り替えは舵が飽和しない程度の揺れで見る
+    std::vector<ControlInputs> gentle = makeInputs(10, 0.2f);
+    checkTransfer<AngleModeControl, AccelModeControl>(gentle, "angle", "accel");
+    checkTransfer<AccelModeControl, AngleModeControl>(gentle, "accel", "angle");
+    benchDispatch(makeInputs(20, 1.0f));
+}
@@ -0,0 +1,149 @@
+// パススルーの出力を、制御周期毎に書く以前の方式と、受信機のパルス毎に書く方式（PassthroughOutput）で比べる
+//   50Hzのフレーム（制御周期と同期しない）を10秒分、500Hzの制御周期で受ける
+//   周期の処理時間と、割り込みから制御タスクが動き出すまでの時間は固定値で模擬する
+//   サーボへの書き込み回数（フレームあたり）と、フレームが確定してから書くまでの遅れを比べる
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "host_tools.h"
+#include "fake_hal.h"
+#include "control_scheduler.h"
+#include "passthrough_output.h"
+#include "pwm_receiver_backend.h"
+
+static const int ELEVATOR_PIN = 21;
+static const int RUDDER_PIN = 1;
+static const int LED_PIN = 10;
+static const uint16_t CONTROL_RATE_HZ = 500;
+static const uint32_t FRAME_MICROS = 20007;
+static const uint32_t TICK_WORK_MICROS = 300;   // 制御周期の処理時間（IMU、ブラックボックス、テレメトリ）
+static const uint32_t WAKE_MICROS = 15;         // 割り込みから制御タスクが動き出すまで
+static const uint32_t SECONDS = 10;
+
+// 待機や処理で時刻を進める途中で、受信機のパルスを発生させる時刻源
+// 待機中にパルスで起こされたら（wakeFromIsr）そこで待機を終える
+class EdgeClock : public FakeClock {
+private:
+    FakePwmInput* input = nullptr;
+    uint32_t nextFrame = 1000;
+    uint16_t pulseWidth = 1500;
+    bool woken = false;
+
+    // endまでに届くパルスを発生させる（stopOnWakeなら起こされた所で止まる）
+    bool runUntil(uint32_t end, bool stopOnWake) {
+        while ((int32_t)(nextFrame - end) <= 0) {
+            set(nextFrame);
+            pulseWidth = pulseWidth >= 1900 ? 1100 : pulseWidth + 1;
+            input->pulse(LED_PIN, 1000);
+            input->pulse(ELEVATOR_PIN, pulseWidth);
+            input->pulse(RUDDER_PIN, pulseWidth);
+            nextFrame += FRAME_MICROS;
+            frames++;
+            if (woken && stopOnWake) {
+                woken = false;
+                advance(WAKE_MICROS);
+                return true;
+            }
+        }
+        set(end);
+        return false;
+    }
+
+public:
+    uint32_t frames = 0;
+
+    EdgeClock() : FakeClock(0) {}
+    void attach(FakePwmInput& pwm) { input = &pwm; }
+
+    void delayMicros(uint32_t us) override {
+        // 待機の前に届いていた分はすぐ戻る
+        if (woken) {
+            woken = false;
+            return;
+        }
+        runUntil(micros() + us, true);
+    }
+    void wakeFromIsr() override { woken = true; }
+
+    // 周期の処理（この間に届いたパルスは次の待機をすぐ終わらせる）
+    void work(uint32_t us) { runUntil(micros() + us, false); }
+};
+
+struct PassthroughResult {
+    uint32_t frames;
+    uint32_t writes;
+    std::vector<uint32_t> latency;
+};
+
+static PassthroughResult run(bool edge) {
+    EdgeClock clock;
+    FakePwmInput pwmInput(clock);
+    clock.attach(pwmInput);
+    FakeServoDriver elevatorDriver, rudderDriver;
+    ServoOutput elevatorServo(elevatorDriver, 20, "elevator");
+    ServoOutput rudderServo(rudderDriver, 2, "rudder");
+    PwmReceiverBackend backend(pwmInput, clock, ELEVATOR_PIN, RUDDER_PIN, LED_PIN);
+    RCReceiver receiver(backend, clock);
+    RcConditioner conditioner;
+    PassthroughOutput output(clock, elevatorServo, rudderServo, conditioner);
+    ControlScheduler scheduler(clock, CONTROL_RATE_HZ);
+
+    receiver.begin();
+    conditioner.begin(DEFAULT_RC_CURVE, DEFAULT_RC_CURVE);
+    elevatorServo.begin();
+    rudderServo.begin();
+    if (edge) backend.setWakeClock(&clock);
+    scheduler.begin();
+
+    PassthroughResult r = {};
+    uint32_t writesAtStart = elevatorDriver.writeCount;
+    uint32_t framesAtStart = clock.frames;
+    uint32_t counted = 0;
+    uint32_t end = SECONDS * 1000000;
+    while (clock.micros() < end) {
+        if (edge) {
+            if (!scheduler.waitForTickOrWake()) {
+                receiver.updateBetweenTicks();
+                output.service(receiver);
+            } else {
+                receiver.update();
+                output.service(receiver);
+                clock.work(TICK_WORK_MICROS);
+            }
+            while (counted < output.getFrameCount()) {
+                r.latency.push_back(output.getLastLatency());
+                counted++;
+            }
+        } else {
+            // 以前: 周期毎にRCReceiverの値を書く（フレームが届いた周期の書き込みで遅れを測る）
+            scheduler.waitForTick();
+            const RCSnapshot& snapshot = receiver.update();
+            elevatorServo.writeValue(conditioner.getCurve(RC_AXIS_ELEVATOR).apply(snapshot.pulseWidth[0]));
+            rudderServo.writeValue(conditioner.getCurve(RC_AXIS_RUDDER).apply(snapshot.pulseWidth[1]));
+            if (snapshot.updated[0]) r.latency.push_back(clock.micros() - snapshot.pulseTime[0]);
+            clock.work(TICK_WORK_MICROS);
+        }
+    }
+    r.frames = clock.frames - framesAtStart;
+    r.writes = elevatorDriver.writeCount - writesAtStart;
+    return r;
+}
+
+static void printResult(const char* name, PassthroughResult r) {
+    std::vector<uint32_t>& latency = r.latency;
+    std::sort(latency.begin(), latency.end());
+    uint64_t sum = 0;
+    for (uint32_t value : latency) sum += value;
+    size_t n = latency.size();
+    printf("  %-22s frames %5u | writes/frame %6.2f | latency mean %5.0f p99 %5u max %5u us\n", name, r.frames,
+           (double)r.writes / r.frames, n > 0 ? (double)sum / n : 0.0, n > 0 ? latency[n * 99 / 100] : 0,
+           n > 0 ? latency[n - 1] : 0);
+}
+
+void benchPassthrough() {
+    printf("50Hz frames, %uHz control, tick work %uus, wake %uus:\n", CONTROL_RATE_HZ, TICK_WORK_MICROS,
+           WAKE_MICROS);
+    printResult("every tick (before)", run(false));
+    printResult("on receiver edge", run(true));
+}
@@ -0,0 +1,202 @@
+// PIDControllerの応答を以前の実装（legacy_pid.h）と比べる
+// 模擬機体: 舵[%] → ピッチ角速度（1次遅れ）→ ピッチ角。ゲインは以前の単一ループと同じ 0.8/0.5/0.5
+//   step:     目標 0 → 15度。微分の跳ね（目標が変わった周期の舵の変化）、行き過ぎ、整定時間
+//   windup:   舵を±30%に制限し、機体を5秒まで押さえたまま目標15度。放した後の行き過ぎと整定
+//             （押さえている間の積分は舵の制限に当たる前から溜まるため、バックカリキュレーションだけでは戻らない。
+//              積分の上限でトリム分だけに絞ると、通常のステップと同程度の行き過ぎで整定する）
+//   noise:    測定値にノイズを足して一定の目標を保つ。舵のばらつき（微分フィルターの効果）
+//   rate:     角速度の目標（内側ループ相当、3/6/0.02）を段階的に変える。フィードフォワードの有無を比べる
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "legacy_pid.h"
+#include "pid_controller.h"
+
+static const float DT = 0.002f;           // 500Hz
+static const float PLANT_GAIN = 4.0f;     // 舵1%あたりの角速度[deg/s]
+static const float PLANT_TAU = 0.15f;     // 角速度の遅れ[秒]
+static const float WINDUP_INTEGRAL_LIMIT = 5.0f;  // windupで使う積分の上限[%]
+
+struct Plant {
+    float rate = 0;
+    float angle = 0;
+    float& measured(bool controlRate) { return controlRate ? rate : angle; }
+
+    void step(float u) {
+        rate += (PLANT_GAIN * u - rate) * DT / PLANT_TAU;
+        angle += rate * DT;
+    }
+};
+
+struct Response {
+    float kick = 0;         // 目標が変わった周期の舵の変化[%]
+    float overshoot = 0;    // 最終目標を越えた量[度]
+    float settleTime = -1;  // 最終目標の±2%に入ったまま出なくなった時刻[秒]
+    float iae = 0;          // 誤差の絶対値の積分[度・秒]
+    float outputStd = 0;    // 舵の標準偏差[%]
+};
+
+static float gaussian() {
+    // Box-Muller
+    float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+// target(t)に沿って制御し、最後の目標値に対する応答を集計する
+template <typename Controller, typename Target>
+static Response simulate(Controller& pid, Target target, float seconds, float noise, bool controlRate = false,
+                         float releaseTime = 0) {
+    Response r;
+    Plant plant;
+    srand(7);
+    float previousOutput = 0, previousTarget = target(0.0f);
+    float finalTarget = target(seconds);
+    bool rising = finalTarget >= previousTarget;    // 最後の目標に向かう向き
+    float band = fmaxf(fabsf(finalTarget) * 0.02f, 0.2f);
+    double sum = 0, sumSquared = 0;
+    int count = 0;
+    for (float t = 0; t < seconds; t += DT) {
+        float sp = target(t);
+        float measured = plant.measured(controlRate) + (noise > 0 ? noise * gaussian() : 0.0f);
+        float u = pid.calculate(sp, measured, DT);
+        if (sp != previousTarget) {
+            r.kick = fmaxf(r.kick, fabsf(u - previousOutput));
+            if (sp == finalTarget) rising = sp > previousTarget;
+        }
+        if (t >= releaseTime) plant.step(u);
+        float value = plant.measured(controlRate);
+        float error = value - sp;
+        r.iae += fabsf(error) * DT;
+        if (sp == finalTarget) {
+            float beyond = rising ? value - finalTarget : finalTarget - value;
+            r.overshoot = fmaxf(r.overshoot, beyond);
+            if (fabsf(error) > band) r.settleTime = -1;
+            else if (r.settleTime < 0) r.settleTime = t;
+        }
+        sum += u;
+        sumSquared += (double)u * u;
+        count++;
+        previousOutput = u;
+        previousTarget = sp;
+    }
+    double mean = sum / count;
+    r.outputStd = (float)sqrt(fmax(sumSquared / count - mean * mean, 0.0));
+    return r;
+}
+
+static void printResponse(const char* name, const Response& r) {
+    printf("  %-28s kick %6.2f%% | overshoot %5.2f | settle %5.2fs | iae %6.3f | output std %5.2f%%\n",
+           name, r.kick, r.overshoot, r.settleTime, r.iae, r.outputStd);
+}
+
+// 以前の単一ループのゲイン
+static LegacyPIDController makeLegacy(float limit) {
+    LegacyPIDController pid(0.8f, 0.5f, 0.5f);
+    pid.setOutputLimits(-limit, limit);
+    return pid;
+}
+
+static PIDController makeCurrent(float limit, DerivativeFilterType filter = DERIVATIVE_FILTER_NONE) {
+    PIDController pid(0.8f, 0.5f, 0.5f);
+    pid.setOutputLimits(-limit, limit);
+    pid.setDerivativeFilter(filter, 30.0f, 1.0f / DT);
+    return pid;
+}
+
+static void compareStep() {
+    printf("  step 0 -> 15 deg (at 0.5s)\n");
+    auto target = [](float t) { return t < 0.5f ? 0.0f : 15.0f; };
+    LegacyPIDController legacy = makeLegacy(90);
+    PIDController current = makeCurrent(90);
+    printResponse("legacy", simulate(legacy, target, 10.0f, 0));
+    printResponse("current", simulate(current, target, 10.0f, 0));
+}
+
+static void compareWindup() {
+    printf("  windup: target 15 deg, airframe held level until 5s (output limit 30%%)\n");
+    auto target = [](float t) { return t < 0.5f ? 0.0f : 15.0f; };
+    LegacyPIDController legacy = makeLegacy(30);
+    PIDController current = makeCurrent(30);
+    printResponse("legacy", simulate(legacy, target, 12.0f, 0, false, 5.0f));
+    printResponse("current (back-calculation)", simulate(current, target, 12.0f, 0, false, 5.0f));
+    PIDController limited = makeCurrent(30);
+    limited.setIntegralLimit(WINDUP_INTEGRAL_LIMIT);
+    printResponse("current + integral limit 5%", simulate(limited, target, 12.0f, 0, false, 5.0f));
+}
+
+static void compareNoise() {
+    printf("  noise 0.3 deg rms, hold 5 deg (D filter 30Hz)\n");
+    auto target = [](float) { return 5.0f; };
+    LegacyPIDController legacy = makeLegacy(90);
+    PIDController none = makeCurrent(90);
+    PIDController firstOrder = makeCurrent(90, DERIVATIVE_FILTER_FIRST_ORDER);
+    PIDController biquad = makeCurrent(90, DERIVATIVE_FILTER_BIQUAD);
+    printResponse("legacy", simulate(legacy, target, 5.0f, 0.3f));
+    printResponse("current", simulate(none, target, 5.0f, 0.3f));
+    printResponse("current + 1st order", simulate(firstOrder, target, 5.0f, 0.3f));
+    printResponse("current + biquad", simulate(biquad, target, 5.0f, 0.3f));
+}
+
+static void compareFeedForward() {
+    printf("  rate 0 -> 60 -> -30 deg/s, inner loop gains\n");
+    auto target = [](float t) { return t < 0.5f ? 0.0f : t < 1.5f ? 60.0f : -30.0f; };
+    PIDController plain(3.0f, 6.0f, 0.02f);
+    PIDController withFF(3.0f, 6.0f, 0.02f);
+    plain.setOutputLimits(-90, 90);
+    withFF.setOutputLimits(-90, 90);
+    // 定常で必要な舵 = 目標角速度 / 模擬機体のゲイン
+    withFF.setFeedForward(1.0f / PLANT_GAIN);
+    printResponse("current", simulate(plain, target, 3.0f, 0, true));
+    printResponse("current + feed-forward", simulate(withFF, target, 3.0f, 0, true));
+}
+
+// ki = 0: 以前は outputMax / ki で0除算になっていた
+static void checkZeroKi() {
+    PIDController pid(0.8f, 0.0f, 0.5f);
+    pid.setOutputLimits(-90, 90);
+    auto target = [](float t) { return t < 0.5f ? 0.0f : 15.0f; };
+    Response r = simulate(pid, target, 5.0f, 0);
+    printf("  ki = 0: integral %.3f, finite output %s\n", pid.getIntegral(),
+           isfinite(pid.getLastP() + pid.getLastD()) ? "yes" : "no");
+    printResponse("current (P + D only)", r);
+}
+
+static void benchCalculate() {
+    std::vector<float> inputs;
+    srand(3);
+    for (int i = 0; i < 10000; i++) inputs.push_back(5.0f + gaussian());
+    const int repeat = 100;
+
+    LegacyPIDController legacy = makeLegacy(90);
+    BenchTimer legacyTimer;
+    for (int r = 0; r < repeat; r++) {
+        for (float in : inputs) doNotOptimize(legacy.calculate(5.0f, in, DT));
+    }
+    printBenchResult("legacy calculate", legacyTimer.elapsedNanos(), (uint64_t)inputs.size() * repeat);
+
+    const DerivativeFilterType filters[] = { DERIVATIVE_FILTER_NONE, DERIVATIVE_FILTER_FIRST_ORDER,
+                                             DERIVATIVE_FILTER_BIQUAD };
+    const char* names[] = { "calculate", "calculate + 1st order", "calculate + biquad" };
+    for (int f = 0; f < 3; f++) {
+        PIDController pid = makeCurrent(90, filters[f]);
+        BenchTimer timer;
+        for (int r = 0; r < repeat; r++) {
+            for (float in : inputs) doNotOptimize(pid.calculate(5.0f, in, DT));
+        }
+        printBenchResult(names[f], timer.elapsedNanos(), (uint64_t)inputs.size() * repeat);
+    }
+}
+
+void benchPid() {
+    compareStep();
+    compareWindup();
+    compareNoise();
+    compareFeedForward();
+    checkZeroKi();
+    benchCalculate();
+}
@@ -0,0 +1,123 @@
+// 受信機の値の前処理（RcConditioner）の比較
+//   curve: パルス幅 → 値。以前の整数のmap()と表の補間の時間と、1000〜2000μsで取りうる値の数
+//   stick: 50Hzのフレームを500Hzの制御周期で読む。スティックは1Hzの正弦波（±50%）
+//          階段（フレームの値のまま）、補間、補間+フィードフォワードで、目標角度の1周期の跳ね、
+//          舵の1周期の変化、連続なスティックに対する追従の誤差を比べる
+//          模擬機体とゲインは bench pid と同じ（外側は比例のみ）
+
+#include <math.h>
+#include <stdio.h>
+#include <set>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "rc_conditioner.h"
+#include "rc_receiver.h"
+#include "pid_controller.h"
+
+static const uint32_t TICK_MICROS = 2000;       // 500Hz
+static const uint32_t FRAME_MICROS = 20000;     // 50Hz
+static const float STICK_SCALE = 0.05f;         // 値 → 目標角度[deg]（main.cppの姿勢制御モード）
+static const float ANGLE_KP = 4.0f;             // 角度誤差1degあたりの目標角速度[deg/s]
+static const float PLANT_GAIN = 4.0f;           // 舵1%あたりの角速度[deg/s]
+static const float PLANT_TAU = 0.15f;
+
+static void benchCurve() {
+    RcCurve curve;
+    const int iterations = 10000000;
+    BenchTimer mapTimer;
+    long mapSum = 0;
+    for (int i = 0; i < iterations; i++) {
+        mapSum += RCReceiver::pulseToValue(1000 + (i % 1001));
+    }
+    doNotOptimize(mapSum);
+    printBenchResult("map() (integer)", mapTimer.elapsedNanos(), iterations);
+
+    BenchTimer curveTimer;
+    float curveSum = 0;
+    for (int i = 0; i < iterations; i++) {
+        curveSum += curve.apply(1000 + (i % 1001));
+    }
+    doNotOptimize(curveSum);
+    printBenchResult("RcCurve::apply (table)", curveTimer.elapsedNanos(), iterations);
+
+    std::set<long> mapLevels;
+    std::set<float> curveLevels;
+    for (int pulse = 1000; pulse <= 2000; pulse++) {
+        mapLevels.insert(RCReceiver::pulseToValue(pulse));
+        curveLevels.insert(curve.apply(pulse));
+    }
+    printf("  distinct values over 1000-2000us: map %zu, curve %zu (deadband %.0f%%)\n", mapLevels.size(),
+           curveLevels.size(), DEFAULT_RC_CURVE.deadband);
+}
+
+struct StickResult {
+    float setpointStep = 0;     // 目標角度の1周期の変化の最大[deg]
+    float outputStep = 0;       // 舵の1周期の変化の最大[%]
+    float outputStepRms = 0;    // 舵の1周期の変化の実効値[%]
+    float trackRms = 0;         // 連続なスティックの目標に対する機体の角度の誤差[deg]
+};
+
+static StickResult runStick(bool smoothing, float feedForward) {
+    RcConditioner conditioner;
+    conditioner.begin(DEFAULT_RC_CURVE, DEFAULT_RC_CURVE);
+    conditioner.setSmoothing(smoothing);
+    PIDController ratePID(3.0f, 6.0f, 0.02f);
+    ratePID.setOutputLimits(-90, 90);
+    float rate = 0, angle = 0, previousSetpoint = 0, previousOutput = 0;
+    double stepSquared = 0, trackSquared = 0;
+    StickResult r;
+    const uint32_t ticks = 5 * 1000000 / TICK_MICROS;
+    uint32_t frameTime = 0;
+    uint16_t pulse = 1500;
+    for (uint32_t i = 0; i < ticks; i++) {
+        uint32_t now = i * TICK_MICROS;
+        float t = now * 1e-6f;
+        float stick = 50.0f * sinf(2.0f * (float)M_PI * t);
+        RcChannelFrame frame = { pulse, false, now - frameTime, FRAME_MICROS };
+        // フレームは制御周期と同期していない（7μsずつずれる）
+        if (now >= frameTime + FRAME_MICROS + 7 || i == 0) {
+            frameTime = i == 0 ? 0 : frameTime + FRAME_MICROS + 7;
+            pulse = (uint16_t)lroundf(1500 + stick * 5);
+            frame = { pulse, true, now - frameTime, FRAME_MICROS + 7 };
+        }
+        RcChannelFrame frames[RC_AXIS_COUNT] = { frame, frame };
+        conditioner.update(frames);
+
+        float setpoint = conditioner.getElevatorValue() * STICK_SCALE;
+        float rateTarget = ANGLE_KP * (setpoint - angle) +
+                           conditioner.getRate(RC_AXIS_ELEVATOR) * STICK_SCALE * feedForward;
+        float output = ratePID.calculate(rateTarget, rate, TICK_MICROS * 1e-6f);
+        rate += (PLANT_GAIN * output - rate) * (TICK_MICROS * 1e-6f) / PLANT_TAU;
+        angle += rate * (TICK_MICROS * 1e-6f);
+
+        // 最初の1秒は立ち上がりなので除く
+        if (t >= 1.0f) {
+            r.setpointStep = fmaxf(r.setpointStep, fabsf(setpoint - previousSetpoint));
+            r.outputStep = fmaxf(r.outputStep, fabsf(output - previousOutput));
+            stepSquared += (output - previousOutput) * (output - previousOutput);
+            float error = angle - stick * STICK_SCALE;
+            trackSquared += error * error;
+        }
+        previousSetpoint = setpoint;
+        previousOutput = output;
+    }
+    uint32_t counted = ticks - 1000000 / TICK_MICROS;
+    r.outputStepRms = sqrtf(stepSquared / counted);
+    r.trackRms = sqrtf(trackSquared / counted);
+    return r;
+}
+
+static void printStick(const char* name, const StickResult& r) {
+    printf("  %-28s setpoint step %.3f deg | output step max %5.2f%% rms %5.3f%% | track rms %.3f deg\n", name,
+           r.setpointStep, r.outputStep, r.outputStepRms, r.trackRms);
+}
+
+void benchRcInput() {
+    printf("curve:\n");
+    benchCurve();
+    printf("stick (1Hz sine, 50Hz frames, 500Hz control):\n");
+    printStick("stair (no smoothing)", runStick(false, 0));
+    printStick("smoothed", runStick(true, 0));
+    printStick("smoothed + feed-forward 0.5", runStick(true, 0.5f));
+    printStick("smoothed + feed-forward 1.0", runStick(true, 1.0f));
+}
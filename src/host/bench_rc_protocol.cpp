@@ -0,0 +1,141 @@
+// 受信機プロトコルのパーサーの1フレームあたりの解析コストと正しさの確認
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "rc_frame_encoder.h"
+#include "rc_protocol.h"
+
+static const int FRAME_COUNT = 2000;
+static const int REPEAT = 50;
+
+// 乱数のスティック値でフレーム列を作る
+static void makeChannels(uint16_t* micros, unsigned seed) {
+    srand(seed);
+    for (int ch = 0; ch < 16; ch++) {
+        micros[ch] = 988 + rand() % 1025;
+    }
+}
+
+// 11bit量子化による誤差（最大1μs程度）を許容して比較
+static bool matches(const uint16_t* expected, const RCChannelFrame& frame) {
+    for (int ch = 0; ch < 16; ch++) {
+        int diff = (int)expected[ch] - (int)frame.channels[ch];
+        if (diff < -1 || diff > 1) return false;
+    }
+    return true;
+}
+
+static void benchSbus() {
+    std::vector<uint8_t> stream;
+    std::vector<uint16_t> expected;
+    uint16_t micros[16];
+    uint8_t frame[SbusParser::FRAME_SIZE];
+    
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        makeChannels(micros, i);
+        encodeSbusFrame(micros, false, frame);
+        stream.insert(stream.end(), frame, frame + sizeof(frame));
+        expected.insert(expected.end(), micros, micros + 16);
+        // 時々ノイズを混ぜて再同期を確認
+        if (i % 100 == 50) stream.push_back(0x0F);
+    }
+    
+    // 正しさ
+    SbusParser check;
+    int decoded = 0, mismatched = 0;
+    for (uint8_t byte : stream) {
+        if (check.feed(byte)) {
+            if (!matches(&expected[decoded * 16], check.getFrame())) mismatched++;
+            decoded++;
+        }
+    }
+    // 挿入したノイズの直後はヘッダー/フッターだけでは区別できないことがある
+    printf("  sbus: decoded %d/%d frames, %d mismatched, %u sync errors (%d noise bytes)\n",
+           decoded, FRAME_COUNT, mismatched, check.getSyncErrors(), FRAME_COUNT / 100);
+    
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT; r++) {
+        SbusParser parser;
+        for (uint8_t byte : stream) {
+            if (parser.feed(byte)) doNotOptimize(parser.getFrame().channels[0]);
+        }
+    }
+    printBenchResult("SbusParser per frame", timer.elapsedNanos(), (uint64_t)FRAME_COUNT * REPEAT);
+}
+
+static void benchCrsf() {
+    std::vector<uint8_t> stream;
+    std::vector<uint16_t> expected;
+    uint16_t micros[16];
+    uint8_t frame[26];
+    
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        makeChannels(micros, i);
+        encodeCrsfFrame(micros, frame);
+        // 時々CRCを壊して読み飛ばしを確認
+        if (i % 100 == 50) frame[10] ^= 0x40;
+        stream.insert(stream.end(), frame, frame + sizeof(frame));
+        if (i % 100 != 50) expected.insert(expected.end(), micros, micros + 16);
+    }
+    
+    CrsfParser check;
+    int decoded = 0, mismatched = 0;
+    for (uint8_t byte : stream) {
+        if (check.feed(byte)) {
+            if (!matches(&expected[decoded * 16], check.getFrame())) mismatched++;
+            decoded++;
+        }
+    }
+    printf("  crsf: decoded %d/%d frames, %d mismatched, %u crc errors\n",
+           decoded, FRAME_COUNT, mismatched, check.getCrcErrors());
+    
+    BenchTimer timer;
+    for (int r = 0; r < REPEAT; r++) {
+        CrsfParser parser;
+        for (uint8_t byte : stream) {
+            if (parser.feed(byte)) doNotOptimize(parser.getFrame().channels[0]);
+        }
+    }
+    printBenchResult("CrsfParser per frame", timer.elapsedNanos(), (uint64_t)FRAME_COUNT * REPEAT);
+}
+
+static void benchPpm() {
+    // 8チャンネル + 同期間隔のエッジ時刻列
+    std::vector<uint32_t> edges;
+    uint32_t t = 0;
+    uint16_t micros[16];
+    for (int i = 0; i < FRAME_COUNT; i++) {
+        makeChannels(micros, i);
+        edges.push_back(t);
+        for (int ch = 0; ch < 8; ch++) {
+            t += micros[ch];
+            edges.push_back(t);
+        }
+        t += 6000;
+    }
+    
+    BenchTimer timer;
+    uint64_t channels = 0;
+    for (int r = 0; r < REPEAT; r++) {
+        PpmDecoder decoder;
+        uint8_t channel;
+        uint16_t width;
+        for (uint32_t edge : edges) {
+            if (decoder.onRisingEdge(edge, channel, width)) {
+                doNotOptimize(width);
+                channels++;
+            }
+        }
+    }
+    printf("  ppm: %llu channel values decoded\n", (unsigned long long)channels);
+    printBenchResult("PpmDecoder per frame (8ch)", timer.elapsedNanos(), (uint64_t)FRAME_COUNT * REPEAT);
+}
+
+void benchRcProtocols() {
+    benchSbus();
+    benchCrsf();
+    benchPpm();
+}
@@ -0,0 +1,53 @@
+// ホスト用ベンチマークの一覧と実行
+// 例: program bench          （全て）
+//     program bench rc       （名前を指定）
+
+#include <stdio.h>
+#include <string.h>
+#include "host_tools.h"
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[] = {
+    { "rc", benchRcProtocols },
+    { "rcinput", benchRcInput },
+    { "passthrough", benchPassthrough },
+    { "fixed", benchFixedPoint },
+    { "math", benchFastMath },
+    { "attitude", benchAttitude },
+    { "i2c", benchI2C },
+    { "cascade", benchCascade },
+    { "modes", benchModes },
+    { "pid", benchPid },
+    { "blackbox", benchBlackbox },
+};
+
+void printBenchmarkNames() {
+    printf("    names:");
+    for (const Benchmark& bench : benchmarks) {
+        printf(" %s", bench.name);
+    }
+    printf("\n");
+}
+
+int benchTool(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+    
+    for (const Benchmark& bench : benchmarks) {
+        if (filter != nullptr && strcmp(filter, bench.name) != 0) continue;
+        printf("[%s]\n", bench.name);
+        bench.run();
+        found = true;
+    }
+    
+    if (!found) {
+        fprintf(stderr, "unknown benchmark: %s\n", filter);
+        printBenchmarkNames();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// ホスト用マイクロベンチマークの補助
+// 実機（RISC-V、FPUなし）とは絶対値が異なるため、実装間の相対比較に使う
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+
+// 最適化で計算が消されないようにする
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchTimer {
+private:
+    std::chrono::steady_clock::time_point start;
+
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedNanos() const {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// 1回あたりの時間を表示
+inline void printBenchResult(const char* name, double totalNanos, uint64_t iterations) {
+    printf("  %-32s %10.1f ns/op  (%llu ops)\n", name, totalNanos / iterations,
+           (unsigned long long)iterations);
+}
+
+#endif
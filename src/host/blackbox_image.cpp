@@ -0,0 +1,86 @@
+#include "blackbox_image.h"
+#include <stdio.h>
+#include <algorithm>
+
+bool BlackboxImage::load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) return false;
+    std::vector<uint8_t> image;
+    uint8_t buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        image.insert(image.end(), buffer, buffer + length);
+    }
+    fclose(file);
+    load(image);
+    return true;
+}
+
+void BlackboxImage::load(const std::vector<uint8_t>& image) {
+    data = image;
+    sessions.clear();
+
+    struct Entry {
+        BlackboxSectorHeader header;
+        uint32_t index;
+    };
+    std::vector<Entry> entries;
+    for (uint32_t index = 0; (index + 1) * sectorSize <= data.size(); index++) {
+        Entry entry;
+        if (!decodeBlackboxHeader(data.data() + index * sectorSize, entry.header)) continue;
+        entry.index = index;
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.header.sequence < b.header.sequence; });
+
+    for (const Entry& entry : entries) {
+        if (sessions.empty() || sessions.back().session != entry.header.session) {
+            BlackboxSession session;
+            session.session = entry.header.session;
+            session.firstSequence = entry.header.sequence;
+            sessions.push_back(session);
+        }
+        sessions.back().sectors.push_back(entry.index);
+    }
+}
+
+const BlackboxSession* BlackboxImage::findSession(uint16_t session) const {
+    for (const BlackboxSession& s : sessions) {
+        if (s.session == session) return &s;
+    }
+    return nullptr;
+}
+
+std::vector<BlackboxSample> BlackboxImage::read(const BlackboxSession& session, uint32_t* corrupt) const {
+    std::vector<BlackboxSample> samples;
+    uint32_t bad = 0;
+    for (uint32_t index : session.sectors) {
+        const uint8_t* sector = data.data() + index * sectorSize;
+        for (uint32_t offset = BLACKBOX_HEADER_SIZE; offset + BLACKBOX_RECORD_SIZE <= sectorSize;
+             offset += BLACKBOX_RECORD_SIZE) {
+            if (sector[offset] == 0xFF) break;     // 未使用の位置
+            BlackboxSample sample;
+            if (decodeBlackboxRecord(sector + offset, sample)) {
+                samples.push_back(sample);
+            } else {
+                bad++;
+            }
+        }
+    }
+    if (corrupt != nullptr) *corrupt = bad;
+    return samples;
+}
+
+uint32_t BlackboxImage::getMissingSectors(const BlackboxSession& session) const {
+    // 通し番号は連続しているはず（欠けは上書きされたか壊れたセクター）
+    uint32_t missing = 0;
+    uint32_t expected = session.firstSequence;
+    for (uint32_t index : session.sectors) {
+        BlackboxSectorHeader header;
+        decodeBlackboxHeader(data.data() + index * sectorSize, header);
+        missing += header.sequence - expected;
+        expected = header.sequence + 1;
+    }
+    return missing;
+}
@@ -0,0 +1,39 @@
+#ifndef BLACKBOX_IMAGE_H
+#define BLACKBOX_IMAGE_H
+
+// ブラックボックスのパーティションの中身（esptool.pyで読み出したファイル）からセッション毎の記録を取り出す
+// セクターを通し番号の順に並べ、CRCが合わないレコード（書き込み中の電源断など）は数えて読み飛ばす
+
+#include <stdint.h>
+#include <vector>
+#include "blackbox.h"
+
+struct BlackboxSession {
+    uint16_t session;
+    std::vector<uint32_t> sectors;  // 書いた順のセクター番号
+    uint32_t firstSequence;
+};
+
+class BlackboxImage {
+private:
+    std::vector<uint8_t> data;
+    uint32_t sectorSize;
+    std::vector<BlackboxSession> sessions;
+
+public:
+    explicit BlackboxImage(uint32_t sectorSize = 4096) : sectorSize(sectorSize) {}
+
+    bool load(const char* path);
+    void load(const std::vector<uint8_t>& image);
+
+    // 古い順
+    const std::vector<BlackboxSession>& getSessions() const { return sessions; }
+    const BlackboxSession* findSession(uint16_t session) const;
+
+    // セッションの全レコード（corrupt: CRCが合わなかった数）
+    std::vector<BlackboxSample> read(const BlackboxSession& session, uint32_t* corrupt = nullptr) const;
+    // 通し番号の欠け（上書きされたか、ヘッダーが壊れたセクター）
+    uint32_t getMissingSectors(const BlackboxSession& session) const;
+};
+
+#endif
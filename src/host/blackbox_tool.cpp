@@ -0,0 +1,83 @@
+// ブラックボックスのパーティションを読み出したファイルをCSVに変換する
+// 読み出し: esptool.py read_flash 0x190000 0x260000 blackbox.bin（partitions.csvのblackbox）
+// 例: program blackbox blackbox.bin list          （セッションの一覧）
+//     program blackbox blackbox.bin > flight.csv  （最後のセッション）
+//     program blackbox blackbox.bin 12 > flight.csv
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_tools.h"
+#include "blackbox_image.h"
+#include "telemetry.h"
+
+static void listSessions(const BlackboxImage& image) {
+    printf("session sectors records corrupt missing   start_s  duration_s  max_dt_us\n");
+    for (const BlackboxSession& session : image.getSessions()) {
+        uint32_t corrupt = 0;
+        std::vector<BlackboxSample> samples = image.read(session, &corrupt);
+        uint32_t maxDt = 0;
+        for (size_t i = 1; i < samples.size(); i++) {
+            uint32_t dt = samples[i].timeMicros - samples[i - 1].timeMicros;
+            if (dt > maxDt) maxDt = dt;
+        }
+        double start = samples.empty() ? 0 : samples.front().timeMicros * 1e-6;
+        double duration = samples.empty() ? 0 : (samples.back().timeMicros - samples.front().timeMicros) * 1e-6;
+        printf("%7u %7zu %7zu %7u %7u %9.3f %11.3f %10u\n", session.session, session.sectors.size(),
+               samples.size(), corrupt, image.getMissingSectors(session), start, duration, maxDt);
+    }
+}
+
+static void printCsv(const std::vector<BlackboxSample>& samples) {
+    printf("time_us,passthrough,imu_ok,accel_mode,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z,"
+           "rc_elev_us,rc_rud_us,rc_led_us,rc_elev_new,rc_rud_new,rc_elev_age_us,rc_rud_age_us,"
+           "rc_elev_period_us,rc_rud_period_us,att0,att1,att2,tgt0,tgt1,tgt2,"
+           "elev_p,elev_i,elev_d,rud_p,rud_i,rud_d,servo_elev_us,servo_rud_us,dt_us,exec_us,jitter_us\n");
+    for (const BlackboxSample& s : samples) {
+        printf("%u,%d,%d,%d,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%u,%u,%u,%d,%d,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,"
+               "%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.1f,%u,%u,%u\n",
+               s.timeMicros, (s.flags & TELEMETRY_FLAG_PASSTHROUGH) != 0,
+               (s.flags & TELEMETRY_FLAG_IMU_OK) != 0, (s.flags & TELEMETRY_FLAG_ACCEL_MODE) != 0,
+               s.acc[0], s.acc[1], s.acc[2], s.gyro[0], s.gyro[1], s.gyro[2],
+               s.rcPulse[0], s.rcPulse[1], s.rcPulse[2], (s.rcFrames & 1) != 0, (s.rcFrames & 2) != 0,
+               s.rcAge[0], s.rcAge[1], s.rcPeriod[0], s.rcPeriod[1],
+               s.attitude[0], s.attitude[1], s.attitude[2], s.target[0], s.target[1], s.target[2],
+               s.pTerm[0], s.iTerm[0], s.dTerm[0], s.pTerm[1], s.iTerm[1], s.dTerm[1],
+               s.servoPulse[0], s.servoPulse[1], s.dtMicros, s.execMicros, s.jitterMicros);
+    }
+}
+
+int blackboxTool(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: blackbox <image> [list|session]\n");
+        return 1;
+    }
+    BlackboxImage image;
+    if (!image.load(argv[1])) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (image.getSessions().empty()) {
+        fprintf(stderr, "no blackbox sectors in %s\n", argv[1]);
+        return 1;
+    }
+    if (argc > 2 && strcmp(argv[2], "list") == 0) {
+        listSessions(image);
+        return 0;
+    }
+
+    const BlackboxSession* session = &image.getSessions().back();
+    if (argc > 2) {
+        session = image.findSession((uint16_t)atoi(argv[2]));
+        if (session == nullptr) {
+            fprintf(stderr, "session %s not found\n", argv[2]);
+            return 1;
+        }
+    }
+    uint32_t corrupt = 0;
+    std::vector<BlackboxSample> samples = image.read(*session, &corrupt);
+    printCsv(samples);
+    fprintf(stderr, "session=%u records=%zu corrupt=%u missing_sectors=%u\n", session->session,
+            samples.size(), corrupt, image.getMissingSectors(*session));
+    return 0;
+}
@@ -0,0 +1,353 @@
+#ifndef FAKE_HAL_H
+#define FAKE_HAL_H
+
+// ホスト実行用のハードウェア抽象化層の実装
+// 時刻は仮想時間で進むため、実時間より速く実行できる
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "clock.h"
+#include "flash_storage.h"
+#include "i2c_bus.h"
+#include "mpu6050_driver.h"
+#include "imu_sensor.h"
+#include "pwm_input.h"
+#include "servo_driver.h"
+
+// 仮想時刻（delayMicrosで即座に時間を進める）
+class FakeClock : public Clock {
+private:
+    uint32_t now;
+
+public:
+    // ESP32-C3の既定クロックに合わせる
+    static const uint32_t CYCLES_PER_MICRO = 160;
+
+    FakeClock(uint32_t start = 0) : now(start) {}
+    uint32_t micros() override { return now; }
+    uint32_t cycleCount() override { return now * CYCLES_PER_MICRO; }
+    uint32_t cyclesPerMicro() override { return CYCLES_PER_MICRO; }
+    void delayMicros(uint32_t us) override { now += us; }
+    void advance(uint32_t us) { now += us; }
+    void set(uint32_t us) { now = us; }
+};
+
+// 値を外部から直接設定するIMU
+class FakeImu : public ImuSensor {
+public:
+    float accX = 0, accY = 0, accZ = 1.0f;
+    float gyroX = 0, gyroY = 0, gyroZ = 0;
+    float temp = 25.0f;
+    uint32_t updateCount = 0;
+
+    void update() override { updateCount++; }
+    float getAccX() override { return accX; }
+    float getAccY() override { return accY; }
+    float getAccZ() override { return accZ; }
+    float getGyroX() override { return gyroX; }
+    float getGyroY() override { return gyroY; }
+    float getGyroZ() override { return gyroZ; }
+    float getTemp() override { return temp; }
+};
+
+// ピンレベルを保持し、エッジ毎に登録された割り込みハンドラーを呼ぶ
+class FakePwmInput : public PwmInput {
+private:
+    static const int MAX_PINS = 32;
+    void (*handlers[MAX_PINS])() = {};
+    bool levels[MAX_PINS] = {};
+    FakeClock& clock;
+
+public:
+    FakePwmInput(FakeClock& clock) : clock(clock) {}
+
+    void attach(int pin, void (*isr)()) override {
+        if (pin >= 0 && pin < MAX_PINS) handlers[pin] = isr;
+    }
+
+    bool read(int pin) override {
+        return (pin >= 0 && pin < MAX_PINS) ? levels[pin] : false;
+    }
+
+    // ピンレベルを変えて割り込みを発生させる
+    void setLevel(int pin, bool level) {
+        if (pin < 0 || pin >= MAX_PINS || levels[pin] == level) return;
+        levels[pin] = level;
+        if (handlers[pin] != nullptr) handlers[pin]();
+    }
+
+    // 現在時刻に終わる1パルス分を発生させる（仮想時刻は進めない）
+    void pulse(int pin, uint32_t widthMicros) {
+        uint32_t now = clock.micros();
+        clock.set(now - widthMicros);
+        setLevel(pin, true);
+        clock.set(now);
+        setLevel(pin, false);
+    }
+};
+
+// 最後に書き込まれた角度を保持するサーボ
+class FakeServoDriver : public ServoDriver {
+public:
+    int pin = -1;
+    uint16_t frameRateHz = 0;
+    float pulseMicros = 0;
+    uint32_t writeCount = 0;
+
+    bool attach(int p, uint16_t rate) override {
+        pin = p;
+        frameRateHz = rate;
+        return rate > 0;
+    }
+    void writeMicroseconds(float micros) override { pulseMicros = micros; writeCount++; }
+};
+
+// MPU6050のレジスタとFIFOを模擬するI2Cバス
+// Mpu6050Driverのレジスタ設定と変換をそのまま通すために使う
+class FakeMpu6050Bus : public I2CBus {
+private:
+    uint8_t registers[128] = {};
+    std::deque<uint8_t> fifo;
+
+    static void putInt16(uint8_t* p, float value) {
+        long raw = lroundf(value);
+        if (raw > 32767) raw = 32767;
+        if (raw < -32768) raw = -32768;
+        p[0] = (uint8_t)((raw >> 8) & 0xFF);
+        p[1] = (uint8_t)(raw & 0xFF);
+    }
+
+    bool fifoEnabled() const { return (registers[Mpu6050Reg::USER_CTRL] & 0x40) != 0; }
+
+public:
+    uint8_t address = Mpu6050Driver::ADDRESS_LOW;
+    uint32_t transactions = 0;
+    uint32_t bytesRead = 0;
+    FakePwmInput* interruptInput = nullptr;    // INTの配線先（nullptrなら未配線）
+    int interruptPin = -1;
+
+    FakeMpu6050Bus() { registers[Mpu6050Reg::WHO_AM_I] = 0x68; }
+
+    // センサーが1サンプル取得したことにする（単位はg、deg/s、℃）
+    void pushSample(const float acc[3], const float gyro[3], float temp) {
+        uint8_t raw[Mpu6050Driver::BURST_SIZE];
+        for (int axis = 0; axis < 3; axis++) {
+            putInt16(raw + axis * 2, acc[axis] * Mpu6050Driver::ACC_LSB_PER_G);
+            putInt16(raw + 8 + axis * 2, gyro[axis] * Mpu6050Driver::GYRO_LSB_PER_DPS);
+        }
+        putInt16(raw + 6, (temp - 36.53f) * 340.0f);
+        for (int i = 0; i < Mpu6050Driver::BURST_SIZE; i++) {
+            registers[Mpu6050Reg::ACCEL_XOUT_H + i] = raw[i];
+        }
+        if (fifoEnabled() && fifo.size() + Mpu6050Driver::BURST_SIZE <= Mpu6050Driver::FIFO_SIZE) {
+            fifo.insert(fifo.end(), raw, raw + Mpu6050Driver::BURST_SIZE);
+        }
+        // DATA_RDY_INT（INT_STATUSを読むと0に戻る）と、配線されていればINTのパルス
+        registers[Mpu6050Reg::INT_STATUS] |= 0x01;
+        if (interruptInput != nullptr && (registers[Mpu6050Reg::INT_ENABLE] & 0x01)) {
+            interruptInput->setLevel(interruptPin, true);
+            interruptInput->setLevel(interruptPin, false);
+        }
+    }
+
+    bool probe(uint8_t addr) override {
+        transactions++;
+        return addr == address;
+    }
+
+    bool write(uint8_t addr, const uint8_t* data, size_t length) override {
+        transactions++;
+        if (addr != address || length == 0) return false;
+        uint8_t reg = data[0] & 0x7F;
+        for (size_t i = 1; i < length; i++, reg = (reg + 1) & 0x7F) {
+            if (reg == Mpu6050Reg::USER_CTRL && (data[i] & 0x04)) {
+                fifo.clear();   // FIFO_RESET
+            }
+            registers[reg] = data[i] & (reg == Mpu6050Reg::USER_CTRL ? ~0x04 : 0xFF);
+        }
+        return true;
+    }
+
+    bool writeRead(uint8_t addr, const uint8_t* tx, size_t txLength,
+                   uint8_t* rx, size_t rxLength) override {
+        transactions++;
+        if (addr != address || txLength == 0) return false;
+        uint8_t reg = tx[0] & 0x7F;
+        uint16_t count = (uint16_t)fifo.size();
+        for (size_t i = 0; i < rxLength; i++) {
+            if (reg == Mpu6050Reg::FIFO_R_W) {
+                // FIFOの読み出しはアドレスが進まない
+                rx[i] = fifo.empty() ? 0 : fifo.front();
+                if (!fifo.empty()) fifo.pop_front();
+                continue;
+            }
+            if (reg == Mpu6050Reg::FIFO_COUNT_H) rx[i] = count >> 8;
+            else if (reg == Mpu6050Reg::FIFO_COUNT_H + 1) rx[i] = count & 0xFF;
+            else rx[i] = registers[reg];
+            if (reg == Mpu6050Reg::INT_STATUS) registers[reg] = 0;
+            reg = (reg + 1) & 0x7F;
+        }
+        bytesRead += rxLength;
+        return true;
+    }
+};
+
+// 複数デバイスをつないだI2Cバス（アドレスで各デバイスの模擬に振り分ける）
+// 転送時間だけ仮想時刻を進め、失敗やバスの固着を注入できる
+class MockI2CBus : public I2CBus {
+private:
+    FakeClock& clock;
+    uint32_t byteNanos;
+
+    struct Target {
+        uint8_t address;
+        I2CBus* device;     // nullptrなら書き込みを受け取るだけ
+    };
+    Target targets[4];
+    int targetCount = 0;
+
+    Target* find(uint8_t addr) {
+        for (int i = 0; i < targetCount; i++) {
+            if (targets[i].address == addr) return &targets[i];
+        }
+        return nullptr;
+    }
+
+    // 転送時間（アドレス + データ、1バイト9クロック）
+    void spend(size_t bytes) {
+        clock.advance(OVERHEAD_MICROS + (uint32_t)((bytes + 1) * byteNanos / 1000));
+    }
+
+    bool fail() {
+        if (stuck) return true;
+        if (failuresToInject > 0) {
+            failuresToInject--;
+            return true;
+        }
+        return false;
+    }
+
+public:
+    static const uint32_t OVERHEAD_MICROS = 40;
+
+    uint32_t failuresToInject = 0;  // 次のn回を失敗させる
+    bool stuck = false;             // recover()まで全て失敗（SDAが固まった状態）
+    uint32_t recoveries = 0;
+    uint32_t transactions = 0;
+    uint32_t bytes = 0;
+
+    MockI2CBus(FakeClock& clock, uint32_t busClockHz = 400000)
+        : clock(clock), byteNanos((uint32_t)(9000000000ULL / busClockHz)) {}
+
+    void attach(uint8_t addr, I2CBus* device) {
+        if (targetCount < 4) targets[targetCount++] = { addr, device };
+    }
+
+    bool probe(uint8_t addr) override {
+        spend(0);
+        transactions++;
+        Target* target = find(addr);
+        return target != nullptr && !stuck &&
+               (target->device == nullptr || target->device->probe(addr));
+    }
+
+    bool write(uint8_t addr, const uint8_t* data, size_t length) override {
+        spend(length);
+        transactions++;
+        Target* target = find(addr);
+        if (target == nullptr || fail()) return false;
+        bytes += length;
+        return target->device == nullptr || target->device->write(addr, data, length);
+    }
+
+    bool writeRead(uint8_t addr, const uint8_t* tx, size_t txLength,
+                   uint8_t* rx, size_t rxLength) override {
+        spend(txLength + rxLength + 1);     // リピートスタートでアドレスをもう1回
+        transactions++;
+        Target* target = find(addr);
+        if (target == nullptr || target->device == nullptr || fail()) return false;
+        bytes += txLength + rxLength;
+        return target->device->writeRead(addr, tx, txLength, rx, rxLength);
+    }
+
+    bool recover() override {
+        clock.advance(100);
+        recoveries++;
+        stuck = false;
+        return true;
+    }
+};
+
+// フラッシュの操作でCPUが止まっていた区間[μs]
+struct FlashBusy {
+    uint32_t start;
+    uint32_t end;
+};
+
+// メモリ上のフラッシュ領域（書き込みはNORフラッシュと同じくビットを0にするだけ）
+// セクター毎の消去回数を数え、書き込めるバイト数を制限して電源断を模擬できる
+// clockを渡すと、消去・書き込みの時間だけ時計を進め、その区間をbusyに残す
+class FakeFlashStorage : public FlashStorage {
+private:
+    uint32_t sector;
+
+public:
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> eraseCounts;  // セクター毎
+    uint32_t eraseCalls = 0;
+    uint32_t writeCalls = 0;
+    uint32_t bytesWritten = 0;
+    uint32_t writeBudget = UINT32_MAX;  // 残りの書き込めるバイト数（使い切ったら以降は書かれない）
+    FakeClock* clock = nullptr;
+    uint32_t eraseMicros = 45000;       // 4KBセクターの消去時間（ESP32-C3の代表値）
+    uint32_t pageMicros = 600;          // 1ページの書き込み時間
+    std::vector<FlashBusy> busy;
+
+    void spend(uint32_t micros) {
+        if (clock == nullptr) return;
+        FlashBusy b = { clock->micros(), clock->micros() + micros };
+        busy.push_back(b);
+        clock->advance(micros);
+    }
+
+    FakeFlashStorage(uint32_t size, uint32_t sectorSize = 4096)
+        : sector(sectorSize), data(size, 0xFF), eraseCounts(size / sectorSize, 0) {}
+
+    uint32_t size() override { return (uint32_t)data.size(); }
+    uint32_t sectorSize() override { return sector; }
+
+    bool erase(uint32_t offset, uint32_t length) override {
+        if (offset % sector != 0 || length % sector != 0 || offset + length > data.size()) return false;
+        memset(data.data() + offset, 0xFF, length);
+        for (uint32_t i = offset / sector; i < (offset + length) / sector; i++) eraseCounts[i]++;
+        eraseCalls++;
+        spend(length / sector * eraseMicros);
+        return true;
+    }
+
+    bool write(uint32_t offset, const void* source, size_t length) override {
+        if (offset + length > data.size()) return false;
+        const uint8_t* bytes = static_cast<const uint8_t*>(source);
+        writeCalls++;
+        // ページの境目をまたぐ書き込みはページ毎に時間がかかる
+        if (length > 0) spend(((offset + length - 1) / FLASH_PAGE_SIZE - offset / FLASH_PAGE_SIZE + 1) * pageMicros);
+        for (size_t i = 0; i < length; i++) {
+            if (writeBudget == 0) return false;
+            writeBudget--;
+            data[offset + i] &= bytes[i];
+            bytesWritten++;
+        }
+        return true;
+    }
+
+    bool read(uint32_t offset, void* destination, size_t length) override {
+        if (offset + length > data.size()) return false;
+        memcpy(destination, data.data() + offset, length);
+        return true;
+    }
+};
+
+#endif
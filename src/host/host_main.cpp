@@ -0,0 +1,47 @@
+// ホスト（native環境）用エントリーポイント
+// 制御コードを実機なしで動かすためのサブコマンドをまとめる
+
+#include <stdio.h>
+#include <string.h>
+#include "host_tools.h"
+
+struct HostCommand {
+    const char* name;
+    int (*run)(int argc, char** argv);
+    const char* help;
+};
+
+static const HostCommand commands[] = {
+    { "run", runLoopTool, "run [seconds] [rate_hz] - 制御ループを仮想時間で実行しCSV出力" },
+    { "decode", telemetryDecodeTool, "decode [file] - バイナリテレメトリをCSVに変換（省略時は標準入力）" },
+    { "blackbox", blackboxTool, "blackbox <image> [list|session] - ブラックボックスの読み出しをCSVに変換（省略時は最後のセッション）" },
+    { "rcparse", rcParseTool, "rcparse <sbus|crsf> [file] - 受信機のバイト列をチャンネル値CSVに変換" },
+    { "sitl", sitlTool, "sitl [scenario|all|sweep] [rate_hz] [csv] - 模擬機体で閉ループ試験（基準外は終了コード1）" },
+    { "replay", replayTool, "replay <input> [out file] [session n] [tolerance us] - 記録した飛行を制御コードで再生し、記録の出力と比べる（ずれがあれば終了コード1）" },
+    { "bench", benchTool, "bench [name] - ホスト用ベンチマーク（省略時は全て）" },
+};
+
+// 単体テスト（pio test -e native）ではtest/test_native/のmain()を使う
+#ifndef PIO_UNIT_TESTING
+static void printUsage(const char* program) {
+    printf("usage: %s <command> [args...]\n", program);
+    for (const HostCommand& command : commands) {
+        printf("  %s\n", command.help);
+        if (command.run == benchTool) printBenchmarkNames();
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    for (const HostCommand& command : commands) {
+        if (strcmp(argv[1], command.name) == 0) {
+            return command.run(argc - 1, argv + 1);
+        }
+    }
+    printUsage(argv[0]);
+    return 1;
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef HOST_TOOLS_H
+#define HOST_TOOLS_H
+
+// ホスト用サブコマンド（argv[0]はサブコマンド名）
+int runLoopTool(int argc, char** argv);
+int telemetryDecodeTool(int argc, char** argv);
+int rcParseTool(int argc, char** argv);
+int benchTool(int argc, char** argv);
+int sitlTool(int argc, char** argv);
+int blackboxTool(int argc, char** argv);
+int replayTool(int argc, char** argv);
+
+// benchの名前の一覧（使い方の表示用）
+void printBenchmarkNames();
+
+// ベンチマーク（benchサブコマンドから呼ぶ）
+void benchRcProtocols();
+void benchRcInput();
+void benchPassthrough();
+void benchFixedPoint();
+void benchFastMath();
+void benchAttitude();
+void benchI2C();
+void benchCascade();
+void benchModes();
+void benchPid();
+void benchBlackbox();
+
+#endif
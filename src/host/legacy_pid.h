@@ -0,0 +1,42 @@
+#ifndef LEGACY_PID_H
+#define LEGACY_PID_H
+
+// 以前のPIDController（比較用）
+// 誤差の微分（フィルターなし）、積分を outputMax / ki で制限、初回は10msと仮定
+
+class LegacyPIDController {
+private:
+    float kp, ki, kd;
+    float previousError;
+    float integral;
+    bool firstRun;
+    float outputMin, outputMax;
+
+public:
+    LegacyPIDController(float kp, float ki, float kd)
+        : kp(kp), ki(ki), kd(kd), previousError(0), integral(0), firstRun(true),
+          outputMin(-1000), outputMax(1000) {}
+
+    void setOutputLimits(float min, float max) {
+        outputMin = min;
+        outputMax = max;
+    }
+
+    float calculate(float setpoint, float input, float deltaTime) {
+        if (firstRun) deltaTime = 0.01;
+        float error = setpoint - input;
+        integral += error * deltaTime;
+        if (integral > outputMax / ki) integral = outputMax / ki;
+        if (integral < outputMin / ki) integral = outputMin / ki;
+        float derivative = 0;
+        if (deltaTime > 0) derivative = (error - previousError) / deltaTime;
+        float output = kp * error + ki * integral + kd * derivative;
+        if (output > outputMax) output = outputMax;
+        if (output < outputMin) output = outputMin;
+        previousError = error;
+        firstRun = false;
+        return output;
+    }
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef RC_FRAME_ENCODER_H
+#define RC_FRAME_ENCODER_H
+
+// ベンチマークと動作確認用に、SBUS/CRSFフレームを生成する（ホスト専用）
+
+#include <stdint.h>
+#include <string.h>
+#include "rc_protocol.h"
+
+// マイクロ秒（988-2012）を11bit値に戻す
+inline uint16_t rcMicrosToTicks(uint16_t micros) {
+    return (uint16_t)(((int32_t)micros - 1500) * 8 / 5 + 992);
+}
+
+inline void packChannels11(const uint16_t* ticks, uint8_t count, uint8_t* out) {
+    uint32_t bits = 0;
+    uint8_t bitCount = 0;
+    for (uint8_t ch = 0; ch < count; ch++) {
+        bits |= (uint32_t)(ticks[ch] & 0x07FF) << bitCount;
+        bitCount += 11;
+        while (bitCount >= 8) {
+            *out++ = bits & 0xFF;
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) *out = bits & 0xFF;
+}
+
+// 25バイトのSBUSフレーム
+inline void encodeSbusFrame(const uint16_t* micros, bool failsafe, uint8_t* out) {
+    uint16_t ticks[16];
+    for (int ch = 0; ch < 16; ch++) ticks[ch] = rcMicrosToTicks(micros[ch]);
+    out[0] = SbusParser::HEADER;
+    packChannels11(ticks, 16, out + 1);
+    out[23] = failsafe ? 0x08 : 0x00;
+    out[24] = 0x00;
+}
+
+// 26バイトのCRSFチャンネルフレーム
+inline void encodeCrsfFrame(const uint16_t* micros, uint8_t* out) {
+    uint16_t ticks[16];
+    for (int ch = 0; ch < 16; ch++) ticks[ch] = rcMicrosToTicks(micros[ch]);
+    out[0] = CrsfParser::ADDRESS_FLIGHT_CONTROLLER;
+    out[1] = 24;
+    out[2] = CrsfParser::TYPE_RC_CHANNELS_PACKED;
+    packChannels11(ticks, 16, out + 3);
+    out[25] = CrsfParser::crc8(out + 2, 23);
+}
+
+#endif
@@ -0,0 +1,55 @@
+// 記録したSBUS/CRSFのバイト列をフレーム毎のチャンネル値（CSV）に変換する
+// 例: program rcparse sbus capture.bin
+
+#include <stdio.h>
+#include <string.h>
+#include "host_tools.h"
+#include "rc_protocol.h"
+
+static void printFrame(uint32_t index, const RCChannelFrame& frame) {
+    printf("%u,%d,%d", index, frame.failsafe, frame.frameLost);
+    for (uint8_t ch = 0; ch < frame.channelCount; ch++) {
+        printf(",%u", frame.channels[ch]);
+    }
+    printf("\n");
+}
+
+int rcParseTool(int argc, char** argv) {
+    if (argc < 2 || (strcmp(argv[1], "sbus") != 0 && strcmp(argv[1], "crsf") != 0)) {
+        fprintf(stderr, "usage: rcparse <sbus|crsf> [file]\n");
+        return 1;
+    }
+    bool isSbus = strcmp(argv[1], "sbus") == 0;
+    
+    FILE* input = stdin;
+    if (argc > 2) {
+        input = fopen(argv[2], "rb");
+        if (input == nullptr) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+    
+    SbusParser sbus;
+    CrsfParser crsf;
+    uint32_t frames = 0;
+    
+    printf("frame,failsafe,frame_lost");
+    for (int ch = 1; ch <= RC_PROTOCOL_MAX_CHANNELS; ch++) printf(",ch%d", ch);
+    printf("\n");
+    
+    int byte;
+    while ((byte = fgetc(input)) != EOF) {
+        if (isSbus ? sbus.feed((uint8_t)byte) : crsf.feed((uint8_t)byte)) {
+            printFrame(frames++, isSbus ? sbus.getFrame() : crsf.getFrame());
+        }
+    }
+    
+    if (isSbus) {
+        fprintf(stderr, "frames=%u sync_errors=%u\n", sbus.getFrameCount(), sbus.getSyncErrors());
+    } else {
+        fprintf(stderr, "frames=%u crc_errors=%u\n", crsf.getFrameCount(), crsf.getCrcErrors());
+    }
+    if (input != stdin) fclose(input);
+    return 0;
+}
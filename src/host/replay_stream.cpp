@@ -0,0 +1,247 @@
+#include "replay_stream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include "blackbox_image.h"
+#include "control_scheduler.h"
+#include "telemetry.h"
+
+static const char* CSV_HEADER =
+    "dt_us,passthrough,imu_ok,accel_mode,acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z,"
+    "elevator_us,rudder_us,elevator_new,rudder_new,elevator_age_us,rudder_age_us,"
+    "elevator_period_us,rudder_period_us,expected_elevator_us,expected_rudder_us";
+static const int CSV_REQUIRED_COLUMNS = 18;     // expectedは省略できる
+static const int CSV_COLUMNS = 20;
+
+// 空欄（NaN）は0
+static uint16_t toU16(float value) {
+    return isnan(value) || value < 0 ? 0 : (value > UINT16_MAX ? UINT16_MAX : (uint16_t)value);
+}
+
+// 周期の中央値に一番近い対応周期
+static uint16_t estimateRate(const ReplayFrame* frames, size_t count) {
+    std::vector<uint32_t> dts;
+    for (size_t i = 0; i < count; i++) {
+        if (frames[i].dtMicros > 0) dts.push_back(frames[i].dtMicros);
+    }
+    if (dts.empty()) return 0;
+    std::nth_element(dts.begin(), dts.begin() + dts.size() / 2, dts.end());
+    float rate = 1e6f / dts[dts.size() / 2];
+    const uint16_t rates[] = { 100, 250, 500, 1000 };
+    uint16_t best = rates[0];
+    for (uint16_t candidate : rates) {
+        if (fabsf(candidate - rate) < fabsf(best - rate)) best = candidate;
+    }
+    return best;
+}
+
+ReplayInput::ReplayInput()
+    : mapped(nullptr), mappedLength(0), frames(nullptr), count(0), rateHz(0), resolution(0) {
+    error[0] = '\0';
+}
+
+ReplayInput::~ReplayInput() {
+    if (mapped != nullptr) munmap(mapped, mappedLength);
+}
+
+void ReplayInput::useOwned() {
+    frames = owned.data();
+    count = owned.size();
+}
+
+bool ReplayInput::load(const char* path, int session) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        snprintf(error, sizeof(error), "%s: %s", path, strerror(errno));
+        return false;
+    }
+    uint8_t head[16] = {};
+    size_t length = fread(head, 1, sizeof(head), file);
+    uint32_t magic = 0;
+    memcpy(&magic, head, sizeof(magic));
+
+    bool ok;
+    if (length == sizeof(head) && magic == REPLAY_MAGIC) {
+        fclose(file);
+        ok = loadBinary(path);
+    } else if (length > 0 && memcmp(head, "dt_us", 5) == 0) {
+        rewind(file);
+        ok = loadCsv(file);
+        fclose(file);
+    } else {
+        fclose(file);
+        ok = loadBlackbox(path, session);
+    }
+    if (ok && rateHz == 0) rateHz = estimateRate(frames, count);
+    if (ok && !ControlScheduler::isSupportedRate(rateHz)) {
+        snprintf(error, sizeof(error), "%s: no usable control period", path);
+        return false;
+    }
+    return ok;
+}
+
+bool ReplayInput::loadBinary(const char* path) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        snprintf(error, sizeof(error), "%s: %s", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    mappedLength = info.st_size;
+    mapped = mmap(nullptr, mappedLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        mapped = nullptr;
+        snprintf(error, sizeof(error), "%s: mmap failed", path);
+        return false;
+    }
+
+    ReplayHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    size_t available = (mappedLength - sizeof(header)) / sizeof(ReplayFrame);
+    if (header.version != REPLAY_VERSION || header.frameSize != sizeof(ReplayFrame) ||
+        header.frameCount > available) {
+        snprintf(error, sizeof(error), "%s: unsupported replay file (version %u, frame %u bytes)", path,
+                 header.version, header.frameSize);
+        return false;
+    }
+    // ヘッダーが16バイトなので、mmapの先頭（ページ境界）からの並びはfloatの境界に揃う
+    frames = reinterpret_cast<const ReplayFrame*>(static_cast<const uint8_t*>(mapped) + sizeof(header));
+    count = header.frameCount;
+    rateHz = header.rateHz;
+    resolution = 0;
+    madvise(mapped, mappedLength, MADV_SEQUENTIAL);
+    return true;
+}
+
+// 空欄はNaN
+static float parseField(char*& cursor) {
+    char* end;
+    float value = strtof(cursor, &end);
+    if (end == cursor) value = NAN;
+    cursor = strchr(end, ',');
+    if (cursor != nullptr) cursor++;
+    return value;
+}
+
+bool ReplayInput::loadCsv(FILE* file) {
+    char line[512];
+    if (fgets(line, sizeof(line), file) == nullptr) return false;
+    uint32_t lineNumber = 1;
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        lineNumber++;
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') continue;
+        char* cursor = line;
+        float fields[CSV_COLUMNS];
+        int parsed = 0;
+        while (parsed < CSV_COLUMNS && cursor != nullptr) {
+            fields[parsed++] = parseField(cursor);
+        }
+        if (parsed < CSV_REQUIRED_COLUMNS || isnan(fields[0]) || isnan(fields[10]) || isnan(fields[11])) {
+            snprintf(error, sizeof(error), "line %u: expected %d to %d columns (dt_us,...)", lineNumber,
+                     CSV_REQUIRED_COLUMNS, CSV_COLUMNS);
+            return false;
+        }
+        ReplayFrame frame = {};
+        frame.dtMicros = (uint32_t)fields[0];
+        frame.flags = (fields[1] != 0 ? TELEMETRY_FLAG_PASSTHROUGH : 0) |
+                      (fields[2] != 0 ? TELEMETRY_FLAG_IMU_OK : 0) |
+                      (fields[3] != 0 ? TELEMETRY_FLAG_ACCEL_MODE : 0);
+        for (int i = 0; i < 3; i++) {
+            frame.acc[i] = fields[4 + i];
+            frame.gyro[i] = fields[7 + i];
+        }
+        for (int axis = 0; axis < 2; axis++) {
+            frame.rcPulse[axis] = toU16(fields[10 + axis]);
+            if (fields[12 + axis] != 0 && !isnan(fields[12 + axis])) frame.rcFrames |= 1 << axis;
+            frame.rcAge[axis] = toU16(fields[14 + axis]);
+            frame.rcPeriod[axis] = toU16(fields[16 + axis]);
+        }
+        frame.expected[0] = parsed > 18 ? fields[18] : NAN;
+        frame.expected[1] = parsed > 19 ? fields[19] : NAN;
+        owned.push_back(frame);
+    }
+    useOwned();
+    rateHz = 0;
+    resolution = 0;
+    return true;
+}
+
+bool ReplayInput::loadBlackbox(const char* path, int session) {
+    BlackboxImage image;
+    if (!image.load(path) || image.getSessions().empty()) {
+        snprintf(error, sizeof(error), "%s: not a replay file, CSV or blackbox image", path);
+        return false;
+    }
+    const BlackboxSession* selected = &image.getSessions().back();
+    if (session >= 0) {
+        selected = image.findSession((uint16_t)session);
+        if (selected == nullptr) {
+            snprintf(error, sizeof(error), "%s: session %d not found", path, session);
+            return false;
+        }
+    }
+    for (const BlackboxSample& sample : image.read(*selected)) {
+        ReplayFrame frame = {};
+        frame.dtMicros = sample.dtMicros;
+        frame.flags = sample.flags;
+        for (int i = 0; i < 3; i++) {
+            frame.acc[i] = sample.acc[i];
+            frame.gyro[i] = sample.gyro[i];
+        }
+        frame.rcFrames = sample.rcFrames;
+        for (int axis = 0; axis < 2; axis++) {
+            frame.rcPulse[axis] = sample.rcPulse[axis];
+            frame.rcAge[axis] = sample.rcAge[axis];
+            frame.rcPeriod[axis] = sample.rcPeriod[axis];
+        }
+        frame.expected[0] = sample.servoPulse[0];
+        frame.expected[1] = sample.servoPulse[1];
+        owned.push_back(frame);
+    }
+    useOwned();
+    rateHz = 0;
+    // サーボのパルス幅は0.1μs単位で記録しているので、丸めの分（0.05μs）に余裕を足して比べる
+    resolution = 0.06f;
+    return true;
+}
+
+bool writeReplayBinary(const char* path, const ReplayFrame* frames, size_t count, uint16_t rateHz) {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) return false;
+    ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, sizeof(ReplayFrame), rateHz, 0, (uint32_t)count };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(frames, sizeof(ReplayFrame), count, file) == count;
+    return fclose(file) == 0 && ok;
+}
+
+static void printFloat(FILE* file, float value) {
+    if (isnan(value)) fputc(',', file);
+    else fprintf(file, ",%.9g", value);
+}
+
+bool writeReplayCsv(const char* path, const ReplayFrame* frames, size_t count) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+    fprintf(file, "%s\n", CSV_HEADER);
+    for (size_t i = 0; i < count; i++) {
+        const ReplayFrame& f = frames[i];
+        fprintf(file, "%u,%d,%d,%d", f.dtMicros, (f.flags & TELEMETRY_FLAG_PASSTHROUGH) != 0,
+                (f.flags & TELEMETRY_FLAG_IMU_OK) != 0, (f.flags & TELEMETRY_FLAG_ACCEL_MODE) != 0);
+        for (int axis = 0; axis < 3; axis++) printFloat(file, f.acc[axis]);
+        for (int axis = 0; axis < 3; axis++) printFloat(file, f.gyro[axis]);
+        fprintf(file, ",%u,%u,%d,%d,%u,%u,%u,%u", f.rcPulse[0], f.rcPulse[1], (f.rcFrames & 1) != 0,
+                (f.rcFrames & 2) != 0, f.rcAge[0], f.rcAge[1], f.rcPeriod[0], f.rcPeriod[1]);
+        printFloat(file, f.expected[0]);
+        printFloat(file, f.expected[1]);
+        fputc('\n', file);
+    }
+    return fclose(file) == 0;
+}
@@ -0,0 +1,82 @@
+#ifndef REPLAY_STREAM_H
+#define REPLAY_STREAM_H
+
+// 記録した飛行を制御コードに流し直すための入力列（replayサブコマンド）
+// 1周期分の入力（周期、パススルー/モード、IMU、受信機のフレーム）と、その周期に出た/出るはずのサーボのパルス幅
+//
+// 読める形式
+//   バイナリ: [ヘッダー16バイト][ReplayFrame × n]。ホストのメモリ上の並びそのまま（リトルエンディアン）で、mmapして読む
+//   CSV:      ヘッダー行 + ReplayFrameと同じ列（expectedが空欄なら比べない）
+//   ブラックボックスの読み出し（esptool.pyのイメージ）: セッションを選んで変換する
+// 書き出しはバイナリとCSV。出力をexpectedに入れて書くので、そのまま次の版の基準になる
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+static const uint32_t REPLAY_MAGIC = 0x314C5052;   // "RPL1"
+static const uint16_t REPLAY_VERSION = 2;   // 2: スティックを受信機のフレーム（パルス幅と時刻）で持つ
+
+struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t frameSize;
+    uint16_t rateHz;        // 制御周期（0なら周期の中央値から決める）
+    uint16_t reserved;
+    uint32_t frameCount;
+};
+
+struct ReplayFrame {
+    uint32_t dtMicros;      // スケジューラが計測した周期
+    uint8_t flags;          // TELEMETRY_FLAG_*（パススルー、IMU有効、加速度モード）
+    uint8_t rcFrames;       // この周期に新しいフレームが届いた軸（ビット0: エレベーター、1: ラダー）
+    uint8_t reserved[2];
+    float acc[3];           // 補正後のIMU値[g]
+    float gyro[3];          // [deg/s]
+    uint16_t rcPulse[2];    // エレベーター/ラダーの受信機のパルス幅[μs]（RcConditionerに通す）
+    uint16_t rcAge[2];      // フレームが届いてからの時間[μs]
+    uint16_t rcPeriod[2];   // フレーム周期[μs]（0は未計測）
+    float expected[2];      // エレベーター/ラダーのサーボのパルス幅[μs]（NaNなら比べない）
+};
+
+static_assert(sizeof(ReplayHeader) == 16, "ReplayHeader must be 16 bytes");
+static_assert(sizeof(ReplayFrame) == 52, "ReplayFrame must be 52 bytes");
+
+// 入力列（バイナリはmmapした領域をそのまま指す）
+class ReplayInput {
+private:
+    std::vector<ReplayFrame> owned;     // CSV、ブラックボックスから変換した分
+    void* mapped;
+    size_t mappedLength;
+    const ReplayFrame* frames;
+    size_t count;
+    uint16_t rateHz;
+    float resolution;                   // expectedの分解能[μs]（比べる時の許容差の目安）
+    char error[128];
+
+    bool loadBinary(const char* path);
+    bool loadCsv(FILE* file);
+    bool loadBlackbox(const char* path, int session);
+    void useOwned();
+
+public:
+    ReplayInput();
+    ~ReplayInput();
+    ReplayInput(const ReplayInput&) = delete;
+    ReplayInput& operator=(const ReplayInput&) = delete;
+
+    // 形式は中身で判断する（session: ブラックボックスのセッション番号、負なら最後）
+    bool load(const char* path, int session = -1);
+
+    const ReplayFrame* data() const { return frames; }
+    size_t size() const { return count; }
+    uint16_t getRateHz() const { return rateHz; }
+    float getResolution() const { return resolution; }
+    const char* getError() const { return error; }
+};
+
+// 書き出し（CSVはfloatを往復で同じ値に戻る桁数で書く）
+bool writeReplayBinary(const char* path, const ReplayFrame* frames, size_t count, uint16_t rateHz);
+bool writeReplayCsv(const char* path, const ReplayFrame* frames, size_t count);
+
+#endif
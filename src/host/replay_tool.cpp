@@ -0,0 +1,259 @@
+// 記録した飛行を実機と同じ制御コード（AutoControl、出力の混合、ServoOutput）に流し直す
+// 入力は replay_stream.h のバイナリ/CSV、またはブラックボックスの読み出し。実時間は待たずに全周期を計算する
+//   - 入力のexpected（記録されたサーボのパルス幅）と違った周期を、ずれ始めた位置毎にまとめて表示する
+//   - 同じ入力を何度も回して1周期あたりの計算時間と、周期毎の時間の分布を出す
+//   - 出力を付けた入力列を書き出すと、別の版やゲインで回した時の基準になる（許容差0ならビット単位で比べる）
+// 例: program replay blackbox.bin out base.rpl      （最後のセッションを再生し、出力付きで保存）
+//     program replay base.rpl                       （変更後の版で再生して、保存した出力と比べる）
+//     program replay flight.csv tolerance 0.5         （許容差[μs]を指定）
+// ずれがあれば終了コード1
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "host_tools.h"
+#include "bench_util.h"
+#include "fake_hal.h"
+#include "replay_stream.h"
+#include "auto_control.h"
+#include "control_tick.h"
+#include "servo_output.h"
+#include "rc_conditioner.h"
+#include "telemetry.h"
+
+static const size_t MAX_DIVERGENCE_REPORTS = 10;
+static const size_t RECONVERGE_SAMPLES = 100;       // これだけ一致が続いた後のずれは別の箇所として表示する
+static const uint64_t MIN_TIMED_SAMPLES = 1000000;  // 計算時間はこの数以上回して測る
+
+struct ReplayOutput {
+    float pulse[2];     // エレベーター/ラダーのサーボのパルス幅[μs]
+};
+
+// 実機のloop()のうち、受信機とIMUを読んだ後の部分（制御中は実機と同じ runControlTick、設定は control_tick.h）
+class ReplayHarness {
+private:
+    FakeServoDriver elevatorDriver;
+    FakeServoDriver rudderDriver;
+    ServoOutput elevatorServo;
+    ServoOutput rudderServo;
+    AutoControl autoControl;
+    RcConditioner rcConditioner;
+    bool previousControlActive;
+
+public:
+    ReplayHarness()
+        : elevatorServo(elevatorDriver, 20, "elevator", ELEVATOR_SERVO_CONFIG),
+          rudderServo(rudderDriver, 2, "rudder", RUDDER_SERVO_CONFIG),
+          previousControlActive(false) {}
+
+    void begin(uint16_t rateHz) {
+        elevatorServo.begin();
+        rudderServo.begin();
+        autoControl.begin(rateHz);
+        rcConditioner.begin(ELEVATOR_RC_CURVE, RUDDER_RC_CURVE);
+    }
+
+    void tick(const ReplayFrame& in, ReplayOutput& out) {
+        bool passthrough = (in.flags & TELEMETRY_FLAG_PASSTHROUGH) != 0;
+        bool imuAvailable = (in.flags & TELEMETRY_FLAG_IMU_OK) != 0;
+        ControlMode mode = (in.flags & TELEMETRY_FLAG_ACCEL_MODE) ? CONTROL_MODE_ACCEL : CONTROL_MODE_ANGLE;
+        if (imuAvailable && mode != autoControl.getMode()) autoControl.setMode(mode);
+
+        RcChannelFrame rcFrames[RC_AXIS_COUNT];
+        for (int axis = 0; axis < RC_AXIS_COUNT; axis++) {
+            rcFrames[axis] = { in.rcPulse[axis], (in.rcFrames & (1 << axis)) != 0, in.rcAge[axis],
+                               in.rcPeriod[axis] };
+        }
+        rcConditioner.update(rcFrames);
+
+        ControlInputs inputs;
+        memcpy(inputs.acc, in.acc, sizeof(inputs.acc));
+        memcpy(inputs.gyro, in.gyro, sizeof(inputs.gyro));
+        bool controlActive = !passthrough && imuAvailable;
+        float elevatorOutput, rudderOutput;
+        if (controlActive) {
+            inputs.hold = !previousControlActive;
+            ControlTickOutput control = runControlTick(autoControl, rcConditioner, inputs, in.dtMicros);
+            elevatorOutput = control.elevator;
+            rudderOutput = control.rudder;
+        } else {
+            // パススルーは補間せず、最新のフレームにカーブだけ掛けた値（PassthroughOutput）
+            elevatorOutput = rcConditioner.getCurve(RC_AXIS_ELEVATOR).apply(in.rcPulse[0]);
+            rudderOutput = rcConditioner.getCurve(RC_AXIS_RUDDER).apply(in.rcPulse[1]);
+            runIdleTick(autoControl, inputs, in.dtMicros, imuAvailable, previousControlActive);
+        }
+        elevatorServo.writeValue(elevatorOutput);
+        rudderServo.writeValue(rudderOutput);
+        out.pulse[0] = elevatorServo.getLastPulse();
+        out.pulse[1] = rudderServo.getLastPulse();
+        previousControlActive = controlActive;
+    }
+};
+
+static void runAll(const ReplayInput& input, std::vector<ReplayOutput>& outputs) {
+    ReplayHarness harness;
+    harness.begin(input.getRateHz());
+    const ReplayFrame* frames = input.data();
+    for (size_t i = 0; i < input.size(); i++) {
+        harness.tick(frames[i], outputs[i]);
+    }
+}
+
+// expectedと比べ、ずれ始めた位置毎に表示する（戻り値: ずれた周期の数）
+// 積分などの状態がずれると以降も一致しないので、最初の位置が一番の手がかりになる
+static size_t reportDivergence(const ReplayInput& input, const std::vector<ReplayOutput>& outputs,
+                               float tolerance) {
+    static const char* AXIS_NAMES[2] = { "elevator", "rudder" };
+    const ReplayFrame* frames = input.data();
+    size_t compared = 0, diverged = 0, reported = 0;
+    float maxError[2] = { 0, 0 };
+    size_t lastDiverged = 0;
+    double time = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        time += frames[i].dtMicros * 1e-6;
+        bool differs = false;
+        int worstAxis = 0;
+        float worst = 0;
+        for (int axis = 0; axis < 2; axis++) {
+            float expected = frames[i].expected[axis];
+            if (isnan(expected)) continue;
+            float error = fabsf(outputs[i].pulse[axis] - expected);
+            if (error > maxError[axis]) maxError[axis] = error;
+            // 許容差0はビット単位で比べる
+            bool mismatch = tolerance > 0 ? error > tolerance
+                                          : memcmp(&outputs[i].pulse[axis], &expected, sizeof(float)) != 0;
+            if (mismatch && error >= worst) {
+                differs = true;
+                worst = error;
+                worstAxis = axis;
+            }
+        }
+        if (!isnan(frames[i].expected[0]) || !isnan(frames[i].expected[1])) compared++;
+        if (differs) {
+            diverged++;
+            if ((diverged == 1 || i - lastDiverged > RECONVERGE_SAMPLES) && reported < MAX_DIVERGENCE_REPORTS) {
+                reported++;
+                printf("  diverged at #%zu (t=%.3fs) %s %.4f us (expected %.4f)%s\n", i, time,
+                       AXIS_NAMES[worstAxis], outputs[i].pulse[worstAxis], frames[i].expected[worstAxis],
+                       (frames[i].flags & TELEMETRY_FLAG_PASSTHROUGH) ? " passthrough" : "");
+            }
+            lastDiverged = i;
+        }
+    }
+    if (compared == 0) {
+        printf("  no expected outputs in input (nothing to compare)\n");
+        return 0;
+    }
+    printf("  compared %zu samples, diverged %zu (tolerance %s%.3g us), max error elevator %.3f us rudder %.3f us\n",
+           compared, diverged, tolerance > 0 ? "" : "bit-exact ", tolerance, maxError[0], maxError[1]);
+    return diverged;
+}
+
+// 全体を何度も回した時間と、1周期ずつの時間の分布
+static bool reportCost(const ReplayInput& input, const std::vector<ReplayOutput>& reference) {
+    size_t count = input.size();
+    uint64_t repeat = (MIN_TIMED_SAMPLES + count - 1) / count;
+    std::vector<ReplayOutput> outputs(count);
+    bool deterministic = true;
+
+    BenchTimer timer;
+    for (uint64_t pass = 0; pass < repeat; pass++) {
+        runAll(input, outputs);
+        doNotOptimize(outputs[count - 1].pulse[0]);
+        // 毎回同じ結果になること（未初期化の状態や時刻に依存していない）
+        if (pass == 0) deterministic = memcmp(outputs.data(), reference.data(), count * sizeof(ReplayOutput)) == 0;
+    }
+    double total = timer.elapsedNanos();
+    uint64_t samples = repeat * count;
+    printf("  %llu samples in %.1f ms: %.1f ns/sample, %.2f M samples/s (%llu passes)\n",
+           (unsigned long long)samples, total * 1e-6, total / samples, samples * 1e3 / total,
+           (unsigned long long)repeat);
+
+    std::vector<float> cost(count);
+    ReplayHarness harness;
+    harness.begin(input.getRateHz());
+    ReplayOutput out;
+    for (size_t i = 0; i < count; i++) {
+        BenchTimer sample;
+        harness.tick(input.data()[i], out);
+        cost[i] = (float)sample.elapsedNanos();
+    }
+    size_t slowest = std::max_element(cost.begin(), cost.end()) - cost.begin();
+    float slowestCost = cost[slowest];
+    std::sort(cost.begin(), cost.end());
+    printf("  per sample (incl. timer): p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, max %.0f ns at #%zu\n",
+           cost[count / 2], cost[count * 99 / 100], cost[count * 999 / 1000], slowestCost, slowest);
+    printf("  deterministic: %s\n", deterministic ? "yes" : "NO");
+    return deterministic;
+}
+
+int replayTool(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: replay <input> [out file.rpl|file.csv] [session n] [tolerance us]\n");
+        return 1;
+    }
+    const char* outputPath = nullptr;
+    int session = -1;
+    float tolerance = -1;
+    for (int i = 2; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value for %s\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "out") == 0) outputPath = argv[i + 1];
+        else if (strcmp(argv[i], "session") == 0) session = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "tolerance") == 0) tolerance = atof(argv[i + 1]);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    ReplayInput input;
+    if (!input.load(argv[1], session)) {
+        fprintf(stderr, "%s\n", input.getError());
+        return 1;
+    }
+    if (input.size() == 0) {
+        fprintf(stderr, "%s: no samples\n", argv[1]);
+        return 1;
+    }
+    // 許容差の既定は入力の分解能（ブラックボックスは0.1μs単位で記録している）
+    if (tolerance < 0) tolerance = input.getResolution();
+
+    size_t control = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        uint8_t flags = input.data()[i].flags;
+        if (!(flags & TELEMETRY_FLAG_PASSTHROUGH) && (flags & TELEMETRY_FLAG_IMU_OK)) control++;
+    }
+    printf("%s: %zu samples at %u Hz (%zu under control)\n", argv[1], input.size(), input.getRateHz(), control);
+
+    std::vector<ReplayOutput> outputs(input.size());
+    runAll(input, outputs);
+
+    printf("divergence:\n");
+    size_t diverged = reportDivergence(input, outputs, tolerance);
+    printf("cost:\n");
+    bool deterministic = reportCost(input, outputs);
+
+    if (outputPath != nullptr) {
+        std::vector<ReplayFrame> frames(input.data(), input.data() + input.size());
+        for (size_t i = 0; i < frames.size(); i++) {
+            frames[i].expected[0] = outputs[i].pulse[0];
+            frames[i].expected[1] = outputs[i].pulse[1];
+        }
+        size_t length = strlen(outputPath);
+        bool csv = length > 4 && strcmp(outputPath + length - 4, ".csv") == 0;
+        bool ok = csv ? writeReplayCsv(outputPath, frames.data(), frames.size())
+                      : writeReplayBinary(outputPath, frames.data(), frames.size(), input.getRateHz());
+        if (!ok) {
+            perror(outputPath);
+            return 1;
+        }
+        printf("wrote %s\n", outputPath);
+    }
+    return diverged == 0 && deterministic ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+// 実機のloop()と同じ順序で制御系を仮想時間で回す
+// 機体の運動は模擬しないため、IMUには一定の姿勢を与える
+// IMUはMPU6050のレジスタを模擬したバス越しに自前ドライバーで読む
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_tools.h"
+#include "fake_hal.h"
+#include "auto_control.h"
+#include "control_tick.h"
+#include "control_scheduler.h"
+#include "rc_receiver.h"
+#include "rc_conditioner.h"
+#include "pwm_receiver_backend.h"
+#include "servo_output.h"
+#include "mpu6050_driver.h"
+
+static const int ELEVATOR_INPUT_PIN = 21;
+static const int RUDDER_INPUT_PIN = 1;
+static const int LED_INPUT_PIN = 10;
+
+int runLoopTool(int argc, char** argv) {
+    float seconds = argc > 1 ? atof(argv[1]) : 2.0f;
+    int rateHz = argc > 2 ? atoi(argv[2]) : 100;
+    
+    FakeClock clock(1);
+    FakePwmInput pwmInput(clock);
+    FakeMpu6050Bus imuBus;
+    Mpu6050Driver imu(imuBus);
+    FakeServoDriver elevatorDriver;
+    FakeServoDriver rudderDriver;
+    
+    PwmReceiverBackend rcBackend(pwmInput, clock, ELEVATOR_INPUT_PIN, RUDDER_INPUT_PIN, LED_INPUT_PIN);
+    RCReceiver rcReceiver(rcBackend, clock);
+    RcConditioner rcConditioner;
+    ServoOutput elevatorServo(elevatorDriver, 20, "elevator", ELEVATOR_SERVO_CONFIG);
+    ServoOutput rudderServo(rudderDriver, 2, "rudder", RUDDER_SERVO_CONFIG);
+    AutoControl autoControl;
+    ControlScheduler scheduler(clock, rateHz);
+    if (!ControlScheduler::isSupportedRate(rateHz)) {
+        fprintf(stderr, "unsupported rate %d, using %u\n", rateHz, scheduler.getRate());
+    }
+    
+    rcReceiver.begin();
+    rcConditioner.begin(ELEVATOR_RC_CURVE, RUDDER_RC_CURVE);
+    elevatorServo.begin();
+    rudderServo.begin();
+    
+    Mpu6050Config imuConfig = { 3, 0, true, -1 };   // 1kHzサンプル、FIFO使用
+    if (!imu.probe(Mpu6050Driver::ADDRESS_LOW) ||
+        !imu.begin(Mpu6050Driver::ADDRESS_LOW, imuConfig)) {
+        fprintf(stderr, "MPU6050 init failed\n");
+        return 1;
+    }
+    
+    scheduler.begin();
+    autoControl.begin(scheduler.getRate());
+    
+    // 機首上げ10度相当の加速度とわずかなヨーレート
+    const float acc[3] = { -0.17f, 0.0f, 0.98f };
+    const float gyro[3] = { 0.0f, 0.0f, 1.0f };
+    uint32_t samplesPerTick = 1000 / scheduler.getRate();
+    
+    printf("time_us,dt_us,pitch,yaw,elevator,rudder,elevator_us,rudder_us\n");
+    uint32_t ticks = (uint32_t)(seconds * scheduler.getRate());
+    for (uint32_t i = 0; i < ticks; i++) {
+        scheduler.waitForTick();
+        uint32_t deltaMicros = scheduler.getDeltaMicros();
+        
+        // 受信機は20ms周期でパルスを出す（姿勢制御モード、スティック中立）
+        if (i % (scheduler.getRate() / 50) == 0) {
+            pwmInput.pulse(LED_INPUT_PIN, 2000);
+            pwmInput.pulse(ELEVATOR_INPUT_PIN, 1500);
+            pwmInput.pulse(RUDDER_INPUT_PIN, 1500);
+        }
+        rcReceiver.update();
+        rcConditioner.update(rcReceiver);
+        
+        for (uint32_t n = 0; n < samplesPerTick; n++) {
+            imuBus.pushSample(acc, gyro, 25.0f);
+        }
+        imu.update();
+        ControlInputs inputs = {};
+        inputs.setImu(imu);
+        inputs.hold = i == 0;
+        ControlTickOutput control = runControlTick(autoControl, rcConditioner, inputs, deltaMicros);
+        
+        float elevatorOutput = control.elevator;
+        float rudderOutput = control.rudder;
+        elevatorServo.writeValue(elevatorOutput);
+        rudderServo.writeValue(rudderOutput);
+        
+        float pitch = autoControl.getCurrentPitch();
+        float yaw = autoControl.getCurrentYaw();
+        printf("%u,%u,%.3f,%.3f,%.2f,%.2f,%.1f,%.1f\n", clock.micros(), scheduler.getDeltaMicros(),
+               pitch, yaw, elevatorOutput, rudderOutput, elevatorDriver.pulseMicros, rudderDriver.pulseMicros);
+        
+        // 処理時間の代わりに少し時間を進める
+        clock.advance(200);
+    }
+    
+    fprintf(stderr, "i2c transactions=%u bytes=%u (%.2f transactions/tick)\n",
+            imuBus.transactions, imuBus.bytesRead, (double)imuBus.transactions / ticks);
+    return 0;
+}
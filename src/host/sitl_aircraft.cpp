@@ -0,0 +1,248 @@
+#include "sitl_aircraft.h"
+#include <math.h>
+
+static const float GRAVITY = 9.80665f;
+static const float AIR_DENSITY = 1.225f;
+static const float RAD_TO_DEG_F = 57.2957795f;
+
+AircraftParams AircraftParams::trainer() {
+    AircraftParams p;
+    p.mass = 1.0f;
+    p.wingArea = 0.25f;
+    p.chord = 0.21f;
+    p.span = 1.2f;
+    p.inertia[0] = 0.04f;
+    p.inertia[1] = 0.06f;
+    p.inertia[2] = 0.09f;
+    p.thrust = 1.08f;           // 12m/sの水平飛行の抗力とつり合う
+
+    p.cl0 = 0.445f;             // 12m/s、迎角0で揚力 = 重量
+    p.clAlpha = 4.5f;
+    p.cd0 = 0.035f;
+    p.cdInduced = 0.07f;
+    p.cyBeta = -0.3f;
+    p.cyRudder = 0.15f;
+    p.cm0 = 0.0f;
+    p.cmAlpha = -0.6f;
+    p.cmQ = -10.0f;
+    p.cmElevator = 0.9f;
+    p.clBeta = -0.08f;          // 上反角
+    p.clP = -0.45f;
+    p.clR = 0.1f;
+    p.clAileron = 0.2f;
+    p.clRudder = 0.005f;
+    p.cnBeta = 0.07f;           // 方向安定
+    p.cnP = -0.03f;
+    p.cnR = -0.12f;
+    p.cnRudder = -0.07f;        // 正のラダーで機首左
+
+    p.maxDeflection = 25.0f / RAD_TO_DEG_F;
+    p.servoTau = 0.02f;
+    p.servoRate = 60.0f / RAD_TO_DEG_F / 0.1f;   // 60度/0.1秒
+    return p;
+}
+
+SitlAircraft::SitlAircraft(const AircraftParams& params) : params(params) {
+    reset(12.0f);
+}
+
+void SitlAircraft::reset(float speed) {
+    position = { 0, 0, -50.0f };
+    velocity = { speed, 0, 0 };
+    q[0] = 1;
+    q[1] = q[2] = q[3] = 0;
+    rates = { 0, 0, 0 };
+    surfaces = { 0, 0, 0 };
+    specificForce = { 0, 0, -GRAVITY };
+    wind = { 0, 0, 0 };
+    alpha = beta = 0;
+    airspeed = speed;
+}
+
+Vec3 SitlAircraft::toNed(const Vec3& v) const {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    return {
+        (1 - 2 * (y * y + z * z)) * v.x + 2 * (x * y - w * z) * v.y + 2 * (x * z + w * y) * v.z,
+        2 * (x * y + w * z) * v.x + (1 - 2 * (x * x + z * z)) * v.y + 2 * (y * z - w * x) * v.z,
+        2 * (x * z - w * y) * v.x + 2 * (y * z + w * x) * v.y + (1 - 2 * (x * x + y * y)) * v.z,
+    };
+}
+
+Vec3 SitlAircraft::toBody(const Vec3& v) const {
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    return {
+        (1 - 2 * (y * y + z * z)) * v.x + 2 * (x * y + w * z) * v.y + 2 * (x * z - w * y) * v.z,
+        2 * (x * y - w * z) * v.x + (1 - 2 * (x * x + z * z)) * v.y + 2 * (y * z + w * x) * v.z,
+        2 * (x * z + w * y) * v.x + 2 * (y * z - w * x) * v.y + (1 - 2 * (x * x + y * y)) * v.z,
+    };
+}
+
+void SitlAircraft::moveSurface(float& actual, float command, float dt) {
+    float limit = params.maxDeflection;
+    if (command > limit) command = limit;
+    if (command < -limit) command = -limit;
+    // 1次遅れ、速度制限付き
+    float speed = (command - actual) / params.servoTau;
+    if (speed > params.servoRate) speed = params.servoRate;
+    if (speed < -params.servoRate) speed = -params.servoRate;
+    float next = actual + speed * dt;
+    actual = (command - actual) * (command - next) <= 0 ? command : next;
+}
+
+void SitlAircraft::step(const ControlSurfaces& command, float dt) {
+    moveSurface(surfaces.elevator, command.elevator, dt);
+    moveSurface(surfaces.aileron, command.aileron, dt);
+    moveSurface(surfaces.rudder, command.rudder, dt);
+
+    // 対気速度と迎角・横滑り角
+    Vec3 windBody = toBody(wind);
+    Vec3 air = { velocity.x - windBody.x, velocity.y - windBody.y, velocity.z - windBody.z };
+    airspeed = sqrtf(air.x * air.x + air.y * air.y + air.z * air.z);
+    if (airspeed < 1.0f) airspeed = 1.0f;
+    alpha = atan2f(air.z, air.x);
+    beta = asinf(fmaxf(-1.0f, fminf(1.0f, air.y / airspeed)));
+
+    const AircraftParams& p = params;
+    float qbar = 0.5f * AIR_DENSITY * airspeed * airspeed;
+    float pHat = rates.x * p.span / (2 * airspeed);
+    float qHat = rates.y * p.chord / (2 * airspeed);
+    float rHat = rates.z * p.span / (2 * airspeed);
+
+    // 空力係数（正のエレベーター = 機首上げ）
+    float cl = p.cl0 + p.clAlpha * alpha;
+    float cd = p.cd0 + p.cdInduced * cl * cl;
+    float cy = p.cyBeta * beta + p.cyRudder * surfaces.rudder;
+    float cRoll = p.clBeta * beta + p.clP * pHat + p.clR * rHat + p.clAileron * surfaces.aileron +
+                  p.clRudder * surfaces.rudder;
+    float cPitch = p.cm0 + p.cmAlpha * alpha + p.cmQ * qHat + p.cmElevator * surfaces.elevator;
+    float cYaw = p.cnBeta * beta + p.cnP * pHat + p.cnR * rHat + p.cnRudder * surfaces.rudder;
+
+    // 力（機体座標）
+    float lift = qbar * p.wingArea * cl;
+    float drag = qbar * p.wingArea * cd;
+    float ca = cosf(alpha), sa = sinf(alpha);
+    Vec3 force = {
+        p.thrust - drag * ca + lift * sa,
+        qbar * p.wingArea * cy,
+        -drag * sa - lift * ca,
+    };
+    specificForce = { force.x / p.mass, force.y / p.mass, force.z / p.mass };
+
+    // モーメント
+    Vec3 moment = {
+        qbar * p.wingArea * p.span * cRoll,
+        qbar * p.wingArea * p.chord * cPitch,
+        qbar * p.wingArea * p.span * cYaw,
+    };
+    const float* I = p.inertia;
+    Vec3 angularAccel = {
+        (moment.x - (I[2] - I[1]) * rates.y * rates.z) / I[0],
+        (moment.y - (I[0] - I[2]) * rates.x * rates.z) / I[1],
+        (moment.z - (I[1] - I[0]) * rates.x * rates.y) / I[2],
+    };
+
+    // 並進（機体座標、重力と回転による見かけの力を含む）
+    Vec3 gravity = toBody({ 0, 0, GRAVITY });
+    Vec3 accel = {
+        specificForce.x + gravity.x - (rates.y * velocity.z - rates.z * velocity.y),
+        specificForce.y + gravity.y - (rates.z * velocity.x - rates.x * velocity.z),
+        specificForce.z + gravity.z - (rates.x * velocity.y - rates.y * velocity.x),
+    };
+
+    // 半陰的オイラー法（角速度と速度を先に更新）
+    rates.x += angularAccel.x * dt;
+    rates.y += angularAccel.y * dt;
+    rates.z += angularAccel.z * dt;
+    velocity.x += accel.x * dt;
+    velocity.y += accel.y * dt;
+    velocity.z += accel.z * dt;
+
+    // 姿勢: dq = 0.5 * q ⊗ (0, ω)
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+    float h = 0.5f * dt;
+    q[0] += h * (-x * rates.x - y * rates.y - z * rates.z);
+    q[1] += h * (w * rates.x + y * rates.z - z * rates.y);
+    q[2] += h * (w * rates.y - x * rates.z + z * rates.x);
+    q[3] += h * (w * rates.z + x * rates.y - y * rates.x);
+    float norm = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int i = 0; i < 4; i++) q[i] *= norm;
+
+    Vec3 ground = toNed(velocity);
+    position.x += ground.x * dt;
+    position.y += ground.y * dt;
+    position.z += ground.z * dt;
+}
+
+float SitlAircraft::getPitch() const {
+    float s = 2 * (q[0] * q[2] - q[3] * q[1]);
+    return asinf(fmaxf(-1.0f, fminf(1.0f, s))) * RAD_TO_DEG_F;
+}
+
+float SitlAircraft::getRoll() const {
+    return atan2f(2 * (q[0] * q[1] + q[2] * q[3]), 1 - 2 * (q[1] * q[1] + q[2] * q[2])) * RAD_TO_DEG_F;
+}
+
+float SitlAircraft::getYaw() const {
+    return atan2f(2 * (q[0] * q[3] + q[1] * q[2]), 1 - 2 * (q[2] * q[2] + q[3] * q[3])) * RAD_TO_DEG_F;
+}
+
+ImuErrorModel ImuErrorModel::typical() {
+    ImuErrorModel m;
+    m.accNoise = 0.01f;
+    m.gyroNoise = 0.05f;
+    m.accBias[0] = 0.02f;
+    m.accBias[1] = -0.015f;
+    m.accBias[2] = 0.03f;
+    m.gyroBias[0] = 0.8f;
+    m.gyroBias[1] = -0.6f;
+    m.gyroBias[2] = 0.4f;
+    m.vibrationHz = 120.0f;
+    m.accVibration = 0.15f;
+    m.gyroVibration = 2.0f;
+    m.dlpfHz = 44.0f;           // Mpu6050ConfigのDLPF 3
+    return m;
+}
+
+ImuErrorModel ImuErrorModel::ideal() {
+    ImuErrorModel m = {};
+    return m;
+}
+
+SitlImu::SitlImu(const ImuErrorModel& model, uint32_t seed)
+    : model(model), random(seed), phase(0), first(true) {
+}
+
+float SitlImu::gaussian() {
+    // Box-Muller（std::normal_distributionは標準ライブラリによって結果が変わるため使わない）
+    float u1 = ((random() >> 8) + 1.0f) * (1.0f / 16777217.0f);
+    float u2 = (random() >> 8) * (1.0f / 16777216.0f);
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+void SitlImu::sample(const SitlAircraft& aircraft, float dt, float acc[3], float gyro[3]) {
+    // 姿勢推定の符号に合わせた取り付け（X: 後ろ、Y: 右、Z: 上）
+    const Vec3& f = aircraft.getSpecificForce();
+    const Vec3& w = aircraft.getRates();
+    float trueAcc[3] = { -f.x / GRAVITY, f.y / GRAVITY, -f.z / GRAVITY };
+    float trueGyro[3] = { -w.x * RAD_TO_DEG_F, w.y * RAD_TO_DEG_F, -w.z * RAD_TO_DEG_F };
+
+    // 振動（軸毎に位相をずらす）
+    phase += 2.0f * (float)M_PI * model.vibrationHz * dt;
+    if (phase > 2.0f * (float)M_PI) phase -= 2.0f * (float)M_PI;
+    float weight = model.dlpfHz > 0 ? dt / (1.0f / (2.0f * (float)M_PI * model.dlpfHz) + dt) : 1.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        float vibration = sinf(phase + axis * 2.1f);
+        float a = trueAcc[axis] + model.accBias[axis] + model.accVibration * vibration;
+        float g = trueGyro[axis] + model.gyroBias[axis] + model.gyroVibration * vibration;
+        if (first) {
+            // 電源投入時はローパスが落ち着いている（振動を含まない値から始める）
+            accFiltered[axis] = trueAcc[axis] + model.accBias[axis];
+            gyroFiltered[axis] = trueGyro[axis] + model.gyroBias[axis];
+        }
+        accFiltered[axis] += weight * (a - accFiltered[axis]);
+        gyroFiltered[axis] += weight * (g - gyroFiltered[axis]);
+        acc[axis] = accFiltered[axis] + model.accNoise * gaussian();
+        gyro[axis] = gyroFiltered[axis] + model.gyroNoise * gaussian();
+    }
+    first = false;
+}
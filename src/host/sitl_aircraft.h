@@ -0,0 +1,118 @@
+#ifndef SITL_AIRCRAFT_H
+#define SITL_AIRCRAFT_H
+
+// SITL用の固定翼機の6自由度モデルとIMUの模擬
+// 機体座標は前・右・下（FRD）、地上座標は北・東・下（NED）。角度はラジアン、出力のIMU値は[g]と[deg/s]
+// 空力は線形の微係数（1kg前後の練習機を想定した値）で、失速は扱わない
+
+#include <stdint.h>
+#include <random>
+
+struct Vec3 {
+    float x, y, z;
+};
+
+// 機体の諸元と空力微係数
+struct AircraftParams {
+    float mass;             // [kg]
+    float wingArea;         // S [m^2]
+    float chord;            // c [m]
+    float span;             // b [m]
+    float inertia[3];       // Ixx, Iyy, Izz [kg m^2]（慣性乗積は無視）
+    float thrust;           // 推力[N]（一定）
+
+    float cl0, clAlpha;     // 揚力
+    float cd0, cdInduced;   // 抗力 = cd0 + cdInduced * CL^2
+    float cyBeta, cyRudder; // 横力
+    float cm0, cmAlpha, cmQ, cmElevator;                // ピッチ
+    float clBeta, clP, clR, clAileron, clRudder;        // ロール（clはロールモーメント）
+    float cnBeta, cnP, cnR, cnRudder;                   // ヨー
+
+    float maxDeflection;    // 舵角の最大[rad]（入力±100%、1000-2000μs）
+    float servoTau;         // サーボの応答の時定数[秒]
+    float servoRate;        // サーボの最大速度[rad/秒]
+
+    static AircraftParams trainer();
+};
+
+// 舵（正のエレベーター = 機首上げ、正のラダー = 機首左。ファームウェアの符号に合わせる）
+struct ControlSurfaces {
+    float elevator;
+    float aileron;
+    float rudder;
+};
+
+class SitlAircraft {
+private:
+    AircraftParams params;
+    Vec3 position;          // NED [m]
+    Vec3 velocity;          // 対地速度（機体座標）[m/s]
+    float q[4];             // 姿勢（機体 → NED の回転、w, x, y, z）
+    Vec3 rates;             // p, q, r [rad/s]
+    ControlSurfaces surfaces;   // 実際の舵角[rad]（サーボの遅れ後）
+    Vec3 specificForce;     // 重力以外の力 / 質量（加速度計が測るもの）[m/s^2]
+    Vec3 wind;              // 風（NED）[m/s]
+    float alpha, beta, airspeed;
+
+    Vec3 toBody(const Vec3& ned) const;
+    Vec3 toNed(const Vec3& body) const;
+    void moveSurface(float& actual, float command, float dt);
+
+public:
+    explicit SitlAircraft(const AircraftParams& params);
+
+    // 水平直線飛行（対気速度airspeed[m/s]）から始める
+    void reset(float airspeed);
+
+    // 1ステップ進める（command: 舵角の指令[rad]、サーボの遅れと速度制限を通して効く）
+    void step(const ControlSurfaces& command, float dt);
+
+    void setWind(const Vec3& ned) { wind = ned; }
+
+    // 姿勢（オイラー角[deg]、ピッチは機首上げ、ロールは右翼下げ、ヨーは右回りが正）
+    float getPitch() const;
+    float getRoll() const;
+    float getYaw() const;
+    const Vec3& getRates() const { return rates; }
+    const Vec3& getSpecificForce() const { return specificForce; }
+    const Vec3& getPosition() const { return position; }
+    float getAirspeed() const { return airspeed; }
+    float getAlpha() const { return alpha; }
+    const ControlSurfaces& getSurfaces() const { return surfaces; }
+    const AircraftParams& getParams() const { return params; }
+};
+
+// MPU6050の測定値の模擬（ノイズ、バイアス、機体の振動、内蔵ローパス）
+// 取り付けの向きは姿勢推定の符号に合わせる（X: 後ろ、Y: 右、Z: 上）
+struct ImuErrorModel {
+    float accNoise;         // [g rms]
+    float gyroNoise;        // [deg/s rms]
+    float accBias[3];       // [g]
+    float gyroBias[3];      // [deg/s]
+    float vibrationHz;      // モーターの振動の周波数
+    float accVibration;     // [g]（振幅）
+    float gyroVibration;    // [deg/s]（振幅）
+    float dlpfHz;           // センサー内蔵のローパス（CONFIGのDLPF相当）
+
+    static ImuErrorModel typical();
+    static ImuErrorModel ideal();
+};
+
+class SitlImu {
+private:
+    ImuErrorModel model;
+    std::mt19937 random;    // 乱数列が標準で決まっているもの（環境によらず同じ結果になる）
+    float accFiltered[3], gyroFiltered[3];
+    float phase;
+    bool first;
+
+    float gaussian();
+
+public:
+    SitlImu(const ImuErrorModel& model, uint32_t seed);
+
+    // 機体の状態から1サンプル作る（dt: サンプル周期[秒]）
+    void sample(const SitlAircraft& aircraft, float dt, float acc[3], float gyro[3]);
+};
+
+#endif
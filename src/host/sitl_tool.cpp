@@ -0,0 +1,449 @@
+// SITL（ソフトウェア・イン・ザ・ループ）: 実機と同じ制御コードで模擬機体を飛ばす
+// 受信機のパルス → RCReceiver、模擬MPU6050のレジスタ → Mpu6050Driver、AutoControl、ServoOutputのパルス幅 → 舵角
+// の順に、実機のloop()と同じ手順で仮想時間を進める（実時間を待たない）
+// 例: program sitl               （全シナリオを実行し、基準を外れたら終了コード1）
+//     program sitl gust 1000     （シナリオと制御周期を指定）
+//     program sitl step 500 csv  （軌跡をCSVで出力）
+//     program sitl sweep         （ピッチのゲインを総当たりで評価）
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "host_tools.h"
+#include "fake_hal.h"
+#include "sitl_aircraft.h"
+#include "auto_control.h"
+#include "control_tick.h"
+#include "control_scheduler.h"
+#include "rc_receiver.h"
+#include "rc_conditioner.h"
+#include "passthrough_output.h"
+#include "pwm_receiver_backend.h"
+#include "servo_output.h"
+#include "mpu6050_driver.h"
+
+static const int ELEVATOR_INPUT_PIN = 21;
+static const int RUDDER_INPUT_PIN = 1;
+static const int LED_INPUT_PIN = 10;
+
+static const uint32_t PHYSICS_MICROS = 1000;    // IMUのサンプル周期（1kHz）
+static const int PHYSICS_SUBSTEPS = 4;
+static const uint32_t RC_FRAME_MICROS = 20000;  // PWM受信機の周期
+static const uint32_t LOG_MICROS = 10000;       // CSVの出力周期
+
+// ピッチのゲイン（sweepで変える）
+struct PitchGains {
+    float angleKp;
+    float rateKp, rateKi, rateKd;
+};
+
+// 制御系一式と模擬機体
+class SitlHarness {
+public:
+    FakeClock clock;
+    FakePwmInput pwmInput;
+    FakeMpu6050Bus imuBus;
+    Mpu6050Driver imu;
+    FakeServoDriver elevatorDriver;
+    FakeServoDriver rudderDriver;
+    PwmReceiverBackend rcBackend;
+    RCReceiver rcReceiver;
+    RcConditioner rcConditioner;
+    ServoOutput elevatorServo;
+    ServoOutput rudderServo;
+    PassthroughOutput passthroughOutput;
+    AutoControl autoControl;
+    ControlScheduler scheduler;
+    SitlAircraft aircraft;
+    SitlImu imuModel;
+    ImuErrorModel imuErrors;
+
+    // 送信機のスティックとスイッチ[μs]
+    uint16_t elevatorStick = 1500;
+    uint16_t rudderStick = 1500;
+    uint16_t modeSwitch = 2000;     // 2000: 姿勢制御、1000: パススルー
+
+    bool passthrough = true;
+    bool previousPassthroughMode = true;
+    float elevatorOutput = 0, rudderOutput = 0;
+    uint32_t ticks = 0;
+
+private:
+    float elevatorPulse = 1500, rudderPulse = 1500;     // サーボが受け取ったパルス
+    uint32_t servoElapsed = 0;
+
+    // 実機のloop()の1周期（src/main.cpp と同じ順序）
+    void controlTick() {
+        uint32_t deltaMicros = scheduler.getDeltaMicros();
+        rcReceiver.update();
+        rcConditioner.update(rcReceiver);
+        passthrough = rcReceiver.isPassthroughMode();
+        bool modeChanged = passthrough != previousPassthroughMode;
+        imu.update();
+
+        if (!passthrough) {
+            ControlInputs inputs;
+            inputs.setImu(imu);
+            inputs.hold = modeChanged && previousPassthroughMode;
+            ControlTickOutput control = runControlTick(autoControl, rcConditioner, inputs, deltaMicros);
+            elevatorOutput = control.elevator;
+            rudderOutput = control.rudder;
+            elevatorServo.writeValue(elevatorOutput);
+            rudderServo.writeValue(rudderOutput);
+        } else {
+            // 新しいフレームの分だけ書く（実機は周期の間にも受信機のパルスで起きて書く）
+            if (modeChanged) passthroughOutput.invalidate();
+            passthroughOutput.service(rcReceiver);
+            elevatorOutput = passthroughOutput.getValue(RC_AXIS_ELEVATOR);
+            rudderOutput = passthroughOutput.getValue(RC_AXIS_RUDDER);
+            ControlInputs inputs;
+            inputs.setImu(imu);
+            runIdleTick(autoControl, inputs, deltaMicros, true, modeChanged);
+        }
+        previousPassthroughMode = passthrough;
+        ticks++;
+    }
+
+    // パルス幅 → 舵角（サーボ設定の中立が0、振れ幅で最大舵角）
+    float toDeflection(float pulse, const ServoConfig& config) const {
+        return (pulse - config.centerMicros - config.subtrimMicros) / config.travelMicros
+               * (config.reversed ? -1 : 1) * aircraft.getParams().maxDeflection;
+    }
+
+public:
+    SitlHarness(uint16_t rateHz, const ImuErrorModel& imuErrors, uint32_t seed)
+        : clock(1), pwmInput(clock), imu(imuBus),
+          rcBackend(pwmInput, clock, ELEVATOR_INPUT_PIN, RUDDER_INPUT_PIN, LED_INPUT_PIN),
+          rcReceiver(rcBackend, clock),
+          elevatorServo(elevatorDriver, 20, "elevator", ELEVATOR_SERVO_CONFIG),
+          rudderServo(rudderDriver, 2, "rudder", RUDDER_SERVO_CONFIG),
+          passthroughOutput(clock, elevatorServo, rudderServo, rcConditioner),
+          scheduler(clock, rateHz),
+          aircraft(AircraftParams::trainer()),
+          imuModel(imuErrors, seed), imuErrors(imuErrors) {}
+
+    bool begin() {
+        rcReceiver.begin();
+        rcConditioner.begin(ELEVATOR_RC_CURVE, RUDDER_RC_CURVE);
+        elevatorServo.begin();
+        rudderServo.begin();
+        Mpu6050Config imuConfig = { 3, 0, true, -1 };   // 1kHzサンプル、FIFO使用
+        if (!imu.probe(Mpu6050Driver::ADDRESS_LOW) || !imu.begin(Mpu6050Driver::ADDRESS_LOW, imuConfig)) {
+            return false;
+        }
+        // 保存済みのIMU校正（ImuCalibrator）を読み込んだ状態にする
+        imu.setGyroOffsets(imuErrors.gyroBias[0], imuErrors.gyroBias[1], imuErrors.gyroBias[2]);
+        imu.setAccelOffsets(imuErrors.accBias[0], imuErrors.accBias[1], imuErrors.accBias[2]);
+        scheduler.begin();
+        autoControl.begin(scheduler.getRate());
+        return true;
+    }
+
+    void setPitchGains(const PitchGains& gains) {
+        AngleModeControl& angle = autoControl.getAngleMode();
+        angle.setPitchAnglePID(gains.angleKp, 0, 0, 180);
+        angle.setPitchRatePID(gains.rateKp, gains.rateKi, gains.rateKd);
+    }
+
+    // 1ms進める（受信機のパルス、機体の運動、IMUのサンプル、制御周期、サーボのフレーム）
+    void advance() {
+        if (clock.micros() % RC_FRAME_MICROS < PHYSICS_MICROS) {
+            pwmInput.pulse(LED_INPUT_PIN, modeSwitch);
+            pwmInput.pulse(ELEVATOR_INPUT_PIN, elevatorStick);
+            pwmInput.pulse(RUDDER_INPUT_PIN, rudderStick);
+        }
+
+        ControlSurfaces command = { toDeflection(elevatorPulse, ELEVATOR_SERVO_CONFIG), 0,
+                                    toDeflection(rudderPulse, RUDDER_SERVO_CONFIG) };
+        const float dt = PHYSICS_MICROS * 1e-6f / PHYSICS_SUBSTEPS;
+        for (int i = 0; i < PHYSICS_SUBSTEPS; i++) {
+            aircraft.step(command, dt);
+        }
+        float acc[3], gyro[3];
+        imuModel.sample(aircraft, PHYSICS_MICROS * 1e-6f, acc, gyro);
+        imuBus.pushSample(acc, gyro, 25.0f);
+        clock.advance(PHYSICS_MICROS);
+
+        if (scheduler.poll()) controlTick();
+
+        // サーボはフレーム毎に最新のパルス幅を受け取る
+        servoElapsed += PHYSICS_MICROS;
+        if (servoElapsed >= 1000000u / elevatorDriver.frameRateHz) {
+            servoElapsed = 0;
+            elevatorPulse = elevatorDriver.pulseMicros;
+            rudderPulse = rudderDriver.pulseMicros;
+        }
+    }
+
+    float seconds() { return (clock.micros() - 1) * 1e-6f; }
+};
+
+// 評価値（基準値と比べる）
+struct Metric {
+    const char* name;
+    float value;
+    float limit;    // これ以下なら合格
+};
+
+struct ScenarioResult {
+    std::vector<Metric> metrics;
+    float cost;     // sweepの並べ替え用（小さいほど良い）
+
+    bool passed() const {
+        for (const Metric& m : metrics) {
+            if (!(m.value <= m.limit)) return false;
+        }
+        return true;
+    }
+};
+
+struct Scenario {
+    const char* name;
+    const char* description;
+    ScenarioResult (*run)(SitlHarness& sim, FILE* csv);
+};
+
+static float wrapDegrees(float angle) {
+    while (angle > 180) angle -= 360;
+    while (angle < -180) angle += 360;
+    return angle;
+}
+
+// 1-cos形の突風（start[秒]から長さlength[秒]、最大peak[m/s]）
+static float gust(float t, float start, float length, float peak) {
+    if (t < start || t > start + length) return 0;
+    return 0.5f * peak * (1 - cosf(2 * (float)M_PI * (t - start) / length));
+}
+
+static void logHeader(FILE* csv) {
+    if (csv == nullptr) return;
+    fprintf(csv, "time_s,passthrough,pitch,roll,yaw,est_pitch,est_yaw,target_pitch,elevator,rudder,"
+                 "elevator_deg,rudder_deg,airspeed,altitude\n");
+}
+
+static void logRow(FILE* csv, SitlHarness& sim) {
+    if (csv == nullptr || sim.clock.micros() % LOG_MICROS >= PHYSICS_MICROS) return;
+    const SitlAircraft& a = sim.aircraft;
+    fprintf(csv, "%.3f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+            sim.seconds(), sim.passthrough ? 1 : 0, a.getPitch(), a.getRoll(), a.getYaw(),
+            sim.autoControl.getCurrentPitch(), sim.autoControl.getCurrentYaw(),
+            sim.autoControl.getTargetPitch(), sim.elevatorOutput, sim.rudderOutput,
+            a.getSurfaces().elevator * 57.2958f, a.getSurfaces().rudder * 57.2958f,
+            a.getAirspeed(), -a.getPosition().z);
+}
+
+// 姿勢保持中の上昇気流（3秒）と横風（6秒）
+static ScenarioResult runGust(SitlHarness& sim, FILE* csv) {
+    float pitchRef = 0, yawRef = 0, pitchMax = 0, yawMax = 0;
+    double pitchSquared = 0;
+    int count = 0;
+    logHeader(csv);
+    while (sim.seconds() < 10.0f) {
+        float t = sim.seconds();
+        sim.aircraft.setWind({ 0, gust(t, 6.0f, 1.0f, 3.0f), -gust(t, 3.0f, 0.5f, 3.0f) });
+        sim.advance();
+        logRow(csv, sim);
+        if (t < 2.9f) {
+            pitchRef = sim.aircraft.getPitch();
+            yawRef = sim.aircraft.getYaw();
+            continue;
+        }
+        float pitchError = sim.aircraft.getPitch() - pitchRef;
+        float yawError = wrapDegrees(sim.aircraft.getYaw() - yawRef);
+        pitchMax = fmaxf(pitchMax, fabsf(pitchError));
+        yawMax = fmaxf(yawMax, fabsf(yawError));
+        pitchSquared += pitchError * pitchError;
+        count++;
+    }
+    float pitchRms = sqrtf(pitchSquared / count);
+    ScenarioResult r;
+    r.metrics = {
+        { "pitch max deviation [deg]", pitchMax, 6.0f },
+        { "pitch rms deviation [deg]", pitchRms, 3.0f },
+        { "yaw max deviation [deg]", yawMax, 12.0f },
+    };
+    r.cost = pitchRms + 0.1f * pitchMax;
+    return r;
+}
+
+// エレベーターのスティックを2秒から3秒間+50%（目標+2.5度、舵にも直接足される）
+static ScenarioResult runStep(SitlHarness& sim, FILE* csv) {
+    const float STEP = ANGLE_STICK_SCALE * 50.0f;
+    float pitchRef = 0, overshoot = 0, riseTime = -1, holdError = 0, returnError = 0;
+    double trackSquared = 0;
+    int count = 0;
+    logHeader(csv);
+    while (sim.seconds() < 8.0f) {
+        float t = sim.seconds();
+        sim.elevatorStick = t >= 2.0f && t < 5.0f ? 1750 : 1500;
+        sim.advance();
+        logRow(csv, sim);
+        if (t < 2.0f) {
+            pitchRef = sim.aircraft.getPitch();
+            continue;
+        }
+        float pitch = sim.aircraft.getPitch() - pitchRef;
+        float target = t < 5.0f ? STEP : 0.0f;
+        trackSquared += (pitch - target) * (pitch - target);
+        count++;
+        if (t < 5.0f) {
+            if (riseTime < 0 && pitch >= 0.9f * STEP) riseTime = t - 2.0f;
+            overshoot = fmaxf(overshoot, pitch - STEP);
+            if (t >= 4.5f) holdError = fmaxf(holdError, fabsf(pitch - STEP));
+        } else if (t >= 7.5f) {
+            returnError = fmaxf(returnError, fabsf(pitch));
+        }
+    }
+    float trackRms = sqrtf(trackSquared / count);
+    ScenarioResult r;
+    r.metrics = {
+        { "rise time 90% [s]", riseTime < 0 ? 99.0f : riseTime, 0.5f },
+        { "overshoot [deg]", overshoot, 2.0f },
+        { "hold error [deg]", holdError, 1.0f },
+        { "return error [deg]", returnError, 5.0f },
+        { "tracking rms [deg]", trackRms, 2.5f },
+    };
+    r.cost = trackRms + overshoot * 0.2f;
+    return r;
+}
+
+// パススルーで巡航し、3秒で姿勢制御に切り替える（その時の姿勢を保つ）
+static ScenarioResult runEngage(SitlHarness& sim, FILE* csv) {
+    float pitchAtSwitch = 0, yawAtSwitch = 0, pitchMax = 0, yawMax = 0, pulseJump = 0;
+    float lastPulse = 1500;
+    bool switched = false;
+    sim.modeSwitch = 1000;
+    logHeader(csv);
+    while (sim.seconds() < 8.0f) {
+        float t = sim.seconds();
+        sim.modeSwitch = t < 3.0f ? 1000 : 2000;
+        uint32_t ticksBefore = sim.ticks;
+        sim.advance();
+        logRow(csv, sim);
+        if (sim.ticks == ticksBefore) continue;
+
+        float pulse = sim.elevatorServo.getLastPulse();
+        if (!sim.passthrough && !switched) {
+            // 切り替えた周期の舵の変化と、その時の姿勢
+            switched = true;
+            pulseJump = fabsf(pulse - lastPulse);
+            pitchAtSwitch = sim.aircraft.getPitch();
+            yawAtSwitch = sim.aircraft.getYaw();
+        }
+        lastPulse = pulse;
+        if (switched && t >= 4.0f) {
+            pitchMax = fmaxf(pitchMax, fabsf(sim.aircraft.getPitch() - pitchAtSwitch));
+            yawMax = fmaxf(yawMax, fabsf(wrapDegrees(sim.aircraft.getYaw() - yawAtSwitch)));
+        }
+    }
+    ScenarioResult r;
+    r.metrics = {
+        { "engaged", switched ? 0.0f : 1.0f, 0.0f },
+        { "elevator pulse jump [us]", pulseJump, 20.0f },
+        { "pitch hold error [deg]", pitchMax, 8.0f },
+        { "yaw hold error [deg]", yawMax, 5.0f },
+    };
+    r.cost = pitchMax;
+    return r;
+}
+
+static const Scenario scenarios[] = {
+    { "gust", "attitude hold through an updraft and a crosswind gust", runGust },
+    { "step", "elevator stick step to +2.5 deg pitch and back", runStep },
+    { "engage", "switch from passthrough to attitude hold in cruise", runEngage },
+};
+
+static bool runScenario(const Scenario& scenario, uint16_t rateHz, const PitchGains* gains, FILE* csv,
+                        ScenarioResult& result) {
+    SitlHarness sim(rateHz, ImuErrorModel::typical(), 1);
+    if (!sim.begin()) {
+        fprintf(stderr, "MPU6050 init failed\n");
+        return false;
+    }
+    if (gains != nullptr) sim.setPitchGains(*gains);
+    result = scenario.run(sim, csv);
+    return true;
+}
+
+static int runAll(const char* filter, uint16_t rateHz, bool csvOutput) {
+    bool found = false, allPassed = true;
+    for (const Scenario& scenario : scenarios) {
+        if (filter != nullptr && strcmp(filter, scenario.name) != 0) continue;
+        found = true;
+        ScenarioResult result;
+        auto start = std::chrono::steady_clock::now();
+        if (!runScenario(scenario, rateHz, nullptr, csvOutput ? stdout : nullptr, result)) return 1;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (csvOutput) continue;
+
+        bool passed = result.passed();
+        allPassed = allPassed && passed;
+        printf("[%s] %s (%uHz) %s, %.0f ms\n", scenario.name, scenario.description, rateHz,
+               passed ? "PASS" : "FAIL", elapsed * 1000);
+        for (const Metric& m : result.metrics) {
+            printf("  %-28s %8.2f  (limit %.2f)%s\n", m.name, m.value, m.limit,
+                   m.value <= m.limit ? "" : "  <-- FAIL");
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "unknown scenario: %s\n", filter);
+        return 1;
+    }
+    return allPassed ? 0 : 1;
+}
+
+// ピッチのゲインの総当たり（gustとstepの評価値の和で並べる）
+static int runSweep(uint16_t rateHz) {
+    const float angleKp[] = { 4, 6, 8, 12 };
+    const float rateKp[] = { 1.5f, 3, 4.5f };
+    const float rateKi[] = { 3, 6, 9 };
+    struct Row {
+        PitchGains gains;
+        float cost;
+        bool passed;
+    };
+    std::vector<Row> rows;
+    auto start = std::chrono::steady_clock::now();
+    for (float ak : angleKp) {
+        for (float rk : rateKp) {
+            for (float ri : rateKi) {
+                PitchGains gains = { ak, rk, ri, 0.02f };
+                Row row = { gains, 0, true };
+                for (const Scenario& scenario : scenarios) {
+                    if (strcmp(scenario.name, "engage") == 0) continue;
+                    ScenarioResult result;
+                    if (!runScenario(scenario, rateHz, &gains, nullptr, result)) return 1;
+                    row.cost += result.cost;
+                    row.passed = row.passed && result.passed();
+                }
+                rows.push_back(row);
+            }
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.cost < b.cost; });
+
+    printf("pitch gain sweep (%uHz): %zu combinations in %.2f s\n", rateHz, rows.size(), elapsed);
+    printf("  angle kp | rate kp  ki    kd   | cost   | limits\n");
+    for (const Row& row : rows) {
+        printf("  %8.1f | %7.1f %5.1f %5.2f | %6.3f | %s\n", row.gains.angleKp, row.gains.rateKp,
+               row.gains.rateKi, row.gains.rateKd, row.cost, row.passed ? "pass" : "fail");
+    }
+    return 0;
+}
+
+int sitlTool(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : "all";
+    uint16_t rateHz = argc > 2 ? (uint16_t)atoi(argv[2]) : 500;
+    bool csvOutput = argc > 3 && strcmp(argv[3], "csv") == 0;
+    if (!ControlScheduler::isSupportedRate(rateHz)) {
+        fprintf(stderr, "unsupported rate %u\n", rateHz);
+        return 1;
+    }
+    if (strcmp(name, "sweep") == 0) return runSweep(rateHz);
+    return runAll(strcmp(name, "all") == 0 ? nullptr : name, rateHz, csvOutput);
+}
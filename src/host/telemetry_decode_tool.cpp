@@ -0,0 +1,47 @@
+// シリアルから保存したテレメトリのバイト列をCSVに変換する
+// 例: cat /dev/ttyACM0 > flight.bin; program decode flight.bin > flight.csv
+// テキスト出力が混ざっていても同期バイトとCRCで読み飛ばす
+
+#include <stdio.h>
+#include "host_tools.h"
+#include "telemetry.h"
+
+int telemetryDecodeTool(int argc, char** argv) {
+    FILE* input = stdin;
+    if (argc > 1) {
+        input = fopen(argv[1], "rb");
+        if (input == nullptr) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    
+    TelemetryDecoder decoder;
+    printf("seq,time_us,passthrough,imu_ok,accel_mode,"
+           "att0,att1,att2,tgt0,tgt1,tgt2,"
+           "elev_p,elev_i,elev_d,rud_p,rud_i,rud_d,"
+           "servo_elev,servo_rud,dt_us,jitter_us,exec_us,overruns,latency_us,latency_max_us\n");
+    
+    int byte;
+    while ((byte = fgetc(input)) != EOF) {
+        if (!decoder.feed((uint8_t)byte)) continue;
+        
+        const TelemetrySample& s = decoder.getSample();
+        printf("%u,%u,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,"
+               "%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u,%u,%u,%u,%u,%u\n",
+               decoder.getSequence(), s.timeMicros,
+               (s.flags & TELEMETRY_FLAG_PASSTHROUGH) != 0,
+               (s.flags & TELEMETRY_FLAG_IMU_OK) != 0,
+               (s.flags & TELEMETRY_FLAG_ACCEL_MODE) != 0,
+               s.attitude[0], s.attitude[1], s.attitude[2],
+               s.target[0], s.target[1], s.target[2],
+               s.pTerm[0], s.iTerm[0], s.dTerm[0], s.pTerm[1], s.iTerm[1], s.dTerm[1],
+               s.servo[0], s.servo[1], s.dtMicros, s.jitterMicros, s.execMicros, s.overruns,
+               s.latencyMicros, s.latencyMaxMicros);
+    }
+    
+    fprintf(stderr, "frames=%u crc_errors=%u lost=%u\n",
+            decoder.getFrameCount(), decoder.getCrcErrors(), decoder.getLostFrames());
+    if (input != stdin) fclose(input);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// I2Cバスのインターフェース（1回の呼び出しが1トランザクション）
+class I2CBus {
+public:
+    virtual ~I2CBus() {}
+
+    // アドレスに応答があるか
+    virtual bool probe(uint8_t address) = 0;
+
+    // 書き込みのみ
+    virtual bool write(uint8_t address, const uint8_t* data, size_t length) = 0;
+
+    // 書き込み後、リピートスタートで読み出し
+    virtual bool writeRead(uint8_t address, const uint8_t* tx, size_t txLength,
+                           uint8_t* rx, size_t rxLength) = 0;
+
+    // SDAが固まった時の回復（SCLを空打ちしてSTOPを出す）。非対応ならfalse
+    virtual bool recover() { return false; }
+
+    // レジスタ操作の補助
+    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+        uint8_t data[2] = { reg, value };
+        return write(address, data, 2);
+    }
+
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer, size_t length) {
+        return writeRead(address, &reg, 1, buffer, length);
+    }
+};
+
+#endif
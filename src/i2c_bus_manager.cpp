@@ -0,0 +1,207 @@
+#include "i2c_bus_manager.h"
+#include <string.h>
+
+I2CBusManager::I2CBusManager(I2CBus& bus, Clock& clock, uint32_t busClockHz)
+    : bus(bus), clock(clock) {
+    deviceCount = 0;
+    memset(devices, 0, sizeof(devices));
+    memset(queue, 0, sizeof(queue));
+    nextSequence = 0;
+    // アドレス/データ1バイトにつき9クロック
+    byteNanos = busClockHz > 0 ? (uint32_t)(9000000000ULL / busClockHz) : 22500;
+    consecutiveFailures = 0;
+    recoveryCount = 0;
+    reserveInterval = 0;
+    highSinceLow = 0;
+    reservedCount = 0;
+    statsStartMicros = 0;
+}
+
+uint8_t I2CBusManager::addDevice(const char* name, I2CPriority priority, uint8_t retries) {
+    if (deviceCount >= MAX_DEVICES) return INVALID_DEVICE;
+    Device& device = devices[deviceCount];
+    device.name = name;
+    device.priority = priority;
+    device.retries = retries;
+    device.pending = 0;
+    device.stats = {};
+    device.stats.minLatencyMicros = UINT32_MAX;
+    return deviceCount++;
+}
+
+uint32_t I2CBusManager::estimateMicros(size_t bytes) const {
+    // データ + アドレス1バイト
+    return TRANSACTION_OVERHEAD_MICROS + (uint32_t)(((uint64_t)(bytes + 1) * byteNanos) / 1000);
+}
+
+void I2CBusManager::recordLatency(Device& device, uint32_t latency) {
+    I2CDeviceStats& stats = device.stats;
+    if (latency < stats.minLatencyMicros) stats.minLatencyMicros = latency;
+    if (latency > stats.maxLatencyMicros) stats.maxLatencyMicros = latency;
+    stats.totalLatencyMicros += latency;
+}
+
+template <typename Transfer>
+bool I2CBusManager::execute(uint8_t id, size_t bytes, uint32_t requestMicros, Transfer transfer) {
+    Device& device = devices[id];
+    uint32_t start = clock.micros();
+    bool ok = false;
+    for (uint8_t attempt = 0; attempt <= device.retries; attempt++) {
+        if (attempt > 0) device.stats.retries++;
+        if (transfer()) {
+            ok = true;
+            break;
+        }
+        // 連続して失敗する時はバスが固まっている可能性がある
+        if (++consecutiveFailures >= RECOVERY_THRESHOLD) {
+            bus.recover();
+            recoveryCount++;
+            consecutiveFailures = 0;
+        }
+    }
+    
+    uint32_t end = clock.micros();
+    device.stats.busyMicros += end - start;
+    if (device.priority == I2C_PRIORITY_HIGH) {
+        if (highSinceLow < UINT16_MAX) highSinceLow++;
+    } else {
+        highSinceLow = 0;
+    }
+    if (ok) {
+        consecutiveFailures = 0;
+        device.stats.transactions++;
+        device.stats.bytes += bytes;
+        recordLatency(device, end - requestMicros);
+    } else {
+        device.stats.errors++;
+    }
+    return ok;
+}
+
+bool I2CBusManager::probe(uint8_t id, uint8_t address) {
+    if (id >= deviceCount) return false;
+    // 応答がないのは異常ではないため、リトライや統計の対象にしない
+    return bus.probe(address);
+}
+
+bool I2CBusManager::write(uint8_t id, uint8_t address, const uint8_t* data, size_t length) {
+    if (id >= deviceCount) return false;
+    return execute(id, length, clock.micros(), [&]() { return bus.write(address, data, length); });
+}
+
+bool I2CBusManager::writeRead(uint8_t id, uint8_t address, const uint8_t* tx, size_t txLength,
+                              uint8_t* rx, size_t rxLength) {
+    if (id >= deviceCount) return false;
+    return execute(id, txLength + rxLength, clock.micros(),
+                   [&]() { return bus.writeRead(address, tx, txLength, rx, rxLength); });
+}
+
+bool I2CBusManager::submitWrite(uint8_t id, uint8_t address, const uint8_t* data, size_t length,
+                                uint32_t timeoutMicros) {
+    if (id >= deviceCount) return false;
+    Device& device = devices[id];
+    if (length > MAX_WRITE_SIZE) {
+        device.stats.dropped++;
+        return false;
+    }
+    for (QueuedWrite& entry : queue) {
+        if (entry.used) continue;
+        entry.used = true;
+        entry.device = id;
+        entry.address = address;
+        entry.length = (uint8_t)length;
+        entry.sequence = nextSequence++;
+        entry.submitMicros = clock.micros();
+        entry.deadlineMicros = entry.submitMicros + timeoutMicros;
+        memcpy(entry.data, data, length);
+        device.pending++;
+        return true;
+    }
+    device.stats.dropped++;
+    return false;
+}
+
+I2CBusManager::QueuedWrite* I2CBusManager::nextQueued() {
+    QueuedWrite* best = nullptr;
+    for (QueuedWrite& entry : queue) {
+        if (!entry.used) continue;
+        if (best == nullptr) {
+            best = &entry;
+            continue;
+        }
+        I2CPriority priority = devices[entry.device].priority;
+        I2CPriority bestPriority = devices[best->device].priority;
+        if (priority < bestPriority ||
+            (priority == bestPriority && (int32_t)(entry.sequence - best->sequence) < 0)) {
+            best = &entry;
+        }
+    }
+    return best;
+}
+
+void I2CBusManager::flushDevice(uint8_t id, bool expired) {
+    Device& device = devices[id];
+    for (QueuedWrite& entry : queue) {
+        if (!entry.used || entry.device != id) continue;
+        entry.used = false;
+        if (expired) device.stats.expired++;
+        else device.stats.dropped++;
+    }
+    device.pending = 0;
+}
+
+void I2CBusManager::poll(uint32_t budgetMicros) {
+    uint32_t start = clock.micros();
+    bool reserved = false;
+    while (true) {
+        QueuedWrite* entry = nextQueued();
+        if (entry == nullptr) return;
+        
+        uint32_t now = clock.micros();
+        if ((int32_t)(now - entry->deadlineMicros) > 0) {
+            flushDevice(entry->device, true);
+            continue;
+        }
+        
+        // 次の制御周期までに終わらないトランザクションは始めない（予約の枠に達していれば1回だけ流す）
+        uint32_t elapsed = now - start;
+        if (elapsed + estimateMicros(entry->length) > budgetMicros) {
+            bool starved = reserveInterval > 0 && highSinceLow >= reserveInterval &&
+                           devices[entry->device].priority != I2C_PRIORITY_HIGH;
+            if (reserved || !starved) return;
+            reserved = true;
+            reservedCount++;
+        }
+        
+        uint8_t id = entry->device;
+        entry->used = false;
+        devices[id].pending--;
+        const uint8_t* data = entry->data;
+        size_t length = entry->length;
+        uint8_t address = entry->address;
+        if (!execute(id, length, entry->submitMicros, [&]() { return bus.write(address, data, length); })) {
+            flushDevice(id, false);
+        }
+    }
+}
+
+uint32_t I2CBusManager::getMeanLatency(uint8_t id) const {
+    const I2CDeviceStats& stats = devices[id].stats;
+    return stats.transactions > 0 ? (uint32_t)(stats.totalLatencyMicros / stats.transactions) : 0;
+}
+
+uint32_t I2CBusManager::getBytesPerSecond(uint8_t id) const {
+    uint32_t elapsed = clock.micros() - statsStartMicros;
+    if (elapsed == 0) return 0;
+    return (uint32_t)((uint64_t)devices[id].stats.bytes * 1000000 / elapsed);
+}
+
+void I2CBusManager::resetStats() {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        devices[i].stats = {};
+        devices[i].stats.minLatencyMicros = UINT32_MAX;
+    }
+    recoveryCount = 0;
+    reservedCount = 0;
+    statsStartMicros = clock.micros();
+}
@@ -0,0 +1,156 @@
+#ifndef I2C_BUS_MANAGER_H
+#define I2C_BUS_MANAGER_H
+
+// 1本のI2Cバスを複数デバイス（MPU6050とOLED）で共有するための調停
+// 優先度の高いデバイス（IMU）は同期で即時に実行し、低いデバイス（OLED）の書き込みはキューに積んで
+// 制御周期の空き時間にトランザクション単位で流す。IMUの読み出しが表示の転送を待つことはない
+// 空き時間が1トランザクションより短い時（1kHz制御など）は、優先度の高いトランザクションN回毎に
+// 低いものを1回だけ空き時間を超えて流す（setLowPriorityReserve）。表示が止まり続けないようにする
+// 制御ループのタスクからのみ使う（排他制御はしていない）
+
+#include <stdint.h>
+#include <stddef.h>
+#include "clock.h"
+#include "i2c_bus.h"
+
+enum I2CPriority : uint8_t {
+    I2C_PRIORITY_HIGH = 0,  // 同期で即時実行（IMU）
+    I2C_PRIORITY_LOW,       // 空き時間に非同期で実行（表示）
+};
+
+// デバイス毎の統計
+struct I2CDeviceStats {
+    uint32_t transactions;      // 成功したトランザクション数
+    uint32_t errors;            // リトライしても失敗した数
+    uint32_t retries;
+    uint32_t expired;           // 期限までに実行できず捨てた数
+    uint32_t dropped;           // キューが一杯で積めなかった数
+    uint32_t bytes;             // 送受信したデータ量
+    uint32_t minLatencyMicros;  // 要求から完了まで（非同期はキューでの待ちを含む）
+    uint32_t maxLatencyMicros;
+    uint64_t totalLatencyMicros;
+    uint32_t busyMicros;        // バスを使っていた時間
+};
+
+class I2CBusManager {
+public:
+    static const uint8_t MAX_DEVICES = 4;
+    static const uint8_t QUEUE_SIZE = 16;
+    static const uint8_t MAX_WRITE_SIZE = 32;           // Wireのバッファに合わせる
+    static const uint8_t RECOVERY_THRESHOLD = 3;        // 連続失敗でバスを回復
+    static const uint32_t TRANSACTION_OVERHEAD_MICROS = 50;  // 開始/停止とドライバの処理
+    static const uint8_t INVALID_DEVICE = 0xFF;
+
+private:
+    struct Device {
+        const char* name;
+        I2CPriority priority;
+        uint8_t retries;
+        uint8_t pending;
+        I2CDeviceStats stats;
+    };
+
+    // 非同期の書き込み（データはコピーして持つ）
+    struct QueuedWrite {
+        bool used;
+        uint8_t device;
+        uint8_t address;
+        uint8_t length;
+        uint32_t sequence;          // 同じ優先度の中では古い順
+        uint32_t submitMicros;
+        uint32_t deadlineMicros;
+        uint8_t data[MAX_WRITE_SIZE];
+    };
+
+    I2CBus& bus;
+    Clock& clock;
+    Device devices[MAX_DEVICES];
+    uint8_t deviceCount;
+    QueuedWrite queue[QUEUE_SIZE];
+    uint32_t nextSequence;
+    uint32_t byteNanos;             // 1バイト（9ビット）の転送時間
+    uint8_t consecutiveFailures;
+    uint32_t recoveryCount;
+    uint16_t reserveInterval;       // 優先度の高いトランザクションこの回数毎に低いものを1回流す（0で無効）
+    uint16_t highSinceLow;          // 最後に低い優先度を流してからの高い優先度のトランザクション数
+    uint32_t reservedCount;         // 予約の枠で空き時間を超えて流した数
+    uint32_t statsStartMicros;
+
+    // リトライとバス回復を含めて1トランザクションを実行
+    template <typename Transfer>
+    bool execute(uint8_t device, size_t bytes, uint32_t requestMicros, Transfer transfer);
+    void recordLatency(Device& device, uint32_t latency);
+    QueuedWrite* nextQueued();
+    // デバイスの残りのキューを捨てる（途中が抜けたコマンド列を送らないため）
+    void flushDevice(uint8_t device, bool expired);
+
+public:
+    I2CBusManager(I2CBus& bus, Clock& clock, uint32_t busClockHz = 400000);
+
+    // デバイス登録（失敗時はINVALID_DEVICE）
+    uint8_t addDevice(const char* name, I2CPriority priority, uint8_t retries);
+
+    // 同期（即時実行）
+    bool probe(uint8_t device, uint8_t address);
+    bool write(uint8_t device, uint8_t address, const uint8_t* data, size_t length);
+    bool writeRead(uint8_t device, uint8_t address, const uint8_t* tx, size_t txLength,
+                   uint8_t* rx, size_t rxLength);
+
+    // 非同期の書き込み（timeoutMicros以内に始められなければ捨てる）
+    bool submitWrite(uint8_t device, uint8_t address, const uint8_t* data, size_t length,
+                     uint32_t timeoutMicros);
+
+    // キューに積まれた書き込みを、budgetMicros以内に終わる分だけ実行
+    // 予約（setLowPriorityReserve）の回数に達していれば、収まらなくても1回だけ実行する
+    void poll(uint32_t budgetMicros);
+
+    // 低い優先度の最低限の枠（優先度の高いトランザクションhighTransactions回毎に1回、0で無効）
+    // 枠で流したトランザクションの分だけ次の制御周期が遅れる
+    void setLowPriorityReserve(uint16_t highTransactions) { reserveInterval = highTransactions; }
+    uint32_t getReservedCount() const { return reservedCount; }
+
+    // 転送時間の見積もり
+    uint32_t estimateMicros(size_t bytes) const;
+
+    uint8_t getDeviceCount() const { return deviceCount; }
+    const char* getDeviceName(uint8_t device) const { return devices[device].name; }
+    uint8_t getPendingCount(uint8_t device) const { return devices[device].pending; }
+    const I2CDeviceStats& getStats(uint8_t device) const { return devices[device].stats; }
+    uint32_t getMeanLatency(uint8_t device) const;
+    uint32_t getBytesPerSecond(uint8_t device) const;
+    uint32_t getRecoveryCount() const { return recoveryCount; }
+    void resetStats();
+};
+
+// 1デバイス分のI2CBus（ドライバからはこれまでのI2CBusとして使える）
+class ManagedI2CBus : public I2CBus {
+private:
+    I2CBusManager& manager;
+    uint8_t device;
+
+public:
+    ManagedI2CBus(I2CBusManager& manager, const char* name, I2CPriority priority, uint8_t retries)
+        : manager(manager), device(manager.addDevice(name, priority, retries)) {}
+
+    bool probe(uint8_t address) override { return manager.probe(device, address); }
+    bool write(uint8_t address, const uint8_t* data, size_t length) override {
+        return manager.write(device, address, data, length);
+    }
+    bool writeRead(uint8_t address, const uint8_t* tx, size_t txLength,
+                   uint8_t* rx, size_t rxLength) override {
+        return manager.writeRead(device, address, tx, txLength, rx, rxLength);
+    }
+
+    bool submitWrite(uint8_t address, const uint8_t* data, size_t length, uint32_t timeoutMicros) {
+        return manager.submitWrite(device, address, data, length, timeoutMicros);
+    }
+    uint8_t getPendingCount() const { return manager.getPendingCount(device); }
+    // 失敗・期限切れ・積めなかった回数の合計（送ったはずの内容が届いていない可能性）
+    uint32_t getFailureCount() const {
+        const I2CDeviceStats& stats = manager.getStats(device);
+        return stats.errors + stats.expired + stats.dropped;
+    }
+    uint8_t getDevice() const { return device; }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "imu_calibrator.h"
+#include <math.h>
+
+ImuCalibrator::ImuCalibrator(Mpu6050Driver& imu, CalibrationStore& store)
+    : imu(imu), store(store), hasStored(false), levelRequested(false), refineEnabled(false),
+      refineCount(0), saveCount(0), secondsSinceSave(0) {
+    calibration = {};
+    stored = {};
+    calibration.version = ImuCalibration::VERSION;
+    for (int axis = 0; axis < 3; axis++) appliedGyroOffset[axis] = 0;
+    resetWindow();
+}
+
+bool ImuCalibrator::begin() {
+    ImuCalibration loaded;
+    if (!store.load(loaded) || loaded.version != ImuCalibration::VERSION) {
+        hasStored = false;
+        return false;
+    }
+    
+    calibration = loaded;
+    stored = loaded;
+    hasStored = true;
+    // 起動時（制御の前）はそのまま適用する
+    for (int axis = 0; axis < 3; axis++) appliedGyroOffset[axis] = calibration.gyroOffset[axis];
+    imu.setGyroOffsets(calibration.gyroOffset[0], calibration.gyroOffset[1], calibration.gyroOffset[2]);
+    imu.setAccelOffsets(calibration.accelOffset[0], calibration.accelOffset[1], calibration.accelOffset[2]);
+    return true;
+}
+
+void ImuCalibrator::setRefineEnabled(bool enabled) {
+    // 地上でなくなったら集計中の区間は捨てる
+    if (!enabled && refineEnabled) resetWindow();
+    refineEnabled = enabled;
+}
+
+void ImuCalibrator::resetWindow() {
+    for (int axis = 0; axis < 3; axis++) {
+        gyroSum[axis] = 0;
+        accelSum[axis] = 0;
+        gyroMin[axis] = 1e9f;
+        gyroMax[axis] = -1e9f;
+    }
+    tempSum = 0;
+    sampleCount = 0;
+    windowSeconds = 0;
+}
+
+// 適用中の角速度のオフセットを求めた値へ近づける（段差で姿勢推定と制御が跳ねないように）
+void ImuCalibrator::rampGyroOffsets(float deltaTime) {
+    float maxStep = OFFSET_RAMP_RATE * deltaTime;
+    bool changed = false;
+    for (int axis = 0; axis < 3; axis++) {
+        float diff = calibration.gyroOffset[axis] - appliedGyroOffset[axis];
+        if (diff == 0) continue;
+        if (diff > maxStep) appliedGyroOffset[axis] += maxStep;
+        else if (diff < -maxStep) appliedGyroOffset[axis] -= maxStep;
+        else appliedGyroOffset[axis] = calibration.gyroOffset[axis];
+        changed = true;
+    }
+    if (changed) imu.setGyroOffsets(appliedGyroOffset[0], appliedGyroOffset[1], appliedGyroOffset[2]);
+}
+
+void ImuCalibrator::update(float deltaTime) {
+    secondsSinceSave += deltaTime;
+    rampGyroOffsets(deltaTime);
+    if (!refineEnabled && !levelRequested) return;
+    
+    // 補正前の値に戻して集計する
+    float gyro[3] = {
+        imu.getGyroX() + imu.getGyroOffset(0),
+        imu.getGyroY() + imu.getGyroOffset(1),
+        imu.getGyroZ() + imu.getGyroOffset(2),
+    };
+    float accel[3] = {
+        imu.getAccX() + imu.getAccelOffset(0),
+        imu.getAccY() + imu.getAccelOffset(1),
+        imu.getAccZ() + imu.getAccelOffset(2),
+    };
+    
+    // 静止判定（加速度が1g付近で、区間内の角速度の幅が小さい）
+    float accelNorm = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+    bool still = fabsf(accelNorm - 1.0f) < ACCEL_TOLERANCE;
+    for (int axis = 0; axis < 3 && still; axis++) {
+        float low = gyro[axis] < gyroMin[axis] ? gyro[axis] : gyroMin[axis];
+        float high = gyro[axis] > gyroMax[axis] ? gyro[axis] : gyroMax[axis];
+        if (high - low > GYRO_SPREAD_LIMIT) still = false;
+    }
+    if (!still) {
+        resetWindow();
+        return;
+    }
+    
+    for (int axis = 0; axis < 3; axis++) {
+        gyroSum[axis] += gyro[axis];
+        accelSum[axis] += accel[axis];
+        if (gyro[axis] < gyroMin[axis]) gyroMin[axis] = gyro[axis];
+        if (gyro[axis] > gyroMax[axis]) gyroMax[axis] = gyro[axis];
+    }
+    tempSum += imu.getTemp();
+    sampleCount++;
+    windowSeconds += deltaTime;
+    
+    if (windowSeconds >= WINDOW_SECONDS) {
+        finishWindow();
+        resetWindow();
+    }
+}
+
+// 静止区間の平均から補正値を更新し、必要なら保存する
+void ImuCalibrator::finishWindow() {
+    // 保存済みの値から大きく離れる場合は、静止ではなく一定の旋回とみなして捨てる
+    for (int axis = 0; axis < 3 && hasStored; axis++) {
+        if (fabsf(gyroSum[axis] / sampleCount - stored.gyroOffset[axis]) > MAX_OFFSET_JUMP) return;
+    }
+    
+    float maxChange = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        calibration.gyroOffset[axis] = gyroSum[axis] / sampleCount;
+        float change = fabsf(calibration.gyroOffset[axis] - stored.gyroOffset[axis]);
+        if (change > maxChange) maxChange = change;
+    }
+    calibration.temperature = tempSum / sampleCount;
+    
+    bool leveled = levelRequested;
+    if (leveled) {
+        // 水平に置いた時に(0, 0, 1g)になるようにする
+        calibration.accelOffset[0] = accelSum[0] / sampleCount;
+        calibration.accelOffset[1] = accelSum[1] / sampleCount;
+        calibration.accelOffset[2] = accelSum[2] / sampleCount - 1.0f;
+        imu.setAccelOffsets(calibration.accelOffset[0], calibration.accelOffset[1], calibration.accelOffset[2]);
+        levelRequested = false;
+    }
+    refineCount++;
+    
+    bool changed = maxChange > SAVE_OFFSET_DELTA ||
+                   fabsf(calibration.temperature - stored.temperature) > SAVE_TEMP_DELTA;
+    bool due = secondsSinceSave >= SAVE_MIN_INTERVAL;
+    if (!hasStored || leveled || (changed && due)) {
+        store.save(calibration);
+        stored = calibration;
+        hasStored = true;
+        saveCount++;
+        secondsSinceSave = 0;
+    }
+}
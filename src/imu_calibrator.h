@@ -0,0 +1,76 @@
+#ifndef IMU_CALIBRATOR_H
+#define IMU_CALIBRATOR_H
+
+// IMUの補正値の管理
+// 起動時は保存済みの補正値をすぐに適用し（平均化で待たない）、
+// 地上（setRefineEnabled）で静止を検出したら制御周期の中で少しずつ平均をとって補正値を更新・保存する
+// 更新した角速度のオフセットは一度に切り替えず、OFFSET_RAMP_RATEで少しずつ移す
+
+#include "calibration_store.h"
+#include "mpu6050_driver.h"
+
+class ImuCalibrator {
+private:
+    Mpu6050Driver& imu;
+    CalibrationStore& store;
+    ImuCalibration calibration; // 適用中の補正値
+    ImuCalibration stored;      // 最後に保存した補正値
+    bool hasStored;             // 保存済みの値がある
+    bool levelRequested;        // 次の静止区間で加速度の水平補正も行う
+    bool refineEnabled;         // 静止区間の集計を行う（地上のみ）
+    float appliedGyroOffset[3]; // IMUに適用中の角速度のオフセット（calibrationへ近づける途中の値）
+    
+    // 静止区間の集計
+    float gyroSum[3];
+    float accelSum[3];
+    float gyroMin[3], gyroMax[3];
+    float tempSum;
+    uint32_t sampleCount;
+    float windowSeconds;
+    
+    uint32_t refineCount;
+    uint32_t saveCount;
+    float secondsSinceSave;
+    
+    void resetWindow();
+    void finishWindow();
+    void rampGyroOffsets(float deltaTime);
+
+public:
+    // 静止とみなす条件
+    static constexpr float WINDOW_SECONDS = 2.0f;       // この時間続けば補正値を更新
+    static constexpr float GYRO_SPREAD_LIMIT = 1.5f;    // 区間内の角速度の幅[deg/s]
+    static constexpr float ACCEL_TOLERANCE = 0.05f;     // |a|と1gの差[g]
+    static constexpr float MAX_OFFSET_JUMP = 3.0f;      // 保存済みのオフセットからの差の上限[deg/s]
+    static constexpr float OFFSET_RAMP_RATE = 0.5f;     // 適用中のオフセットを動かす速さ[deg/s毎秒]
+    // 保存する条件
+    static constexpr float SAVE_TEMP_DELTA = 3.0f;      // 保存済みの温度との差[℃]
+    static constexpr float SAVE_OFFSET_DELTA = 0.1f;    // 保存済みのオフセットとの差[deg/s]
+    static constexpr float SAVE_MIN_INTERVAL = 60.0f;   // 保存の最短間隔[秒]
+    
+    ImuCalibrator(Mpu6050Driver& imu, CalibrationStore& store);
+    
+    // 保存済みの補正値を読み込んでIMUに適用（無ければfalse、静止したら求めて保存する）
+    // 温度が離れている場合も適用し、静止中の更新で保存し直す
+    bool begin();
+    
+    // 毎周期、imu.update()の後に呼ぶ
+    void update(float deltaTime);
+    
+    // 静止区間の集計を許可する（地上にいる間だけtrueにする。飛行中の一定の旋回をオフセットとして取り込まない）
+    // falseの間も、更新済みのオフセットへの移行は続ける
+    void setRefineEnabled(bool enabled);
+    bool isRefineEnabled() const { return refineEnabled; }
+    
+    // 次の静止区間で加速度の水平補正を行う（機体を水平に置いて使う。setRefineEnabledによらず集計する）
+    void requestLevelCalibration() { levelRequested = true; }
+    
+    const ImuCalibration& getCalibration() const { return calibration; }
+    bool hasStoredCalibration() const { return hasStored; }
+    bool isStationary() const { return windowSeconds > 0; }
+    float getAppliedGyroOffset(int axis) const { return appliedGyroOffset[axis]; }
+    uint32_t getRefineCount() const { return refineCount; }
+    uint32_t getSaveCount() const { return saveCount; }
+};
+
+#endif
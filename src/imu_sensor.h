@@ -0,0 +1,22 @@
+#ifndef IMU_SENSOR_H
+#define IMU_SENSOR_H
+
+// IMUのインターフェース
+// 単位はMPU6050_tocknに合わせる（加速度[g]、角速度[deg/s]、温度[℃]）
+class ImuSensor {
+public:
+    virtual ~ImuSensor() {}
+
+    // センサーから最新値を読み込む
+    virtual void update() = 0;
+
+    virtual float getAccX() = 0;
+    virtual float getAccY() = 0;
+    virtual float getAccZ() = 0;
+    virtual float getGyroX() = 0;
+    virtual float getGyroY() = 0;
+    virtual float getGyroZ() = 0;
+    virtual float getTemp() = 0;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "loop_profiler.h"
+
+uint8_t LatencyHistogram::bucketIndex(uint32_t micros) {
+    if (micros < LINEAR_BUCKETS) return (uint8_t)micros;
+    
+    // 最上位ビットの位置（オクターブ）と、その下2ビットでサブバケットを決める
+    uint8_t octave = 31 - __builtin_clz(micros);   // 4以上
+    uint8_t sub = (micros >> (octave - 2)) & (SUB_BUCKETS - 1);
+    uint32_t index = LINEAR_BUCKETS + (octave - 4) * SUB_BUCKETS + sub;
+    return index < BUCKET_COUNT ? (uint8_t)index : BUCKET_COUNT - 1;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(uint8_t index) {
+    if (index < LINEAR_BUCKETS) return index;
+    
+    uint8_t octave = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+    uint8_t sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    uint32_t step = 1UL << (octave - 2);
+    return (1UL << octave) + (sub + 1) * step - 1;
+}
+
+void LatencyHistogram::record(uint32_t micros) {
+    buckets[bucketIndex(micros)]++;
+    count++;
+    sumMicros += micros;
+    if (micros < minMicros) minMicros = micros;
+    if (micros > maxMicros) maxMicros = micros;
+}
+
+void LatencyHistogram::reset() {
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] = 0;
+    }
+    count = 0;
+    minMicros = UINT32_MAX;
+    maxMicros = 0;
+    sumMicros = 0;
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+    if (count == 0) return 0;
+    
+    // 目標順位（切り上げ）に達するバケットを探す
+    uint64_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t bound = bucketUpperBound(i);
+            return bound < maxMicros ? bound : maxMicros;
+        }
+    }
+    return maxMicros;
+}
+
+LatencyHistogram::Stats LatencyHistogram::getStats() const {
+    Stats stats;
+    stats.count = count;
+    stats.minMicros = count > 0 ? minMicros : 0;
+    stats.maxMicros = maxMicros;
+    stats.meanMicros = count > 0 ? (uint32_t)(sumMicros / count) : 0;
+    stats.p99Micros = percentile(99);
+    return stats;
+}
+
+LoopProfiler::LoopProfiler(Clock& clock)
+    : clock(clock), cycleStart(0), stageStart(0), deadlineMicros(10000), deadlineMisses(0) {
+}
+
+uint32_t LoopProfiler::cyclesToMicros(uint32_t cycles) {
+    uint32_t perMicro = clock.cyclesPerMicro();
+    return perMicro > 0 ? cycles / perMicro : cycles;
+}
+
+void LoopProfiler::beginCycle() {
+    cycleStart = clock.cycleCount();
+    stageStart = cycleStart;
+}
+
+void LoopProfiler::endStage(LoopStage stage) {
+    uint32_t now = clock.cycleCount();
+    histograms[stage].record(cyclesToMicros(now - stageStart));
+    stageStart = now;
+}
+
+void LoopProfiler::endCycle() {
+    uint32_t elapsed = cyclesToMicros(clock.cycleCount() - cycleStart);
+    histograms[STAGE_TOTAL].record(elapsed);
+    if (elapsed > deadlineMicros) {
+        deadlineMisses++;
+    }
+}
+
+void LoopProfiler::reset() {
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        histograms[i].reset();
+    }
+    deadlineMisses = 0;
+}
+
+const char* LoopProfiler::stageName(LoopStage stage) {
+    switch (stage) {
+        case STAGE_RC_READ:     return "rc_read";
+        case STAGE_IMU_READ:    return "imu_read";
+        case STAGE_FILTER:      return "filter";
+        case STAGE_PID:         return "pid";
+        case STAGE_SERVO_WRITE: return "servo_write";
+        case STAGE_TELEMETRY:   return "telemetry";
+        case STAGE_TOTAL:       return "total";
+        default:                return "?";
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stdint.h>
+#include "clock.h"
+
+// リリースビルド（-DRELEASE_BUILD）では計測コードを完全に取り除く
+#ifndef RELEASE_BUILD
+#define LOOP_PROFILER_ENABLED
+#endif
+
+// loop()内の計測区間
+enum LoopStage : uint8_t {
+    STAGE_RC_READ = 0,
+    STAGE_IMU_READ,
+    STAGE_FILTER,       // 推定（AutoControl::step / observe の中で区切る）
+    STAGE_PID,          // 全PID（AutoControl::step の中で区切る）
+    STAGE_SERVO_WRITE,
+    STAGE_TELEMETRY,
+    STAGE_TOTAL,        // 1周期全体
+    STAGE_COUNT
+};
+
+// 固定バケットのレイテンシヒストグラム（マイクロ秒）
+// 16μs未満は1μs刻み、それ以上は1オクターブを4分割する（誤差は最大25%）
+class LatencyHistogram {
+public:
+    static const uint8_t LINEAR_BUCKETS = 16;
+    static const uint8_t SUB_BUCKETS = 4;
+    static const uint8_t BUCKET_COUNT = LINEAR_BUCKETS + 16 * SUB_BUCKETS;  // 約1秒まで
+
+    struct Stats {
+        uint32_t count;
+        uint32_t minMicros;
+        uint32_t maxMicros;
+        uint32_t meanMicros;
+        uint32_t p99Micros;   // バケット上限値
+    };
+
+private:
+    uint32_t buckets[BUCKET_COUNT];
+    uint32_t count;
+    uint32_t minMicros;
+    uint32_t maxMicros;
+    uint64_t sumMicros;
+
+public:
+    LatencyHistogram() { reset(); }
+
+    static uint8_t bucketIndex(uint32_t micros);
+    static uint32_t bucketUpperBound(uint8_t index);
+
+    void record(uint32_t micros);
+    void reset();
+
+    // 指定パーセンタイル（0-100）を含むバケットの上限値
+    uint32_t percentile(uint8_t percent) const;
+    Stats getStats() const;
+};
+
+// ステージ毎の処理時間とデッドラインミスを集計する
+class LoopProfiler {
+private:
+    Clock& clock;
+    LatencyHistogram histograms[STAGE_COUNT];
+
+    uint32_t cycleStart;        // 周期開始時のサイクル値
+    uint32_t stageStart;        // 現在ステージ開始時のサイクル値
+    uint32_t deadlineMicros;    // 1周期の許容時間
+    uint32_t deadlineMisses;
+
+    uint32_t cyclesToMicros(uint32_t cycles);
+
+public:
+    LoopProfiler(Clock& clock);
+
+    // 制御周期（これを超えるとデッドラインミス）
+    void setDeadline(uint32_t micros) { deadlineMicros = micros; }
+
+    // 周期の開始
+    void beginCycle();
+
+    // 直前の区切りからここまでをstageとして記録
+    void endStage(LoopStage stage);
+
+    // 周期全体を記録しデッドラインを判定
+    void endCycle();
+
+    void reset();
+
+    static const char* stageName(LoopStage stage);
+    LatencyHistogram::Stats getStats(LoopStage stage) const { return histograms[stage].getStats(); }
+    uint32_t getDeadlineMisses() const { return deadlineMisses; }
+    uint32_t getDeadline() const { return deadlineMicros; }
+};
+
+// 計測マクロ（リリースビルドでは空になる）
+#ifdef LOOP_PROFILER_ENABLED
+#define PROFILE_BEGIN(profiler) (profiler).beginCycle()
+#define PROFILE_STAGE(profiler, stage) (profiler).endStage(stage)
+#define PROFILE_END(profiler) (profiler).endCycle()
+#else
+#define PROFILE_BEGIN(profiler) ((void)0)
+#define PROFILE_STAGE(profiler, stage) ((void)0)
+#define PROFILE_END(profiler) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include "mahony_estimator.h"
+#include <math.h>
+#include "fast_math.h"
+
+static const float DEG_TO_RAD_F = 0.017453292f;
+static const float RAD_TO_DEG_F = 57.29578f;
+static const float REST_CONFIRM_SECONDS = 0.5f;   // これだけ静止が続いたらバイアス追従を始める
+static const float BIAS_LIMIT = 10.0f * DEG_TO_RAD_F;
+
+MahonyEstimator::MahonyEstimator()
+    : kp(0.5f), ki(0.1f), accelTolerance(0.15f),
+      restBiasRate(0.2f), restGyroThreshold(3.0f * DEG_TO_RAD_F) {
+    reset();
+}
+
+void MahonyEstimator::reset() {
+    q0 = 1;
+    q1 = q2 = q3 = 0;
+    bias[0] = bias[1] = bias[2] = 0;
+    restSeconds = 0;
+    firstUpdate = true;
+    pitch = roll = yaw = 0;
+    lastWrappedYaw = 0;
+}
+
+// 加速度からロール・ピッチを求め、ヨー0度のクォータニオンにする
+void MahonyEstimator::initFromAccel(float accX, float accY, float accZ) {
+    float halfRoll = fastAtan2Deg(accY, accZ) * 0.5f * DEG_TO_RAD_F;
+    float halfPitch = fastAtan2Deg(-accX, fastSqrt(accY * accY + accZ * accZ)) * 0.5f * DEG_TO_RAD_F;
+    // 三角関数は初回のみ
+    float cr = cosf(halfRoll), sr = sinf(halfRoll);
+    float cp = cosf(halfPitch), sp = sinf(halfPitch);
+    q0 = cr * cp;
+    q1 = sr * cp;
+    q2 = cr * sp;
+    q3 = -sr * sp;
+}
+
+void MahonyEstimator::update(float accX, float accY, float accZ,
+                             float gyroX, float gyroY, float gyroZ, float deltaTime) {
+    if (firstUpdate) {
+        initFromAccel(accX, accY, accZ);
+        firstUpdate = false;
+        updateEuler();
+        return;
+    }
+    
+    float gx = gyroX * DEG_TO_RAD_F;
+    float gy = gyroY * DEG_TO_RAD_F;
+    float gz = gyroZ * DEG_TO_RAD_F;
+    
+    float accNormSquared = accX * accX + accY * accY + accZ * accZ;
+    float accRecipNorm = fastInvSqrt(accNormSquared);
+    float accNorm = accNormSquared * accRecipNorm;
+    bool accelValid = accNorm > 1.0f - accelTolerance && accNorm < 1.0f + accelTolerance;
+    
+    // 静止判定（加速度が1g付近で、バイアス除去後の角速度が小さい）
+    float rx = gx - bias[0], ry = gy - bias[1], rz = gz - bias[2];
+    bool still = accelValid && rx * rx + ry * ry + rz * rz < restGyroThreshold * restGyroThreshold;
+    restSeconds = still ? restSeconds + deltaTime : 0;
+    if (restSeconds > REST_CONFIRM_SECONDS) {
+        // 静止中はジャイロの出力そのものがバイアス
+        float rate = restBiasRate * deltaTime;
+        bias[0] += (gx - bias[0]) * rate;
+        bias[1] += (gy - bias[1]) * rate;
+        bias[2] += (gz - bias[2]) * rate;
+    }
+    
+    gx -= bias[0];
+    gy -= bias[1];
+    gz -= bias[2];
+    
+    if (accelValid) {
+        float ax = accX * accRecipNorm, ay = accY * accRecipNorm, az = accZ * accRecipNorm;
+        
+        // 現在の姿勢から見た重力方向
+        float vx = 2 * (q1 * q3 - q0 * q2);
+        float vy = 2 * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        
+        // 測定との誤差（外積）
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+        
+        // I項はバイアスとして保持
+        // 重力まわりの回転は観測できないため、水平時のヨー軸は静止時の追従に任せる
+        if (ki > 0) {
+            bias[0] -= ki * ex * deltaTime;
+            bias[1] -= ki * ey * deltaTime;
+            bias[2] -= ki * ez * deltaTime;
+            for (int axis = 0; axis < 3; axis++) {
+                if (bias[axis] > BIAS_LIMIT) bias[axis] = BIAS_LIMIT;
+                if (bias[axis] < -BIAS_LIMIT) bias[axis] = -BIAS_LIMIT;
+            }
+        }
+        
+        gx += kp * ex;
+        gy += kp * ey;
+        gz += kp * ez;
+    }
+    
+    // クォータニオンの積分（q' = 0.5 * q * ω）
+    float halfDt = 0.5f * deltaTime;
+    gx *= halfDt;
+    gy *= halfDt;
+    gz *= halfDt;
+    float a = q0, b = q1, c = q2;
+    q0 += -b * gx - c * gy - q3 * gz;
+    q1 += a * gx + c * gz - q3 * gy;
+    q2 += a * gy - b * gz + q3 * gx;
+    q3 += a * gz + b * gy - c * gx;
+    
+    float recipNorm = fastInvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm;
+    q1 *= recipNorm;
+    q2 *= recipNorm;
+    q3 *= recipNorm;
+    
+    updateEuler();
+}
+
+// ZYX順のオイラー角（AutoControlのピッチ/ロール/ヨーと同じ向き）
+void MahonyEstimator::updateEuler() {
+    float sinPitch = 2 * (q0 * q2 - q3 * q1);
+    if (sinPitch > 1) sinPitch = 1;
+    if (sinPitch < -1) sinPitch = -1;
+    roll = fastAtan2Deg(2 * (q0 * q1 + q2 * q3), 1 - 2 * (q1 * q1 + q2 * q2));
+    pitch = fastAtan2Deg(sinPitch, fastSqrt(1 - sinPitch * sinPitch));
+    
+    // ヨーは±180度で折り返さず連続にする（PIDの目標値との差が飛ばないように）
+    float wrappedYaw = fastAtan2Deg(2 * (q0 * q3 + q1 * q2), 1 - 2 * (q2 * q2 + q3 * q3));
+    float delta = wrappedYaw - lastWrappedYaw;
+    if (delta > 180) delta -= 360;
+    if (delta < -180) delta += 360;
+    yaw += delta;
+    lastWrappedYaw = wrappedYaw;
+}
+
+float MahonyEstimator::getGyroBias(int axis) const {
+    return bias[axis] * RAD_TO_DEG_F;
+}
+
+bool MahonyEstimator::isResting() const {
+    return restSeconds > REST_CONFIRM_SECONDS;
+}
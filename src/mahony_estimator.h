@@ -0,0 +1,50 @@
+#ifndef MAHONY_ESTIMATOR_H
+#define MAHONY_ESTIMATOR_H
+
+// Mahonyの姿勢推定（クォータニオン）
+// 加速度から求めた重力方向との誤差をPIでジャイロに戻す。I項がジャイロのバイアス推定になる
+// オイラー角を積分しないため、垂直に近い姿勢でも破綻しない
+// 静止中はヨー軸を含めた全軸のバイアスをジャイロ値から直接追従させ、ヨーのドリフトを抑える
+
+#include "attitude_estimator.h"
+
+class MahonyEstimator : public AttitudeEstimator {
+private:
+    float q0, q1, q2, q3;       // 姿勢クォータニオン
+    float bias[3];              // ジャイロバイアス推定値[rad/s]
+    float kp, ki;               // 重力誤差のフィードバックゲイン
+    float accelTolerance;       // 加速度補正を使う |a| の許容幅[g]
+    float restBiasRate;         // 静止中のバイアス追従の速さ[1/s]
+    float restGyroThreshold;    // 静止判定の角速度[rad/s]
+    float restSeconds;          // 静止が続いている時間[秒]
+    bool firstUpdate;           // 初回は加速度から姿勢を初期化
+    
+    float pitch, roll, yaw;     // 直近のオイラー角[度]（ヨーは連続値）
+    float lastWrappedYaw;       // 前回の±180度のヨー
+    
+    void initFromAccel(float accX, float accY, float accZ);
+    void updateEuler();
+
+public:
+    MahonyEstimator();
+    
+    void update(float accX, float accY, float accZ,
+                float gyroX, float gyroY, float gyroZ, float deltaTime) override;
+    void reset() override;
+    
+    // 実行中に調整できる
+    void setGains(float kp, float ki) { this->kp = kp; this->ki = ki; }
+    void setAccelTolerance(float tolerance) { accelTolerance = tolerance; }
+    void setRestBiasRate(float rate) { restBiasRate = rate; }
+    
+    float getPitch() const override { return pitch; }
+    float getRoll() const override { return roll; }
+    float getYaw() const override { return yaw; }
+    const char* getName() const override { return "mahony"; }
+    
+    // 推定したジャイロバイアス[deg/s]
+    float getGyroBias(int axis) const;
+    bool isResting() const;
+};
+
+#endif
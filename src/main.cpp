@@ -1,215 +1,725 @@
 #include <Arduino.h>
 #include <Wire.h>
-#include <MPU6050_tockn.h>
 #include "rc_receiver.h"
+#include "pwm_receiver_backend.h"
+#include "ppm_receiver_backend.h"
+#include "serial_receiver_backend.h"
 #include "servo_output.h"
 #include "led_output.h"
 #include "display_controller.h"
 #include "auto_control.h"
+#include "mpu6050_driver.h"
+#include "i2c_bus_manager.h"
+#include "imu_calibrator.h"
+#include "boot_trace.h"
+#include "boot_sequencer.h"
+#include "fixed_string.h"
+#include "heap_guard.h"
+#include "arduino_hal.h"
+#include "control_scheduler.h"
+#include "loop_profiler.h"
+#include "telemetry.h"
+#include "telemetry_writer.h"
+#include "blackbox.h"
+#include "blackbox_writer.h"
+#include "rc_conditioner.h"
+#include "passthrough_output.h"
+#include "control_tick.h"
+
+// 制御周期（100/250/500/1000Hz、ビルドフラグで変更可能）
+#ifndef CONTROL_RATE_HZ
+#define CONTROL_RATE_HZ 500
+#endif
+
+// 受信機の信号方式
+#define RC_BACKEND_PWM  0   // 1チャンネル1ピン（エレベーター/ラダー/LED）
+#define RC_BACKEND_SBUS 1   // ELEVATOR_INPUT_PINに1本で接続
+#define RC_BACKEND_CRSF 2
+#define RC_BACKEND_PPM  3
+#ifndef RC_BACKEND
+#define RC_BACKEND RC_BACKEND_PWM
+#endif
+
+// テレメトリ送信周期（制御周期が上限）
+#ifndef TELEMETRY_RATE_HZ
+#define TELEMETRY_RATE_HZ 50
+#endif
+
+// タスク優先度（テレメトリ送信は制御ループより低くする）
+const UBaseType_t CONTROL_TASK_PRIORITY = 2;
+const UBaseType_t TELEMETRY_TASK_PRIORITY = 1;
+const UBaseType_t CALIBRATION_TASK_PRIORITY = 1;
+const UBaseType_t BLACKBOX_TASK_PRIORITY = 1;
+
+// ブラックボックスの記録先（partitions.csvのパーティション名）
+const char* BLACKBOX_PARTITION = "blackbox";
 
 // ピン定義
 const int SDA_PIN = 5;         // I2C SDA
 const int SCL_PIN = 6;         // I2C SCL
+const uint32_t I2C_CLOCK_HZ = 400000;
+const uint32_t I2C_IDLE_MARGIN_MICROS = 100;  // 空き時間の転送が次の制御周期に食い込まないための余裕
+// 空き時間に表示の転送が収まらない時（1kHz制御）も、IMUのトランザクションこの回数毎に1回は表示を流す
+const uint16_t I2C_DISPLAY_RESERVE_TRANSACTIONS = 20;
 const int ELEVATOR_INPUT_PIN = 21;   // エレベーター受信ピン
 const int ELEVATOR_SERVO_PIN = 20;   // エレベーターサーボピン
 const int RUDDER_INPUT_PIN = 1;    // ラダー受信ピン
 const int RUDDER_SERVO_PIN = 2;    // ラダーサーボピン
+const uint8_t ELEVATOR_SERVO_CHANNEL = 0;  // LEDCチャンネル
+const uint8_t RUDDER_SERVO_CHANNEL = 1;
 const int LED_INPUT_PIN = 10;        // LED制御信号受信ピン
 const int LED_OUTPUT_PIN = 0;       // LED出力ピン
+const int IMU_INT_PIN = 3;          // MPU6050 INT（データレディ、未配線なら-1。配線がなくても割り込みが来なければポーリングに戻る）
+
+// サーボ、スティックのカーブ、スティックの目標値への換算は control_tick.h（SITL/再生と共通）
+
+// これを超えてスティックを動かしたら離陸の準備とみなし、IMUの補正値の更新をやめる[%]
+const float CALIBRATION_STICK_THRESHOLD = 10.0f;
+
+// 受信機のフレームの間を補間する（0で無効。フレームの値を階段状にそのまま使う）
+#ifndef RC_SMOOTHING
+#define RC_SMOOTHING 1
+#endif
+
+// 加速度制御の間も姿勢推定を続ける（0で止め、加速度制御の周期毎のコストを加速度制御だけの時と同じにする）
+#ifndef ACCEL_MODE_ATTITUDE_ESTIMATION
+#define ACCEL_MODE_ATTITUDE_ESTIMATION 1
+#endif
+
+// MPU6050設定（1kHzサンプルをFIFOにため、制御周期でまとめて読む）
+const uint8_t IMU_DLPF_CFG = 3;             // 加速度44Hz/角速度42Hz
+const uint8_t IMU_SAMPLE_RATE_DIVIDER = 0;  // 1kHz
+const uint32_t IMU_PROBE_TIMEOUT_MS = 100;  // 電源投入直後はMPU6050が応答するまで少し待つ
+
+// ハードウェア抽象化層
+ArduinoClock systemClock;
+ArduinoPwmInput pwmInput;
+LedcServoDriver elevatorServoDriver(ELEVATOR_SERVO_CHANNEL);
+LedcServoDriver rudderServoDriver(RUDDER_SERVO_CHANNEL);
+ArduinoI2CBus i2cBus(Wire);
+// I2Cはジャイロとディスプレイで共有（IMUは即時、ディスプレイは空き時間に転送）
+I2CBusManager i2cManager(i2cBus, systemClock, I2C_CLOCK_HZ);
+ManagedI2CBus imuBus(i2cManager, "imu", I2C_PRIORITY_HIGH, /* retries=*/ 1);
+ManagedI2CBus displayBus(i2cManager, "display", I2C_PRIORITY_LOW, /* retries=*/ 1);
+Mpu6050Driver imu(imuBus);
+NvsCalibrationStore calibrationStore;
+EspPartitionStorage blackboxStorage(BLACKBOX_PARTITION);
+
+// 受信機バックエンド
+#if RC_BACKEND == RC_BACKEND_PWM
+PwmReceiverBackend rcBackend(pwmInput, systemClock, ELEVATOR_INPUT_PIN, RUDDER_INPUT_PIN, LED_INPUT_PIN);
+#elif RC_BACKEND == RC_BACKEND_PPM
+PpmReceiverBackend rcBackend(pwmInput, systemClock, ELEVATOR_INPUT_PIN);
+#else
+ArduinoSerialPort rcSerialPort(Serial1, ELEVATOR_INPUT_PIN);
+SerialReceiverBackend rcBackend(rcSerialPort, systemClock,
+    RC_BACKEND == RC_BACKEND_SBUS ? SerialReceiverBackend::SBUS : SerialReceiverBackend::CRSF);
+#endif
+
+// 1本線の受信機で使うチャンネル（0始まり、AETR配列の送信機を想定）
+const uint8_t RC_ELEVATOR_CHANNEL = 1;
+const uint8_t RC_RUDDER_CHANNEL = 3;
+const uint8_t RC_LED_CHANNEL = 4;
+const uint8_t RC_MODE_CHANNEL = 5;      // 制御モードの切り替えスイッチ（PWM受信では使わない）
 
 // オブジェクト
-MPU6050 mpu6050(Wire);
-RCReceiver rcReceiver(ELEVATOR_INPUT_PIN, RUDDER_INPUT_PIN, LED_INPUT_PIN);
-ServoOutput elevatorServo(ELEVATOR_SERVO_PIN, "エレベーター");
-ServoOutput rudderServo(RUDDER_SERVO_PIN, "ラダー");
+RCReceiver rcReceiver(rcBackend, systemClock);
+RcConditioner rcConditioner;
+ServoOutput elevatorServo(elevatorServoDriver, ELEVATOR_SERVO_PIN, "エレベーター", ELEVATOR_SERVO_CONFIG);
+ServoOutput rudderServo(rudderServoDriver, RUDDER_SERVO_PIN, "ラダー", RUDDER_SERVO_CONFIG);
+PassthroughOutput passthroughOutput(systemClock, elevatorServo, rudderServo, rcConditioner);
 LedOutput ledOutput(LED_OUTPUT_PIN);
-DisplayController displayController(SDA_PIN, SCL_PIN);
+DisplayController displayController(displayBus);
 AutoControl autoControl;
+ImuCalibrator imuCalibrator(imu, calibrationStore);
+BootTrace bootTrace(systemClock);
+ControlScheduler controlScheduler(systemClock, CONTROL_RATE_HZ);
+TelemetryQueue telemetryQueue;
+TelemetryWriter telemetryWriter(telemetryQueue, Serial);
+BlackboxQueue blackboxQueue;
+BlackboxLog blackboxLog(blackboxStorage);
+BlackboxWriter blackboxWriter(blackboxQueue, blackboxLog);
+#ifdef LOOP_PROFILER_ENABLED
+LoopProfiler loopProfiler(systemClock);
+#endif
 
 // 制御モード管理
 bool mpu6050Available = false;
+bool imuStale = false;                // IMUの新しいサンプルが止まっている（制御せずパススルー、IMU_OKを落とす）
+bool imuFallbackReported = false;     // INTが来ないのでポーリングに切り替えたことを表示した
 bool previousPassthroughMode = true;  // 前回のパススルーモード状態
+bool previousControlActive = false;   // 前回の周期で自動制御していた
+bool firstRcOutputDone = false;       // 受信機の値を初めてサーボに出したか
+bool sticksMovedSinceBoot = false;    // 電源投入後にスティックを動かしたか（地上の判定）
+ControlMode requestedControlMode = CONTROL_MODE_ANGLE;  // 次の制御周期で使うモード（RC / シリアル）
+ControlMode rcSwitchMode = CONTROL_MODE_COUNT;          // モードスイッチの前回の位置（未受信はCOUNT）
+
+// 起動処理の各段階の時間を表示
+void printBootTrace() {
+  Serial.println("boot step        step    total [us]");
+  for (uint8_t i = 0; i < bootTrace.getCount(); i++) {
+    FixedString<48> line;
+    line.addPadded(bootTrace.getName(i), 16).addUnsigned(bootTrace.getDuration(i), 9)
+        .addUnsigned(bootTrace.getMicros(i), 9);
+    Serial.println(line.c_str());
+  }
+  // 最初の段階がサーボ出力の開始
+  if (bootTrace.getCount() > 0) {
+    Serial.print("time to first servo output: ");
+    Serial.print(bootTrace.getMicros(0));
+    Serial.println(" us");
+  }
+}
+
+// 起動の後半（制御ループの各周期で1段階ずつ進める）
+// MPU6050の状態
+bool mpu6050Found = false;
+uint8_t mpu6050Address = Mpu6050Driver::ADDRESS_LOW;
+uint32_t imuProbeStart = 0;
+
+bool bootI2C() {
+  // I2C初期化（ジャイロとディスプレイ共用）
+  i2cBus.begin(SDA_PIN, SCL_PIN, I2C_CLOCK_HZ);
+  i2cManager.setLowPriorityReserve(I2C_DISPLAY_RESERVE_TRANSACTIONS);
+  imuProbeStart = millis();
+  return true;
+}
+
+bool bootDisplay() {
+  // 初期化コマンドのみ送る（画面の描画と転送は制御周期の空き時間に少しずつ行う）
+  displayController.begin();
+  return true;
+}
+
+bool bootImuProbe() {
+  // 0x68、0x69の順に応答を確認（電源投入直後で応答しなければ次の周期で再試行）
+  if (imu.probe(Mpu6050Driver::ADDRESS_LOW)) {
+    mpu6050Found = true;
+    Serial.println("MPU6050 found at 0x68");
+  } else if (imu.probe(Mpu6050Driver::ADDRESS_HIGH)) {
+    mpu6050Found = true;
+    mpu6050Address = Mpu6050Driver::ADDRESS_HIGH;
+    Serial.println("MPU6050 found at 0x69");
+  } else if (millis() - imuProbeStart >= IMU_PROBE_TIMEOUT_MS) {
+    Serial.println("MPU6050 Error - Passthrough only");
+    return true;
+  }
+  return mpu6050Found;
+}
+
+bool bootImuConfig() {
+  if (!mpu6050Found) return true;
+  Mpu6050Config imuConfig;
+  imuConfig.dlpf = IMU_DLPF_CFG;
+  imuConfig.sampleRateDivider = IMU_SAMPLE_RATE_DIVIDER;
+  imuConfig.useFifo = true;
+  imuConfig.interruptPin = IMU_INT_PIN;
+  if (!imu.begin(mpu6050Address, imuConfig, IMU_INT_PIN >= 0 ? &pwmInput : nullptr)) {
+    Serial.println("MPU6050 config failed");
+    mpu6050Found = false;
+  }
+  return true;
+}
+
+bool bootCalibration() {
+  if (!mpu6050Found) return true;
+  // 保存済みの補正値をすぐに適用（静止を検出したら裏で更新して保存する）
+  calibrationStore.begin(CALIBRATION_TASK_PRIORITY);
+  if (imuCalibrator.begin()) {
+    Serial.println("IMU calibration loaded");
+  } else {
+    Serial.println("No IMU calibration - keep still before moving the sticks to calibrate");
+  }
+  return true;
+}
+
+bool bootBlackbox() {
+  // 最後に書いた位置を探すだけ（消去は送信機の電源が入ってから書き込みタスクで行う）
+  if (!blackboxStorage.begin() || !blackboxLog.begin()) {
+    Serial.println("No blackbox partition - flight log disabled");
+    return true;
+  }
+  blackboxWriter.begin(BLACKBOX_TASK_PRIORITY);
+  FixedString<64> line;
+  line.add("Blackbox: session ").addUnsigned(blackboxLog.getSession()).add(", ")
+      .addUnsigned(blackboxLog.getSectorCount()).add(" sectors");
+  Serial.println(line.c_str());
+  return true;
+}
+
+bool bootAutoControl() {
+  if (!mpu6050Found) return true;
+  // 自動制御システム初期化（ここから姿勢制御モードが使える）
+  autoControl.begin(controlScheduler.getRate());
+  autoControl.setBackgroundEstimation(ACCEL_MODE_ATTITUDE_ESTIMATION);
+  mpu6050Available = true;
+  Serial.print("AutoControl initialized - ");
+  Serial.println(autoControl.getModeName());
+  return true;
+}
+
+
+const BootSequencer::Stage BOOT_STAGES[] = {
+  { "i2c", bootI2C },
+  { "display", bootDisplay },
+  { "imu probe", bootImuProbe },
+  { "imu config", bootImuConfig },
+  { "calibration", bootCalibration },
+  { "blackbox", bootBlackbox },
+  { "auto control", bootAutoControl },
+};
+BootSequencer bootSequencer(BOOT_STAGES, sizeof(BOOT_STAGES) / sizeof(BOOT_STAGES[0]), bootTrace);
 
 void setup() {
+  // サーボと受信機を最初に立ち上げ、すぐにパススルーで動けるようにする
+  // 固定の待ち時間は入れない（空中で再起動しても早く操縦に戻るため）
+  bool servosOk = elevatorServo.begin();
+  servosOk = rudderServo.begin() && servosOk;
+  bootTrace.mark("servo output");
+  
+  ledOutput.begin();
+#if RC_BACKEND != RC_BACKEND_PWM
+  rcReceiver.setChannelMap(RC_ELEVATOR_CHANNEL, RC_RUDDER_CHANNEL, RC_LED_CHANNEL);
+#endif
+  rcReceiver.begin();
+  rcConditioner.begin(ELEVATOR_RC_CURVE, RUDDER_RC_CURVE);
+  rcConditioner.setSmoothing(RC_SMOOTHING);
+  rcBackend.setWakeClock(&systemClock);   // 起動時はパススルー
+  bootTrace.mark("rc input");
+  
   Serial.begin(115200);
-  delay(500);
   Serial.println("ESP32-C3 RC System Start");
+  if (!servosOk) {
+    Serial.println("Servo output setup failed - check SERVO_FRAME_RATE_HZ");
+  }
+  Serial.print("Servo frame rate: ");
+  Serial.print(SERVO_FRAME_RATE_HZ);
+  Serial.println("Hz");
   
-  // I2C初期化（ジャイロとディスプレイ共用）
-  Wire.begin(SDA_PIN, SCL_PIN);
-  Wire.setClock(400000);  // 400kHz
-  delay(700);
+  if (!ControlScheduler::isSupportedRate(CONTROL_RATE_HZ)) {
+    Serial.println("Unsupported CONTROL_RATE_HZ - using 100Hz");
+  }
+  controlScheduler.begin();
+#ifdef LOOP_PROFILER_ENABLED
+  loopProfiler.setDeadline(controlScheduler.getPeriodMicros());
+  autoControl.setProfiler(&loopProfiler);
+  Serial.println("Loop profiler: 'p' = dump, 'r' = reset");
+#endif
+  Serial.print("Control rate: ");
+  Serial.print(controlScheduler.getRate());
+  Serial.println("Hz");
   
-  // MPU6050初期化（エラーハンドリング付き）
-  bool mpu6050Found = false;
+  // 制御ループ（loopTask）を送信タスクより優先させる
+  vTaskPrioritySet(NULL, CONTROL_TASK_PRIORITY);
+  telemetryQueue.setRate(controlScheduler.getRate(), TELEMETRY_RATE_HZ);
+  telemetryWriter.begin(TELEMETRY_TASK_PRIORITY);
+  Serial.println("Telemetry: 't' = on/off");
+  bootTrace.mark("scheduler");
   
-  // 0x68をチェック
-  Wire.beginTransmission(0x68);
-  if (Wire.endTransmission() == 0) {
-    mpu6050Found = true;
-    Serial.println("MPU6050 found at 0x68");
+  // IMUなどは制御ループの中で順に立ち上げる
+}
+
+#ifdef LOOP_PROFILER_ENABLED
+// ステージ毎の処理時間をシリアルに出力
+void printLoopProfile() {
+  Serial.print("Loop profile (deadline ");
+  Serial.print(loopProfiler.getDeadline());
+  Serial.print("us, misses ");
+  Serial.print(loopProfiler.getDeadlineMisses());
+  Serial.println(")");
+  Serial.println("stage        count    min   mean    p99    max [us]");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    LoopStage stage = (LoopStage)i;
+    LatencyHistogram::Stats stats = loopProfiler.getStats(stage);
+    FixedString<64> line;
+    line.addPadded(LoopProfiler::stageName(stage), 11).addUnsigned(stats.count, 8)
+        .addUnsigned(stats.minMicros, 7).addUnsigned(stats.meanMicros, 7)
+        .addUnsigned(stats.p99Micros, 7).addUnsigned(stats.maxMicros, 7);
+    Serial.println(line.c_str());
   }
-  
-  // 0x68で見つからなかった場合、0x69をチェック
-  if (!mpu6050Found) {
-    Wire.beginTransmission(0x69);
-    if (Wire.endTransmission() == 0) {
-      mpu6050Found = true;
-      Serial.println("MPU6050 found at 0x69");
+}
+#endif
+
+// I2Cのデバイス毎の統計
+void printI2CStats() {
+  Serial.print("I2C bus (recoveries ");
+  Serial.print(i2cManager.getRecoveryCount());
+  Serial.print(", reserved ");
+  Serial.print(i2cManager.getReservedCount());
+  Serial.println(")");
+  Serial.println("device     count  errors retries expired dropped    min   mean    max [us]  bytes/s");
+  for (uint8_t i = 0; i < i2cManager.getDeviceCount(); i++) {
+    const I2CDeviceStats& stats = i2cManager.getStats(i);
+    FixedString<96> line;
+    line.addPadded(i2cManager.getDeviceName(i), 8).addUnsigned(stats.transactions, 8)
+        .addUnsigned(stats.errors, 8).addUnsigned(stats.retries, 8).addUnsigned(stats.expired, 8)
+        .addUnsigned(stats.dropped, 8).addUnsigned(stats.transactions > 0 ? stats.minLatencyMicros : 0, 7)
+        .addUnsigned(i2cManager.getMeanLatency(i), 7).addUnsigned(stats.maxLatencyMicros, 7)
+        .addUnsigned(i2cManager.getBytesPerSecond(i), 9);
+    Serial.println(line.c_str());
+  }
+}
+
+// 制御ループでヒープが使われたら一度だけ表示（呼び出し元のアドレスはaddr2lineで調べる）
+uint32_t reportedHeapViolations = 0;
+
+void reportHeapViolations() {
+  uint32_t violations = HeapGuard::getViolationCount();
+  if (violations == reportedHeapViolations) return;
+  reportedHeapViolations = violations;
+  FixedString<64> line;
+  line.add("HEAP used in control loop: ").addUnsigned(violations).add(" times, last caller ")
+      .addHex(HeapGuard::getLastCaller());
+  Serial.println(line.c_str());
+}
+
+// シリアルからの1文字コマンド処理
+void handleSerialCommands() {
+  while (Serial.available() > 0) {
+    char command = Serial.read();
+    switch (command) {
+      case 't':
+        telemetryQueue.setEnabled(!telemetryQueue.isEnabled());
+        break;
+#ifdef LOOP_PROFILER_ENABLED
+      case 'p':
+        printLoopProfile();
+        break;
+      case 'r':
+        loopProfiler.reset();
+        controlScheduler.resetStats();
+        Serial.println("Loop profile reset");
+        break;
+#endif
+      case 'b':
+        printBootTrace();
+        break;
+      case 'i':
+        printI2CStats();
+        i2cManager.resetStats();
+        break;
+      case 'o': {
+        // パススルーの受信機のフレームからサーボ出力までの遅れ
+        FixedString<128> line;
+        line.add("Passthrough frames ").addUnsigned(passthroughOutput.getFrameCount())
+            .add(", latency last ").addUnsigned(passthroughOutput.getLastLatency())
+            .add("us max ").addUnsigned(passthroughOutput.getMaxLatency())
+            .add(rcBackend.canWake() ? "us (edge wake)" : "us (polled each tick)");
+        Serial.println(line.c_str());
+        passthroughOutput.resetStats();
+        break;
+      }
+      case 'l': {
+        // ブラックボックスの状態
+        FixedString<160> line;
+        line.add("Blackbox session ").addUnsigned(blackboxLog.getSession())
+            .add(blackboxLog.isFailed() ? " failed" : blackboxQueue.isEnabled() ? " recording" : " idle")
+            .add(", records ").addUnsigned(blackboxLog.getRecordCount())
+            .add(", dropped ").addUnsigned(blackboxQueue.getDropCount())
+            .add(", full ").addUnsigned(blackboxLog.getFullDrops())
+            .add(", erase pending ").addUnsigned(blackboxLog.getErasePending())
+            .add(", errors ").addUnsigned(blackboxLog.getErrorCount());
+        Serial.println(line.c_str());
+        break;
+      }
+      case 'c':
+        // 水平に置いた状態で使う（次の静止区間で加速度の補正値を求めて保存）
+        imuCalibrator.requestLevelCalibration();
+        Serial.println("Level calibration requested - keep level and still");
+        break;
+      case 'm':
+        // 制御モードを順に切り替え（次の制御周期から）
+        requestedControlMode = (ControlMode)((requestedControlMode + 1) % CONTROL_MODE_COUNT);
+        Serial.print("Control mode: ");
+        Serial.println(AutoControl::getModeName(requestedControlMode));
+        break;
+      case 'e': {
+        // 姿勢推定器の切り替え（相補フィルター <-> Mahony）
+        ControlAngleFilter& angleFilter = autoControl.getAngleMode().getAngleFilter();
+#ifdef USE_FIXED_POINT
+        bool isMahony = angleFilter.getEstimatorType() == ESTIMATOR_MAHONY;
+#else
+        bool isMahony = &angleFilter.getEstimator() == &angleFilter.getMahony();
+#endif
+        angleFilter.selectEstimator(isMahony ? ESTIMATOR_COMPLEMENTARY : ESTIMATOR_MAHONY);
+        Serial.print("Estimator: ");
+        Serial.println(isMahony ? "complementary" : "mahony");
+        break;
+      }
+      default:
+        break;
     }
   }
+}
+
+// テレメトリとブラックボックスの共通部分（flags、姿勢と目標値、PID各項）
+template <typename Sample>
+void fillControlState(Sample& sample, uint32_t tickStart, bool isPassthrough) {
+  sample.timeMicros = tickStart;
+  sample.flags = (isPassthrough ? TELEMETRY_FLAG_PASSTHROUGH : 0) |
+                 (mpu6050Available && !imuStale ? TELEMETRY_FLAG_IMU_OK : 0);
   
-  if (mpu6050Found) {
-    mpu6050.begin();
-    mpu6050.calcGyroOffsets(true);
-    mpu6050Available = true;
-    Serial.println("MPU6050 OK");
-    
-    // 自動制御システム初期化
-    autoControl.begin();
+  if (autoControl.getMode() == CONTROL_MODE_ACCEL) {
+    sample.flags |= TELEMETRY_FLAG_ACCEL_MODE;
+    sample.attitude[0] = autoControl.getCurrentAccelX();
+    sample.attitude[1] = autoControl.getCurrentAccelY();
+    sample.attitude[2] = autoControl.getCurrentAccelZ();
+    sample.target[0] = autoControl.getTargetAccelX();
+    sample.target[1] = autoControl.getTargetAccelY();
+    sample.target[2] = autoControl.getTargetAccelZ();
   } else {
-    Serial.println("MPU6050 Error - Passthrough only");
-    mpu6050Available = false;
+    sample.attitude[0] = autoControl.getCurrentPitch();
+    sample.attitude[1] = autoControl.getCurrentRoll();
+    sample.attitude[2] = autoControl.getCurrentYaw();
+    sample.target[0] = autoControl.getTargetPitch();
+    sample.target[1] = autoControl.getTargetRoll();
+    sample.target[2] = autoControl.getTargetYaw();
   }
   
-  // 各コントローラーの初期化
-  // displayController.begin();
-  ledOutput.begin();
-  rcReceiver.begin();
-  elevatorServo.begin();
-  rudderServo.begin();
+  const ControlOutputs& control = autoControl.getOutputs();
+  sample.pTerm[0] = control.elevator.p;
+  sample.iTerm[0] = control.elevator.i;
+  sample.dTerm[0] = control.elevator.d;
+  sample.pTerm[1] = control.rudder.p;
+  sample.iTerm[1] = control.rudder.i;
+  sample.dTerm[1] = control.rudder.d;
+}
+
+// 1周期分の制御状態をテレメトリキューに積む（変換は送信タスク側で行う）
+void queueTelemetry(uint32_t tickStart, bool isPassthrough, float elevatorOutput, float rudderOutput) {
+  TelemetrySample sample = {};
+  fillControlState(sample, tickStart, isPassthrough);
+  sample.servo[0] = elevatorOutput;
+  sample.servo[1] = rudderOutput;
   
-  Serial.println("System Ready");
+  sample.dtMicros = controlScheduler.getDeltaMicros();
+  sample.jitterMicros = controlScheduler.getLastJitter();
+  sample.execMicros = systemClock.micros() - tickStart;
+  sample.overruns = controlScheduler.getOverrunCount();
+  passthroughOutput.takeWindow(sample.latencyMicros, sample.latencyMaxMicros);
+  telemetryQueue.push(sample);
+}
+
+// 毎周期の記録をブラックボックスのキューに積む（フラッシュへの書き込みは別タスク）
+void recordBlackbox(uint32_t tickStart, bool isPassthrough) {
+  BlackboxSample sample = {};
+  fillControlState(sample, tickStart, isPassthrough);
+  if (mpu6050Available) {
+    sample.acc[0] = imu.getAccX();
+    sample.acc[1] = imu.getAccY();
+    sample.acc[2] = imu.getAccZ();
+    sample.gyro[0] = imu.getGyroX();
+    sample.gyro[1] = imu.getGyroY();
+    sample.gyro[2] = imu.getGyroZ();
+  }
+  sample.rcPulse[0] = rcReceiver.getElevatorPulseWidth();
+  sample.rcPulse[1] = rcReceiver.getRudderPulseWidth();
+  sample.rcPulse[2] = rcReceiver.getLedPulseWidth();
+  for (int axis = 0; axis < RC_AXIS_COUNT; axis++) {
+    const RcChannelFrame& frame = rcConditioner.getFrame((RCAxis)axis);
+    if (frame.updated) sample.rcFrames |= 1 << axis;
+    sample.rcAge[axis] = frame.ageMicros < UINT16_MAX ? frame.ageMicros : UINT16_MAX;
+    sample.rcPeriod[axis] = frame.periodMicros < UINT16_MAX ? frame.periodMicros : UINT16_MAX;
+  }
+  sample.servoPulse[0] = elevatorServo.getLastPulse();
+  sample.servoPulse[1] = rudderServo.getLastPulse();
+  sample.dtMicros = controlScheduler.getDeltaMicros();
+  sample.jitterMicros = controlScheduler.getLastJitter();
+  sample.execMicros = systemClock.micros() - tickStart;
+  blackboxQueue.push(sample);
+}
+
+// 画面に出す状態を渡す（描画は空き時間に行うので値のコピーのみ）
+void updateDisplayStatus(bool isPassthrough) {
+  DisplayStatus status = {};
+  status.passthrough = isPassthrough;
+  status.imuAvailable = mpu6050Available && !imuStale;
+  status.rcValid = rcReceiver.isElevatorValid();
+  status.pitch = autoControl.getCurrentPitch();
+  status.roll = autoControl.getCurrentRoll();
+  status.yaw = autoControl.getCurrentYaw();
+  status.temperature = imu.getTemp();
+  status.controlRate = controlScheduler.getRate();
+  status.overruns = controlScheduler.getOverrunCount();
+  status.bootStage = bootSequencer.isDone() ? nullptr : bootSequencer.getCurrentStageName();
+  displayController.setStatus(status);
+}
+
+// RCのモードスイッチ（3段スイッチなら 下: 角度制御、中/上: 加速度制御）
+// スイッチを動かした時だけ要求を変え、シリアルで選んだモードを上書きし続けないようにする
+void pollModeSwitch() {
+#if RC_BACKEND != RC_BACKEND_PWM
+  if (!rcReceiver.isChannelValid(RC_MODE_CHANNEL)) return;
+  float value = rcReceiver.getChannelValue(RC_MODE_CHANNEL);
+  ControlMode position = rcSwitchMode;
+  if (value < -30) position = CONTROL_MODE_ANGLE;
+  else if (value > -10) position = CONTROL_MODE_ACCEL;  // 境目の付近では前の位置のまま
+  if (position != rcSwitchMode) {
+    rcSwitchMode = position;
+    requestedControlMode = position;
+  }
+#endif
+}
+
+// IMUの新しいサンプルが止まった/戻った時と、INTが来ないのでポーリングに切り替えた時に表示する
+void reportImuHealth(uint32_t deltaMicros) {
+  bool stale = imu.isStale(deltaMicros);
+  if (stale != imuStale) {
+    imuStale = stale;
+    Serial.println(stale ? "IMU stalled - Passthrough until data resumes" : "IMU data resumed");
+  }
+  if (imu.isInterruptFallback() && !imuFallbackReported) {
+    imuFallbackReported = true;
+    Serial.println("MPU6050 INT not detected - polling");
+  }
+}
+
+// 制御周期の待機中に受信機の割り込みで起きた時（パススルー中のみ）
+// 新しいフレームだけをサーボに出し、制御周期の処理はしない
+void servicePassthroughEdge() {
+  if (!previousPassthroughMode) return;
+  rcReceiver.updateBetweenTicks();
+  passthroughOutput.service(rcReceiver);
 }
 
 void loop() {
+  // 次の制御周期まで待機（タイマーで起床、パススルー中は受信機のパルスでも起床）
+  if (!controlScheduler.waitForTickOrWake()) {
+    servicePassthroughEdge();
+    return;
+  }
+  uint32_t deltaMicros = controlScheduler.getDeltaMicros();
+  uint32_t tickStart = systemClock.micros();
+  PROFILE_BEGIN(loopProfiler);
+  
   // RC受信機の状態を確認（最初に判定）
+  // 全チャンネルをこの時点のスナップショットとして取り込む
+  // スティックはカーブを掛け、フレームの間を補間した値を使う
+  rcReceiver.update();
+  rcConditioner.update(rcReceiver);
   bool isPassthrough = rcReceiver.isPassthroughMode();
+  float elevatorInput = rcConditioner.getElevatorValue();
+  float rudderInput = rcConditioner.getRudderValue();
+  pollModeSwitch();
+  PROFILE_STAGE(loopProfiler, STAGE_RC_READ);
   
   // LED制御処理（パススルーモードの時オン、姿勢制御の時オフ）
   ledOutput.setState(isPassthrough);
   
-  // デバッグ出力用
-  static unsigned long lastDebugTime = 0;
-  static unsigned long lastControlTime = 0;
-  
-  // 制御モード切り替わりを検出
-  bool modeChanged = (isPassthrough != previousPassthroughMode);
+  // サーボ出力（パススルーではRC入力そのまま）
+  float elevatorOutput = elevatorInput;
+  float rudderOutput = rudderInput;
   
   // 制御モード（姿勢制御）
-  if (!isPassthrough && mpu6050Available) {
-    // MPU6050データ更新
-    mpu6050.update();
-    
-    // 自動制御システム更新
-    autoControl.update(mpu6050);
-    
-    // パススルーから制御モードに切り替わった瞬間
-    if (modeChanged && previousPassthroughMode) {
-#ifdef USE_ANGLE_CONTROL
-      // 現在の姿勢を目標値として設定
-      float currentPitch = autoControl.getCurrentPitch();
-      float currentRoll = autoControl.getCurrentRoll();
-      float currentYaw = autoControl.getCurrentYaw();
-      
-      autoControl.setTargets(currentPitch, currentRoll, currentYaw);
-      Serial.println("Auto Control ON - Holding current attitude:");
-      Serial.print("Target Pitch: "); Serial.println(currentPitch, 2);
-      Serial.print("Target Roll: "); Serial.println(currentRoll, 2);
-      Serial.print("Target Yaw: "); Serial.println(currentYaw, 2);
-#endif
-#ifdef USE_ACCEL_CONTROL
-      // 現在の加速度を目標値として設定
-      float currentAccelX = autoControl.getCurrentAccelX();
-      float currentAccelY = autoControl.getCurrentAccelY();
-      float currentAccelZ = autoControl.getCurrentAccelZ();
-      
-      autoControl.setAccelTargets(currentAccelX, currentAccelY, currentAccelZ);
-      Serial.println("Auto Control ON - Holding current acceleration:");
-      Serial.print("Target AccelX: "); Serial.println(currentAccelX, 3);
-      Serial.print("Target AccelY: "); Serial.println(currentAccelY, 3);
-      Serial.print("Target AccelZ: "); Serial.println(currentAccelZ, 3);
-#endif
-    }
-    
-    // RC受信機からの目標値を取得（微調整用）
-    float elevatorInput = rcReceiver.getElevatorValue();
-    float rudderInput = rcReceiver.getRudderValue();
-    
-#ifdef USE_ANGLE_CONTROL
-    // RC入力による目標角度の微調整（現在の目標値からのオフセット）
-    static float basePitchTarget = 0;
-    static float baseYawTarget = 0;
-    
-    // モード切り替わり時にベース目標値を更新
-    if (modeChanged && previousPassthroughMode) {
-      basePitchTarget = autoControl.getCurrentPitch();
-      baseYawTarget = autoControl.getCurrentYaw();
-    }
-    
-    float pitchTarget = basePitchTarget + (elevatorInput * 0.05);  // ±5度程度の微調整
-    float yawTarget = baseYawTarget + (rudderInput * 0.05);       // ±5度程度の微調整
-    autoControl.setTargets(pitchTarget, 0, yawTarget);
-#endif
-
-#ifdef USE_ACCEL_CONTROL
-    // RC入力による目標加速度の微調整
-    static float baseAccelXTarget = 0;
-    static float baseAccelZTarget = -1.0;  // 重力分
-    
-    // モード切り替わり時にベース目標値を更新
-    if (modeChanged && previousPassthroughMode) {
-      baseAccelXTarget = autoControl.getCurrentAccelX();
-      baseAccelZTarget = autoControl.getCurrentAccelZ();
+  // MPU6050データ更新（パススルー中も静止検出と補正値の更新のために読む）
+  // 補正値の更新は地上（パススルーで、電源投入後にスティックを動かしていない）の静止区間だけで行う
+  if (fabsf(elevatorInput) > CALIBRATION_STICK_THRESHOLD || fabsf(rudderInput) > CALIBRATION_STICK_THRESHOLD) {
+    sticksMovedSinceBoot = true;
+  }
+  if (mpu6050Available) {
+    imu.update();
+    imuCalibrator.setRefineEnabled(isPassthrough && !sticksMovedSinceBoot);
+    imuCalibrator.update(deltaMicros * 1e-6f);
+    reportImuHealth(deltaMicros);
+  }
+  PROFILE_STAGE(loopProfiler, STAGE_IMU_READ);
+  
+  // 制御モードの切り替え（制御中は次のstep()で舵が連続するようにPIDの状態を引き継ぐ）
+  if (mpu6050Available && requestedControlMode != autoControl.getMode()) {
+    autoControl.setMode(requestedControlMode);
+    Serial.print("Auto Control mode - ");
+    Serial.println(autoControl.getModeName());
+  }
+  
+  // IMUが止まっている間は制御せず、RC入力をそのまま出す
+  bool controlActive = !isPassthrough && mpu6050Available && !imuStale;
+  if (controlActive) {
+    // 制御を始めた瞬間（パススルーから、またはIMUが戻った時）は、現在の姿勢（加速度）を基準の目標値にする
+    ControlInputs controlInputs;
+    controlInputs.setImu(imu);
+    controlInputs.hold = !previousControlActive;
+    if (controlInputs.hold) {
+      Serial.println(autoControl.getMode() == CONTROL_MODE_ACCEL
+                         ? "Auto Control ON - Holding current acceleration"
+                         : "Auto Control ON - Holding current attitude");
     }
     
-    float accelXTarget = baseAccelXTarget + (elevatorInput * 0.01);  // 微調整
-    float accelZTarget = baseAccelZTarget + (rudderInput * 0.01);    // 微調整
-    autoControl.setAccelTargets(accelXTarget, 0, accelZTarget);
-#endif
-    
-    // PID制御出力を取得
-    float elevatorControl = autoControl.getElevatorOutput();
-    float rudderControl = autoControl.getRudderOutput();
-    
-    // RC入力と制御出力を混合
-    float elevatorOutput = elevatorInput + elevatorControl;
-    float rudderOutput = rudderInput + rudderControl;
-    
-    // 出力制限
-    elevatorOutput = constrain(elevatorOutput, -100, 100);
-    rudderOutput = constrain(rudderOutput, -100, 100);
+    // スティックによる目標値のずれ、推定の更新と全PIDの計算、RC入力との混合と出力制限（control_tick.h）
+    ControlTickOutput control = runControlTick(autoControl, rcConditioner, controlInputs, deltaMicros);
+    elevatorOutput = control.elevator;
+    rudderOutput = control.rudder;
     
     // サーボに出力
     elevatorServo.writeValue(elevatorOutput);
     rudderServo.writeValue(rudderOutput);
-    
-    // デバッグ出力（1秒毎）
-    if (millis() - lastDebugTime > 1000) {
-      autoControl.printDebugInfo();
-      Serial.print("Control: E=");
-      Serial.print(elevatorOutput, 1);
-      Serial.print(" R=");
-      Serial.println(rudderOutput, 1);
-      lastDebugTime = millis();
-    }
-    delay(10);  // 100Hz制御ループ
+    PROFILE_STAGE(loopProfiler, STAGE_SERVO_WRITE);
   } else {
-    // パススルーモード
+    // パススルーモード（またはIMUが止まっている）
     
-    // RC受信機からの入力をそのまま出力
-    float elevatorInput = rcReceiver.getElevatorValue();
-    float rudderInput = rcReceiver.getRudderValue();
+    // RC受信機からの入力をそのまま出力（新しいフレームが届いた軸だけ。周期の間に届いた分は待機中に出している）
+    if (previousControlActive) passthroughOutput.invalidate();
+    passthroughOutput.service(rcReceiver);
+    elevatorOutput = passthroughOutput.getValue(RC_AXIS_ELEVATOR);
+    rudderOutput = passthroughOutput.getValue(RC_AXIS_RUDDER);
+    PROFILE_STAGE(loopProfiler, STAGE_SERVO_WRITE);
     
-    elevatorServo.writeValue(elevatorInput);
-    rudderServo.writeValue(rudderInput);
+    // 受信機の値を初めて出力した時刻（起動から操縦できるまでの時間）
+    if (!firstRcOutputDone && rcReceiver.isElevatorValid()) {
+      firstRcOutputDone = true;
+      bootTrace.mark("first rc output");
+    }
     
-    // 制御システムをリセット
+    // 推定だけを続ける（地上の静止中にバイアスを学習し、制御を始めた周期はその姿勢を基準にする）
+    // 制御をやめた周期はPIDと目標値だけをリセットする
     if (mpu6050Available) {
-      autoControl.reset();
+      ControlInputs idleInputs;
+      idleInputs.setImu(imu);
+      runIdleTick(autoControl, idleInputs, deltaMicros, !imuStale, previousControlActive);
     }
   }
   
+  // ブラックボックス（送信機の電源が入ったら記録を始め、以後は毎周期積む）
+  // フラッシュの消去は地上（パススルーで、電源投入後にスティックを動かしていない）の間だけ
+  blackboxQueue.setEraseAllowed(isPassthrough && !sticksMovedSinceBoot);
+  if (!blackboxQueue.isEnabled() && blackboxLog.isReady() && rcReceiver.isElevatorValid()) {
+    blackboxQueue.setEnabled(true);
+    Serial.println("Blackbox recording");
+  }
+  if (blackboxQueue.isEnabled()) {
+    recordBlackbox(tickStart, isPassthrough);
+  }
+  
+  // テレメトリ（キューに積むだけで送信は別タスク）
+  if (telemetryQueue.due()) {
+    queueTelemetry(tickStart, isPassthrough, elevatorOutput, rudderOutput);
+  }
+  PROFILE_STAGE(loopProfiler, STAGE_TELEMETRY);
+  
   // 前回のモード状態を更新
+  // パススルー中は受信機の新しい値で待機を終わらせる（制御中は周期毎に読むので起こさない）
+  if (isPassthrough != previousPassthroughMode) {
+    rcBackend.setWakeClock(isPassthrough ? &systemClock : nullptr);
+  }
   previousPassthroughMode = isPassthrough;
+  previousControlActive = controlActive;
+  PROFILE_END(loopProfiler);
+  
+  // 起動の後半を1段階ずつ進める（全て終わったら起動時間を表示）
+  // 起動が終わってからはこのタスクでヒープを使わない（使ったら検出して表示）
+  if (!bootSequencer.isDone() && bootSequencer.poll()) {
+    Serial.println("System Ready");
+    printBootTrace();
+    HeapGuard::arm();
+  }
+  reportHeapViolations();
+  
+  handleSerialCommands();
+  
+  // OLEDの描画と、キューに積まれたI2C転送（次の制御周期までの空き時間に収まる分だけ）
+  if (displayController.isInitialized()) {
+    updateDisplayStatus(isPassthrough);
+    displayController.poll(controlScheduler.getTimeUntilNextTick());
+  }
+  uint32_t idleMicros = controlScheduler.getTimeUntilNextTick();
+  i2cManager.poll(idleMicros > I2C_IDLE_MARGIN_MICROS ? idleMicros - I2C_IDLE_MARGIN_MICROS : 0);
 }
@@ -0,0 +1,207 @@
+#include "mpu6050_driver.h"
+
+Mpu6050Driver* Mpu6050Driver::instance = nullptr;
+
+static int16_t readInt16(const uint8_t* p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+Mpu6050Driver::Mpu6050Driver(I2CBus& bus)
+    : bus(bus), interruptInput(nullptr), address(ADDRESS_LOW), config(), fifoEnabled(false),
+      sample(), lastSampleCount(0), fifoOverflows(0), readErrors(0),
+      dataReadyCount(0), consumedReadyCount(0), useInterrupt(false), interruptFallback(false),
+      interruptMisses(0), emptyUpdates(0) {
+    gyroOffset[0] = gyroOffset[1] = gyroOffset[2] = 0;
+    accelOffset[0] = accelOffset[1] = accelOffset[2] = 0;
+    sample.acc[2] = 1.0f;
+}
+
+bool Mpu6050Driver::probe(uint8_t addr) {
+    if (!bus.probe(addr)) return false;
+    
+    // WHO_AM_Iはアドレスピンに関係なく0x68
+    uint8_t whoAmI = 0;
+    if (!bus.readRegisters(addr, Mpu6050Reg::WHO_AM_I, &whoAmI, 1)) return false;
+    return (whoAmI & 0x7E) == 0x68;
+}
+
+bool Mpu6050Driver::begin(uint8_t addr, const Mpu6050Config& cfg, PwmInput* input) {
+    address = addr;
+    config = cfg;
+    
+    bool ok = true;
+    ok &= bus.writeRegister(address, Mpu6050Reg::PWR_MGMT_1, 0x01);     // スリープ解除、ジャイロXのPLL
+    ok &= bus.writeRegister(address, Mpu6050Reg::CONFIG, config.dlpf & 0x07);
+    ok &= bus.writeRegister(address, Mpu6050Reg::SMPLRT_DIV, config.sampleRateDivider);
+    ok &= bus.writeRegister(address, Mpu6050Reg::GYRO_CONFIG, 0x08);    // ±500deg/s
+    ok &= bus.writeRegister(address, Mpu6050Reg::ACCEL_CONFIG, 0x00);   // ±2g
+    
+    // 割り込みはアクティブHigh、50μsパルス（ラッチしない）
+    ok &= bus.writeRegister(address, Mpu6050Reg::INT_PIN_CFG, 0x00);
+    ok &= bus.writeRegister(address, Mpu6050Reg::INT_ENABLE, 0x01);     // DATA_RDY
+    
+    fifoEnabled = config.useFifo;
+    if (fifoEnabled) {
+        ok &= bus.writeRegister(address, Mpu6050Reg::FIFO_EN, 0xF8);    // 温度 + 角速度XYZ + 加速度
+        ok &= resetFifo();
+    } else {
+        ok &= bus.writeRegister(address, Mpu6050Reg::FIFO_EN, 0x00);
+        ok &= bus.writeRegister(address, Mpu6050Reg::USER_CTRL, 0x00);
+    }
+    
+    useInterrupt = false;
+    interruptFallback = false;
+    interruptMisses = 0;
+    emptyUpdates = 0;
+    if (input != nullptr && config.interruptPin >= 0) {
+        interruptInput = input;
+        instance = this;
+        input->attach(config.interruptPin, dataReadyISR);
+        useInterrupt = true;
+    }
+    return ok;
+}
+
+void IRAM_ATTR Mpu6050Driver::dataReadyISR() {
+    if (instance == nullptr) return;
+    if (instance->interruptInput->read(instance->config.interruptPin)) {
+        instance->dataReadyCount = instance->dataReadyCount + 1;
+    }
+}
+
+bool Mpu6050Driver::resetFifo() {
+    bool ok = bus.writeRegister(address, Mpu6050Reg::USER_CTRL, 0x04);    // FIFO_RESET
+    ok &= bus.writeRegister(address, Mpu6050Reg::USER_CTRL, 0x40);        // FIFO_EN
+    return ok;
+}
+
+void Mpu6050Driver::calcGyroOffsets(uint16_t samples) {
+    float sum[3] = { 0, 0, 0 };
+    uint8_t raw[BURST_SIZE];
+    Mpu6050Sample s;
+    uint16_t count = 0;
+    
+    for (uint16_t i = 0; i < samples; i++) {
+        if (!bus.readRegisters(address, Mpu6050Reg::ACCEL_XOUT_H, raw, BURST_SIZE)) continue;
+        decodeBurst(raw, s);
+        for (int axis = 0; axis < 3; axis++) sum[axis] += s.gyro[axis];
+        count++;
+    }
+    if (count > 0) {
+        setGyroOffsets(sum[0] / count, sum[1] / count, sum[2] / count);
+    }
+    if (fifoEnabled) resetFifo();
+}
+
+void Mpu6050Driver::setGyroOffsets(float x, float y, float z) {
+    gyroOffset[0] = x;
+    gyroOffset[1] = y;
+    gyroOffset[2] = z;
+}
+
+void Mpu6050Driver::setAccelOffsets(float x, float y, float z) {
+    accelOffset[0] = x;
+    accelOffset[1] = y;
+    accelOffset[2] = z;
+}
+
+void Mpu6050Driver::decodeBurst(const uint8_t* raw, Mpu6050Sample& out) {
+    for (int axis = 0; axis < 3; axis++) {
+        out.acc[axis] = readInt16(raw + axis * 2) / ACC_LSB_PER_G;
+        out.gyro[axis] = readInt16(raw + 8 + axis * 2) / GYRO_LSB_PER_DPS;
+    }
+    out.temp = readInt16(raw + 6) / 340.0f + 36.53f;
+}
+
+void Mpu6050Driver::update() {
+    lastSampleCount = 0;
+    
+    // 割り込みが配線されていれば、新しいデータがない時はデータを読まない
+    // 割り込みが来ない周期はINT_STATUSで確かめ、データがあるのに割り込みが続けて来なければ
+    // INTが配線されていないとみなしてポーリングに切り替える（IMUの値が止まったままにならない）
+    if (useInterrupt) {
+        uint32_t ready = dataReadyCount;
+        if (ready != consumedReadyCount) {
+            consumedReadyCount = ready;
+            interruptMisses = 0;
+        } else if (!isDataReady()) {
+            if (emptyUpdates < UINT16_MAX) emptyUpdates++;
+            return;
+        } else if (++interruptMisses >= INTERRUPT_MISS_LIMIT) {
+            useInterrupt = false;
+            interruptFallback = true;
+        }
+    }
+    
+    bool ok = fifoEnabled ? readFifo() : readBurst();
+    if (!ok) readErrors++;
+    if (lastSampleCount > 0) emptyUpdates = 0;
+    else if (emptyUpdates < UINT16_MAX) emptyUpdates++;
+}
+
+bool Mpu6050Driver::isDataReady() {
+    // DATA_RDY_INT（読むと0に戻る。割り込みで読んでいた間の分が残っていることがある）
+    uint8_t status = 0;
+    if (!bus.readRegisters(address, Mpu6050Reg::INT_STATUS, &status, 1)) {
+        readErrors++;
+        return false;
+    }
+    return (status & 0x01) != 0;
+}
+
+bool Mpu6050Driver::readBurst() {
+    uint8_t raw[BURST_SIZE];
+    if (!bus.readRegisters(address, Mpu6050Reg::ACCEL_XOUT_H, raw, BURST_SIZE)) return false;
+    decodeBurst(raw, sample);
+    lastSampleCount = 1;
+    return true;
+}
+
+bool Mpu6050Driver::readFifo() {
+    uint8_t countRaw[2];
+    if (!bus.readRegisters(address, Mpu6050Reg::FIFO_COUNT_H, countRaw, 2)) return false;
+    uint16_t count = (countRaw[0] << 8) | countRaw[1];
+    
+    // あふれた場合はサンプル境界が崩れるので捨てて再開
+    if (count > FIFO_SIZE - FIFO_SAMPLE_SIZE || count % FIFO_SAMPLE_SIZE != 0) {
+        fifoOverflows++;
+        return resetFifo();
+    }
+    
+    uint16_t remaining = count / FIFO_SAMPLE_SIZE;
+    if (remaining == 0) return true;
+    
+    // 制御周期までに溜まったサンプルを平均する（間引きによる折り返しを防ぐ）
+    float acc[3] = { 0, 0, 0 };
+    float gyro[3] = { 0, 0, 0 };
+    float temp = 0;
+    uint16_t total = 0;
+    uint8_t raw[MAX_FIFO_SAMPLES * FIFO_SAMPLE_SIZE];
+    Mpu6050Sample s;
+    
+    while (remaining > 0) {
+        uint8_t chunk = remaining > MAX_FIFO_SAMPLES ? MAX_FIFO_SAMPLES : remaining;
+        if (!bus.readRegisters(address, Mpu6050Reg::FIFO_R_W, raw, chunk * FIFO_SAMPLE_SIZE)) {
+            break;
+        }
+        for (uint8_t i = 0; i < chunk; i++) {
+            decodeBurst(raw + i * FIFO_SAMPLE_SIZE, s);
+            for (int axis = 0; axis < 3; axis++) {
+                acc[axis] += s.acc[axis];
+                gyro[axis] += s.gyro[axis];
+            }
+            temp += s.temp;
+        }
+        total += chunk;
+        remaining -= chunk;
+    }
+    if (total == 0) return false;
+    
+    for (int axis = 0; axis < 3; axis++) {
+        sample.acc[axis] = acc[axis] / total;
+        sample.gyro[axis] = gyro[axis] / total;
+    }
+    sample.temp = temp / total;
+    lastSampleCount = total > 255 ? 255 : total;
+    return remaining == 0;
+}
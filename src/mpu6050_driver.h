@@ -0,0 +1,142 @@
+#ifndef MPU6050_DRIVER_H
+#define MPU6050_DRIVER_H
+
+#include <stdint.h>
+#include "i2c_bus.h"
+#include "imu_sensor.h"
+#include "pwm_input.h"
+
+// MPU6050のレジスタ
+namespace Mpu6050Reg {
+    static const uint8_t SMPLRT_DIV = 0x19;
+    static const uint8_t CONFIG = 0x1A;
+    static const uint8_t GYRO_CONFIG = 0x1B;
+    static const uint8_t ACCEL_CONFIG = 0x1C;
+    static const uint8_t FIFO_EN = 0x23;
+    static const uint8_t INT_PIN_CFG = 0x37;
+    static const uint8_t INT_ENABLE = 0x38;
+    static const uint8_t INT_STATUS = 0x3A;
+    static const uint8_t ACCEL_XOUT_H = 0x3B;
+    static const uint8_t USER_CTRL = 0x6A;
+    static const uint8_t PWR_MGMT_1 = 0x6B;
+    static const uint8_t FIFO_COUNT_H = 0x72;
+    static const uint8_t FIFO_R_W = 0x74;
+    static const uint8_t WHO_AM_I = 0x75;
+}
+
+// 変換済みの1サンプル（加速度[g]、角速度[deg/s]、温度[℃]）
+struct Mpu6050Sample {
+    float acc[3];
+    float gyro[3];
+    float temp;
+};
+
+// センサー設定
+struct Mpu6050Config {
+    uint8_t dlpf;               // CONFIGのDLPF_CFG（0-6、3で約44Hz）
+    uint8_t sampleRateDivider;  // サンプル周期 = 1kHz / (1 + divider)（DLPF有効時）
+    bool useFifo;               // FIFOにため、制御周期でまとめて読む
+    int interruptPin;           // データレディ割り込みのピン（-1で未接続）
+};
+
+// 自前のMPU6050ドライバー
+// 加速度・温度・角速度の14バイトを1回で読み出し、FIFO使用時は溜まった分を1回で読む
+// レンジはMPU6050_tocknと同じ（±2g、±500deg/s）
+class Mpu6050Driver : public ImuSensor {
+public:
+    static const uint8_t ADDRESS_LOW = 0x68;
+    static const uint8_t ADDRESS_HIGH = 0x69;
+    static const uint8_t BURST_SIZE = 14;           // 加速度6 + 温度2 + 角速度6
+    static const uint8_t FIFO_SAMPLE_SIZE = BURST_SIZE;  // FIFOもレジスタ順（加速度・温度・角速度）
+    static const uint16_t FIFO_SIZE = 1024;
+    static const uint8_t MAX_FIFO_SAMPLES = 8;      // 1トランザクションで読む最大サンプル数
+
+    static constexpr float ACC_LSB_PER_G = 16384.0f;
+    static constexpr float GYRO_LSB_PER_DPS = 65.5f;
+
+    // INTの割り込みが来ないままデータがあった回数がこれに達したら、INTは配線されていないとみなしてポーリングにする
+    static const uint8_t INTERRUPT_MISS_LIMIT = 3;
+    // 新しいサンプルがサンプル周期のこの倍数の間届かなければ、IMUが止まったとみなす
+    static const uint8_t STALE_SAMPLE_PERIODS = 5;
+
+private:
+    I2CBus& bus;
+    PwmInput* interruptInput;
+    uint8_t address;
+    Mpu6050Config config;
+    bool fifoEnabled;
+
+    Mpu6050Sample sample;
+    float gyroOffset[3];
+    float accelOffset[3];
+    uint8_t lastSampleCount;        // 直近のupdate()で取り込んだサンプル数
+    uint32_t fifoOverflows;
+    uint32_t readErrors;
+
+    // データレディ割り込みの回数（割り込みで増やし、読み出し側で差分を見る）
+    volatile uint32_t dataReadyCount;
+    uint32_t consumedReadyCount;
+    bool useInterrupt;              // 割り込みで新しいデータを判定する（falseならポーリング）
+    bool interruptFallback;         // 割り込みが来ないのでポーリングに切り替えた
+    uint8_t interruptMisses;        // 割り込みが来ないままデータがあった回数（割り込みが来たら0）
+    uint16_t emptyUpdates;          // 新しいサンプルがなかったupdate()の連続回数
+
+    bool isDataReady();
+
+    static Mpu6050Driver* instance;
+    static void IRAM_ATTR dataReadyISR();
+
+    bool readFifo();
+    bool readBurst();
+    bool resetFifo();
+
+public:
+    Mpu6050Driver(I2CBus& bus);
+
+    // 応答とWHO_AM_Iを確認
+    bool probe(uint8_t address);
+
+    // 初期化（interruptInputはデータレディ割り込みを使う場合のみ）
+    bool begin(uint8_t address, const Mpu6050Config& config, PwmInput* interruptInput = nullptr);
+
+    // 静止状態で角速度の平均をとってオフセットにする（ブロッキング）
+    void calcGyroOffsets(uint16_t samples = 500);
+    void setGyroOffsets(float x, float y, float z);
+    float getGyroOffset(uint8_t axis) const { return gyroOffset[axis]; }
+    void setAccelOffsets(float x, float y, float z);
+    float getAccelOffset(uint8_t axis) const { return accelOffset[axis]; }
+
+    // レジスタ（またはFIFO）の14バイトを変換（I2Cに依存しない）
+    static void decodeBurst(const uint8_t* raw, Mpu6050Sample& out);
+
+    // ImuSensor
+    void update() override;
+    float getAccX() override { return sample.acc[0] - accelOffset[0]; }
+    float getAccY() override { return sample.acc[1] - accelOffset[1]; }
+    float getAccZ() override { return sample.acc[2] - accelOffset[2]; }
+    float getGyroX() override { return sample.gyro[0] - gyroOffset[0]; }
+    float getGyroY() override { return sample.gyro[1] - gyroOffset[1]; }
+    float getGyroZ() override { return sample.gyro[2] - gyroOffset[2]; }
+    float getTemp() override { return sample.temp; }
+
+    // 統計
+    uint8_t getLastSampleCount() const { return lastSampleCount; }
+    uint32_t getFifoOverflows() const { return fifoOverflows; }
+    uint32_t getReadErrors() const { return readErrors; }
+
+    // データレディ割り込みが来ないのでポーリングに切り替えた（INT未配線）
+    bool isInterruptFallback() const { return interruptFallback; }
+
+    // サンプル周期（DLPFが無効なら8kHzが基準）
+    uint32_t getSamplePeriodMicros() const {
+        uint32_t base = (config.dlpf == 0 || config.dlpf == 7) ? 125 : 1000;
+        return base * (1 + config.sampleRateDivider);
+    }
+    // updatePeriodMicros毎にupdate()を呼んでいる時、サンプル周期のSTALE_SAMPLE_PERIODS倍の間新しいサンプルがない
+    // （INTの断線、I2Cの異常、センサーの停止）
+    bool isStale(uint32_t updatePeriodMicros) const {
+        return (uint32_t)emptyUpdates * updatePeriodMicros >= STALE_SAMPLE_PERIODS * getSamplePeriodMicros();
+    }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "passthrough_output.h"
+
+PassthroughOutput::PassthroughOutput(Clock& clock, ServoOutput& elevator, ServoOutput& rudder,
+                                     const RcConditioner& conditioner)
+    : clock(clock), conditioner(conditioner), forced(true) {
+    servos[RC_AXIS_ELEVATOR] = &elevator;
+    servos[RC_AXIS_RUDDER] = &rudder;
+    for (int axis = 0; axis < RC_AXIS_COUNT; axis++) {
+        writtenPulseTime[axis] = 0;
+        written[axis] = false;
+        values[axis] = 0;
+    }
+    resetStats();
+}
+
+uint8_t PassthroughOutput::service(const RCReceiver& receiver) {
+    static const RCFunction FUNCTIONS[RC_AXIS_COUNT] = { RC_ELEVATOR, RC_RUDDER };
+    const RCSnapshot& snapshot = receiver.getSnapshot();
+    uint8_t count = 0;
+    for (int axis = 0; axis < RC_AXIS_COUNT; axis++) {
+        uint8_t channel = receiver.getFunctionChannel(FUNCTIONS[axis]);
+        bool fresh = snapshot.received[channel] &&
+                     (!written[axis] || snapshot.pulseTime[channel] != writtenPulseTime[axis]);
+        if (!fresh && !forced) continue;
+
+        values[axis] = conditioner.getCurve((RCAxis)axis).apply(snapshot.pulseWidth[channel]);
+        servos[axis]->writeValue(values[axis]);
+        count++;
+        if (!snapshot.received[channel]) continue;
+        writtenPulseTime[axis] = snapshot.pulseTime[channel];
+        written[axis] = true;
+
+        // 制御モードから戻った時に書いた古いフレームは数えない
+        if (!fresh) continue;
+        uint32_t latency = clock.micros() - snapshot.pulseTime[channel];
+        lastLatency = latency;
+        if (latency > maxLatency) maxLatency = latency;
+        frameCount++;
+        windowCount++;
+        windowSum += latency;
+        if (latency > windowMax) windowMax = latency;
+    }
+    forced = false;
+    return count;
+}
+
+void PassthroughOutput::takeWindow(uint32_t& meanMicros, uint32_t& maxMicros) {
+    meanMicros = windowCount > 0 ? windowSum / windowCount : 0;
+    maxMicros = windowMax;
+    windowCount = 0;
+    windowSum = 0;
+    windowMax = 0;
+}
+
+void PassthroughOutput::resetStats() {
+    frameCount = 0;
+    lastLatency = 0;
+    maxLatency = 0;
+    windowCount = 0;
+    windowSum = 0;
+    windowMax = 0;
+}
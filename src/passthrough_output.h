@@ -0,0 +1,55 @@
+#ifndef PASSTHROUGH_OUTPUT_H
+#define PASSTHROUGH_OUTPUT_H
+
+#include <stdint.h>
+#include "clock.h"
+#include "rc_receiver.h"
+#include "rc_conditioner.h"
+#include "servo_output.h"
+
+// パススルーの出力（受信機の新しいフレーム毎にサーボへ1回だけ書く）
+//   loop()は制御周期の待機中も受信機の割り込みで起き（RCBackend::setWakeClock）、周期を待たずにここを呼ぶ
+//   値はカーブだけ掛け、フレームの間の補間はしない（補間は制御モードの目標値用で、遅れになる）
+// 遅れ: フレームが確定した時刻（PWMの立ち下がり）からサーボの出力を書き換えるまで
+//   サーボのパルスは書き換えた後のLEDCの周期から出るので、その待ち（最大でサーボの1周期）は含まない
+class PassthroughOutput {
+private:
+    Clock& clock;
+    ServoOutput* servos[RC_AXIS_COUNT];
+    const RcConditioner& conditioner;
+
+    uint32_t writtenPulseTime[RC_AXIS_COUNT];  // 最後に書いたフレームの時刻
+    bool written[RC_AXIS_COUNT];
+    bool forced;                                // 次のservice()は新しいフレームを待たずに書く
+    float values[RC_AXIS_COUNT];
+
+    // 遅れの統計（全体と、テレメトリ1回分の区間）
+    uint32_t frameCount;
+    uint32_t lastLatency;
+    uint32_t maxLatency;
+    uint32_t windowCount;
+    uint32_t windowSum;
+    uint32_t windowMax;
+
+public:
+    PassthroughOutput(Clock& clock, ServoOutput& elevator, ServoOutput& rudder, const RcConditioner& conditioner);
+
+    // 制御モードから戻った時に呼ぶ（次のservice()で今のフレームの値を書く）
+    void invalidate() { forced = true; }
+
+    // スナップショットで新しくなった軸だけサーボに書く（戻り値: 書いた軸の数）
+    uint8_t service(const RCReceiver& receiver);
+
+    // 最後に書いた値（-100〜+100）
+    float getValue(RCAxis axis) const { return values[axis]; }
+
+    // テレメトリ用: 前回呼んでからのフレームの遅れの平均と最大（フレームがなければ0）
+    void takeWindow(uint32_t& meanMicros, uint32_t& maxMicros);
+
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getLastLatency() const { return lastLatency; }
+    uint32_t getMaxLatency() const { return maxLatency; }
+    void resetStats();
+};
+
+#endif
@@ -1,44 +1,76 @@
 #include "pid_controller.h"
-#include <Arduino.h>
+#include <math.h>
 
-PIDController::PIDController(float kp, float ki, float kd) 
-    : kp(kp), ki(ki), kd(kd), previousError(0), integral(0), 
-      lastTime(0), outputMin(-1000), outputMax(1000) {
+// ki = 0 かつ kp = 0 の時のバックカリキュレーションの係数[1/秒]
+static const float DEFAULT_TRACKING_GAIN = 10.0f;
+
+PIDController::PIDController(float kp, float ki, float kd)
+    : kp(kp), ki(ki), kd(kd), kf(0), trackingGain(0), autoTrackingGain(true),
+      previousError(0), previousInput(0), integral(0),
+      firstRun(true), presetPending(false), outputMin(-1000), outputMax(1000), integralLimit(INFINITY),
+      lastP(0), lastI(0), lastD(0), lastF(0) {
+    updateTrackingGain();
 }
 
-float PIDController::calculate(float setpoint, float input) {
-    unsigned long currentTime = millis();
-    float deltaTime = (currentTime - lastTime) / 1000.0; // 秒に変換
-    
-    if (lastTime == 0) {
-        deltaTime = 0.01; // 初回は10msと仮定
-    }
-    
+void PIDController::updateTrackingGain() {
+    if (!autoTrackingGain) return;
+    // 時定数は積分時間 Ti = kp / ki と微分時間 Td = kd / kp の相乗平均（kd = 0 ならTi）
+    if (kd > 0 && ki > 0) trackingGain = sqrtf(ki / kd);
+    else trackingGain = kp > 0 ? ki / kp : DEFAULT_TRACKING_GAIN;
+}
+
+void PIDController::limitIntegral() {
+    // 積分だけで出力制限を超えないようにする（ki = 0 なら積分しない）
+    if (ki == 0) integral = 0;
+    if (integral > outputMax) integral = outputMax;
+    if (integral < outputMin) integral = outputMin;
+    if (integral > integralLimit) integral = integralLimit;
+    if (integral < -integralLimit) integral = -integralLimit;
+}
+
+float PIDController::calculate(float setpoint, float input, float deltaTime) {
     // 誤差計算
     float error = setpoint - input;
-    
-    // 積分項（積分ワインドアップ対策付き）
-    integral += error * deltaTime;
-    if (integral > outputMax / ki) integral = outputMax / ki;
-    if (integral < outputMin / ki) integral = outputMin / ki;
-    
-    // 微分項
+
+    // 積分項（ゲインを掛けてから積分するので、ゲインを変えても出力が跳ばない）
+    // presetの直後は、presetで決めた積分がこの周期の値なので進めない（進めるとki × 誤差 × 周期だけ跳ぶ）
+    if (!presetPending) integral += ki * error * deltaTime;
+    presetPending = false;
+    limitIntegral();
+
+    // 微分項（測定値の変化率。初回は前回の測定値がないので0）
     float derivative = 0;
-    if (deltaTime > 0) {
-        derivative = (error - previousError) / deltaTime;
+    if (firstRun) {
+        derivativeFilter.reset();
+    } else if (deltaTime > 0) {
+        derivative = derivativeFilter.apply(-(input - previousInput) / deltaTime);
     }
-    
+
     // PID出力計算
-    float output = kp * error + ki * integral + kd * derivative;
-    
+    lastP = kp * error;
+    lastI = integral;
+    lastD = kd * derivative;
+    lastF = kf * setpoint;
+    float unlimited = lastP + lastI + lastD + lastF;
+
     // 出力制限
+    float output = unlimited;
     if (output > outputMax) output = outputMax;
     if (output < outputMin) output = outputMin;
-    
+
+    // 積分ワインドアップ対策（制限で削られた分を積分から戻す、1周期で戻し過ぎない）
+    if (output != unlimited) {
+        float tracking = trackingGain * deltaTime;
+        if (tracking > 1.0f) tracking = 1.0f;
+        integral += tracking * (output - unlimited);
+        limitIntegral();
+    }
+
     // 次回用に保存
     previousError = error;
-    lastTime = currentTime;
-    
+    previousInput = input;
+    firstRun = false;
+
     return output;
 }
 
@@ -46,15 +78,56 @@ void PIDController::setGains(float new_kp, float new_ki, float new_kd) {
     kp = new_kp;
     ki = new_ki;
     kd = new_kd;
+    updateTrackingGain();
+    limitIntegral();
 }
 
 void PIDController::setOutputLimits(float min, float max) {
     outputMin = min;
     outputMax = max;
+    limitIntegral();
+}
+
+void PIDController::setFeedForward(float new_kf) {
+    kf = new_kf;
+}
+
+void PIDController::setTrackingGain(float gain) {
+    trackingGain = gain;
+    autoTrackingGain = false;
+}
+
+void PIDController::setIntegralLimit(float limit) {
+    integralLimit = fabsf(limit);
+    limitIntegral();
+}
+
+void PIDController::setDerivativeFilter(DerivativeFilterType type, float cutoffHz, float sampleRateHz) {
+    derivativeFilter.configure(type, cutoffHz, sampleRateHz);
+}
+
+void PIDController::preset(float output, float setpoint, float input) {
+    float error = setpoint - input;
+    // P + I + F = output（積分は通常の計算と同じ範囲に制限）
+    integral = output - kp * error - kf * setpoint;
+    limitIntegral();
+    previousError = error;
+    previousInput = input;
+    firstRun = false;
+    presetPending = true;
+    derivativeFilter.reset();
+    lastP = kp * error;
+    lastI = integral;
+    lastD = 0;
+    lastF = kf * setpoint;
 }
 
 void PIDController::reset() {
     previousError = 0;
+    previousInput = 0;
     integral = 0;
-    lastTime = 0;
+    firstRun = true;
+    presetPending = false;
+    derivativeFilter.reset();
+    lastP = lastI = lastD = lastF = 0;
 }
@@ -1,30 +1,63 @@
 #ifndef PID_CONTROLLER_H
 #define PID_CONTROLLER_H
 
+// PID制御
+//   P: kp × 誤差
+//   I: 誤差の積分（出力の単位で持つ）。出力が制限に当たった分はバックカリキュレーションで戻す
+//   D: 測定値の変化率 × -kd（目標値が跳んでも微分が跳ねない）。ローパスを掛けられる
+//   F: kf × 目標値（フィードフォワード）
+
+#include "derivative_filter.h"
+
 class PIDController {
 private:
-    float kp, ki, kd;           // PID係数
+    float kp, ki, kd, kf;       // PID係数とフィードフォワード係数
+    float trackingGain;         // バックカリキュレーションの係数[1/秒]
+    bool autoTrackingGain;      // trackingGainをゲインから決める
     float previousError;        // 前回の誤差
-    float integral;             // 積分項
-    unsigned long lastTime;     // 前回の時間
+    float previousInput;        // 前回の測定値（微分用）
+    float integral;             // 積分項（出力の単位）
+    bool firstRun;              // 初回計算フラグ（前回の測定値がない）
+    bool presetPending;         // preset直後（次の計算はpresetと同じ周期なので積分を進めない）
     float outputMin, outputMax; // 出力制限
+    float integralLimit;        // 積分項の上限（絶対値、出力制限の内側で更に絞る）
+    float lastP, lastI, lastD, lastF; // 直近の各項（テレメトリ用）
+    DerivativeFilter derivativeFilter;
+
+    void updateTrackingGain();
+    void limitIntegral();
 
 public:
     PIDController(float kp, float ki, float kd);
-    
-    // PID計算
-    float calculate(float setpoint, float input);
-    
+
+    // PID計算（deltaTime: 前回呼び出しからの経過時間[秒]、呼び出し側で計測した周期）
+    float calculate(float setpoint, float input, float deltaTime);
+
     // パラメータ設定
     void setGains(float kp, float ki, float kd);
     void setOutputLimits(float min, float max);
-    
+    void setFeedForward(float kf);
+    // 出力が制限に当たった時に積分を戻す速さ[1/秒]（既定は√(ki / kd)、kd = 0 ならki / kp）
+    void setTrackingGain(float gain);
+    // 積分項の上限（絶対値）。制限に当たらないまま積分が溜まる時（機体が押さえられている等）の行き過ぎを抑える
+    void setIntegralLimit(float limit);
+    // 微分項のローパス（sampleRateHz: calculateを呼ぶ周期）
+    void setDerivativeFilter(DerivativeFilterType type, float cutoffHz, float sampleRateHz);
+
     // リセット
     void reset();
-    
+
+    // 次の出力がoutputから続くように積分と前回の測定値を設定（モード切り替え時のバンプレス移行）
+    // 同じ周期のsetpoint/inputで次にcalculateを呼ぶとoutputをそのまま返す
+    void preset(float output, float setpoint, float input);
+
     // デバッグ情報取得
     float getLastError() const { return previousError; }
     float getIntegral() const { return integral; }
+    float getLastP() const { return lastP; }
+    float getLastI() const { return lastI; }
+    float getLastD() const { return lastD; }
+    float getLastF() const { return lastF; }
 };
 
 #endif
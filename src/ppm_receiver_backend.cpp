@@ -0,0 +1,28 @@
+#include "ppm_receiver_backend.h"
+
+PpmReceiverBackend* PpmReceiverBackend::instance = nullptr;
+
+PpmReceiverBackend::PpmReceiverBackend(PwmInput& input, Clock& clock, int pin)
+    : input(input), clock(clock), pin(pin) {
+    instance = this;
+}
+
+void PpmReceiverBackend::begin() {
+    input.attach(pin, edgeISR);
+}
+
+void IRAM_ATTR PpmReceiverBackend::edgeISR() {
+    if (instance == nullptr) return;
+    
+    uint32_t now = instance->clock.micros();
+    if (!instance->input.read(instance->pin)) return;  // 立ち上がりのみ使う
+    
+    RCPulseEvent event;
+    if (instance->decoder.onRisingEdge(now, event.channel, event.widthMicros)) {
+        event.timeMicros = now;
+        event.failsafe = false;
+        instance->events.push(event);
+        Clock* wake = instance->wakeClock;
+        if (wake != nullptr) wake->wakeFromIsr();
+    }
+}
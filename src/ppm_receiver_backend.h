@@ -0,0 +1,33 @@
+#ifndef PPM_RECEIVER_BACKEND_H
+#define PPM_RECEIVER_BACKEND_H
+
+#include "rc_backend.h"
+#include "rc_protocol.h"
+#include "clock.h"
+#include "pwm_input.h"
+#include "spsc_ring.h"
+
+// PPM受信（1ピン、立ち上がりエッジの捕捉割り込み1つで全チャンネル）
+class PpmReceiverBackend : public RCBackend {
+private:
+    PwmInput& input;
+    Clock& clock;
+    int pin;
+    PpmDecoder decoder;
+    
+    SpscRing<RCPulseEvent, 64> events;
+    
+    static PpmReceiverBackend* instance;
+    static void IRAM_ATTR edgeISR();
+    
+public:
+    PpmReceiverBackend(PwmInput& input, Clock& clock, int pin);
+    
+    void begin() override;
+    bool read(RCPulseEvent& event) override { return events.pop(event); }
+    uint8_t getChannelCount() const override { return decoder.getChannelCount(); }
+    uint32_t getDroppedEvents() const override { return events.getDropCount(); }
+    bool canWake() const override { return true; }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PWM_INPUT_H
+#define PWM_INPUT_H
+
+// ホストビルドではIRAM配置は不要
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// PWM入力ピンのインターフェース（pinMode/attachInterrupt/digitalReadの薄いラッパー）
+class PwmInput {
+public:
+    virtual ~PwmInput() {}
+
+    // 入力ピンとして設定し、両エッジで割り込みハンドラーを呼ぶ
+    virtual void attach(int pin, void (*isr)()) = 0;
+
+    // ピンの現在レベル（HIGHならtrue）
+    virtual bool read(int pin) = 0;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "pwm_receiver_backend.h"
+
+// 静的メンバーの初期化
+PwmReceiverBackend* PwmReceiverBackend::instance = nullptr;
+
+PwmReceiverBackend::PwmReceiverBackend(PwmInput& input, Clock& clock, int pin0, int pin1, int pin2)
+    : input(input), clock(clock) {
+    pins[0] = pin0;
+    pins[1] = pin1;
+    pins[2] = pin2;
+    instance = this;
+}
+
+void PwmReceiverBackend::begin() {
+    // 割り込み設定（立ち上がりと立ち下がりの両方で検出）
+    input.attach(pins[0], channel0ISR);
+    input.attach(pins[1], channel1ISR);
+    input.attach(pins[2], channel2ISR);
+}
+
+void IRAM_ATTR PwmReceiverBackend::channel0ISR() {
+    if (instance == nullptr) return;
+    instance->handleEdge(0);
+}
+
+void IRAM_ATTR PwmReceiverBackend::channel1ISR() {
+    if (instance == nullptr) return;
+    instance->handleEdge(1);
+}
+
+void IRAM_ATTR PwmReceiverBackend::channel2ISR() {
+    if (instance == nullptr) return;
+    instance->handleEdge(2);
+}
+
+void IRAM_ATTR PwmReceiverBackend::handleEdge(uint8_t channel) {
+    uint32_t now = clock.micros();
+    
+    if (input.read(pins[channel])) {
+        // 立ち上がり: パルス開始
+        pulseStart[channel] = now;
+    } else if (pulseStart[channel] != 0) {
+        // 立ち下がり: パルス終了、時刻付きでキューへ
+        RCPulseEvent event;
+        event.timeMicros = now;
+        uint32_t width = now - pulseStart[channel];
+        event.widthMicros = width > 0xFFFF ? 0xFFFF : (uint16_t)width;
+        event.channel = channel;
+        event.failsafe = false;
+        events.push(event);
+        Clock* wake = wakeClock;
+        if (wake != nullptr) wake->wakeFromIsr();
+    }
+}
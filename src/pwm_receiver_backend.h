@@ -0,0 +1,47 @@
+#ifndef PWM_RECEIVER_BACKEND_H
+#define PWM_RECEIVER_BACKEND_H
+
+#include "rc_backend.h"
+#include "clock.h"
+#include "pwm_input.h"
+#include "spsc_ring.h"
+
+// 1チャンネル1ピンのPWM受信（従来方式）
+// 各ピンの両エッジ割り込みでパルス幅を測り、時刻付きでリングに積む
+class PwmReceiverBackend : public RCBackend {
+public:
+    static const uint8_t CHANNEL_COUNT = 3;
+
+private:
+    PwmInput& input;
+    Clock& clock;
+    int pins[CHANNEL_COUNT];
+    
+    // 立ち上がり時刻（各割り込みハンドラーのみが触る）
+    volatile uint32_t pulseStart[CHANNEL_COUNT] = {};
+    
+    // 割り込み → 制御ループのイベントキュー
+    // GPIO割り込みは同じハンドラーから順に呼ばれるため、書き込み側は常に1つ
+    SpscRing<RCPulseEvent, 64> events;
+    
+    // 割り込み処理用の静的変数
+    static PwmReceiverBackend* instance;
+    
+    // 割り込みハンドラー
+    static void IRAM_ATTR channel0ISR();
+    static void IRAM_ATTR channel1ISR();
+    static void IRAM_ATTR channel2ISR();
+    void IRAM_ATTR handleEdge(uint8_t channel);
+    
+public:
+    // チャンネル0,1,2に対応するピン
+    PwmReceiverBackend(PwmInput& input, Clock& clock, int pin0, int pin1, int pin2);
+    
+    void begin() override;
+    bool read(RCPulseEvent& event) override { return events.pop(event); }
+    uint8_t getChannelCount() const override { return CHANNEL_COUNT; }
+    uint32_t getDroppedEvents() const override { return events.getDropCount(); }
+    bool canWake() const override { return true; }
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef RC_BACKEND_H
+#define RC_BACKEND_H
+
+#include <stdint.h>
+#include "clock.h"
+
+// 受信機バックエンドが扱う最大チャンネル数
+static const uint8_t RC_MAX_CHANNELS = 16;
+
+// 1チャンネル分の新しい値
+struct RCPulseEvent {
+    uint32_t timeMicros;    // 値が確定した時刻（PWMでは立ち下がり）
+    uint16_t widthMicros;   // パルス幅（マイクロ秒換算）
+    uint8_t channel;
+    bool failsafe;          // 受信機がフェイルセーフを通知している
+};
+
+// 受信機の信号方式（PWM複数ピン / SBUS / CRSF / PPM）を差し替えるインターフェース
+class RCBackend {
+protected:
+    // 新しい値が届いたら割り込みから起こす時刻源（nullptrなら起こさない）
+    Clock* volatile wakeClock = nullptr;
+
+public:
+    virtual ~RCBackend() {}
+
+    virtual void begin() = 0;
+
+    // 前回以降に届いた値を1つ取り出す（なければfalse）
+    virtual bool read(RCPulseEvent& event) = 0;
+
+    // 提供するチャンネル数
+    virtual uint8_t getChannelCount() const = 0;
+
+    // 取りこぼしたイベント数
+    virtual uint32_t getDroppedEvents() const { return 0; }
+
+    // 新しい値が届いた時にclockの待機を終わらせる（パススルーで周期を待たずに出力する）
+    // 割り込みで受けるPWM/PPMのみ。シリアルは制御ループで読むので起こせない
+    void setWakeClock(Clock* clock) { wakeClock = clock; }
+    virtual bool canWake() const { return false; }
+};
+
+#endif
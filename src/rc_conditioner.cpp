@@ -0,0 +1,87 @@
+#include "rc_conditioner.h"
+
+void RcCurve::configure(const RcCurveConfig& config) {
+    // 不感帯は表の刻み（1/32）より細かいので、表を引く前に外す
+    deadband = config.deadband * 0.01f;
+    if (deadband < 0) deadband = 0;
+    if (deadband > 0.5f) deadband = 0.5f;
+    scale = (TABLE_SIZE - 1) / (1 - deadband);
+    float expo = config.expo < 0 ? 0 : (config.expo > 1 ? 1 : config.expo);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        float x = (float)i / (TABLE_SIZE - 1);
+        table[i] = ((1 - expo) * x + expo * x * x * x) * 100.0f;
+    }
+}
+
+float RcCurve::apply(float pulseWidth) const {
+    float x = (pulseWidth - 1500.0f) * (1.0f / 500.0f);
+    bool negative = x < 0;
+    if (negative) x = -x;
+    if (x <= deadband) return 0;
+    float position = (x - deadband) * scale;
+    if (position >= TABLE_SIZE - 1) return negative ? -table[TABLE_SIZE - 1] : table[TABLE_SIZE - 1];
+    int index = (int)position;
+    float y = table[index] + (table[index + 1] - table[index]) * (position - index);
+    return negative ? -y : y;
+}
+
+RcConditioner::RcConditioner() : smoothing(true) {
+    for (AxisState& axis : axes) {
+        axis.frame = { 1500, false, UINT32_MAX, 0 };
+        axis.started = false;
+        axis.from = axis.to = axis.value = axis.rate = 0;
+        axis.ramp = 0;
+    }
+}
+
+void RcConditioner::begin(const RcCurveConfig& elevator, const RcCurveConfig& rudder) {
+    axes[RC_AXIS_ELEVATOR].curve.configure(elevator);
+    axes[RC_AXIS_RUDDER].curve.configure(rudder);
+}
+
+RcChannelFrame RcConditioner::frameOf(const RCSnapshot& snapshot, uint8_t channel) {
+    RcChannelFrame frame = { 1500, false, UINT32_MAX, 0 };
+    if (channel >= RC_MAX_CHANNELS) return frame;
+    frame.pulseWidth = snapshot.pulseWidth[channel];
+    frame.updated = snapshot.updated[channel];
+    frame.ageMicros = snapshot.ageMicros[channel];
+    frame.periodMicros = snapshot.periodMicros[channel];
+    return frame;
+}
+
+void RcConditioner::update(const RCReceiver& receiver) {
+    const RCSnapshot& snapshot = receiver.getSnapshot();
+    RcChannelFrame frames[RC_AXIS_COUNT] = {
+        frameOf(snapshot, receiver.getFunctionChannel(RC_ELEVATOR)),
+        frameOf(snapshot, receiver.getFunctionChannel(RC_RUDDER)),
+    };
+    update(frames);
+}
+
+void RcConditioner::update(const RcChannelFrame frames[RC_AXIS_COUNT]) {
+    for (int i = 0; i < RC_AXIS_COUNT; i++) {
+        AxisState& axis = axes[i];
+        const RcChannelFrame& frame = frames[i];
+        axis.frame = frame;
+
+        if (frame.updated || !axis.started) {
+            axis.to = axis.curve.apply(frame.pulseWidth);
+            // 最初のフレームは補間しない（起動直後に中立から動き出さないように）
+            axis.from = axis.started ? axis.value : axis.to;
+            // 周期より少し長くかける（次のフレームが揺らぎで遅れても、届く前に止まって変化率が0に落ちない）
+            uint32_t ramp = frame.periodMicros + frame.periodMicros / RAMP_MARGIN_DIVISOR;
+            axis.ramp = ramp < MAX_RAMP_MICROS ? ramp : MAX_RAMP_MICROS;
+            axis.started = true;
+        }
+
+        // フレームが届いた時刻からの経過で補間する（届いた周期に既に進んでいる分も含める）
+        if (!smoothing || axis.ramp == 0 || frame.ageMicros >= axis.ramp) {
+            axis.value = axis.to;
+            axis.rate = 0;
+        } else {
+            float delta = axis.to - axis.from;
+            axis.value = axis.from + delta * ((float)frame.ageMicros / axis.ramp);
+            axis.rate = delta * (1e6f / axis.ramp);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef RC_CONDITIONER_H
+#define RC_CONDITIONER_H
+
+#include <stdint.h>
+#include "rc_receiver.h"
+
+// 受信機の値の前処理（エレベーター/ラダー）
+//   カーブ: パルス幅 → 不感帯とエクスポを掛けた値（-100〜+100）。事前に計算した表を線形補間する
+//           以前の整数のmap()（5μsで1刻み）と違い、パルス幅の1μsがそのまま値に反映される
+//   補間:   受信機のフレームは50Hz程度（PWM）で、制御周期毎に読むと20ms毎の階段になる
+//           新しいフレームが届いたら、今の値からフレームの値へ1フレーム周期（と少し）かけて直線で近づける
+//           （届いた時刻から始めるので、遅れはおよそ1フレーム）
+//   変化率: 補間中の値の変化率[/秒]。スティックを動かした周期から制御のフィードフォワードに使う
+
+enum RCAxis : uint8_t {
+    RC_AXIS_ELEVATOR = 0,
+    RC_AXIS_RUDDER,
+    RC_AXIS_COUNT
+};
+
+// スティックのカーブ（送信機のD/R・エクスポに相当）
+struct RcCurveConfig {
+    float deadband;     // 中立付近の不感帯[%]（この外側から0〜100になるよう伸ばす）
+    float expo;         // 0: 直線 〜 1: 3次曲線（中立付近が穏やか）
+};
+
+// 不感帯はPWMのパルス幅の揺らぎ（±2μs程度）より少し広く、エクスポなし
+static const RcCurveConfig DEFAULT_RC_CURVE = { 1.0f, 0.0f };
+
+// 1チャンネル分のフレームの状態（RCSnapshotから取り出す。ブラックボックスにも記録して再生に使う）
+struct RcChannelFrame {
+    uint16_t pulseWidth;    // 最新のパルス幅[μs]
+    bool updated;           // この周期に新しいフレームが届いた
+    uint32_t ageMicros;     // フレームが届いてからの時間
+    uint32_t periodMicros;  // フレーム周期（0は未計測）
+};
+
+class RcCurve {
+public:
+    static const int TABLE_SIZE = 33;   // 不感帯の外側の0〜1を32等分（左右対称なので片側だけ持つ）
+
+private:
+    float table[TABLE_SIZE];
+    float deadband;                     // 不感帯（-1〜+1の入力に対して）
+    float scale;                        // 不感帯の外側を表の0〜32に伸ばす倍率
+
+public:
+    RcCurve() { configure(DEFAULT_RC_CURVE); }
+
+    void configure(const RcCurveConfig& config);
+
+    // 1000〜2000μs → -100〜+100（範囲外は端の値）
+    float apply(float pulseWidth) const;
+};
+
+class RcConditioner {
+public:
+    // 補間する時間の範囲（これより長いフレーム周期は途切れとみなし、この時間で追いつく）
+    static const uint32_t MAX_RAMP_MICROS = 40000;
+    // 補間はフレーム周期の1/8だけ長くかける
+    static const uint32_t RAMP_MARGIN_DIVISOR = 8;
+
+private:
+    struct AxisState {
+        RcCurve curve;
+        RcChannelFrame frame;
+        bool started;       // 最初のフレームを受けた
+        float from;         // 補間の始点（フレームが届いた時の値）
+        float to;           // 補間の終点（フレームの値）
+        uint32_t ramp;      // 補間にかける時間[μs]
+        float value;
+        float rate;
+    };
+
+    AxisState axes[RC_AXIS_COUNT];
+    bool smoothing;
+
+public:
+    RcConditioner();
+
+    // カーブの設定（制御開始前に呼ぶ）
+    void begin(const RcCurveConfig& elevator, const RcCurveConfig& rudder);
+
+    // 補間の有効/無効（無効ならフレームの値をそのまま使い、変化率は0）
+    void setSmoothing(bool enable) { smoothing = enable; }
+    bool isSmoothing() const { return smoothing; }
+
+    // 制御周期の先頭で1回呼ぶ（RCReceiver::update()の後）
+    void update(const RCReceiver& receiver);
+    void update(const RcChannelFrame frames[RC_AXIS_COUNT]);
+
+    // スナップショットから1チャンネル分のフレームの状態を取り出す
+    static RcChannelFrame frameOf(const RCSnapshot& snapshot, uint8_t channel);
+
+    // 値（-100〜+100）と変化率[/秒]
+    float getValue(RCAxis axis) const { return axes[axis].value; }
+    float getRate(RCAxis axis) const { return axes[axis].rate; }
+    float getElevatorValue() const { return axes[RC_AXIS_ELEVATOR].value; }
+    float getRudderValue() const { return axes[RC_AXIS_RUDDER].value; }
+
+    // カーブ（補間を通さずにフレームの値を使う時）
+    const RcCurve& getCurve(RCAxis axis) const { return axes[axis].curve; }
+
+    // 直近のupdate()に渡したフレームの状態（ブラックボックス用）
+    const RcChannelFrame& getFrame(RCAxis axis) const { return axes[axis].frame; }
+};
+
+#endif
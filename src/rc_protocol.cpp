@@ -0,0 +1,150 @@
+#include "rc_protocol.h"
+#include <string.h>
+
+void unpackChannels11(const uint8_t* data, uint16_t* ticks, uint8_t count) {
+    uint32_t bits = 0;
+    uint8_t bitCount = 0;
+    uint8_t channel = 0;
+    
+    // 下位ビットから順に11bitずつ取り出す
+    while (channel < count) {
+        while (bitCount < 11) {
+            bits |= (uint32_t)(*data++) << bitCount;
+            bitCount += 8;
+        }
+        ticks[channel++] = bits & 0x07FF;
+        bits >>= 11;
+        bitCount -= 11;
+    }
+}
+
+SbusParser::SbusParser() : position(0), frame(), frameCount(0), syncErrors(0) {
+}
+
+bool SbusParser::isValidFooter(uint8_t footer) const {
+    // SBUSは0x00、SBUS2はスロット番号付きの0x04/0x14/0x24/0x34
+    return footer == 0x00 || (footer & 0x0F) == 0x04;
+}
+
+void SbusParser::resync() {
+    // 次のヘッダー候補まで読み捨てて詰める
+    syncErrors++;
+    for (uint8_t i = 1; i < position; i++) {
+        if (buffer[i] == HEADER) {
+            memmove(buffer, buffer + i, position - i);
+            position -= i;
+            return;
+        }
+    }
+    position = 0;
+}
+
+bool SbusParser::feed(uint8_t byte) {
+    if (position == 0 && byte != HEADER) return false;
+    
+    buffer[position++] = byte;
+    if (position < FRAME_SIZE) return false;
+    
+    // フラグの上位4bitは未使用で常に0（ずれたフレームの誤検出を減らす）
+    if (!isValidFooter(buffer[FRAME_SIZE - 1]) || (buffer[23] & 0xF0) != 0) {
+        resync();
+        return false;
+    }
+    
+    uint16_t ticks[RC_PROTOCOL_MAX_CHANNELS];
+    unpackChannels11(buffer + 1, ticks, 16);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        frame.channels[ch] = rcTicksToMicros(ticks[ch]);
+    }
+    frame.channelCount = 16;
+    
+    uint8_t flags = buffer[23];
+    frame.frameLost = (flags & 0x04) != 0;
+    frame.failsafe = (flags & 0x08) != 0;
+    
+    position = 0;
+    frameCount++;
+    return true;
+}
+
+CrsfParser::CrsfParser() : position(0), frame(), frameCount(0), crcErrors(0) {
+}
+
+uint8_t CrsfParser::crc8(const uint8_t* data, size_t length) {
+    // CRC-8/DVB-S2（多項式0xD5）
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+bool CrsfParser::feed(uint8_t byte) {
+    if (position == 0) {
+        if (byte != ADDRESS_FLIGHT_CONTROLLER && byte != ADDRESS_BROADCAST &&
+            byte != ADDRESS_TRANSMITTER) {
+            return false;
+        }
+    } else if (position == 1) {
+        // 長さ = タイプ + ペイロード + CRC
+        if (byte < 2 || byte > MAX_FRAME_SIZE - 2) {
+            position = 0;
+            return false;
+        }
+    }
+    
+    buffer[position++] = byte;
+    if (position < 2 || position < buffer[1] + 2) return false;
+    
+    uint8_t length = buffer[1];
+    position = 0;
+    
+    if (crc8(buffer + 2, length - 1) != buffer[length + 1]) {
+        crcErrors++;
+        return false;
+    }
+    if (buffer[2] != TYPE_RC_CHANNELS_PACKED || length != 24) {
+        return false;  // テレメトリなど他のフレーム
+    }
+    
+    uint16_t ticks[RC_PROTOCOL_MAX_CHANNELS];
+    unpackChannels11(buffer + 3, ticks, 16);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+        frame.channels[ch] = rcTicksToMicros(ticks[ch]);
+    }
+    frame.channelCount = 16;
+    frame.failsafe = false;   // CRSFはリンク断でフレーム自体が止まる
+    frame.frameLost = false;
+    
+    frameCount++;
+    return true;
+}
+
+PpmDecoder::PpmDecoder() : lastEdgeTime(0), channelIndex(-1), channelCount(0) {
+}
+
+bool PpmDecoder::onRisingEdge(uint32_t timeMicros, uint8_t& channel, uint16_t& widthMicros) {
+    uint32_t interval = timeMicros - lastEdgeTime;
+    lastEdgeTime = timeMicros;
+    
+    if (interval >= SYNC_GAP_MICROS) {
+        // フレーム区切り
+        if (channelIndex > 0) channelCount = channelIndex;
+        channelIndex = 0;
+        return false;
+    }
+    if (channelIndex < 0) return false;
+    
+    if (interval < MIN_PULSE_MICROS || interval > MAX_PULSE_MICROS ||
+        channelIndex >= RC_PROTOCOL_MAX_CHANNELS) {
+        channelIndex = -1;  // ノイズ: 次の区切りまで待つ
+        return false;
+    }
+    
+    channel = channelIndex++;
+    widthMicros = (uint16_t)interval;
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef RC_PROTOCOL_H
+#define RC_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 1本の信号線で複数チャンネルを送る受信機プロトコルのパーサー
+// ハードウェアに依存しないため、ホストで記録済みのバイト列を流して確認できる
+
+static const uint8_t RC_PROTOCOL_MAX_CHANNELS = 16;
+
+// 1フレーム分のチャンネル値（マイクロ秒換算済み）
+struct RCChannelFrame {
+    uint16_t channels[RC_PROTOCOL_MAX_CHANNELS];
+    uint8_t channelCount;
+    bool failsafe;          // 受信機がフェイルセーフ状態を通知している
+    bool frameLost;         // 受信機側でフレームを取りこぼした
+};
+
+// SBUS/CRSFの11bit値（172-1811）をマイクロ秒（988-2012）に変換
+inline uint16_t rcTicksToMicros(uint16_t ticks) {
+    return (uint16_t)(((int32_t)ticks - 992) * 5 / 8 + 1500);
+}
+
+// 11bit×16チャンネルのパック形式を展開（SBUS/CRSF共通）
+void unpackChannels11(const uint8_t* data, uint16_t* ticks, uint8_t count);
+
+// SBUS（100000bps 8E2 反転、25バイト固定長）
+class SbusParser {
+public:
+    static const uint8_t FRAME_SIZE = 25;
+    static const uint8_t HEADER = 0x0F;
+
+private:
+    uint8_t buffer[FRAME_SIZE];
+    uint8_t position;
+    RCChannelFrame frame;
+    uint32_t frameCount;
+    uint32_t syncErrors;
+
+    bool isValidFooter(uint8_t footer) const;
+    void resync();
+
+public:
+    SbusParser();
+
+    // 1バイト入力し、フレームが揃ったらtrue
+    bool feed(uint8_t byte);
+
+    const RCChannelFrame& getFrame() const { return frame; }
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getSyncErrors() const { return syncErrors; }
+};
+
+// CRSF（420000bps 8N1）: [アドレス][長さ][タイプ][ペイロード][CRC8]
+class CrsfParser {
+public:
+    static const uint8_t ADDRESS_FLIGHT_CONTROLLER = 0xC8;
+    static const uint8_t ADDRESS_BROADCAST = 0x00;
+    static const uint8_t ADDRESS_TRANSMITTER = 0xEE;
+    static const uint8_t TYPE_RC_CHANNELS_PACKED = 0x16;
+    static const uint8_t MAX_FRAME_SIZE = 64;
+
+private:
+    uint8_t buffer[MAX_FRAME_SIZE];
+    uint8_t position;
+    RCChannelFrame frame;
+    uint32_t frameCount;
+    uint32_t crcErrors;
+
+public:
+    CrsfParser();
+
+    static uint8_t crc8(const uint8_t* data, size_t length);
+
+    // 1バイト入力し、チャンネルフレームが揃ったらtrue（他のタイプは読み飛ばす）
+    bool feed(uint8_t byte);
+
+    const RCChannelFrame& getFrame() const { return frame; }
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getCrcErrors() const { return crcErrors; }
+};
+
+// PPM（立ち上がりエッジの間隔が各チャンネルのパルス幅）
+// 割り込みから呼ばれる前提で、浮動小数点を使わない
+class PpmDecoder {
+public:
+    static const uint32_t SYNC_GAP_MICROS = 3000;   // これより長い間隔はフレーム区切り
+    static const uint16_t MIN_PULSE_MICROS = 700;
+    static const uint16_t MAX_PULSE_MICROS = 2300;
+
+private:
+    uint32_t lastEdgeTime;
+    int8_t channelIndex;     // -1は同期待ち
+    uint8_t channelCount;    // 直前のフレームのチャンネル数
+
+public:
+    PpmDecoder();
+
+    // 立ち上がりエッジ毎に呼び、チャンネル値が確定したらtrue
+    bool onRisingEdge(uint32_t timeMicros, uint8_t& channel, uint16_t& widthMicros);
+
+    uint8_t getChannelCount() const { return channelCount; }
+};
+
+#endif
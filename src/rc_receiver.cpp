@@ -1,111 +1,130 @@
 #include "rc_receiver.h"
 
-// 静的メンバーの初期化
-RCReceiver* RCReceiver::instance = nullptr;
+long RCReceiver::pulseToValue(unsigned long pulseWidth) {
+    // Arduinoのmap()と同じ整数演算
+    return ((long)pulseWidth - 1000) * 200 / 1000 - 100;
+}
 
-RCReceiver::RCReceiver(int elevator_pin, int rudder_pin, int led_pin) {
-    elevatorPin = elevator_pin;
-    rudderPin = rudder_pin;
-    ledPin = led_pin;
-    instance = this;
+RCReceiver::RCReceiver(RCBackend& backend, Clock& clock)
+    : backend(backend), clock(clock), snapshot(), tickTaken(false) {
+    setChannelMap(0, 1, 2);
+    for (uint8_t ch = 0; ch < RC_MAX_CHANNELS; ch++) {
+        snapshot.pulseWidth[ch] = 1500;
+        snapshot.ageMicros[ch] = UINT32_MAX;
+    }
 }
 
 void RCReceiver::begin() {
-    pinMode(elevatorPin, INPUT);
-    pinMode(rudderPin, INPUT);
-    pinMode(ledPin, INPUT);
-    
-    // 割り込み設定（立ち上がりと立ち下がりの両方で検出）
-    attachInterrupt(digitalPinToInterrupt(elevatorPin), elevatorISR, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(rudderPin), rudderISR, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(ledPin), ledISR, CHANGE);
+    backend.begin();
 }
 
-void IRAM_ATTR RCReceiver::elevatorISR() {
-    if (instance == nullptr) return;
-    
-    if (digitalRead(instance->elevatorPin) == HIGH) {
-        // 立ち上がり: パルス開始
-        instance->elevatorPulseStart = micros();
-    } else {
-        // 立ち下がり: パルス終了
-        unsigned long pulseEnd = micros();
-        if (instance->elevatorPulseStart > 0) {
-            instance->elevatorPulseWidth = pulseEnd - instance->elevatorPulseStart;
-        }
-    }
+void RCReceiver::setChannelMap(uint8_t elevator, uint8_t rudder, uint8_t led) {
+    channelMap[RC_ELEVATOR] = elevator < RC_MAX_CHANNELS ? elevator : 0;
+    channelMap[RC_RUDDER] = rudder < RC_MAX_CHANNELS ? rudder : 0;
+    channelMap[RC_LED] = led < RC_MAX_CHANNELS ? led : 0;
 }
 
-void IRAM_ATTR RCReceiver::rudderISR() {
-    if (instance == nullptr) return;
+const RCSnapshot& RCReceiver::update() {
+    return refresh(true);
+}
+
+const RCSnapshot& RCReceiver::updateBetweenTicks() {
+    return refresh(false);
+}
+
+// updatedは前回のupdate()以降に届いたか（間にupdateBetweenTicks()で取り込んだ分も含む）
+const RCSnapshot& RCReceiver::refresh(bool tick) {
+    if (tickTaken) {
+        for (uint8_t ch = 0; ch < RC_MAX_CHANNELS; ch++) {
+            snapshot.updated[ch] = false;
+        }
+        tickTaken = false;
+    }
     
-    if (digitalRead(instance->rudderPin) == HIGH) {
-        // 立ち上がり: パルス開始
-        instance->rudderPulseStart = micros();
-    } else {
-        // 立ち下がり: パルス終了
-        unsigned long pulseEnd = micros();
-        if (instance->rudderPulseStart > 0) {
-            instance->rudderPulseWidth = pulseEnd - instance->rudderPulseStart;
+    // 溜まったイベントを全て取り込む（割り込みは止めない）
+    RCPulseEvent event;
+    while (backend.read(event)) {
+        uint8_t ch = event.channel;
+        if (ch >= RC_MAX_CHANNELS) continue;
+        
+        // フレーム周期を平滑化（1/8の指数移動平均）
+        if (snapshot.received[ch]) {
+            uint32_t interval = event.timeMicros - snapshot.pulseTime[ch];
+            if (snapshot.periodMicros[ch] == 0) {
+                snapshot.periodMicros[ch] = interval;
+            } else {
+                snapshot.periodMicros[ch] = (snapshot.periodMicros[ch] * 7 + interval) / 8;
+            }
         }
+        snapshot.pulseWidth[ch] = event.widthMicros;
+        snapshot.pulseTime[ch] = event.timeMicros;
+        snapshot.received[ch] = true;
+        snapshot.updated[ch] = true;
+        snapshot.failsafe = event.failsafe;
     }
+    
+    snapshot.channelCount = backend.getChannelCount();
+    snapshot.timeMicros = clock.micros();
+    for (uint8_t ch = 0; ch < RC_MAX_CHANNELS; ch++) {
+        snapshot.ageMicros[ch] = snapshot.received[ch]
+            ? snapshot.timeMicros - snapshot.pulseTime[ch]
+            : UINT32_MAX;
+    }
+    if (tick) tickTaken = true;
+    return snapshot;
+}
+
+unsigned long RCReceiver::getChannelPulseWidth(uint8_t channel) const {
+    return channel < RC_MAX_CHANNELS ? snapshot.pulseWidth[channel] : 0;
+}
+
+float RCReceiver::getChannelValue(uint8_t channel) const {
+    // 1000-2000μs を -100 から +100 にマップ
+    return channel < RC_MAX_CHANNELS ? pulseToValue(snapshot.pulseWidth[channel]) : 0;
 }
 
-void IRAM_ATTR RCReceiver::ledISR() {
-    if (instance == nullptr) return;
+bool RCReceiver::isChannelValid(uint8_t channel) const {
+    if (channel >= RC_MAX_CHANNELS || snapshot.failsafe) return false;
     
-    if (digitalRead(instance->ledPin) == HIGH) {
-        // 立ち上がり: パルス開始
-        instance->ledPulseStart = micros();
-    } else {
-        // 立ち下がり: パルス終了
-        unsigned long pulseEnd = micros();
-        if (instance->ledPulseStart > 0) {
-            instance->ledPulseWidth = pulseEnd - instance->ledPulseStart;
-        }
-    }
+    // 800-2200μsの範囲内で、途絶していなければ有効
+    uint16_t width = snapshot.pulseWidth[channel];
+    return width >= 800 && width <= 2200 && snapshot.ageMicros[channel] <= STALE_TIMEOUT_MICROS;
 }
 
 unsigned long RCReceiver::getElevatorPulseWidth() {
-    return elevatorPulseWidth;
+    return getChannelPulseWidth(channelMap[RC_ELEVATOR]);
 }
 
 unsigned long RCReceiver::getRudderPulseWidth() {
-    return rudderPulseWidth;
+    return getChannelPulseWidth(channelMap[RC_RUDDER]);
 }
 
 unsigned long RCReceiver::getLedPulseWidth() {
-    return ledPulseWidth;
+    return getChannelPulseWidth(channelMap[RC_LED]);
 }
 
 float RCReceiver::getElevatorValue() {
-    // 1000-2000μs を -100 から +100 にマップ
-    return map(elevatorPulseWidth, 1000, 2000, -100, 100);
+    return getChannelValue(channelMap[RC_ELEVATOR]);
 }
 
 float RCReceiver::getRudderValue() {
-    // 1000-2000μs を -100 から +100 にマップ
-    return map(rudderPulseWidth, 1000, 2000, -100, 100);
+    return getChannelValue(channelMap[RC_RUDDER]);
 }
 
 float RCReceiver::getLedValue() {
-    // 1000-2000μs を -100 から +100 にマップ
-    return map(ledPulseWidth, 1000, 2000, -100, 100);
+    return getChannelValue(channelMap[RC_LED]);
 }
 
 bool RCReceiver::isElevatorValid() {
-    // 800-2200μsの範囲内であれば有効
-    return (elevatorPulseWidth >= 800 && elevatorPulseWidth <= 2200);
+    return isChannelValid(channelMap[RC_ELEVATOR]);
 }
 
 bool RCReceiver::isRudderValid() {
-    // 800-2200μsの範囲内であれば有効
-    return (rudderPulseWidth >= 800 && rudderPulseWidth <= 2200);
+    return isChannelValid(channelMap[RC_RUDDER]);
 }
 
 bool RCReceiver::isLedValid() {
-    // 800-2200μsの範囲内であれば有効
-    return (ledPulseWidth >= 800 && ledPulseWidth <= 2200);
+    return isChannelValid(channelMap[RC_LED]);
 }
 
 bool RCReceiver::isPassthroughMode() {
@@ -114,5 +133,5 @@ bool RCReceiver::isPassthroughMode() {
     if (!isLedValid()) {
         return true;  // 信号がない場合はパススルーモード
     }
-    return ledPulseWidth < 1500;  // 1500μs未満をパススルーモードとする
+    return getLedPulseWidth() < 1500;  // 1500μs未満をパススルーモードとする
 }
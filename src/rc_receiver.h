@@ -1,45 +1,86 @@
 #ifndef RC_RECEIVER_H
 #define RC_RECEIVER_H
 
-#include <Arduino.h>
+#include <stdint.h>
+#include "clock.h"
+#include "rc_backend.h"
+
+// 受信機の機能チャンネル
+enum RCFunction : uint8_t {
+    RC_ELEVATOR = 0,
+    RC_RUDDER,
+    RC_LED,
+    RC_FUNCTION_COUNT
+};
+
+// 制御周期の先頭で取る全チャンネルの一貫したスナップショット
+struct RCSnapshot {
+    uint32_t timeMicros;                        // スナップショット取得時刻
+    uint8_t channelCount;                       // バックエンドが提供するチャンネル数
+    bool failsafe;                              // 受信機がフェイルセーフを通知している
+    uint16_t pulseWidth[RC_MAX_CHANNELS];       // 最新パルス幅（マイクロ秒）
+    uint32_t pulseTime[RC_MAX_CHANNELS];        // 最新パルスの時刻
+    uint32_t ageMicros[RC_MAX_CHANNELS];        // 最新パルスからの経過時間
+    uint32_t periodMicros[RC_MAX_CHANNELS];     // フレーム周期（平滑化、0は未計測）
+    bool received[RC_MAX_CHANNELS];             // 一度でも受信したか
+    bool updated[RC_MAX_CHANNELS];              // 前回のupdate()以降に新しい値があったか
+};
 
 class RCReceiver {
 private:
-    int elevatorPin;
-    int rudderPin;
-    int ledPin;  // LED制御信号ピン追加
-    
-    // 最新の値を保存
-    volatile unsigned long elevatorPulseStart = 0;
-    volatile unsigned long elevatorPulseWidth = 1500;
-    volatile unsigned long rudderPulseStart = 0;
-    volatile unsigned long rudderPulseWidth = 1500;
-    volatile unsigned long ledPulseStart = 0;
-    volatile unsigned long ledPulseWidth = 1500;
-    
-    // 割り込み処理用の静的変数
-    static RCReceiver* instance;
-    
-    // 割り込みハンドラー
-    static void IRAM_ATTR elevatorISR();
-    static void IRAM_ATTR rudderISR();
-    static void IRAM_ATTR ledISR();
+    RCBackend& backend;
+    Clock& clock;
+    
+    // 機能 → バックエンドのチャンネル番号
+    uint8_t channelMap[RC_FUNCTION_COUNT];
+    
+    // 制御ループ側の最新状態
+    RCSnapshot snapshot;
+    bool tickTaken;     // update()の後、updatedをまだ消していない
+    
+    const RCSnapshot& refresh(bool tick);
+    
+    // この時間パルスが来なければ信号なしとみなす
+    static const uint32_t STALE_TIMEOUT_MICROS = 100000;
     
 public:
-    RCReceiver(int elevator_pin, int rudder_pin, int led_pin);
+    RCReceiver(RCBackend& backend, Clock& clock);
     void begin();
     
+    // 機能チャンネルの割り当て（既定はPWM受信の 0:エレベーター 1:ラダー 2:LED）
+    void setChannelMap(uint8_t elevator, uint8_t rudder, uint8_t led);
+    uint8_t getFunctionChannel(RCFunction function) const { return channelMap[function]; }
+    
+    // 溜まった値を取り込み、スナップショットを更新（制御周期の先頭で1回呼ぶ）
+    const RCSnapshot& update();
+    
+    // 周期の間に取り込む（パススルーの出力用）。updatedは消さず、次のupdate()まで積み重ねる
+    const RCSnapshot& updateBetweenTicks();
+    const RCSnapshot& getSnapshot() const { return snapshot; }
+    
+    // バックエンドで捨てた/壊れていたイベント数
+    uint32_t getDroppedEvents() const { return backend.getDroppedEvents(); }
+    
+    // 任意チャンネルの値
+    uint8_t getChannelCount() const { return snapshot.channelCount; }
+    unsigned long getChannelPulseWidth(uint8_t channel) const;
+    float getChannelValue(uint8_t channel) const;
+    bool isChannelValid(uint8_t channel) const;
+    
     // パルス幅を取得（マイクロ秒）
     unsigned long getElevatorPulseWidth();
     unsigned long getRudderPulseWidth();
     unsigned long getLedPulseWidth();
     
+    // 1000-2000μs を -100 から +100 にマップ（記録したパルス幅の再生にも使う）
+    static long pulseToValue(unsigned long pulseWidth);
+    
     // -100 から +100 の値に変換
     float getElevatorValue();
     float getRudderValue();
     float getLedValue();
     
-    // 信号が有効かチェック
+    // 信号が有効かチェック（範囲内かつ途絶していない）
     bool isElevatorValid();
     bool isRudderValid();
     bool isLedValid();
@@ -0,0 +1,19 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 受信専用シリアルポートのインターフェース
+class SerialPort {
+public:
+    virtual ~SerialPort() {}
+
+    // ボーレート、パリティ/ストップビット、信号反転を設定して開く
+    virtual void begin(uint32_t baud, bool evenParityTwoStop, bool inverted) = 0;
+
+    // 受信済みのバイトを最大length読み出し、読んだ数を返す（待たない）
+    virtual size_t readAvailable(uint8_t* buffer, size_t length) = 0;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "serial_receiver_backend.h"
+
+SerialReceiverBackend::SerialReceiverBackend(SerialPort& port, Clock& clock, Protocol protocol)
+    : port(port), clock(clock), protocol(protocol), frame(), frameTime(0), pendingChannel(0) {
+}
+
+void SerialReceiverBackend::begin() {
+    if (protocol == SBUS) {
+        port.begin(100000, true, true);    // 8E2、反転論理
+    } else {
+        port.begin(420000, false, false);  // 8N1
+    }
+}
+
+bool SerialReceiverBackend::pollPort() {
+    uint8_t buffer[64];
+    bool received = false;
+    size_t length;
+    
+    // 溜まった分を全て解析し、最後に揃ったフレームを採用する
+    while ((length = port.readAvailable(buffer, sizeof(buffer))) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            if (protocol == SBUS ? sbus.feed(buffer[i]) : crsf.feed(buffer[i])) {
+                frame = (protocol == SBUS) ? sbus.getFrame() : crsf.getFrame();
+                received = true;
+            }
+        }
+    }
+    if (received) {
+        frameTime = clock.micros();
+        pendingChannel = 0;
+    }
+    return received;
+}
+
+bool SerialReceiverBackend::read(RCPulseEvent& event) {
+    if (pendingChannel >= frame.channelCount && !pollPort()) {
+        return false;
+    }
+    
+    event.timeMicros = frameTime;
+    event.channel = pendingChannel;
+    event.widthMicros = frame.channels[pendingChannel];
+    event.failsafe = frame.failsafe;
+    pendingChannel++;
+    return true;
+}
+
+uint32_t SerialReceiverBackend::getDroppedEvents() const {
+    return protocol == SBUS ? sbus.getSyncErrors() : crsf.getCrcErrors();
+}
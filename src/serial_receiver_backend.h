@@ -0,0 +1,38 @@
+#ifndef SERIAL_RECEIVER_BACKEND_H
+#define SERIAL_RECEIVER_BACKEND_H
+
+#include "rc_backend.h"
+#include "rc_protocol.h"
+#include "clock.h"
+#include "serial_port.h"
+
+// UARTによるシリアル受信機（SBUS / CRSF）
+// 受信はUARTのFIFOとドライバーのバッファに任せ、制御周期で溜まった分をまとめて解析する
+class SerialReceiverBackend : public RCBackend {
+public:
+    enum Protocol : uint8_t { SBUS, CRSF };
+
+private:
+    SerialPort& port;
+    Clock& clock;
+    Protocol protocol;
+    SbusParser sbus;
+    CrsfParser crsf;
+    
+    // 最新フレームをチャンネル毎のイベントとして払い出す
+    RCChannelFrame frame;
+    uint32_t frameTime;
+    uint8_t pendingChannel;     // 次に払い出すチャンネル（frame.channelCountで完了）
+    
+    bool pollPort();
+    
+public:
+    SerialReceiverBackend(SerialPort& port, Clock& clock, Protocol protocol);
+    
+    void begin() override;
+    bool read(RCPulseEvent& event) override;
+    uint8_t getChannelCount() const override { return RC_PROTOCOL_MAX_CHANNELS; }
+    uint32_t getDroppedEvents() const override;
+};
+
+#endif
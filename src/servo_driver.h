@@ -0,0 +1,18 @@
+#ifndef SERVO_DRIVER_H
+#define SERVO_DRIVER_H
+
+#include <stdint.h>
+
+// サーボ出力のインターフェース（パルス幅で指定）
+class ServoDriver {
+public:
+    virtual ~ServoDriver() {}
+
+    // frameRateHz: パルスの周期（アナログサーボは50Hz、デジタルサーボは200/333Hzも可）
+    virtual bool attach(int pin, uint16_t frameRateHz) = 0;
+
+    // パルス幅[μs]（小数も可、実際の分解能はドライバーによる）
+    virtual void writeMicroseconds(float micros) = 0;
+};
+
+#endif
@@ -1,26 +1,45 @@
 #include "servo_output.h"
 
-ServoOutput::ServoOutput(int output_pin, String servo_name) {
+ServoOutput::ServoOutput(ServoDriver& driver, int output_pin, const char* servo_name,
+                         const ServoConfig& servo_config)
+    : servo(driver) {
     outputPin = output_pin;
     name = servo_name;
+    config = servo_config;
+    lastPulse = 0;
+    updateTransform();
 }
 
-void ServoOutput::begin() {
-    servo.attach(outputPin);
+bool ServoOutput::begin() {
+    if (!servo.attach(outputPin, config.frameRateHz)) return false;
     center();  // 初期位置は中央
+    return true;
+}
+
+void ServoOutput::setConfig(const ServoConfig& servo_config) {
+    config = servo_config;
+    updateTransform();
+}
+
+void ServoOutput::updateTransform() {
+    offset = config.centerMicros + config.subtrimMicros;
+    scale = (config.reversed ? -config.travelMicros : config.travelMicros) / 100.0f;
 }
 
 void ServoOutput::writeValue(float value) {
-    // -100 から +100 を 45-135度にマップ
-    int angle = map(constrain(value, -100, 100), -100, 100, SERVO_MIN, SERVO_MAX);
-    servo.write(angle);
+    // -100 から +100 を超える入力はそのまま伸ばさず止める
+    if (value > 100) value = 100;
+    if (value < -100) value = -100;
+    writeMicroseconds(offset + scale * value);
 }
 
-void ServoOutput::writeAngle(int angle) {
-    angle = constrain(angle, SERVO_MIN, SERVO_MAX);
-    servo.write(angle);
+void ServoOutput::writeMicroseconds(float micros) {
+    if (micros < config.minMicros) micros = config.minMicros;
+    if (micros > config.maxMicros) micros = config.maxMicros;
+    lastPulse = micros;
+    servo.writeMicroseconds(micros);
 }
 
 void ServoOutput::center() {
-    servo.write(SERVO_CENTER);
+    writeMicroseconds(offset);
 }
@@ -1,31 +1,58 @@
 #ifndef SERVO_OUTPUT_H
 #define SERVO_OUTPUT_H
 
-#include <Arduino.h>
-#include <ESP32Servo.h>
+#include <stdint.h>
+#include "servo_driver.h"
+
+// サーボ毎の設定（送信機のエンドポイント/サブトリム/リバースに相当）
+struct ServoConfig {
+    float centerMicros;     // 中立のパルス幅
+    float subtrimMicros;    // 中立の微調整
+    float travelMicros;     // 入力±100の時の中立からの振れ幅
+    float minMicros;        // エンドポイント（この範囲を超えて出さない）
+    float maxMicros;
+    bool reversed;
+    uint16_t frameRateHz;   // 50/200/333Hz
+};
+
+// 1000-2000μs、50Hz（アナログサーボ）
+static const ServoConfig DEFAULT_SERVO_CONFIG = { 1500, 0, 500, 1000, 2000, false, 50 };
 
 class ServoOutput {
 private:
+    ServoDriver& servo;
     int outputPin;
-    Servo servo;
-    String name;
+    const char* name;
+    ServoConfig config;
     
-    static const int SERVO_MIN = 45;     // サーボ最小角度
-    static const int SERVO_MAX = 135;    // サーボ最大角度
-    static const int SERVO_CENTER = 90;  // サーボ中央角度
+    // 入力（-100〜+100）からパルス幅への変換（サブトリムとリバースを含めて事前に計算）
+    // pulse = offset + scale * value を [minMicros, maxMicros] で制限
+    float offset;
+    float scale;
+    float lastPulse;
+    
+    void updateTransform();
     
 public:
-    ServoOutput(int output_pin, String servo_name);
-    void begin();
+    ServoOutput(ServoDriver& driver, int output_pin, const char* servo_name,
+                const ServoConfig& servo_config = DEFAULT_SERVO_CONFIG);
+    bool begin();
+    
+    // 設定の変更（フレームレートはbegin()の前のみ）
+    void setConfig(const ServoConfig& servo_config);
+    const ServoConfig& getConfig() const { return config; }
     
-    // -100 から +100 の値をサーボ角度に変換して出力
+    // -100 から +100 の値をパルス幅に変換して出力
     void writeValue(float value);
     
-    // 角度を直接指定
-    void writeAngle(int angle);
+    // パルス幅を直接指定（エンドポイントで制限）
+    void writeMicroseconds(float micros);
     
-    // センター位置に設定
+    // センター位置（サブトリム込み）に設定
     void center();
+    
+    float getLastPulse() const { return lastPulse; }
+    const char* getName() const { return name; }
 };
 
 #endif
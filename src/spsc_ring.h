@@ -0,0 +1,55 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+// 単一プロデューサ/単一コンシューマのロックフリーリングバッファ
+// 制御タスク（または割り込み）が書き込み、低優先度タスクが読み出す
+// CAPACITYは2のべき乗であること
+template <typename T, uint32_t CAPACITY>
+class SpscRing {
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    T items[CAPACITY];
+    std::atomic<uint32_t> head;     // 書き込み位置（プロデューサのみ更新）
+    std::atomic<uint32_t> tail;     // 読み出し位置（コンシューマのみ更新）
+    volatile uint32_t dropCount;    // 満杯で捨てた数
+
+public:
+    SpscRing() : head(0), tail(0), dropCount(0) {}
+
+    // 満杯なら捨ててfalseを返す（プロデューサは決して待たない）
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= CAPACITY) {
+            dropCount = dropCount + 1;
+            return false;
+        }
+        items[h & (CAPACITY - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 空ならfalse
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (h == t) return false;
+        item = items[t & (CAPACITY - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+    uint32_t getDropCount() const { return dropCount; }
+    static uint32_t capacity() { return CAPACITY; }
+};
+
+#endif
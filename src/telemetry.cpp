@@ -0,0 +1,182 @@
+#include "telemetry.h"
+
+// 値を倍率付きでint16に変換（範囲外は飽和）
+static int16_t toFixed16(float value, float scale) {
+    float scaled = value * scale;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static uint16_t toUnsigned16(uint32_t value) {
+    return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t value) {
+    p = putU16(p, value & 0xFFFF);
+    return putU16(p, value >> 16);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+// 角度は0.01度、加速度は0.001g単位
+static float attitudeScale(uint8_t flags) {
+    return (flags & TELEMETRY_FLAG_ACCEL_MODE) ? 1000.0f : 100.0f;
+}
+
+static const float TERM_SCALE = 100.0f;
+static const uint8_t CONTROL_PAYLOAD_SIZE = 45;
+static const uint8_t CONTROL_PAYLOAD_SIZE_V1 = 41;    // パススルーの遅れがない以前の形式
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+size_t encodeTelemetryFrame(const TelemetrySample& sample, uint8_t sequence, uint8_t* out) {
+    out[0] = TELEMETRY_SYNC1;
+    out[1] = TELEMETRY_SYNC2;
+    out[2] = TELEMETRY_TYPE_CONTROL;
+    out[3] = sequence;
+    out[4] = CONTROL_PAYLOAD_SIZE;
+    
+    float scale = attitudeScale(sample.flags);
+    uint8_t* p = out + TELEMETRY_HEADER_SIZE;
+    p = putU32(p, sample.timeMicros);
+    *p++ = sample.flags;
+    for (int i = 0; i < 3; i++) p = putU16(p, toFixed16(sample.attitude[i], scale));
+    for (int i = 0; i < 3; i++) p = putU16(p, toFixed16(sample.target[i], scale));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.pTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.iTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.dTerm[i], TERM_SCALE));
+    for (int i = 0; i < 2; i++) p = putU16(p, toFixed16(sample.servo[i], TERM_SCALE));
+    p = putU16(p, toUnsigned16(sample.dtMicros));
+    p = putU16(p, toUnsigned16(sample.jitterMicros));
+    p = putU16(p, toUnsigned16(sample.execMicros));
+    p = putU16(p, toUnsigned16(sample.overruns));
+    p = putU16(p, toUnsigned16(sample.latencyMicros));
+    p = putU16(p, toUnsigned16(sample.latencyMaxMicros));
+    
+    uint16_t crc = telemetryCrc16(out + 2, TELEMETRY_HEADER_SIZE - 2 + CONTROL_PAYLOAD_SIZE);
+    putU16(p, crc);
+    return TELEMETRY_HEADER_SIZE + CONTROL_PAYLOAD_SIZE + TELEMETRY_CRC_SIZE;
+}
+
+TelemetryDecoder::TelemetryDecoder()
+    : state(WAIT_SYNC1), position(0), expectedLength(0), sample(), sequence(0),
+      frameCount(0), crcErrors(0), lostFrames(0), hasSequence(false) {
+}
+
+bool TelemetryDecoder::feed(uint8_t byte) {
+    switch (state) {
+        case WAIT_SYNC1:
+            if (byte == TELEMETRY_SYNC1) state = WAIT_SYNC2;
+            return false;
+            
+        case WAIT_SYNC2:
+            if (byte == TELEMETRY_SYNC2) {
+                buffer[0] = TELEMETRY_SYNC1;
+                buffer[1] = TELEMETRY_SYNC2;
+                position = 2;
+                state = READ_HEADER;
+            } else if (byte != TELEMETRY_SYNC1) {
+                state = WAIT_SYNC1;
+            }
+            return false;
+            
+        case READ_HEADER:
+            buffer[position++] = byte;
+            if (position == TELEMETRY_HEADER_SIZE) {
+                if (byte > TELEMETRY_MAX_PAYLOAD) {
+                    state = WAIT_SYNC1;
+                    return false;
+                }
+                expectedLength = TELEMETRY_HEADER_SIZE + byte + TELEMETRY_CRC_SIZE;
+                state = READ_BODY;
+            }
+            return false;
+            
+        case READ_BODY:
+            buffer[position++] = byte;
+            if (position < expectedLength) return false;
+            state = WAIT_SYNC1;
+            return finishFrame();
+    }
+    return false;
+}
+
+bool TelemetryDecoder::finishFrame() {
+    uint8_t payloadLength = buffer[4];
+    uint16_t crc = telemetryCrc16(buffer + 2, TELEMETRY_HEADER_SIZE - 2 + payloadLength);
+    if (crc != getU16(buffer + TELEMETRY_HEADER_SIZE + payloadLength)) {
+        crcErrors++;
+        return false;
+    }
+    if (buffer[2] != TELEMETRY_TYPE_CONTROL ||
+        (payloadLength != CONTROL_PAYLOAD_SIZE && payloadLength != CONTROL_PAYLOAD_SIZE_V1)) {
+        return false;  // 未知のフレームは読み飛ばす
+    }
+    
+    if (hasSequence) {
+        lostFrames += (uint8_t)(buffer[3] - sequence - 1);
+    }
+    sequence = buffer[3];
+    hasSequence = true;
+    
+    const uint8_t* p = buffer + TELEMETRY_HEADER_SIZE;
+    sample.timeMicros = getU32(p); p += 4;
+    sample.flags = *p++;
+    float scale = attitudeScale(sample.flags);
+    for (int i = 0; i < 3; i++, p += 2) sample.attitude[i] = (int16_t)getU16(p) / scale;
+    for (int i = 0; i < 3; i++, p += 2) sample.target[i] = (int16_t)getU16(p) / scale;
+    for (int i = 0; i < 2; i++, p += 2) sample.pTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.iTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.dTerm[i] = (int16_t)getU16(p) / TERM_SCALE;
+    for (int i = 0; i < 2; i++, p += 2) sample.servo[i] = (int16_t)getU16(p) / TERM_SCALE;
+    sample.dtMicros = getU16(p); p += 2;
+    sample.jitterMicros = getU16(p); p += 2;
+    sample.execMicros = getU16(p); p += 2;
+    sample.overruns = getU16(p); p += 2;
+    bool hasLatency = payloadLength == CONTROL_PAYLOAD_SIZE;
+    sample.latencyMicros = hasLatency ? getU16(p) : 0;
+    sample.latencyMaxMicros = hasLatency ? getU16(p + 2) : 0;
+    
+    frameCount++;
+    return true;
+}
+
+TelemetryQueue::TelemetryQueue() : divider(1), counter(0), enabled(true) {
+}
+
+void TelemetryQueue::setRate(uint16_t control_rate_hz, uint16_t telemetry_rate_hz) {
+    if (telemetry_rate_hz == 0 || telemetry_rate_hz >= control_rate_hz) {
+        divider = 1;
+    } else {
+        divider = control_rate_hz / telemetry_rate_hz;
+    }
+    counter = 0;
+}
+
+bool TelemetryQueue::due() {
+    if (!enabled) return false;
+    if (++counter < divider) return false;
+    counter = 0;
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "spsc_ring.h"
+
+// バイナリテレメトリ
+// フレーム: [0xA5][0x5A][type][seq][len][payload(len)][crc16 LE]
+// CRC-16/CCITT-FALSEをtypeからpayload末尾までに対して計算する
+// 数値はすべてリトルエンディアン
+
+static const uint8_t TELEMETRY_SYNC1 = 0xA5;
+static const uint8_t TELEMETRY_SYNC2 = 0x5A;
+static const uint8_t TELEMETRY_TYPE_CONTROL = 0x01;
+static const uint8_t TELEMETRY_HEADER_SIZE = 5;
+static const uint8_t TELEMETRY_CRC_SIZE = 2;
+static const uint8_t TELEMETRY_MAX_PAYLOAD = 64;
+static const uint8_t TELEMETRY_MAX_FRAME = TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE;
+
+// flagsのビット
+static const uint8_t TELEMETRY_FLAG_PASSTHROUGH = 0x01;
+static const uint8_t TELEMETRY_FLAG_IMU_OK = 0x02;
+static const uint8_t TELEMETRY_FLAG_ACCEL_MODE = 0x04;   // 姿勢/目標値が加速度[g]
+
+// 1周期分の制御状態（制御タスク側では変換せずにそのまま詰める）
+struct TelemetrySample {
+    uint32_t timeMicros;
+    uint8_t flags;
+    float attitude[3];      // ピッチ/ロール/ヨー[deg]（加速度モードではX/Y/Z[g]）
+    float target[3];
+    float pTerm[2];         // エレベーター/ラダーのPID各項
+    float iTerm[2];
+    float dTerm[2];
+    float servo[2];         // エレベーター/ラダー出力（-100〜+100）
+    uint32_t dtMicros;      // 実測周期
+    uint32_t jitterMicros;  // 予定時刻からの遅れ
+    uint32_t execMicros;    // 周期内の処理時間
+    uint32_t overruns;
+    uint32_t latencyMicros;     // パススルーの受信機のフレームからサーボ出力までの遅れ（前回のサンプルからの平均）
+    uint32_t latencyMaxMicros;  // 同じ区間の最大（フレームがなければ0）
+};
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+// サンプルをフレームにエンコードし、フレーム長を返す（outはTELEMETRY_MAX_FRAME以上）
+size_t encodeTelemetryFrame(const TelemetrySample& sample, uint8_t sequence, uint8_t* out);
+
+// バイト列からフレームを復元するストリームデコーダー
+// 同期が外れても次の同期バイトから再開する
+class TelemetryDecoder {
+private:
+    enum State : uint8_t { WAIT_SYNC1, WAIT_SYNC2, READ_HEADER, READ_BODY };
+
+    State state;
+    uint8_t buffer[TELEMETRY_MAX_FRAME];
+    uint8_t position;
+    uint8_t expectedLength;
+
+    TelemetrySample sample;
+    uint8_t sequence;
+    uint32_t frameCount;
+    uint32_t crcErrors;
+    uint32_t lostFrames;        // シーケンス番号の欠け
+    bool hasSequence;
+
+    bool finishFrame();
+
+public:
+    TelemetryDecoder();
+
+    // 1バイト入力し、正常なフレームが揃ったらtrue
+    bool feed(uint8_t byte);
+
+    const TelemetrySample& getSample() const { return sample; }
+    uint8_t getSequence() const { return sequence; }
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getCrcErrors() const { return crcErrors; }
+    uint32_t getLostFrames() const { return lostFrames; }
+};
+
+// 制御タスクから低優先度タスクへサンプルを渡すキュー
+// 制御周期に対して間引いて積む（divider=1で毎周期）
+class TelemetryQueue {
+private:
+    static const uint32_t CAPACITY = 32;
+    SpscRing<TelemetrySample, CAPACITY> ring;
+    uint16_t divider;
+    uint16_t counter;
+    bool enabled;
+
+public:
+    TelemetryQueue();
+
+    // 制御周期とテレメトリ周期から間引き数を決める（制御周期が上限）
+    void setRate(uint16_t control_rate_hz, uint16_t telemetry_rate_hz);
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // 今周期に積むべきか（サンプルを詰める前に判定して無駄を省く）
+    bool due();
+
+    // 制御タスク側（決してブロックしない）
+    void push(const TelemetrySample& sample) { ring.push(sample); }
+
+    // 送信タスク側
+    bool pop(TelemetrySample& sample) { return ring.pop(sample); }
+
+    uint32_t getDropCount() const { return ring.getDropCount(); }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "telemetry_writer.h"
+
+TelemetryWriter::TelemetryWriter(TelemetryQueue& queue, Stream& output)
+    : queue(queue), output(output), task(nullptr), sequence(0), sentFrames(0) {
+}
+
+bool TelemetryWriter::begin(UBaseType_t priority) {
+    if (task != nullptr) return true;
+    return xTaskCreate(taskEntry, "telemetry", STACK_SIZE, this, priority, &task) == pdPASS;
+}
+
+void TelemetryWriter::taskEntry(void* arg) {
+    TelemetryWriter* writer = static_cast<TelemetryWriter*>(arg);
+    while (true) {
+        writer->drain();
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+    }
+}
+
+void TelemetryWriter::drain() {
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    TelemetrySample sample;
+    
+    // 送信バッファに空きがある分だけ送る（溜まった分はキュー側で捨てられる）
+    while (output.availableForWrite() >= (int)TELEMETRY_MAX_FRAME && queue.pop(sample)) {
+        size_t length = encodeTelemetryFrame(sample, sequence++, frame);
+        output.write(frame, length);
+        sentFrames++;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef TELEMETRY_WRITER_H
+#define TELEMETRY_WRITER_H
+
+#include <Arduino.h>
+#include "telemetry.h"
+
+// テレメトリキューを低優先度タスクでシリアルへ送り出す
+// エンコードもこのタスクで行うため、制御周期には変換コストがかからない
+class TelemetryWriter {
+private:
+    TelemetryQueue& queue;
+    Stream& output;
+    TaskHandle_t task;
+    uint8_t sequence;
+    uint32_t sentFrames;
+
+    static const uint32_t DRAIN_INTERVAL_MS = 5;
+    static const uint32_t STACK_SIZE = 3072;
+
+    static void taskEntry(void* arg);
+    void drain();
+
+public:
+    TelemetryWriter(TelemetryQueue& queue, Stream& output);
+
+    // 送信タスクを起動（priorityは制御ループより低くする）
+    bool begin(UBaseType_t priority);
+
+    uint32_t getSentFrames() const { return sentFrames; }
+};
+
+#endif
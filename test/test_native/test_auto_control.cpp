@@ -0,0 +1,155 @@
+// AutoControl: 制御中のモード切り替えで舵が跳ばない（両方向）、加速度制御の間も間引いた姿勢推定が続く
+// （止めた場合は角度制御に戻した周期に取り直す）、
+// 制御していない間（observe）も推定を続け、制御をやめた時（resetControl）は推定を残す
+// 入力は bench modes と同じ揺れ（ピッチ20度 × 0.2 / 0.5Hz、ロール30度 × 0.2 / 0.3Hz、500Hz）
+
+#include <unity.h>
+#include <math.h>
+#include "test_suites.h"
+#include "auto_control.h"
+
+static const uint32_t PERIOD_MICROS = 2000;
+static const uint16_t CONTROL_RATE_HZ = 1000000 / PERIOD_MICROS;
+static const float SCALE = 0.2f;
+
+// tick周期目のIMU値（ノイズなし）
+static ControlInputs makeInput(int tick) {
+    float t = tick * PERIOD_MICROS * 1e-6f;
+    float pitch = 20.0f * SCALE * sinf(2 * (float)M_PI * 0.5f * t) * (float)M_PI / 180;
+    float roll = 30.0f * SCALE * sinf(2 * (float)M_PI * 0.3f * t) * (float)M_PI / 180;
+    ControlInputs in = {};
+    in.acc[0] = -sinf(pitch);
+    in.acc[1] = cosf(pitch) * sinf(roll);
+    in.acc[2] = cosf(pitch) * cosf(roll);
+    in.gyro[0] = 30.0f * SCALE * 2 * (float)M_PI * 0.3f * cosf(2 * (float)M_PI * 0.3f * t);
+    in.gyro[1] = 20.0f * SCALE * 2 * (float)M_PI * 0.5f * cosf(2 * (float)M_PI * 0.5f * t);
+    in.gyro[2] = 3.0f;
+    in.hold = tick == 0;
+    return in;
+}
+
+// fromで2秒制御してからtoに切り替え、切り替えた周期の舵の段差[%]を返す（エレベーターとラダーの大きい方）
+static float switchStep(ControlMode from, ControlMode to) {
+    AutoControl control;
+    control.begin(CONTROL_RATE_HZ);
+    control.setMode(from);
+    int tick = 0;
+    for (; tick < 1000; tick++) control.step(PERIOD_MICROS, makeInput(tick));
+    ControlOutputs before = control.getOutputs();
+    control.setMode(to);
+    const ControlOutputs& after = control.step(PERIOD_MICROS, makeInput(tick));
+    TEST_ASSERT_EQUAL_INT(to, control.getMode());
+    return fmaxf(fabsf(after.elevator.value - before.elevator.value),
+                 fabsf(after.rudder.value - before.rudder.value));
+}
+
+// 切り替えた周期は直前のモードの舵がそのまま続く（切り替え先のPIDの1周期分の積分も入らない）
+static void test_switch_accel_to_angle_is_bumpless() {
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, switchStep(CONTROL_MODE_ACCEL, CONTROL_MODE_ANGLE));
+}
+
+static void test_switch_angle_to_accel_is_bumpless() {
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, switchStep(CONTROL_MODE_ANGLE, CONTROL_MODE_ACCEL));
+}
+
+// 加速度制御の間の姿勢推定（外側ループの周期に間引く）は、毎周期更新した場合とほぼ同じ姿勢を返す
+static void test_background_attitude_tracks_full_rate() {
+    AutoControl angle, accel;
+    angle.begin(CONTROL_RATE_HZ);
+    accel.begin(CONTROL_RATE_HZ);
+    accel.setMode(CONTROL_MODE_ACCEL);
+    float maxPitch = 0, maxRoll = 0;
+    for (int tick = 0; tick < 2500; tick++) {
+        ControlInputs in = makeInput(tick);
+        angle.step(PERIOD_MICROS, in);
+        accel.step(PERIOD_MICROS, in);
+        maxPitch = fmaxf(maxPitch, fabsf(accel.getCurrentPitch() - angle.getCurrentPitch()));
+        maxRoll = fmaxf(maxRoll, fabsf(accel.getCurrentRoll() - angle.getCurrentRoll()));
+    }
+    // 間引きの周期（10ms）の間の動きは最大で 0.2 × 20度 × 2π × 0.5Hz × 10ms ≈ 0.13度
+    TEST_ASSERT_LESS_THAN_FLOAT(0.3f, maxPitch);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.3f, maxRoll);
+}
+
+// 加速度制御の間の姿勢推定を止めると姿勢は更新されず、角度制御に戻した周期に加速度から取り直す
+static void test_background_estimation_disabled_reinitializes_on_switch() {
+    AutoControl control;
+    control.begin(CONTROL_RATE_HZ);
+    control.setBackgroundEstimation(false);
+    int tick = 0;
+    for (; tick < 1000; tick++) control.step(PERIOD_MICROS, makeInput(tick));
+    control.setMode(CONTROL_MODE_ACCEL);
+    float stale = control.getCurrentPitch();
+    // 2.5秒でピッチは 0.2 × 20度 = 4度 まで動く
+    for (; tick < 1250; tick++) control.step(PERIOD_MICROS, makeInput(tick));
+    TEST_ASSERT_EQUAL_FLOAT(stale, control.getCurrentPitch());
+
+    control.setMode(CONTROL_MODE_ANGLE);
+    control.step(PERIOD_MICROS, makeInput(tick));
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 20.0f * SCALE, control.getCurrentPitch());
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, 20.0f * SCALE, control.getTargetPitch());
+}
+
+// 地上で静止（ピッチ5度、120Hzの振動、ジャイロのバイアス）している時のIMU値
+static const float GROUND_PITCH = 5.0f;
+static const float GROUND_GYRO_BIAS = 1.0f;
+
+static ControlInputs makeGroundInput(int tick) {
+    float t = tick * PERIOD_MICROS * 1e-6f;
+    float pitch = GROUND_PITCH * (float)M_PI / 180;
+    float vibration = 0.1f * sinf(2 * (float)M_PI * 120.0f * t + 0.5f);
+    ControlInputs in = {};
+    in.acc[0] = -sinf(pitch) + vibration;
+    in.acc[2] = cosf(pitch) + vibration * 0.5f;
+    in.gyro[0] = in.gyro[1] = in.gyro[2] = GROUND_GYRO_BIAS;
+    return in;
+}
+
+// パススルーの間も推定を続けるので、制御を始めた周期の目標は1サンプルの加速度（振動の分ずれる）ではなく推定した姿勢
+static void test_engage_after_observe_holds_estimated_attitude() {
+    AutoControl control;
+    control.begin(CONTROL_RATE_HZ);
+    int tick = 0;
+    for (; tick < 5000; tick++) control.observe(PERIOD_MICROS, makeGroundInput(tick));
+    ControlInputs in = makeGroundInput(tick);
+    in.hold = true;
+    control.step(PERIOD_MICROS, in);
+    TEST_ASSERT_FLOAT_WITHIN(0.3f, GROUND_PITCH, control.getTargetPitch());
+
+    // 比較: 推定していなければ、その周期の加速度だけで決まる
+    AutoControl fresh;
+    fresh.begin(CONTROL_RATE_HZ);
+    fresh.step(PERIOD_MICROS, in);
+    TEST_ASSERT_GREATER_THAN_FLOAT(1.0f, fabsf(fresh.getTargetPitch() - GROUND_PITCH));
+}
+
+// 地上の静止中にジャイロのバイアスを学習し、制御をやめてもPIDと目標値だけがリセットされる
+static void test_observe_learns_bias_and_reset_control_keeps_it() {
+    AutoControl control;
+    control.begin(CONTROL_RATE_HZ);
+    int tick = 0;
+    for (; tick < 10000; tick++) control.observe(PERIOD_MICROS, makeGroundInput(tick));
+    auto& mahony = control.getAngleMode().getAngleFilter().getMahony();
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, GROUND_GYRO_BIAS, mahony.getGyroBias(1));
+    TEST_ASSERT_TRUE(mahony.isResting());
+
+    ControlInputs in = makeGroundInput(tick++);
+    in.hold = true;
+    control.step(PERIOD_MICROS, in);
+    for (int i = 0; i < 100; i++, tick++) control.step(PERIOD_MICROS, makeGroundInput(tick));
+    float pitch = control.getCurrentPitch();
+    control.resetControl();
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, control.getTargetPitch());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, control.getElevatorOutput());
+    TEST_ASSERT_EQUAL_FLOAT(pitch, control.getCurrentPitch());
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, GROUND_GYRO_BIAS, mahony.getGyroBias(1));
+}
+
+void runAutoControlTests() {
+    RUN_TEST(test_switch_accel_to_angle_is_bumpless);
+    RUN_TEST(test_switch_angle_to_accel_is_bumpless);
+    RUN_TEST(test_background_attitude_tracks_full_rate);
+    RUN_TEST(test_background_estimation_disabled_reinitializes_on_switch);
+    RUN_TEST(test_engage_after_observe_holds_estimated_attitude);
+    RUN_TEST(test_observe_learns_bias_and_reset_control_keeps_it);
+}
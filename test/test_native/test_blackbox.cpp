@@ -0,0 +1,134 @@
+// BlackboxLog: 消去は地上（isEraseAllowed）の間だけ、1回の書き込みは1ページまで、
+// 消去済みの領域を使い切ったら捨てて数える、地上では今回の領域の中で環状に消去して前回のセッションは残す
+
+#include <unity.h>
+#include "test_suites.h"
+#include "blackbox.h"
+#include "fake_hal.h"
+
+static const uint32_t SECTOR_COUNT = 16;
+static const uint32_t SECTOR_SIZE = 4096;
+static const uint32_t RECORDS_PER_SECTOR = (SECTOR_SIZE - BLACKBOX_HEADER_SIZE) / BLACKBOX_RECORD_SIZE;
+
+// 書き込みがページの境目をまたいだ回数を数える
+class PageCheckFlash : public FakeFlashStorage {
+public:
+    uint32_t pageCrossings = 0;
+
+    PageCheckFlash() : FakeFlashStorage(SECTOR_COUNT * SECTOR_SIZE, SECTOR_SIZE) {}
+
+    bool write(uint32_t offset, const void* source, size_t length) override {
+        if (offset % FLASH_PAGE_SIZE + length > FLASH_PAGE_SIZE) pageCrossings++;
+        return FakeFlashStorage::write(offset, source, length);
+    }
+};
+
+// 20ms分（500Hzで10レコード）を積んで書き込みタスクを1回動かす
+static void serviceRecords(BlackboxQueue& queue, BlackboxLog& log, uint32_t records) {
+    for (uint32_t i = 0; i < records; i++) {
+        BlackboxSample sample = {};
+        sample.timeMicros = i * 2000;
+        queue.push(sample);
+        if (queue.size() == 10) log.service(queue);
+    }
+    log.service(queue);
+}
+
+// 消去が許されていなければ一度も消去せず、書けない分は捨てて数える
+static void test_no_erase_without_permission() {
+    PageCheckFlash flash;
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    TEST_ASSERT_TRUE(log.begin());
+    queue.setEnabled(true);
+    serviceRecords(queue, log, 100);
+    TEST_ASSERT_TRUE(log.isPrepared());
+    TEST_ASSERT_EQUAL_UINT32(0, flash.eraseCalls);
+    TEST_ASSERT_EQUAL_UINT32(0, log.getRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(100, log.getFullDrops());
+    TEST_ASSERT_EQUAL_UINT32(SECTOR_COUNT, log.getErasePending());
+}
+
+// 地上で消去した分を飛行中に使い切ったら捨て、消去はしない。地上に戻って消去が進めば続きから書く
+static void test_full_in_flight_drops_without_erasing() {
+    PageCheckFlash flash;
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    log.begin();
+    queue.setEnabled(true);
+    queue.setEraseAllowed(true);
+    log.service(queue);
+    TEST_ASSERT_EQUAL_UINT32(BlackboxLog::ERASE_STEP_SECTORS, SECTOR_COUNT - log.getErasePending());
+
+    queue.setEraseAllowed(false);
+    uint32_t erases = flash.eraseCalls;
+    serviceRecords(queue, log, RECORDS_PER_SECTOR * SECTOR_COUNT);
+    TEST_ASSERT_EQUAL_UINT32(erases, flash.eraseCalls);
+    TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SECTOR * BlackboxLog::ERASE_STEP_SECTORS, log.getRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SECTOR * (SECTOR_COUNT - BlackboxLog::ERASE_STEP_SECTORS),
+                             log.getFullDrops());
+
+    queue.setEraseAllowed(true);
+    serviceRecords(queue, log, 1);
+    TEST_ASSERT_EQUAL_UINT32(RECORDS_PER_SECTOR * BlackboxLog::ERASE_STEP_SECTORS + 1, log.getRecordCount());
+    TEST_ASSERT_FALSE(log.isFailed());
+}
+
+// 1回の書き込みは1ページの中に収まる（まとめて変換したレコードもページ毎に分けて書く）
+static void test_writes_stay_within_one_page() {
+    PageCheckFlash flash;
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    log.begin();
+    queue.setEnabled(true);
+    queue.setEraseAllowed(true);
+    for (uint32_t i = 0; i < 3 * RECORDS_PER_SECTOR; i++) {
+        BlackboxSample sample = {};
+        queue.push(sample);
+        // 1回で BATCH_RECORDS を超える量を書かせる
+        if (queue.size() == BlackboxLog::BATCH_RECORDS + 5) log.service(queue);
+    }
+    log.service(queue);
+    TEST_ASSERT_EQUAL_UINT32(3 * RECORDS_PER_SECTOR, log.getRecordCount());
+    TEST_ASSERT_EQUAL_UINT32(0, flash.pageCrossings);
+}
+
+// 地上で待つ間は今回の領域の中で環状に消去を続け、前回のセッションのセクターは消去しない
+static void test_ground_erase_wraps_and_keeps_previous_session() {
+    PageCheckFlash flash;
+    {
+        // 前回: 地上で1回消去してから離陸し、3セクター分を記録
+        BlackboxQueue queue;
+        BlackboxLog log(flash);
+        log.begin();
+        queue.setEnabled(true);
+        queue.setEraseAllowed(true);
+        log.service(queue);
+        queue.setEraseAllowed(false);
+        serviceRecords(queue, log, RECORDS_PER_SECTOR * 3);
+    }
+    std::vector<uint32_t> before = flash.eraseCounts;
+
+    BlackboxQueue queue;
+    BlackboxLog log(flash);
+    log.begin();
+    queue.setEnabled(true);
+    queue.setEraseAllowed(true);
+    // 領域（16 - 3セクター）を3周する長さ
+    serviceRecords(queue, log, RECORDS_PER_SECTOR * (SECTOR_COUNT - 3) * 3);
+    for (uint32_t i = 0; i < SECTOR_COUNT; i++) log.service(queue);
+    TEST_ASSERT_EQUAL_UINT32(0, log.getFullDrops());
+    TEST_ASSERT_EQUAL_UINT32(0, log.getErasePending());
+    uint32_t keptSectors = 0;
+    for (uint32_t i = 0; i < SECTOR_COUNT; i++) {
+        if (flash.eraseCounts[i] == before[i]) keptSectors++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, keptSectors);
+}
+
+void runBlackboxTests() {
+    RUN_TEST(test_no_erase_without_permission);
+    RUN_TEST(test_full_in_flight_drops_without_erasing);
+    RUN_TEST(test_writes_stay_within_one_page);
+    RUN_TEST(test_ground_erase_wraps_and_keeps_previous_session);
+}
@@ -0,0 +1,193 @@
+// ControlScheduler: 仮想時刻での周期、実測dt、予定時刻からの遅れ、取りこぼし時の再同期
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "control_scheduler.h"
+
+static void test_unsupported_rate_is_rejected() {
+    FakeClock clock;
+    ControlScheduler scheduler(clock, 300);
+    TEST_ASSERT_FALSE(ControlScheduler::isSupportedRate(300));
+    TEST_ASSERT_EQUAL_UINT16(100, scheduler.getRate());
+    TEST_ASSERT_FALSE(scheduler.setRate(0));
+    TEST_ASSERT_TRUE(scheduler.setRate(1000));
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getPeriodMicros());
+}
+
+static void test_first_tick_is_immediate_with_nominal_dt() {
+    FakeClock clock(12345);
+    ControlScheduler scheduler(clock, 250);
+    scheduler.begin();
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(4000, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+    TEST_ASSERT_FALSE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(4000, scheduler.getTimeUntilNextTick());
+}
+
+// 処理時間があってもwaitForTick()は予定時刻ちょうどに戻り、dtは周期のまま
+static void test_wait_for_tick_keeps_period_with_work() {
+    const uint16_t rates[] = { 100, 250, 500, 1000 };
+    for (uint16_t rate : rates) {
+        FakeClock clock(1);
+        ControlScheduler scheduler(clock, rate);
+        scheduler.begin();
+        for (int i = 0; i < 100; i++) {
+            scheduler.waitForTick();
+            if (i > 0) TEST_ASSERT_EQUAL_UINT32(1000000u / rate, scheduler.getDeltaMicros());
+            TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+            clock.advance(1000000u / rate / 3);     // 周期の1/3の処理
+        }
+        TEST_ASSERT_EQUAL_UINT32(100, scheduler.getTickCount());
+        TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount());
+        TEST_ASSERT_EQUAL_UINT32(0, scheduler.getMaxJitter());
+    }
+}
+
+// 遅れたティックはその分dtが伸び、次回は絶対時刻の予定に戻る（周期がずれない）
+static void test_late_tick_reports_jitter_and_keeps_schedule() {
+    FakeClock clock(0);
+    ControlScheduler scheduler(clock, 500);
+    scheduler.begin();
+    TEST_ASSERT_TRUE(scheduler.poll());
+
+    clock.advance(2000 + 300);
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(2300, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler.getLastJitter());
+    TEST_ASSERT_EQUAL_UINT32(1700, scheduler.getTimeUntilNextTick());
+
+    scheduler.waitForTick();
+    TEST_ASSERT_EQUAL_UINT32(4000, clock.micros());
+    TEST_ASSERT_EQUAL_UINT32(1700, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+    TEST_ASSERT_EQUAL_UINT32(300, scheduler.getMaxJitter());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount());
+}
+
+// micros()の32bitの折り返しをまたいでも周期とdtが変わらない
+static void test_dt_across_micros_wraparound() {
+    FakeClock clock(0xFFFFFFFFu - 2500);
+    ControlScheduler scheduler(clock, 1000);
+    scheduler.begin();
+    for (int i = 0; i < 10; i++) {
+        scheduler.waitForTick();
+        if (i > 0) TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getDeltaMicros());
+        TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount());
+    TEST_ASSERT_TRUE(clock.micros() < 10000);
+}
+
+// 1周期以上遅れたら取りこぼした分は実行せず、今の時刻から周期を取り直す
+static void test_overrun_drops_missed_ticks_and_resyncs() {
+    FakeClock clock(0);
+    ControlScheduler scheduler(clock, 500);
+    scheduler.begin();
+    TEST_ASSERT_TRUE(scheduler.poll());
+
+    clock.advance(2000 + 5000);     // 2.5周期の停止
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(7000, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(5000, scheduler.getLastJitter());
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getOverrunCount());
+
+    // 取りこぼした周期を続けて実行しない
+    TEST_ASSERT_FALSE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.getTimeUntilNextTick());
+    scheduler.waitForTick();
+    TEST_ASSERT_EQUAL_UINT32(9000, clock.micros());
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getOverrunCount());
+    TEST_ASSERT_EQUAL_UINT32(3, scheduler.getTickCount());
+}
+
+// 1周期未満の遅れは再同期せず、ちょうど1周期の遅れから数える
+static void test_overrun_threshold_is_one_period() {
+    FakeClock clock(0);
+    ControlScheduler scheduler(clock, 1000);
+    scheduler.begin();
+    scheduler.poll();
+    clock.advance(1000 + 999);
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount());
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getTimeUntilNextTick());
+
+    clock.advance(1 + 1000);
+    TEST_ASSERT_TRUE(scheduler.poll());
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getOverrunCount());
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getTimeUntilNextTick());
+}
+
+// 処理が毎周期の周期を超えても、待機毎に1回ずつ実行され続ける（遅れを取り戻そうと連続実行しない）
+// 遅れは1周期に達する度に再同期して捨てる（周期2000μs、処理2500μsなら4周期毎）
+static void test_sustained_overrun_runs_once_per_wait() {
+    FakeClock clock(0);
+    ControlScheduler scheduler(clock, 500);
+    scheduler.begin();
+    for (int i = 0; i < 20; i++) {
+        scheduler.waitForTick();
+        if (i > 0) TEST_ASSERT_EQUAL_UINT32(2500, scheduler.getDeltaMicros());
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(2000, scheduler.getLastJitter());
+        clock.advance(2500);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, scheduler.getTickCount());
+    TEST_ASSERT_EQUAL_UINT32(4, scheduler.getOverrunCount());
+    TEST_ASSERT_EQUAL_UINT32(2500 * 20, clock.micros());
+}
+
+// 動作中の周期変更は前回のティックから新しい周期で取り直す
+static void test_set_rate_while_running_resyncs_from_last_tick() {
+    FakeClock clock(0);
+    ControlScheduler scheduler(clock, 100);
+    scheduler.begin();
+    scheduler.poll();
+    clock.advance(300);
+    TEST_ASSERT_TRUE(scheduler.setRate(1000));
+    TEST_ASSERT_EQUAL_UINT32(700, scheduler.getTimeUntilNextTick());
+    scheduler.waitForTick();
+    TEST_ASSERT_EQUAL_UINT32(1000, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+}
+
+// 待機を途中で終わらせる時刻源（受信機の割り込みを模擬）
+class WakingClock : public FakeClock {
+public:
+    uint32_t wakeAfter = 0;     // 0以外なら次の待機をこの時間で終える
+    void delayMicros(uint32_t us) override {
+        if (wakeAfter != 0 && wakeAfter < us) us = wakeAfter;
+        wakeAfter = 0;
+        FakeClock::delayMicros(us);
+    }
+};
+
+// 起こされた時はティック前にfalseで戻り、ティックの予定とdtは変わらない
+static void test_wake_returns_before_tick_without_shifting_schedule() {
+    WakingClock clock;
+    ControlScheduler scheduler(clock, 500);
+    scheduler.begin();
+    TEST_ASSERT_TRUE(scheduler.waitForTickOrWake());
+    clock.wakeAfter = 700;
+    TEST_ASSERT_FALSE(scheduler.waitForTickOrWake());
+    TEST_ASSERT_EQUAL_UINT32(700, clock.micros());
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler.getTickCount());
+    TEST_ASSERT_TRUE(scheduler.waitForTickOrWake());
+    TEST_ASSERT_EQUAL_UINT32(2000, clock.micros());
+    TEST_ASSERT_EQUAL_UINT32(2000, scheduler.getDeltaMicros());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getLastJitter());
+}
+
+void runControlSchedulerTests() {
+    RUN_TEST(test_unsupported_rate_is_rejected);
+    RUN_TEST(test_first_tick_is_immediate_with_nominal_dt);
+    RUN_TEST(test_wait_for_tick_keeps_period_with_work);
+    RUN_TEST(test_late_tick_reports_jitter_and_keeps_schedule);
+    RUN_TEST(test_dt_across_micros_wraparound);
+    RUN_TEST(test_overrun_drops_missed_ticks_and_resyncs);
+    RUN_TEST(test_overrun_threshold_is_one_period);
+    RUN_TEST(test_sustained_overrun_runs_once_per_wait);
+    RUN_TEST(test_set_rate_while_running_resyncs_from_last_tick);
+    RUN_TEST(test_wake_returns_before_tick_without_shifting_schedule);
+}
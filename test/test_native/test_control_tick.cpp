@@ -0,0 +1,69 @@
+// runControlTick: スティックの目標値への換算（モード毎）、RC入力と制御出力の混合と±100の制限
+
+#include <unity.h>
+#include "test_suites.h"
+#include "control_tick.h"
+
+static const uint32_t PERIOD_MICROS = 2000;
+
+struct TickFixture {
+    AutoControl control;
+    RcConditioner rc;
+
+    TickFixture() {
+        control.begin(1000000 / PERIOD_MICROS);
+        rc.begin(ELEVATOR_RC_CURVE, RUDDER_RC_CURVE);
+        rc.setSmoothing(false);
+    }
+
+    // スティックのパルス幅を与えて水平・静止のIMU値で1周期
+    ControlTickOutput tick(uint16_t elevatorPulse, uint16_t rudderPulse, bool hold) {
+        RcChannelFrame frames[RC_AXIS_COUNT] = {
+            { elevatorPulse, true, 0, 20000 },
+            { rudderPulse, true, 0, 20000 },
+        };
+        rc.update(frames);
+        ControlInputs inputs = {};
+        inputs.acc[2] = 1.0f;
+        inputs.hold = hold;
+        return runControlTick(control, rc, inputs, PERIOD_MICROS);
+    }
+};
+
+// 角度制御はスティック±100%で±5度
+static void test_angle_stick_scale() {
+    TickFixture f;
+    f.tick(1500, 1500, true);
+    f.tick(2000, 1000, false);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100 * ANGLE_STICK_SCALE, f.control.getTargetPitch());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -100 * ANGLE_STICK_SCALE, f.control.getTargetYaw());
+}
+
+// 加速度制御はスティック±100%で±1g
+static void test_accel_stick_scale() {
+    TickFixture f;
+    f.control.setMode(CONTROL_MODE_ACCEL);
+    f.tick(1500, 1500, true);
+    float baseX = f.control.getTargetAccelX();
+    f.tick(2000, 1500, false);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, baseX + 100 * ACCEL_STICK_SCALE, f.control.getTargetAccelX());
+}
+
+// RC入力 + 制御出力を±100で制限する
+static void test_output_is_mixed_and_limited() {
+    TickFixture f;
+    ControlTickOutput first = f.tick(1500, 1500, true);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, f.control.getElevatorOutput(), first.elevator);
+    ControlTickOutput full = f.tick(2000, 2000, false);
+    TEST_ASSERT_EQUAL_FLOAT(CONTROL_OUTPUT_LIMIT, full.elevator);
+    TEST_ASSERT_EQUAL_FLOAT(CONTROL_OUTPUT_LIMIT, full.rudder);
+    ControlTickOutput low = f.tick(1000, 1000, false);
+    TEST_ASSERT_EQUAL_FLOAT(-CONTROL_OUTPUT_LIMIT, low.elevator);
+    TEST_ASSERT_EQUAL_FLOAT(-CONTROL_OUTPUT_LIMIT, low.rudder);
+}
+
+void runControlTickTests() {
+    RUN_TEST(test_angle_stick_scale);
+    RUN_TEST(test_accel_stick_scale);
+    RUN_TEST(test_output_is_mixed_and_limited);
+}
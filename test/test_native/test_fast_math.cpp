@@ -0,0 +1,66 @@
+// fast_math.h: 近似関数の誤差がヘッダーに書いた上限以内（定義域の走査）、境界の入力
+
+#include <unity.h>
+#include <math.h>
+#include <initializer_list>
+#include "test_suites.h"
+#include "fast_math.h"
+
+// 全周の角度を複数の半径で走査（bench math と同じ範囲）
+static void test_atan2_within_bound() {
+    double maxError = 0;
+    for (double radius : { 1e-6, 1e-3, 0.5, 1.0, 2.0, 1e3, 1e6 }) {
+        for (int i = 0; i < 360000; i++) {
+            double angle = (i - 180000) * M_PI / 180000.0;
+            float y = (float)(radius * sin(angle));
+            float x = (float)(radius * cos(angle));
+            double exact = atan2((double)y, (double)x) * 180.0 / M_PI;
+            double diff = fabs(exact - fastAtan2Deg(y, x));
+            if (diff > 180) diff = 360 - diff;  // ±180度の境界
+            if (diff > maxError) maxError = diff;
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(FAST_ATAN2_MAX_ERROR_DEG, (float)maxError);
+}
+
+// 軸上と原点は表の端をそのまま返す
+static void test_atan2_axes_and_origin() {
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastAtan2Deg(0, 0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastAtan2Deg(0, 1));
+    TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERROR_DEG, 90.0f, fastAtan2Deg(1, 0));
+    TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERROR_DEG, -90.0f, fastAtan2Deg(-1, 0));
+    TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERROR_DEG, 180.0f, fastAtan2Deg(0, -1));
+    TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERROR_DEG, 45.0f, fastAtan2Deg(2, 2));
+    TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERROR_DEG, -135.0f, fastAtan2Deg(-2, -2));
+}
+
+// 1e-6〜1e6を対数で走査（相対誤差）
+static void test_sqrt_within_bound() {
+    double invError = 0, sqrtError = 0;
+    for (double x = 1e-6; x < 1e6; x *= 1.00005) {
+        float value = (float)x;
+        double exactSqrt = sqrt((double)value);
+        double inv = fabs(fastInvSqrt(value) * exactSqrt - 1.0);
+        double root = fabs(fastSqrt(value) / exactSqrt - 1.0);
+        if (inv > invError) invError = inv;
+        if (root > sqrtError) sqrtError = root;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(FAST_INVSQRT_MAX_REL_ERROR, (float)invError);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(FAST_SQRT_MAX_REL_ERROR, (float)sqrtError);
+}
+
+// 0以下とNaNは0（正規化で0除算にならない）
+static void test_sqrt_non_positive_returns_zero() {
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastInvSqrt(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastInvSqrt(-4));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastInvSqrt(NAN));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastSqrt(0));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, fastSqrt(-4));
+}
+
+void runFastMathTests() {
+    RUN_TEST(test_atan2_within_bound);
+    RUN_TEST(test_atan2_axes_and_origin);
+    RUN_TEST(test_sqrt_within_bound);
+    RUN_TEST(test_sqrt_non_positive_returns_zero);
+}
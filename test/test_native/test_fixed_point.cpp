@@ -0,0 +1,270 @@
+// 固定小数点（Q16.16）: 基本演算の丸めと飽和、近似関数の誤差、フィルター/PIDがfloat版と許容差内で一致すること、
+// FixedMahonyEstimatorの初期姿勢
+
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include "test_suites.h"
+#include "fixed_point.h"
+#include "attitude_filter.h"
+#include "fixed_mahony_estimator.h"
+#include "pid_controller.h"
+#include "fixed_pid_controller.h"
+
+struct ImuInput {
+    float acc[3];
+    float gyro[3];
+    uint32_t dtMicros;
+};
+
+// 再現性のある乱数（テスト間で状態を共有しない）
+struct TestRandom {
+    uint32_t state;
+    explicit TestRandom(uint32_t seed) : state(seed) {}
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    float noise(float amplitude) { return amplitude * ((next() % 2001) / 1000.0f - 1.0f); }
+};
+
+// ピッチ/ロールを正弦波で振った時のIMU値（ノイズと周期の揺らぎ付き、bench fixed と同じ形）
+static std::vector<ImuInput> makeTrajectory(uint32_t periodMicros, float seconds) {
+    std::vector<ImuInput> inputs;
+    TestRandom random(1);
+    float t = 0;
+    while (t < seconds) {
+        ImuInput in;
+        in.dtMicros = periodMicros + random.next() % 41 - 20;
+        t += in.dtMicros * 1e-6f;
+        float pitch = 20.0f * sinf(2 * (float)M_PI * 0.5f * t) * (float)M_PI / 180;
+        float roll = 30.0f * sinf(2 * (float)M_PI * 0.3f * t) * (float)M_PI / 180;
+        in.acc[0] = -sinf(pitch) + random.noise(0.02f);
+        in.acc[1] = cosf(pitch) * sinf(roll) + random.noise(0.02f);
+        in.acc[2] = cosf(pitch) * cosf(roll) + random.noise(0.02f);
+        in.gyro[0] = 30.0f * 2 * (float)M_PI * 0.3f * cosf(2 * (float)M_PI * 0.3f * t) + random.noise(0.5f);
+        in.gyro[1] = 20.0f * 2 * (float)M_PI * 0.5f * cosf(2 * (float)M_PI * 0.5f * t) + random.noise(0.5f);
+        in.gyro[2] = 3.0f + random.noise(0.5f);
+        inputs.push_back(in);
+    }
+    return inputs;
+}
+
+static float maxAbs(float current, float diff) {
+    diff = fabsf(diff);
+    return diff > current ? diff : current;
+}
+
+// floatからの変換は最も近いQ16値に丸め、範囲外とNaNは飽和/0
+static void test_conversion_rounds_and_saturates() {
+    TEST_ASSERT_EQUAL_INT32(Q16_ONE, q16FromFloat(1.0f));
+    TEST_ASSERT_EQUAL_INT32(-Q16_ONE / 2, q16FromFloat(-0.5f));
+    TEST_ASSERT_EQUAL_INT32(q16Const(12.345), q16FromFloat(12.345f));
+    TEST_ASSERT_EQUAL_INT32(q16Const(-0.001), q16FromFloat(-0.001f));
+    TEST_ASSERT_EQUAL_INT32(1, q16FromFloat(1.0f / 65536.0f));
+    TEST_ASSERT_EQUAL_INT32(0, q16FromFloat(0.4f / 65536.0f));
+    TEST_ASSERT_EQUAL_INT32(Q16_MAX, q16FromFloat(40000.0f));
+    TEST_ASSERT_EQUAL_INT32(Q16_MIN, q16FromFloat(-40000.0f));
+    TEST_ASSERT_EQUAL_INT32(0, q16FromFloat(NAN));
+    TEST_ASSERT_EQUAL_FLOAT(-3.25f, q16ToFloat(q16FromFloat(-3.25f)));
+}
+
+static void test_arithmetic_saturates() {
+    TEST_ASSERT_EQUAL_INT32(q16Const(6.0), q16Mul(q16Const(2.0), q16Const(3.0)));
+    TEST_ASSERT_EQUAL_INT32(q16Const(-0.75), q16Mul(q16Const(1.5), q16Const(-0.5)));
+    TEST_ASSERT_EQUAL_INT32(Q16_MAX, q16Mul(q16Const(30000.0), q16Const(2.0)));
+    TEST_ASSERT_EQUAL_INT32(Q16_MIN, q16Mul(q16Const(30000.0), q16Const(-2.0)));
+    TEST_ASSERT_EQUAL_INT32(Q16_MAX, q16Add(q16Const(20000.0), q16Const(20000.0)));
+    TEST_ASSERT_EQUAL_INT32(Q16_MIN, q16Sub(q16Const(-20000.0), q16Const(20000.0)));
+    TEST_ASSERT_EQUAL_INT32(q16Const(2.5), q16Div(q16Const(5.0), q16Const(2.0)));
+    TEST_ASSERT_EQUAL_INT32(Q16_MAX, q16Div(q16Const(1.0), 0));
+    TEST_ASSERT_EQUAL_INT32(Q16_MIN, q16Div(q16Const(-1.0), 0));
+}
+
+// 周期は1/周期と秒（Q0.32）の両方を持ち、0と1秒以上は範囲内に止める
+static void test_time_step() {
+    Q16TimeStep step = q16TimeStep(1000);
+    TEST_ASSERT_EQUAL_UINT32(1000, step.micros);
+    TEST_ASSERT_EQUAL_INT32(q16Const(1000.0), step.rate);
+    TEST_ASSERT_EQUAL_INT32(q16Const(0.09), q16MulTime(q16Const(90.0), step));
+    TEST_ASSERT_EQUAL_UINT32(1, q16TimeStep(0).micros);
+    TEST_ASSERT_EQUAL_UINT32(999999, q16TimeStep(5000000).micros);
+}
+
+// 加速度の大きさ（約1g）以上の半径で、atan2の誤差は0.003度以内
+static void test_atan2_error_bound() {
+    double maxError = 0;
+    for (int i = 0; i < 3600; i++) {
+        double angle = (i - 1800) * M_PI / 1800.0;
+        for (double radius : { 0.5, 1.0, 2.0, 1000.0 }) {
+            float y = (float)(radius * sin(angle));
+            float x = (float)(radius * cos(angle));
+            double exact = atan2((double)y, (double)x) * 180.0 / M_PI;
+            double diff = fabs(exact - q16ToFloat(q16Atan2Deg(q16FromFloat(y), q16FromFloat(x))));
+            if (diff > 180) diff = 360 - diff;  // ±180度の境界
+            if (diff > maxError) maxError = diff;
+        }
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(0.003f, (float)maxError);
+    TEST_ASSERT_EQUAL_INT32(0, q16Atan2Deg(0, 0));
+}
+
+// 平方根は1/65536の分解能の範囲で正確（負の入力は0）
+static void test_sqrt_error_bound() {
+    double maxError = 0;
+    for (float x = 0.001f; x < 30000.0f; x *= 1.01f) {
+        q16_t value = q16FromFloat(x);
+        double diff = fabs(sqrt((double)q16ToFloat(value)) - q16ToFloat(q16Sqrt(value)));
+        if (diff > maxError) maxError = diff;
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(2e-5f, (float)maxError);
+    TEST_ASSERT_EQUAL_INT32(0, q16Sqrt(q16Const(-4.0)));
+    TEST_ASSERT_EQUAL_INT32(q16Const(3.0), q16Sqrt(q16Const(9.0)));
+}
+
+// AutoControl（角度制御）と同じ組み合わせで両方を回した時の最大差（推定器は両方とも同じ種類）
+static void checkEquivalence(uint32_t periodMicros, EstimatorType type) {
+    std::vector<ImuInput> inputs = makeTrajectory(periodMicros, 20);
+    AngleFilter floatFilter;
+    FixedAngleFilter fixedFilter;
+    floatFilter.selectEstimator(type);
+    fixedFilter.selectEstimator(type);
+    PIDController floatPitch(0.8, 0.5, 0.5), floatYaw(0.8, 0.5, 0.5);
+    FixedPIDController fixedPitch(0.8, 0.5, 0.5), fixedYaw(0.8, 0.5, 0.5);
+    floatPitch.setOutputLimits(-90, 90);
+    floatYaw.setOutputLimits(-90, 90);
+    fixedPitch.setOutputLimits(-90, 90);
+    fixedYaw.setOutputLimits(-90, 90);
+
+    float pitchDiff = 0, rollDiff = 0, yawDiff = 0, elevatorDiff = 0, rudderDiff = 0;
+    int saturated = 0, saturationMismatch = 0;
+    for (const ImuInput& in : inputs) {
+        float dt = in.dtMicros * 1e-6f;
+        Q16TimeStep step = q16TimeStep(in.dtMicros);
+        floatFilter.update(in.acc[0], in.acc[1], in.acc[2], in.gyro[0], in.gyro[1], in.gyro[2], dt);
+        fixedFilter.update(q16FromFloat(in.acc[0]), q16FromFloat(in.acc[1]), q16FromFloat(in.acc[2]),
+                           q16FromFloat(in.gyro[0]), q16FromFloat(in.gyro[1]), q16FromFloat(in.gyro[2]),
+                           step);
+
+        // 目標は水平、ヨーは0度保持（積分が溜まって飽和する）
+        float elevator = floatPitch.calculate(0, floatFilter.getSmoothPitch(), dt);
+        float rudder = floatYaw.calculate(0, floatFilter.getYaw(), dt);
+        float fixedElevator = q16ToFloat(fixedPitch.calculate(0, fixedFilter.getSmoothPitch(), step));
+        float fixedRudder = q16ToFloat(fixedYaw.calculate(0, fixedFilter.getYaw(), step));
+
+        pitchDiff = maxAbs(pitchDiff, floatFilter.getPitch() - q16ToFloat(fixedFilter.getPitch()));
+        rollDiff = maxAbs(rollDiff, floatFilter.getRoll() - q16ToFloat(fixedFilter.getRoll()));
+        yawDiff = maxAbs(yawDiff, floatFilter.getYaw() - q16ToFloat(fixedFilter.getYaw()));
+        elevatorDiff = maxAbs(elevatorDiff, elevator - fixedElevator);
+        rudderDiff = maxAbs(rudderDiff, rudder - fixedRudder);
+
+        // 制限のすぐ手前（許容差内）で判定が分かれるのは丸めの違いなので数えない
+        bool floatSaturated = fabsf(rudder) >= 90;
+        bool fixedSaturated = fabsf(fixedRudder) >= 90;
+        if (floatSaturated) saturated++;
+        if (floatSaturated != fixedSaturated && fminf(fabsf(rudder), fabsf(fixedRudder)) < 90 - 0.05f) {
+            saturationMismatch++;
+        }
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, pitchDiff);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, rollDiff);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, yawDiff);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, elevatorDiff);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, rudderDiff);
+    // 飽和する区間を含んでいて、飽和の判定が食い違わない
+    TEST_ASSERT_GREATER_THAN_INT(0, saturated);
+    TEST_ASSERT_EQUAL_INT(0, saturationMismatch);
+}
+
+static void test_filter_and_pid_match_float_100hz() {
+    checkEquivalence(10000, ESTIMATOR_COMPLEMENTARY);
+}
+
+static void test_filter_and_pid_match_float_1khz() {
+    checkEquivalence(1000, ESTIMATOR_COMPLEMENTARY);
+}
+
+static void test_mahony_and_pid_match_float_100hz() {
+    checkEquivalence(10000, ESTIMATOR_MAHONY);
+}
+
+static void test_mahony_and_pid_match_float_1khz() {
+    checkEquivalence(1000, ESTIMATOR_MAHONY);
+}
+
+// 初回の加速度から求める姿勢は、背面や垂直に近いピッチでも正確（Q16に落とさずQ30で計算する）
+static void test_fixed_mahony_initial_attitude() {
+    float maxError = 0;
+    for (int roll = -180; roll <= 180; roll += 5) {
+        for (int pitch = -85; pitch <= 85; pitch += 5) {
+            double r = roll * M_PI / 180, p = pitch * M_PI / 180;
+            FixedMahonyEstimator estimator;
+            estimator.update(q16FromFloat((float)-sin(p)), q16FromFloat((float)(cos(p) * sin(r))),
+                             q16FromFloat((float)(cos(p) * cos(r))), 0, 0, 0, q16TimeStep(2000));
+            float rollError = fabsf(q16ToFloat(estimator.getRoll()) - roll);
+            if (rollError > 180) rollError = 360 - rollError;  // ±180度の境界
+            maxError = maxAbs(maxError, rollError);
+            maxError = maxAbs(maxError, q16ToFloat(estimator.getPitch()) - pitch);
+            TEST_ASSERT_EQUAL_INT32(0, estimator.getYaw());
+        }
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, maxError);
+}
+
+// 微分フィルター、フィードフォワード、出力制限、積分の上限を使った時もfloat版と同じ出力
+static void test_pid_options_match_float() {
+    PIDController floatPid(1.2f, 0.8f, 0.05f);
+    FixedPIDController fixedPid(1.2f, 0.8f, 0.05f);
+    floatPid.setOutputLimits(-30, 30);
+    fixedPid.setOutputLimits(-30, 30);
+    floatPid.setFeedForward(0.3f);
+    fixedPid.setFeedForward(0.3f);
+    floatPid.setIntegralLimit(10);
+    fixedPid.setIntegralLimit(10);
+    floatPid.setDerivativeFilter(DERIVATIVE_FILTER_BIQUAD, 30, 500);
+    fixedPid.setDerivativeFilter(DERIVATIVE_FILTER_BIQUAD, 30, 500);
+
+    TestRandom random(7);
+    Q16TimeStep step = q16TimeStep(2000);
+    float input = 0, maxDiff = 0;
+    for (int i = 0; i < 5000; i++) {
+        // 目標は2秒毎に±40度の間で切り替え（出力が制限に当たる）
+        float setpoint = (i / 1000) % 2 ? -40.0f : 40.0f;
+        float floatOut = floatPid.calculate(setpoint, input, 0.002f);
+        float fixedOut = q16ToFloat(fixedPid.calculate(q16FromFloat(setpoint), q16FromFloat(input), step));
+        maxDiff = maxAbs(maxDiff, floatOut - fixedOut);
+        // 1次遅れの対象（測定ノイズ付き）
+        input += (floatOut - input) * 0.02f + random.noise(0.2f);
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, maxDiff);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, floatPid.getIntegral(), fixedPid.getIntegral());
+}
+
+// presetの後の最初の出力はfloat版と同じく指定した出力から続く
+static void test_preset_matches_float() {
+    PIDController floatPid(0.8f, 0.5f, 0.5f);
+    FixedPIDController fixedPid(0.8f, 0.5f, 0.5f);
+    floatPid.setOutputLimits(-90, 90);
+    fixedPid.setOutputLimits(-90, 90);
+    floatPid.preset(25, 5, -3);
+    fixedPid.preset(q16Const(25.0), q16Const(5.0), q16Const(-3.0));
+    float floatOut = floatPid.calculate(5, -3, 0.01f);
+    float fixedOut = q16ToFloat(fixedPid.calculate(q16Const(5.0), q16Const(-3.0), q16TimeStep(10000)));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, floatOut, fixedOut);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 25.0f, fixedOut);
+}
+
+void runFixedPointTests() {
+    RUN_TEST(test_conversion_rounds_and_saturates);
+    RUN_TEST(test_arithmetic_saturates);
+    RUN_TEST(test_time_step);
+    RUN_TEST(test_atan2_error_bound);
+    RUN_TEST(test_sqrt_error_bound);
+    RUN_TEST(test_filter_and_pid_match_float_100hz);
+    RUN_TEST(test_filter_and_pid_match_float_1khz);
+    RUN_TEST(test_mahony_and_pid_match_float_100hz);
+    RUN_TEST(test_mahony_and_pid_match_float_1khz);
+    RUN_TEST(test_fixed_mahony_initial_attitude);
+    RUN_TEST(test_pid_options_match_float);
+    RUN_TEST(test_preset_matches_float);
+}
@@ -0,0 +1,114 @@
+// I2CBusManager: 低い優先度の書き込みは空き時間に収まる分だけ流し、空き時間が足りない時も
+// 予約の枠（優先度の高いトランザクションN回毎に1回）で表示が止まり続けない
+// MockI2CBus（src/host/fake_hal.h）の見積もりで仮想時刻を進める
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "control_scheduler.h"
+#include "i2c_bus_manager.h"
+
+static const uint8_t IMU_ADDRESS = 0x68;
+static const uint8_t DISPLAY_ADDRESS = 0x3C;
+
+struct ManagerFixture {
+    FakeClock clock;
+    MockI2CBus bus;
+    I2CBusManager manager;
+    ManagedI2CBus imuBus;
+    ManagedI2CBus displayBus;
+
+    ManagerFixture()
+        : clock(1), bus(clock), manager(bus, clock),
+          imuBus(manager, "imu", I2C_PRIORITY_HIGH, 1),
+          displayBus(manager, "display", I2C_PRIORITY_LOW, 1) {
+        bus.attach(IMU_ADDRESS, nullptr);
+        bus.attach(DISPLAY_ADDRESS, nullptr);
+    }
+
+    void imuTransaction() {
+        const uint8_t data[2] = { 0x3B, 0 };
+        imuBus.write(IMU_ADDRESS, data, sizeof(data));
+    }
+
+    void submitDisplay(int count) {
+        uint8_t data[25] = { 0x40 };
+        for (int i = 0; i < count; i++) displayBus.submitWrite(DISPLAY_ADDRESS, data, sizeof(data), 200000);
+    }
+};
+
+// 空き時間に収まる分だけ流し、収まらなければ積んだまま
+static void test_poll_respects_budget() {
+    ManagerFixture f;
+    f.submitDisplay(3);
+    uint32_t one = f.manager.estimateMicros(25);
+    f.manager.poll(one + one / 2);
+    TEST_ASSERT_EQUAL_UINT8(2, f.displayBus.getPendingCount());
+    f.manager.poll(0);
+    TEST_ASSERT_EQUAL_UINT8(2, f.displayBus.getPendingCount());
+    f.manager.poll(one * 2);
+    TEST_ASSERT_EQUAL_UINT8(0, f.displayBus.getPendingCount());
+}
+
+// 予約なしでは空き時間がない限り流さない。予約ありではN回毎に1回だけ流す
+static void test_reserve_runs_one_write_every_n_high_transactions() {
+    ManagerFixture f;
+    f.submitDisplay(4);
+    for (int i = 0; i < 10; i++) {
+        f.imuTransaction();
+        f.manager.poll(0);
+    }
+    TEST_ASSERT_EQUAL_UINT8(4, f.displayBus.getPendingCount());
+
+    f.manager.setLowPriorityReserve(5);
+    // 既にN回を超えているので次のpollで1回
+    f.manager.poll(0);
+    TEST_ASSERT_EQUAL_UINT8(3, f.displayBus.getPendingCount());
+    f.manager.poll(0);
+    TEST_ASSERT_EQUAL_UINT8(3, f.displayBus.getPendingCount());
+    for (int i = 0; i < 4; i++) {
+        f.imuTransaction();
+        f.manager.poll(0);
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, f.displayBus.getPendingCount());
+    f.imuTransaction();
+    f.manager.poll(0);
+    TEST_ASSERT_EQUAL_UINT8(2, f.displayBus.getPendingCount());
+    TEST_ASSERT_EQUAL_UINT32(2, f.manager.getReservedCount());
+}
+
+// 1kHz制御（IMUの読み出しと制御処理で空き時間が1トランザクションより短い）で表示を送り続ける
+// 予約の枠20回で、表示の書き込みは期限切れにならず、要求からの遅れに上限がある
+static void test_display_latency_bounded_at_1khz() {
+    ManagerFixture f;
+    const uint16_t reserve = 20;
+    const uint32_t period = 1000;
+    const uint8_t pageWrites = 6;
+    f.manager.setLowPriorityReserve(reserve);
+    ControlScheduler scheduler(f.clock, 1000);
+    scheduler.begin();
+    f.manager.resetStats();
+
+    for (int i = 0; i < 3000; i++) {
+        scheduler.waitForTick();
+        f.imuTransaction();
+        f.clock.advance(800);   // IMUの読み出し以外の制御処理
+        if (f.displayBus.getPendingCount() == 0) f.submitDisplay(pageWrites);
+        uint32_t idle = scheduler.getTimeUntilNextTick();
+        f.manager.poll(idle > 100 ? idle - 100 : 0);
+    }
+
+    const I2CDeviceStats& display = f.manager.getStats(f.displayBus.getDevice());
+    TEST_ASSERT_EQUAL_UINT32(0, display.expired);
+    TEST_ASSERT_GREATER_THAN_UINT32(100, display.transactions);
+    // 1ページ（6回）の最後の書き込みは、約 6 × 20周期 で終わる
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(pageWrites * (reserve + 1) * period, display.maxLatencyMicros);
+    // 枠で流した周期の次の周期は遅れるが、1周期以上は遅れない（再同期しない）
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getOverrunCount());
+}
+
+void runI2CBusManagerTests() {
+    RUN_TEST(test_poll_respects_budget);
+    RUN_TEST(test_reserve_runs_one_write_every_n_high_transactions);
+    RUN_TEST(test_display_latency_bounded_at_1khz);
+}
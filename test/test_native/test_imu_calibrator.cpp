@@ -0,0 +1,160 @@
+// ImuCalibrator: 地上（setRefineEnabled）の静止区間だけで補正値を更新し、角速度のオフセットは少しずつ移す
+// FakeMpu6050Bus（src/host/fake_hal.h）に一定の値を入れ、制御周期（500Hz）毎に読む
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "mpu6050_driver.h"
+#include "imu_calibrator.h"
+
+static const float DT = 0.002f;
+
+// 保存先（最後に保存した値を持つ）
+class MemoryCalibrationStore : public CalibrationStore {
+public:
+    bool hasValue = false;
+    ImuCalibration value = {};
+    int saves = 0;
+
+    bool load(ImuCalibration& calibration) override {
+        if (!hasValue) return false;
+        calibration = value;
+        return true;
+    }
+    void save(const ImuCalibration& calibration) override {
+        value = calibration;
+        hasValue = true;
+        saves++;
+    }
+};
+
+struct CalibratorFixture {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu;
+    MemoryCalibrationStore store;
+    ImuCalibrator calibrator;
+
+    CalibratorFixture() : imu(bus), calibrator(imu, store) {
+        Mpu6050Config config = { 3, 0, false, -1 };
+        imu.probe(Mpu6050Driver::ADDRESS_LOW);
+        imu.begin(Mpu6050Driver::ADDRESS_LOW, config);
+    }
+
+    void storeGyroOffset(float x, float y, float z) {
+        store.value.version = ImuCalibration::VERSION;
+        store.value.gyroOffset[0] = x;
+        store.value.gyroOffset[1] = y;
+        store.value.gyroOffset[2] = z;
+        store.value.temperature = 30;
+        store.hasValue = true;
+    }
+
+    // 水平に置いて一定の角速度（補正前の値）を出し続ける
+    void run(float seconds, const float gyro[3]) {
+        const float acc[3] = { 0, 0, 1 };
+        for (int i = 0; i < (int)(seconds / DT + 0.5f); i++) {
+            bus.pushSample(acc, gyro, 30.0f);
+            imu.update();
+            calibrator.update(DT);
+        }
+    }
+};
+
+// 地上でなければ、静止していても補正値を更新しない（一定の旋回を取り込まない）
+static void test_no_refine_unless_enabled() {
+    CalibratorFixture f;
+    const float gyro[3] = { 2.0f, -1.0f, 0.5f };
+    f.run(5.0f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(0, f.calibrator.getRefineCount());
+    TEST_ASSERT_EQUAL_INT(0, f.store.saves);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, f.imu.getGyroOffset(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.0f, f.imu.getGyroX());
+}
+
+// 地上の静止区間で求めて保存し、適用はOFFSET_RAMP_RATEで少しずつ
+static void test_refine_on_ground_and_ramp_in() {
+    CalibratorFixture f;
+    f.calibrator.setRefineEnabled(true);
+    const float gyro[3] = { 2.0f, -1.0f, 0.5f };
+    f.run(ImuCalibrator::WINDOW_SECONDS + 0.01f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(1, f.calibrator.getRefineCount());
+    TEST_ASSERT_EQUAL_INT(1, f.store.saves);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.0f, f.store.value.gyroOffset[0]);
+    // 求めた直後はほとんど動いていない
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, f.calibrator.getAppliedGyroOffset(0));
+
+    f.run(1.0f, gyro);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, ImuCalibrator::OFFSET_RAMP_RATE, f.calibrator.getAppliedGyroOffset(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -ImuCalibrator::OFFSET_RAMP_RATE, f.calibrator.getAppliedGyroOffset(1));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.5f, f.calibrator.getAppliedGyroOffset(2));
+
+    // 2.0 / 0.5 = 4秒で移り終わる
+    f.run(3.5f, gyro);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 2.0f, f.imu.getGyroOffset(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -1.0f, f.imu.getGyroOffset(1));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, f.imu.getGyroX());
+}
+
+// 保存済みの値は起動時にそのまま適用し、更新分だけ少しずつ移す
+static void test_stored_offset_applied_at_begin_then_ramped() {
+    CalibratorFixture f;
+    f.storeGyroOffset(1.0f, 0, 0);
+    TEST_ASSERT_TRUE(f.calibrator.begin());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, f.imu.getGyroOffset(0));
+
+    f.calibrator.setRefineEnabled(true);
+    const float gyro[3] = { 2.5f, 0, 0 };
+    f.run(ImuCalibrator::WINDOW_SECONDS + 0.01f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(1, f.calibrator.getRefineCount());
+    f.run(1.0f, gyro);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.0f + ImuCalibrator::OFFSET_RAMP_RATE, f.imu.getGyroOffset(0));
+}
+
+// 地上でなくなった時点で集計中の区間は捨てる（前後の区間をつながない）
+static void test_disable_discards_window() {
+    CalibratorFixture f;
+    const float gyro[3] = { 1.0f, 0, 0 };
+    f.calibrator.setRefineEnabled(true);
+    f.run(ImuCalibrator::WINDOW_SECONDS * 0.75f, gyro);
+    f.calibrator.setRefineEnabled(false);
+    f.run(1.0f, gyro);
+    f.calibrator.setRefineEnabled(true);
+    f.run(ImuCalibrator::WINDOW_SECONDS * 0.75f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(0, f.calibrator.getRefineCount());
+    f.run(ImuCalibrator::WINDOW_SECONDS * 0.3f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(1, f.calibrator.getRefineCount());
+}
+
+// 保存済みの値から大きく離れる区間は旋回とみなして捨てる
+static void test_large_jump_rejected() {
+    CalibratorFixture f;
+    f.storeGyroOffset(0, 0, 0);
+    f.calibrator.begin();
+    f.calibrator.setRefineEnabled(true);
+    const float gyro[3] = { 0, 0, ImuCalibrator::MAX_OFFSET_JUMP + 1.0f };
+    f.run(ImuCalibrator::WINDOW_SECONDS * 2, gyro);
+    TEST_ASSERT_EQUAL_UINT32(0, f.calibrator.getRefineCount());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, f.imu.getGyroOffset(2));
+}
+
+// 水平補正の要求（シリアルの 'c'）は地上の判定によらず次の静止区間で行う
+static void test_level_request_bypasses_gate() {
+    CalibratorFixture f;
+    f.calibrator.requestLevelCalibration();
+    const float gyro[3] = { 0.2f, 0, 0 };
+    f.run(ImuCalibrator::WINDOW_SECONDS + 0.01f, gyro);
+    TEST_ASSERT_EQUAL_UINT32(1, f.calibrator.getRefineCount());
+    TEST_ASSERT_EQUAL_INT(1, f.store.saves);
+    // 要求を使い切った後は、地上でなければ集計しない
+    f.run(ImuCalibrator::WINDOW_SECONDS * 2, gyro);
+    TEST_ASSERT_EQUAL_UINT32(1, f.calibrator.getRefineCount());
+}
+
+void runImuCalibratorTests() {
+    RUN_TEST(test_no_refine_unless_enabled);
+    RUN_TEST(test_refine_on_ground_and_ramp_in);
+    RUN_TEST(test_stored_offset_applied_at_begin_then_ramped);
+    RUN_TEST(test_disable_discards_window);
+    RUN_TEST(test_large_jump_rejected);
+    RUN_TEST(test_level_request_bypasses_gate);
+}
@@ -0,0 +1,27 @@
+// ホスト（native環境）の単体テスト
+// 実行: pio test -e native
+// 制御コードは実機と同じソースを、src/host/fake_hal.h の仮想HAL（仮想時間）で動かす
+
+#include <unity.h>
+#include "test_suites.h"
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    runControlSchedulerTests();
+    runRcReceiverTests();
+    runServoOutputTests();
+    runRcProtocolTests();
+    runMpu6050DriverTests();
+    runFixedPointTests();
+    runFastMathTests();
+    runPidControllerTests();
+    runAutoControlTests();
+    runControlTickTests();
+    runImuCalibratorTests();
+    runI2CBusManagerTests();
+    runBlackboxTests();
+    return UNITY_END();
+}
@@ -0,0 +1,253 @@
+// Mpu6050Driver: 14バイトの変換、レジスタの一括読み出し、FIFOの読み出しと平均、あふれた時の再開、
+// INTが来ない時のポーリングへの切り替え、新しいサンプルが止まった時の検出
+// FakeMpu6050Bus（src/host/fake_hal.h）のレジスタとFIFOを通して読む
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "mpu6050_driver.h"
+
+static bool beginDriver(Mpu6050Driver& imu, bool useFifo) {
+    Mpu6050Config config = { 3, 0, useFifo, -1 };
+    return imu.probe(Mpu6050Driver::ADDRESS_LOW) && imu.begin(Mpu6050Driver::ADDRESS_LOW, config);
+}
+
+// 加速度XYZ、温度、角速度XYZの順のビッグエンディアン
+static void test_decode_burst_layout_and_scale() {
+    const uint8_t raw[Mpu6050Driver::BURST_SIZE] = {
+        0x40, 0x00,     // acc x  16384 → 1g
+        0xC0, 0x00,     // acc y -16384 → -1g
+        0x20, 0x00,     // acc z   8192 → 0.5g
+        0x00, 0x00,     // temp 0 → 36.53℃
+        0x00, 0x83,     // gyro x  131 → 2deg/s
+        0xFF, 0x7D,     // gyro y -131 → -2deg/s
+        0x7F, 0xFF,     // gyro z 32767
+    };
+    Mpu6050Sample s;
+    Mpu6050Driver::decodeBurst(raw, s);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, s.acc[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, s.acc[1]);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, s.acc[2]);
+    TEST_ASSERT_EQUAL_FLOAT(36.53f, s.temp);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, s.gyro[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, s.gyro[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 500.25f, s.gyro[2]);
+}
+
+static void test_probe_checks_who_am_i() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(imu.probe(Mpu6050Driver::ADDRESS_LOW));
+    TEST_ASSERT_FALSE(imu.probe(Mpu6050Driver::ADDRESS_HIGH));
+}
+
+// FIFOなしは最新のレジスタ値を1回の読み出しで取る
+static void test_burst_mode_reads_latest_registers() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, false));
+    const float acc[3] = { 0.25f, -0.5f, 1.0f };
+    const float gyro[3] = { 10, -20, 30 };
+    bus.pushSample(acc, gyro, 30.0f);
+    uint32_t before = bus.transactions;
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT32(1, bus.transactions - before);
+    TEST_ASSERT_EQUAL_UINT8(1, imu.getLastSampleCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f, imu.getAccX());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.5f, imu.getAccY());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 10, imu.getGyroX());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -20, imu.getGyroY());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 30, imu.getGyroZ());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 30, imu.getTemp());
+}
+
+// 周期の間に溜まったサンプルを全て読み、平均する（加速度・温度・角速度の並びが崩れない）
+static void test_fifo_averages_queued_samples_in_order() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, true));
+    for (int i = 0; i < 4; i++) {
+        const float acc[3] = { 0.1f * i, -0.1f * i, 1.0f };
+        const float gyro[3] = { 1.0f * i, 2.0f * i, -3.0f * i };
+        bus.pushSample(acc, gyro, 20.0f + i);
+    }
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT8(4, imu.getLastSampleCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.15f, imu.getAccX());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -0.15f, imu.getAccY());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, imu.getAccZ());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.5f, imu.getGyroX());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 3.0f, imu.getGyroY());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -4.5f, imu.getGyroZ());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.5f, imu.getTemp());
+
+    // 次の周期は新しいサンプルだけ（前の周期の残りが混ざらない）
+    const float acc[3] = { -0.5f, 0.5f, 0.75f };
+    const float gyro[3] = { 100, 0, -100 };
+    bus.pushSample(acc, gyro, 25.0f);
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT8(1, imu.getLastSampleCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.5f, imu.getAccX());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -100, imu.getGyroZ());
+
+    // 空なら値はそのまま
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT8(0, imu.getLastSampleCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.5f, imu.getAccX());
+    TEST_ASSERT_EQUAL_UINT32(0, imu.getReadErrors());
+}
+
+// 1トランザクションの上限（8サンプル）を超える分は分けて読む
+static void test_fifo_reads_in_chunks() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, true));
+    for (int i = 0; i < 12; i++) {
+        const float acc[3] = { 0, 0, 1.0f };
+        const float gyro[3] = { (float)i, 0, 0 };
+        bus.pushSample(acc, gyro, 25.0f);
+    }
+    uint32_t before = bus.transactions;
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT8(12, imu.getLastSampleCount());
+    TEST_ASSERT_EQUAL_UINT32(3, bus.transactions - before);   // カウント + 8 + 4
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 5.5f, imu.getGyroX());
+}
+
+// あふれたらFIFOを捨てて再開し、以降のサンプルの境界は揃っている
+static void test_fifo_overflow_resets_and_realigns() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, true));
+    const float acc[3] = { 0, 0, 1.0f };
+    const float gyro[3] = { 7, 7, 7 };
+    for (int i = 0; i < 80; i++) bus.pushSample(acc, gyro, 25.0f);
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT32(1, imu.getFifoOverflows());
+    TEST_ASSERT_EQUAL_UINT8(0, imu.getLastSampleCount());
+
+    const float acc2[3] = { 0.5f, 0.25f, 0.75f };
+    const float gyro2[3] = { -8, 16, -32 };
+    bus.pushSample(acc2, gyro2, 25.0f);
+    bus.pushSample(acc2, gyro2, 25.0f);
+    imu.update();
+    TEST_ASSERT_EQUAL_UINT8(2, imu.getLastSampleCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, imu.getAccX());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f, imu.getAccY());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.75f, imu.getAccZ());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -8, imu.getGyroX());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 16, imu.getGyroY());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, -32, imu.getGyroZ());
+    TEST_ASSERT_EQUAL_UINT32(1, imu.getFifoOverflows());
+}
+
+// オフセットは読み出し値から引く
+static void test_offsets_are_subtracted() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, true));
+    imu.setGyroOffsets(1, -2, 3);
+    imu.setAccelOffsets(0.05f, 0, -0.05f);
+    const float acc[3] = { 0.05f, 0, 0.95f };
+    const float gyro[3] = { 1, -2, 3 };
+    bus.pushSample(acc, gyro, 25.0f);
+    imu.update();
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0, imu.getAccX());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, imu.getAccZ());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, imu.getGyroX());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, imu.getGyroY());
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, imu.getGyroZ());
+}
+
+static const int INT_PIN = 3;
+
+// INT付きで初期化（wiredならFakeMpu6050BusのサンプルでINTのパルスが出る）
+struct InterruptFixture {
+    FakeClock clock;
+    FakePwmInput pwmInput;
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu;
+
+    InterruptFixture(bool wired) : clock(1), pwmInput(clock), imu(bus) {
+        if (wired) {
+            bus.interruptInput = &pwmInput;
+            bus.interruptPin = INT_PIN;
+        }
+        Mpu6050Config config = { 3, 0, true, INT_PIN };
+        imu.probe(Mpu6050Driver::ADDRESS_LOW);
+        imu.begin(Mpu6050Driver::ADDRESS_LOW, config, &pwmInput);
+    }
+
+    void push(float accX) {
+        const float acc[3] = { accX, 0, 1 };
+        const float gyro[3] = { 0, 0, 0 };
+        bus.pushSample(acc, gyro, 25.0f);
+    }
+};
+
+// INTが来ていれば割り込みのまま（データのない周期はINT_STATUSを見るだけでFIFOを読まない）
+static void test_interrupt_wired_keeps_interrupt() {
+    InterruptFixture f(true);
+    for (int i = 0; i < 20; i++) {
+        f.push(0.01f * i);
+        f.imu.update();
+        TEST_ASSERT_EQUAL_UINT8(1, f.imu.getLastSampleCount());
+        // 制御周期がサンプルより速い時の空の周期
+        f.imu.update();
+        f.imu.update();
+    }
+    TEST_ASSERT_FALSE(f.imu.isInterruptFallback());
+    uint32_t before = f.bus.transactions;
+    f.imu.update();
+    TEST_ASSERT_EQUAL_UINT32(before + 1, f.bus.transactions);
+    TEST_ASSERT_EQUAL_UINT8(0, f.imu.getLastSampleCount());
+}
+
+// INTが配線されていなければ、切り替えるまでの周期もデータを読み、INTERRUPT_MISS_LIMIT回でポーリングにする
+static void test_interrupt_missing_falls_back_to_polling() {
+    InterruptFixture f(false);
+    for (int i = 0; i < 10; i++) {
+        f.push(0.1f * (i + 1));
+        f.imu.update();
+        TEST_ASSERT_EQUAL_UINT8(1, f.imu.getLastSampleCount());
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.1f * (i + 1), f.imu.getAccX());
+        TEST_ASSERT_EQUAL(i + 1 >= Mpu6050Driver::INTERRUPT_MISS_LIMIT, f.imu.isInterruptFallback());
+    }
+    TEST_ASSERT_FALSE(f.imu.isStale(1000));
+}
+
+// 新しいサンプルがサンプル周期のSTALE_SAMPLE_PERIODS倍の間なければ止まったとみなし、届けば戻る
+static void test_stale_when_samples_stop() {
+    FakeMpu6050Bus bus;
+    Mpu6050Driver imu(bus);
+    TEST_ASSERT_TRUE(beginDriver(imu, true));
+    TEST_ASSERT_EQUAL_UINT32(1000, imu.getSamplePeriodMicros());
+    const float acc[3] = { 0, 0, 1 };
+    const float gyro[3] = { 0, 0, 0 };
+    for (int i = 0; i < 10; i++) {
+        bus.pushSample(acc, gyro, 25.0f);
+        imu.update();
+    }
+    TEST_ASSERT_FALSE(imu.isStale(2000));
+    imu.update();
+    imu.update();
+    TEST_ASSERT_FALSE(imu.isStale(2000));
+    imu.update();
+    TEST_ASSERT_TRUE(imu.isStale(2000));
+    bus.pushSample(acc, gyro, 25.0f);
+    imu.update();
+    TEST_ASSERT_FALSE(imu.isStale(2000));
+}
+
+void runMpu6050DriverTests() {
+    RUN_TEST(test_decode_burst_layout_and_scale);
+    RUN_TEST(test_probe_checks_who_am_i);
+    RUN_TEST(test_burst_mode_reads_latest_registers);
+    RUN_TEST(test_fifo_averages_queued_samples_in_order);
+    RUN_TEST(test_fifo_reads_in_chunks);
+    RUN_TEST(test_fifo_overflow_resets_and_realigns);
+    RUN_TEST(test_offsets_are_subtracted);
+    RUN_TEST(test_interrupt_wired_keeps_interrupt);
+    RUN_TEST(test_interrupt_missing_falls_back_to_polling);
+    RUN_TEST(test_stale_when_samples_stop);
+}
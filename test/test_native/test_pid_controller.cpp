@@ -0,0 +1,191 @@
+// PIDController: 目標値のステップで微分が跳ねない、押さえられた後の行き過ぎと整定、微分フィルターのノイズ抑制、
+// ki = 0、フィードフォワード、presetでの引き継ぎ、積分の上限
+// 模擬機体は bench pid と同じ（舵[%] → ピッチ角速度（1次遅れ）→ ピッチ角、500Hz）
+
+#include <unity.h>
+#include <math.h>
+#include "test_suites.h"
+#include "pid_controller.h"
+#include "legacy_pid.h"
+
+static const float DT = 0.002f;
+static const float PLANT_GAIN = 4.0f;     // 舵1%あたりの角速度[deg/s]
+static const float PLANT_TAU = 0.15f;     // 角速度の遅れ[秒]
+
+struct Plant {
+    float rate = 0;
+    float angle = 0;
+
+    void step(float u) {
+        rate += (PLANT_GAIN * u - rate) * DT / PLANT_TAU;
+        angle += rate * DT;
+    }
+};
+
+// 再現性のある正規乱数（Box-Muller）
+struct GaussianNoise {
+    uint32_t state = 7;
+    float uniform() {
+        state = state * 1664525u + 1013904223u;
+        return ((state >> 8) + 1.0f) / 16777218.0f;
+    }
+    float next() {
+        float u1 = uniform(), u2 = uniform();
+        return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+    }
+};
+
+struct Response {
+    float kick = 0;         // 目標が変わった周期の舵の変化[%]
+    float overshoot = 0;    // 目標を越えた量[度]
+    float settleTime = -1;  // 目標の±2%（最低0.2度）に入ったまま出なくなった時刻[秒]
+    float outputStd = 0;    // 舵の標準偏差[%]
+};
+
+// 目標 0 → finalTarget（stepTimeで切り替え）。releaseTimeまでは機体を押さえておく
+template <typename Controller>
+static Response simulate(Controller& pid, float finalTarget, float stepTime, float seconds,
+                         float noise = 0, float releaseTime = 0) {
+    Response r;
+    Plant plant;
+    GaussianNoise gaussian;
+    float previousOutput = 0, previousTarget = 0;
+    float band = fmaxf(fabsf(finalTarget) * 0.02f, 0.2f);
+    double sum = 0, sumSquared = 0;
+    int count = 0;
+    for (int i = 0; i * DT < seconds; i++) {
+        float t = i * DT;
+        float sp = t < stepTime ? 0.0f : finalTarget;
+        float u = pid.calculate(sp, plant.angle + noise * gaussian.next(), DT);
+        if (sp != previousTarget) r.kick = fmaxf(r.kick, fabsf(u - previousOutput));
+        if (t >= releaseTime) plant.step(u);
+        if (t >= stepTime) {
+            r.overshoot = fmaxf(r.overshoot, plant.angle - finalTarget);
+            if (fabsf(plant.angle - finalTarget) > band) r.settleTime = -1;
+            else if (r.settleTime < 0) r.settleTime = t;
+        }
+        sum += u;
+        sumSquared += (double)u * u;
+        count++;
+        previousOutput = u;
+        previousTarget = sp;
+    }
+    double mean = sum / count;
+    r.outputStd = (float)sqrt(fmax(sumSquared / count - mean * mean, 0.0));
+    return r;
+}
+
+static PIDController makePid(float limit, DerivativeFilterType filter = DERIVATIVE_FILTER_NONE) {
+    PIDController pid(0.8f, 0.5f, 0.5f);
+    pid.setOutputLimits(-limit, limit);
+    pid.setDerivativeFilter(filter, 30.0f, 1.0f / DT);
+    return pid;
+}
+
+// 目標値が跳んだ周期の舵の変化はP（と1周期分のI）だけ。以前の実装は誤差の微分で制限まで跳ねた
+static void test_no_derivative_kick_on_setpoint_step() {
+    PIDController pid = makePid(90);
+    Response r = simulate(pid, 15.0f, 0.5f, 1.0f);
+    float expected = 0.8f * 15.0f + 0.5f * 15.0f * DT;
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, expected, r.kick);
+
+    LegacyPIDController legacy(0.8f, 0.5f, 0.5f);
+    legacy.setOutputLimits(-90, 90);
+    TEST_ASSERT_GREATER_THAN_FLOAT(80.0f, simulate(legacy, 15.0f, 0.5f, 1.0f).kick);
+}
+
+// 測定値が変わらない周期は微分項が0
+static void test_derivative_is_on_measurement() {
+    PIDController pid = makePid(90);
+    pid.calculate(0, 3, DT);
+    pid.calculate(20, 3, DT);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, pid.getLastD());
+    pid.calculate(20, 3.1f, DT);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -0.5f * 0.1f / DT, pid.getLastD());
+}
+
+// 機体を5秒押さえたまま目標15度（舵の制限30%）。積分の上限をトリム分に絞ると、
+// 放した後の行き過ぎは通常のステップと同程度で、12秒以内に整定する
+static void test_windup_overshoot_is_bounded_and_settles() {
+    PIDController step = makePid(30);
+    Response normal = simulate(step, 15.0f, 0.5f, 12.0f);
+
+    PIDController held = makePid(30);
+    held.setIntegralLimit(5.0f);
+    Response r = simulate(held, 15.0f, 0.5f, 12.0f, 0, 5.0f);
+    TEST_ASSERT_LESS_THAN_FLOAT(5.0f, r.overshoot);
+    TEST_ASSERT_LESS_THAN_FLOAT(normal.overshoot + 1.0f, r.overshoot);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, r.settleTime);
+    TEST_ASSERT_LESS_THAN_FLOAT(11.0f, r.settleTime);
+
+    // 上限なしでもバックカリキュレーションで以前の実装より行き過ぎが小さい
+    LegacyPIDController legacy(0.8f, 0.5f, 0.5f);
+    legacy.setOutputLimits(-30, 30);
+    PIDController unlimited = makePid(30);
+    float legacyOvershoot = simulate(legacy, 15.0f, 0.5f, 12.0f, 0, 5.0f).overshoot;
+    TEST_ASSERT_LESS_THAN_FLOAT(legacyOvershoot, simulate(unlimited, 15.0f, 0.5f, 12.0f, 0, 5.0f).overshoot);
+}
+
+// 測定ノイズ0.3度rmsで一定の目標を保つ時、微分のローパスで舵のばらつきが下がる
+static void test_derivative_filter_limits_output_noise() {
+    PIDController none = makePid(90);
+    PIDController firstOrder = makePid(90, DERIVATIVE_FILTER_FIRST_ORDER);
+    PIDController biquad = makePid(90, DERIVATIVE_FILTER_BIQUAD);
+    float noneStd = simulate(none, 5.0f, 0, 5.0f, 0.3f).outputStd;
+    float firstOrderStd = simulate(firstOrder, 5.0f, 0, 5.0f, 0.3f).outputStd;
+    float biquadStd = simulate(biquad, 5.0f, 0, 5.0f, 0.3f).outputStd;
+    TEST_ASSERT_LESS_THAN_FLOAT(noneStd * 0.5f, firstOrderStd);
+    TEST_ASSERT_LESS_THAN_FLOAT(noneStd * 0.2f, biquadStd);
+    TEST_ASSERT_LESS_THAN_FLOAT(firstOrderStd, biquadStd);
+}
+
+// ki = 0 でも0除算にならず、積分は0のまま
+static void test_zero_ki_is_finite() {
+    PIDController pid(0.8f, 0.0f, 0.5f);
+    pid.setOutputLimits(-90, 90);
+    Response r = simulate(pid, 15.0f, 0.5f, 5.0f);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, pid.getIntegral());
+    TEST_ASSERT_TRUE(isfinite(pid.getLastP() + pid.getLastD()));
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, r.settleTime);
+}
+
+// フィードフォワードは目標値 × kf をそのまま足す
+static void test_feed_forward_adds_setpoint_term() {
+    PIDController pid(3.0f, 0.0f, 0.0f);
+    pid.setOutputLimits(-90, 90);
+    pid.setFeedForward(0.25f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f * 60.0f + 3.0f * 10.0f, pid.calculate(60, 50, DT));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.25f * 60.0f, pid.getLastF());
+}
+
+// presetと同じ周期の計算は指定した舵をそのまま返す（積分は次の周期から進む）
+static void test_preset_continues_from_output() {
+    PIDController pid = makePid(90);
+    pid.calculate(0, 0, DT);
+    pid.preset(25, 5, -3);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 25.0f, pid.calculate(5, -3, DT));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 25.0f + 0.5f * 8.0f * DT, pid.calculate(5, -3, DT));
+}
+
+// 積分の上限は出力制限の内側で効き、出力制限は変えない
+static void test_integral_limit_clamps_integral_only() {
+    PIDController pid(1.0f, 10.0f, 0.0f);
+    pid.setOutputLimits(-90, 90);
+    pid.setIntegralLimit(5);
+    for (int i = 0; i < 1000; i++) pid.calculate(20, 0, DT);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, pid.getIntegral());
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, pid.calculate(20, 0, DT));
+    for (int i = 0; i < 1000; i++) pid.calculate(-20, 0, DT);
+    TEST_ASSERT_EQUAL_FLOAT(-5.0f, pid.getIntegral());
+}
+
+void runPidControllerTests() {
+    RUN_TEST(test_no_derivative_kick_on_setpoint_step);
+    RUN_TEST(test_derivative_is_on_measurement);
+    RUN_TEST(test_windup_overshoot_is_bounded_and_settles);
+    RUN_TEST(test_derivative_filter_limits_output_noise);
+    RUN_TEST(test_zero_ki_is_finite);
+    RUN_TEST(test_feed_forward_adds_setpoint_term);
+    RUN_TEST(test_preset_continues_from_output);
+    RUN_TEST(test_integral_limit_clamps_integral_only);
+}
@@ -0,0 +1,320 @@
+// 受信機プロトコルのパーサー: SBUS / CRSF / PPM
+// 正しいフレームの値に加えて、壊れたフレーム・途中で切れたフレーム・ノイズの後に
+// 誤った値を出さず、次の正しいフレームから読み直せることを確かめる
+
+#include <string.h>
+#include <vector>
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "rc_frame_encoder.h"
+#include "rc_protocol.h"
+#include "rc_receiver.h"
+#include "ppm_receiver_backend.h"
+
+static void makeChannels(uint16_t* micros, int seed) {
+    for (int ch = 0; ch < 16; ch++) {
+        micros[ch] = (uint16_t)(988 + (seed * 131 + ch * 67) % 1024);
+    }
+}
+
+// 11bitの量子化で±1μsまでずれる
+static void assertChannels(const uint16_t* expected, const RCChannelFrame& frame) {
+    TEST_ASSERT_EQUAL_UINT8(16, frame.channelCount);
+    for (int ch = 0; ch < 16; ch++) {
+        TEST_ASSERT_INT_WITHIN(1, expected[ch], frame.channels[ch]);
+    }
+}
+
+template <typename Parser>
+static int feedAll(Parser& parser, const uint8_t* data, size_t length) {
+    int frames = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (parser.feed(data[i])) frames++;
+    }
+    return frames;
+}
+
+static void test_channels11_pack_roundtrip() {
+    uint16_t ticks[16], unpacked[16];
+    for (int ch = 0; ch < 16; ch++) ticks[ch] = (uint16_t)((ch * 293 + 7) & 0x07FF);
+    ticks[0] = 0;
+    ticks[15] = 0x07FF;
+    uint8_t packed[22] = {};
+    packChannels11(ticks, 16, packed);
+    unpackChannels11(packed, unpacked, 16);
+    for (int ch = 0; ch < 16; ch++) TEST_ASSERT_EQUAL_UINT16(ticks[ch], unpacked[ch]);
+
+    TEST_ASSERT_EQUAL_UINT16(988, rcTicksToMicros(172));
+    TEST_ASSERT_EQUAL_UINT16(1500, rcTicksToMicros(992));
+    TEST_ASSERT_EQUAL_UINT16(2011, rcTicksToMicros(1811));
+}
+
+static void test_sbus_decodes_channels_and_flags() {
+    uint16_t micros[16];
+    makeChannels(micros, 1);
+    uint8_t frame[SbusParser::FRAME_SIZE];
+    encodeSbusFrame(micros, false, frame);
+    SbusParser parser;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, frame, sizeof(frame)));
+    assertChannels(micros, parser.getFrame());
+    TEST_ASSERT_FALSE(parser.getFrame().failsafe);
+    TEST_ASSERT_FALSE(parser.getFrame().frameLost);
+
+    encodeSbusFrame(micros, true, frame);
+    frame[23] |= 0x04;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, frame, sizeof(frame)));
+    TEST_ASSERT_TRUE(parser.getFrame().failsafe);
+    TEST_ASSERT_TRUE(parser.getFrame().frameLost);
+
+    // SBUS2のフッター（スロット番号付き）も受け付ける
+    encodeSbusFrame(micros, false, frame);
+    frame[24] = 0x14;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT32(3, parser.getFrameCount());
+    TEST_ASSERT_EQUAL_UINT32(0, parser.getSyncErrors());
+}
+
+// ヘッダーより前のごみは読み飛ばす
+static void test_sbus_skips_leading_garbage() {
+    uint16_t micros[16];
+    makeChannels(micros, 2);
+    std::vector<uint8_t> stream = { 0x00, 0xFF, 0x12, 0x34 };
+    uint8_t frame[SbusParser::FRAME_SIZE];
+    encodeSbusFrame(micros, false, frame);
+    stream.insert(stream.end(), frame, frame + sizeof(frame));
+    SbusParser parser;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, stream.data(), stream.size()));
+    assertChannels(micros, parser.getFrame());
+}
+
+// フッターや未使用のフラグが壊れたフレームは捨て、次のフレームは読める
+static void test_sbus_rejects_corrupted_frame() {
+    uint16_t bad[16], good[16];
+    makeChannels(bad, 3);
+    makeChannels(good, 4);
+    uint8_t frame[SbusParser::FRAME_SIZE];
+    SbusParser parser;
+
+    encodeSbusFrame(bad, false, frame);
+    frame[24] = 0xA5;
+    TEST_ASSERT_EQUAL_INT(0, feedAll(parser, frame, sizeof(frame)));
+    encodeSbusFrame(bad, false, frame);
+    frame[23] |= 0x80;
+    TEST_ASSERT_EQUAL_INT(0, feedAll(parser, frame, sizeof(frame)));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, parser.getSyncErrors());
+
+    encodeSbusFrame(good, false, frame);
+    int decoded = 0;
+    for (int i = 0; i < 3; i++) decoded += feedAll(parser, frame, sizeof(frame));
+    TEST_ASSERT_GREATER_OR_EQUAL(2, decoded);
+    assertChannels(good, parser.getFrame());
+}
+
+// 途中で切れたフレームの後: 誤った値を出さず、遅くとも2つ目のフレームから読める
+static void test_sbus_recovers_from_short_frame() {
+    uint16_t micros[16];
+    uint8_t frame[SbusParser::FRAME_SIZE];
+    for (int cut = 1; cut < SbusParser::FRAME_SIZE; cut++) {
+        SbusParser parser;
+        makeChannels(micros, 100 + cut);
+        encodeSbusFrame(micros, false, frame);
+        feedAll(parser, frame, cut);
+
+        makeChannels(micros, 200 + cut);
+        encodeSbusFrame(micros, false, frame);
+        int decoded = 0;
+        for (int repeat = 0; repeat < 3; repeat++) {
+            for (uint8_t byte : frame) {
+                if (parser.feed(byte)) {
+                    assertChannels(micros, parser.getFrame());
+                    decoded++;
+                }
+            }
+        }
+        TEST_ASSERT_GREATER_OR_EQUAL(2, decoded);
+    }
+}
+
+static void test_crsf_decodes_channels() {
+    uint16_t micros[16];
+    makeChannels(micros, 5);
+    uint8_t frame[26];
+    encodeCrsfFrame(micros, frame);
+    CrsfParser parser;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, frame, sizeof(frame)));
+    assertChannels(micros, parser.getFrame());
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getFrameCount());
+    TEST_ASSERT_EQUAL_UINT32(0, parser.getCrcErrors());
+}
+
+// CRCが合わないフレームは捨てて数え、次のフレームは読める
+static void test_crsf_rejects_bad_crc() {
+    uint16_t bad[16], good[16];
+    makeChannels(bad, 6);
+    makeChannels(good, 7);
+    uint8_t frame[26];
+    CrsfParser parser;
+    encodeCrsfFrame(bad, frame);
+    frame[10] ^= 0x40;
+    TEST_ASSERT_EQUAL_INT(0, feedAll(parser, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT32(1, parser.getCrcErrors());
+
+    encodeCrsfFrame(good, frame);
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, frame, sizeof(frame)));
+    assertChannels(good, parser.getFrame());
+}
+
+// 他のタイプ（リンク統計など）はCRCが合っていれば黙って読み飛ばす
+// 長さが範囲外ならその場で同期をやり直す
+static void test_crsf_skips_other_types_and_bad_length() {
+    uint16_t micros[16];
+    makeChannels(micros, 8);
+    std::vector<uint8_t> stream;
+    uint8_t linkStats[] = { CrsfParser::ADDRESS_FLIGHT_CONTROLLER, 12, 0x14, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0 };
+    linkStats[13] = CrsfParser::crc8(linkStats + 2, 11);
+    stream.insert(stream.end(), linkStats, linkStats + sizeof(linkStats));
+    stream.push_back((uint8_t)CrsfParser::ADDRESS_FLIGHT_CONTROLLER);
+    stream.push_back(1);                        // 長さが短すぎる
+    stream.push_back((uint8_t)CrsfParser::ADDRESS_FLIGHT_CONTROLLER);
+    stream.push_back(200);                      // 長さが長すぎる
+    uint8_t frame[26];
+    encodeCrsfFrame(micros, frame);
+    stream.insert(stream.end(), frame, frame + sizeof(frame));
+
+    CrsfParser parser;
+    TEST_ASSERT_EQUAL_INT(1, feedAll(parser, stream.data(), stream.size()));
+    assertChannels(micros, parser.getFrame());
+    TEST_ASSERT_EQUAL_UINT32(0, parser.getCrcErrors());
+}
+
+// 途中で切れたフレームの後: 誤った値を出さず、数フレーム以内に読み直せる
+static void test_crsf_recovers_from_short_frame() {
+    uint16_t micros[16];
+    uint8_t frame[26];
+    for (int cut = 1; cut < 26; cut++) {
+        CrsfParser parser;
+        makeChannels(micros, 300 + cut);
+        encodeCrsfFrame(micros, frame);
+        feedAll(parser, frame, cut);
+
+        makeChannels(micros, 400 + cut);
+        encodeCrsfFrame(micros, frame);
+        int decoded = 0;
+        for (int repeat = 0; repeat < 4; repeat++) {
+            for (uint8_t byte : frame) {
+                if (parser.feed(byte)) {
+                    assertChannels(micros, parser.getFrame());
+                    decoded++;
+                }
+            }
+        }
+        TEST_ASSERT_GREATER_OR_EQUAL(2, decoded);
+    }
+}
+
+// 同期間隔の後の立ち上がりエッジの間隔がチャンネル値
+static void test_ppm_decodes_frame_after_sync() {
+    const uint16_t widths[8] = { 1000, 1500, 2000, 1200, 1800, 1100, 1900, 1500 };
+    PpmDecoder decoder;
+    uint8_t channel;
+    uint16_t width;
+    uint32_t t = 1000;
+    // 最初の同期までは何も出さない
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    t += 1500;
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    for (int frame = 0; frame < 2; frame++) {
+        t += 8000;
+        TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+        for (uint8_t ch = 0; ch < 8; ch++) {
+            t += widths[ch];
+            TEST_ASSERT_TRUE(decoder.onRisingEdge(t, channel, width));
+            TEST_ASSERT_EQUAL_UINT8(ch, channel);
+            TEST_ASSERT_EQUAL_UINT16(widths[ch], width);
+        }
+    }
+    t += 8000;
+    decoder.onRisingEdge(t, channel, width);
+    TEST_ASSERT_EQUAL_UINT8(8, decoder.getChannelCount());
+}
+
+// 範囲外の間隔（ノイズ）の後は次の同期間隔まで値を出さない
+static void test_ppm_noise_drops_rest_of_frame() {
+    PpmDecoder decoder;
+    uint8_t channel;
+    uint16_t width;
+    uint32_t t = 10000;
+    decoder.onRisingEdge(t, channel, width);
+    t += 1500;
+    TEST_ASSERT_TRUE(decoder.onRisingEdge(t, channel, width));
+    t += 200;                                   // グリッチ
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    t += 1500;
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    t += 2600;                                  // 長すぎるが同期間隔より短い
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    t += 5000;
+    TEST_ASSERT_FALSE(decoder.onRisingEdge(t, channel, width));
+    t += 1234;
+    TEST_ASSERT_TRUE(decoder.onRisingEdge(t, channel, width));
+    TEST_ASSERT_EQUAL_UINT8(0, channel);
+    TEST_ASSERT_EQUAL_UINT16(1234, width);
+}
+
+// 同期間隔のないまま16チャンネルを超えたら捨てる
+static void test_ppm_too_many_channels_resyncs() {
+    PpmDecoder decoder;
+    uint8_t channel;
+    uint16_t width;
+    uint32_t t = 10000;
+    decoder.onRisingEdge(t, channel, width);
+    int decoded = 0;
+    for (int i = 0; i < 20; i++) {
+        t += 1500;
+        if (decoder.onRisingEdge(t, channel, width)) decoded++;
+    }
+    TEST_ASSERT_EQUAL_INT(RC_PROTOCOL_MAX_CHANNELS, decoded);
+}
+
+// PPMバックエンドをピンのエッジから通し、チャンネル割り当てでRCReceiverの値になる
+static void test_ppm_backend_feeds_receiver() {
+    FakeClock clock(10000);
+    FakePwmInput input(clock);
+    PpmReceiverBackend backend(input, clock, 21);
+    RCReceiver receiver(backend, clock);
+    receiver.setChannelMap(1, 3, 4);
+    receiver.begin();
+    const uint16_t widths[6] = { 1500, 1750, 1500, 1250, 2000, 1000 };
+    for (int frame = 0; frame < 2; frame++) {
+        clock.advance(8000);
+        input.setLevel(21, true);
+        input.setLevel(21, false);
+        for (uint16_t w : widths) {
+            clock.advance(w);
+            input.setLevel(21, true);
+            input.setLevel(21, false);
+        }
+    }
+    receiver.update();
+    TEST_ASSERT_EQUAL_UINT32(1750, receiver.getElevatorPulseWidth());
+    TEST_ASSERT_EQUAL_UINT32(1250, receiver.getRudderPulseWidth());
+    TEST_ASSERT_FALSE(receiver.isPassthroughMode());
+    TEST_ASSERT_EQUAL_UINT32(0, receiver.getDroppedEvents());
+}
+
+void runRcProtocolTests() {
+    RUN_TEST(test_channels11_pack_roundtrip);
+    RUN_TEST(test_sbus_decodes_channels_and_flags);
+    RUN_TEST(test_sbus_skips_leading_garbage);
+    RUN_TEST(test_sbus_rejects_corrupted_frame);
+    RUN_TEST(test_sbus_recovers_from_short_frame);
+    RUN_TEST(test_crsf_decodes_channels);
+    RUN_TEST(test_crsf_rejects_bad_crc);
+    RUN_TEST(test_crsf_skips_other_types_and_bad_length);
+    RUN_TEST(test_crsf_recovers_from_short_frame);
+    RUN_TEST(test_ppm_decodes_frame_after_sync);
+    RUN_TEST(test_ppm_noise_drops_rest_of_frame);
+    RUN_TEST(test_ppm_too_many_channels_resyncs);
+    RUN_TEST(test_ppm_backend_feeds_receiver);
+}
@@ -0,0 +1,117 @@
+// RCReceiver: パルス幅 → 値の変換、PWM受信のスナップショット、信号の途絶とモード判定
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "rc_receiver.h"
+#include "pwm_receiver_backend.h"
+
+static const int ELEVATOR_PIN = 21;
+static const int RUDDER_PIN = 1;
+static const int LED_PIN = 10;
+
+static void test_pulse_to_value_matches_arduino_map() {
+    TEST_ASSERT_EQUAL_INT(-100, RCReceiver::pulseToValue(1000));
+    TEST_ASSERT_EQUAL_INT(0, RCReceiver::pulseToValue(1500));
+    TEST_ASSERT_EQUAL_INT(100, RCReceiver::pulseToValue(2000));
+    TEST_ASSERT_EQUAL_INT(50, RCReceiver::pulseToValue(1750));
+    // 整数演算なので5μsで1刻み（切り捨て）
+    TEST_ASSERT_EQUAL_INT(0, RCReceiver::pulseToValue(1504));
+    TEST_ASSERT_EQUAL_INT(1, RCReceiver::pulseToValue(1505));
+    // 範囲外はそのまま伸びる（制限はServoOutput側）
+    TEST_ASSERT_EQUAL_INT(-120, RCReceiver::pulseToValue(900));
+}
+
+static void test_pwm_pulses_map_to_function_channels() {
+    FakeClock clock(10000);
+    FakePwmInput input(clock);
+    PwmReceiverBackend backend(input, clock, ELEVATOR_PIN, RUDDER_PIN, LED_PIN);
+    RCReceiver receiver(backend, clock);
+    receiver.begin();
+
+    input.pulse(ELEVATOR_PIN, 1750);
+    input.pulse(RUDDER_PIN, 1250);
+    input.pulse(LED_PIN, 2000);
+    clock.advance(500);
+    const RCSnapshot& snapshot = receiver.update();
+
+    TEST_ASSERT_EQUAL_UINT32(1750, receiver.getElevatorPulseWidth());
+    TEST_ASSERT_EQUAL_UINT32(1250, receiver.getRudderPulseWidth());
+    TEST_ASSERT_EQUAL_FLOAT(50, receiver.getElevatorValue());
+    TEST_ASSERT_EQUAL_FLOAT(-50, receiver.getRudderValue());
+    TEST_ASSERT_TRUE(receiver.isElevatorValid());
+    TEST_ASSERT_FALSE(receiver.isPassthroughMode());
+    TEST_ASSERT_TRUE(snapshot.updated[0]);
+    TEST_ASSERT_EQUAL_UINT32(500, snapshot.ageMicros[0]);
+
+    // 新しいパルスがなければupdatedは次の周期で消える
+    receiver.update();
+    TEST_ASSERT_FALSE(receiver.getSnapshot().updated[0]);
+    TEST_ASSERT_EQUAL_UINT32(1750, receiver.getElevatorPulseWidth());
+}
+
+// フレーム周期は立ち下がりの間隔から測る
+static void test_frame_period_is_measured() {
+    FakeClock clock(10000);
+    FakePwmInput input(clock);
+    PwmReceiverBackend backend(input, clock, ELEVATOR_PIN, RUDDER_PIN, LED_PIN);
+    RCReceiver receiver(backend, clock);
+    receiver.begin();
+    for (int i = 0; i < 5; i++) {
+        input.pulse(ELEVATOR_PIN, 1500);
+        receiver.update();
+        clock.advance(20000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, receiver.getSnapshot().periodMicros[0]);
+}
+
+// 信号がない・途絶した・LEDスイッチがオフの時はパススルー
+static void test_passthrough_on_missing_stale_or_low_switch() {
+    FakeClock clock(10000);
+    FakePwmInput input(clock);
+    PwmReceiverBackend backend(input, clock, ELEVATOR_PIN, RUDDER_PIN, LED_PIN);
+    RCReceiver receiver(backend, clock);
+    receiver.begin();
+
+    receiver.update();
+    TEST_ASSERT_FALSE(receiver.isElevatorValid());
+    TEST_ASSERT_TRUE(receiver.isPassthroughMode());
+
+    input.pulse(LED_PIN, 1000);
+    receiver.update();
+    TEST_ASSERT_TRUE(receiver.isLedValid());
+    TEST_ASSERT_TRUE(receiver.isPassthroughMode());
+
+    input.pulse(LED_PIN, 2000);
+    receiver.update();
+    TEST_ASSERT_FALSE(receiver.isPassthroughMode());
+
+    // 100msパルスが来なければ無効
+    clock.advance(100001);
+    receiver.update();
+    TEST_ASSERT_FALSE(receiver.isLedValid());
+    TEST_ASSERT_TRUE(receiver.isPassthroughMode());
+}
+
+// 範囲外（800〜2200μs以外）のパルスは無効
+static void test_out_of_range_pulse_is_invalid() {
+    FakeClock clock(10000);
+    FakePwmInput input(clock);
+    PwmReceiverBackend backend(input, clock, ELEVATOR_PIN, RUDDER_PIN, LED_PIN);
+    RCReceiver receiver(backend, clock);
+    receiver.begin();
+    input.pulse(ELEVATOR_PIN, 2500);
+    receiver.update();
+    TEST_ASSERT_FALSE(receiver.isElevatorValid());
+    input.pulse(ELEVATOR_PIN, 2200);
+    receiver.update();
+    TEST_ASSERT_TRUE(receiver.isElevatorValid());
+}
+
+void runRcReceiverTests() {
+    RUN_TEST(test_pulse_to_value_matches_arduino_map);
+    RUN_TEST(test_pwm_pulses_map_to_function_channels);
+    RUN_TEST(test_frame_period_is_measured);
+    RUN_TEST(test_passthrough_on_missing_stale_or_low_switch);
+    RUN_TEST(test_out_of_range_pulse_is_invalid);
+}
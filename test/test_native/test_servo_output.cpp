@@ -0,0 +1,80 @@
+// ServoOutput: 値 → パルス幅の変換、入力とエンドポイントでの制限、リバースとサブトリム
+
+#include <unity.h>
+#include "test_suites.h"
+#include "fake_hal.h"
+#include "servo_output.h"
+
+static void test_begin_attaches_and_centers() {
+    FakeServoDriver driver;
+    ServoOutput servo(driver, 20, "elevator");
+    TEST_ASSERT_TRUE(servo.begin());
+    TEST_ASSERT_EQUAL_INT(20, driver.pin);
+    TEST_ASSERT_EQUAL_UINT16(50, driver.frameRateHz);
+    TEST_ASSERT_EQUAL_FLOAT(1500, driver.pulseMicros);
+}
+
+static void test_value_maps_linearly_to_pulse() {
+    FakeServoDriver driver;
+    ServoOutput servo(driver, 20, "elevator");
+    servo.begin();
+    servo.writeValue(0);
+    TEST_ASSERT_EQUAL_FLOAT(1500, driver.pulseMicros);
+    servo.writeValue(100);
+    TEST_ASSERT_EQUAL_FLOAT(2000, driver.pulseMicros);
+    servo.writeValue(-100);
+    TEST_ASSERT_EQUAL_FLOAT(1000, driver.pulseMicros);
+    servo.writeValue(12.5f);
+    TEST_ASSERT_EQUAL_FLOAT(1562.5f, driver.pulseMicros);
+    TEST_ASSERT_EQUAL_FLOAT(1562.5f, servo.getLastPulse());
+}
+
+// ±100を超える入力は止め、パルスの直接指定はエンドポイントで止める
+static void test_output_is_clamped() {
+    FakeServoDriver driver;
+    ServoOutput servo(driver, 20, "elevator");
+    servo.begin();
+    servo.writeValue(250);
+    TEST_ASSERT_EQUAL_FLOAT(2000, driver.pulseMicros);
+    servo.writeValue(-1000);
+    TEST_ASSERT_EQUAL_FLOAT(1000, driver.pulseMicros);
+    servo.writeMicroseconds(2600);
+    TEST_ASSERT_EQUAL_FLOAT(2000, driver.pulseMicros);
+    servo.writeMicroseconds(400);
+    TEST_ASSERT_EQUAL_FLOAT(1000, driver.pulseMicros);
+}
+
+// 振れ幅がエンドポイントより広くても、サブトリムで中立がずれてもエンドポイントを超えない
+static void test_endpoints_limit_travel_and_subtrim() {
+    FakeServoDriver driver;
+    const ServoConfig config = { 1500, 40, 600, 1100, 1900, false, 50 };
+    ServoOutput servo(driver, 20, "elevator", config);
+    servo.begin();
+    TEST_ASSERT_EQUAL_FLOAT(1540, driver.pulseMicros);
+    servo.writeValue(100);
+    TEST_ASSERT_EQUAL_FLOAT(1900, driver.pulseMicros);
+    servo.writeValue(-100);
+    TEST_ASSERT_EQUAL_FLOAT(1100, driver.pulseMicros);
+    servo.writeValue(10);
+    TEST_ASSERT_EQUAL_FLOAT(1600, driver.pulseMicros);
+}
+
+static void test_reversed_servo_mirrors_around_center() {
+    FakeServoDriver driver;
+    const ServoConfig config = { 1500, 0, 500, 1000, 2000, true, 333 };
+    ServoOutput servo(driver, 2, "rudder", config);
+    TEST_ASSERT_TRUE(servo.begin());
+    TEST_ASSERT_EQUAL_UINT16(333, driver.frameRateHz);
+    servo.writeValue(40);
+    TEST_ASSERT_EQUAL_FLOAT(1300, driver.pulseMicros);
+    servo.writeValue(-40);
+    TEST_ASSERT_EQUAL_FLOAT(1700, driver.pulseMicros);
+}
+
+void runServoOutputTests() {
+    RUN_TEST(test_begin_attaches_and_centers);
+    RUN_TEST(test_value_maps_linearly_to_pulse);
+    RUN_TEST(test_output_is_clamped);
+    RUN_TEST(test_endpoints_limit_travel_and_subtrim);
+    RUN_TEST(test_reversed_servo_mirrors_around_center);
+}
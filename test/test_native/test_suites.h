@@ -0,0 +1,19 @@
+#ifndef TEST_SUITES_H
+#define TEST_SUITES_H
+
+// ファイル毎のテスト一覧（test_main.cppから順に呼ぶ）
+void runControlSchedulerTests();
+void runRcReceiverTests();
+void runServoOutputTests();
+void runRcProtocolTests();
+void runMpu6050DriverTests();
+void runFixedPointTests();
+void runFastMathTests();
+void runPidControllerTests();
+void runAutoControlTests();
+void runControlTickTests();
+void runImuCalibratorTests();
+void runI2CBusManagerTests();
+void runBlackboxTests();
+
+#endif